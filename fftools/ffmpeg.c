@@ -2206,6 +2206,23 @@ static int ifilter_send_frame(InputFilter *ifilter, AVFrame *frame)
             return ret;
     }
 
+    /* convert the frames at the input and keep the rest of the graph running */
+    if (need_reinit && fg->graph && ifilter->ist->reinit_filters == 2 &&
+        ifilter->type == AVMEDIA_TYPE_VIDEO && !ifilter->hw_frames_ctx) {
+        AVBufferSrcParameters *par = av_buffersrc_parameters_alloc();
+        if (!par)
+            return AVERROR(ENOMEM);
+        par->format = frame->format;
+        par->width  = frame->width;
+        par->height = frame->height;
+        ret = av_buffersrc_reconfigure(ifilter->filter, par);
+        av_freep(&par);
+        if (ret < 0 && ret != AVERROR(ENOSYS))
+            av_log(NULL, AV_LOG_WARNING, "Error reconfiguring the filter input: %s, "
+                   "reinitializing the filtergraph\n", av_err2str(ret));
+        need_reinit = ret < 0;
+    }
+
     /* (re)init the graph if possible, otherwise buffer the frame and return */
     if (need_reinit || !fg->graph) {
         for (i = 0; i < fg->nb_inputs; i++) {
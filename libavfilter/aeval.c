@@ -71,6 +71,9 @@ typedef struct EvalContext {
     double var_values[VAR_VARS_NB];
     double *channel_values;
     int64_t out_channel_layout;
+    int uses_val;               ///< set if the expressions depend on the input samples
+    double *sample_values[VAR_VARS_NB]; ///< per sample values of the variables
+    int nb_sample_values;
 } EvalContext;
 
 static double val(void *priv, double ch)
@@ -164,11 +167,37 @@ static int parse_channel_expressions(AVFilterContext *ctx,
         goto end;
     }
 
+    eval->uses_val = 0;
+    if (func1) {
+        for (i = 0; i < eval->nb_channels; i++) {
+            unsigned count = 0;
+
+            av_expr_count_func(eval->expr[i], &count, 1, 1);
+            eval->uses_val |= !!count;
+        }
+    }
+
 end:
     av_free(args1);
     return ret;
 }
 
+static int alloc_sample_values(EvalContext *eval, int nb_samples)
+{
+    if (nb_samples <= eval->nb_sample_values)
+        return 0;
+
+    av_freep(&eval->sample_values[VAR_N]);
+    av_freep(&eval->sample_values[VAR_T]);
+    eval->nb_sample_values = 0;
+    eval->sample_values[VAR_N] = av_malloc_array(nb_samples, sizeof(double));
+    eval->sample_values[VAR_T] = av_malloc_array(nb_samples, sizeof(double));
+    if (!eval->sample_values[VAR_N] || !eval->sample_values[VAR_T])
+        return AVERROR(ENOMEM);
+    eval->nb_sample_values = nb_samples;
+    return 0;
+}
+
 static av_cold int init(AVFilterContext *ctx)
 {
     EvalContext *eval = ctx->priv;
@@ -218,6 +247,8 @@ static av_cold void uninit(AVFilterContext *ctx)
     }
     av_freep(&eval->expr);
     av_freep(&eval->channel_values);
+    av_freep(&eval->sample_values[VAR_N]);
+    av_freep(&eval->sample_values[VAR_T]);
 }
 
 static int config_props(AVFilterLink *outlink)
@@ -275,7 +306,7 @@ static int request_frame(AVFilterLink *outlink)
 {
     EvalContext *eval = outlink->src->priv;
     AVFrame *samplesref;
-    int i, j;
+    int i, j, ret;
     int64_t t = av_rescale(eval->n, AV_TIME_BASE, eval->sample_rate);
     int nb_samples;
 
@@ -293,14 +324,24 @@ static int request_frame(AVFilterLink *outlink)
     if (!samplesref)
         return AVERROR(ENOMEM);
 
-    /* evaluate expression for each single sample and for each channel */
+    if ((ret = alloc_sample_values(eval, nb_samples)) < 0) {
+        av_frame_free(&samplesref);
+        return ret;
+    }
+
+    /* evaluate expression for all the samples of each channel at once */
     for (i = 0; i < nb_samples; i++, eval->n++) {
-        eval->var_values[VAR_N] = eval->n;
-        eval->var_values[VAR_T] = eval->var_values[VAR_N] * (double)1/eval->sample_rate;
+        eval->sample_values[VAR_N][i] = eval->n;
+        eval->sample_values[VAR_T][i] = eval->sample_values[VAR_N][i] * (double)1/eval->sample_rate;
+    }
 
-        for (j = 0; j < eval->nb_channels; j++) {
-            *((double *) samplesref->extended_data[j] + i) =
-                av_expr_eval(eval->expr[j], eval->var_values, NULL);
+    for (j = 0; j < eval->nb_channels; j++) {
+        ret = av_expr_eval_array(eval->expr[j], (double *)samplesref->extended_data[j],
+                                 nb_samples, eval->var_values,
+                                 (const double * const *)eval->sample_values, NULL);
+        if (ret < 0) {
+            av_frame_free(&samplesref);
+            return ret;
         }
     }
 
@@ -434,18 +475,46 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 
     t0 = TS2T(in->pts, inlink->time_base);
 
-    /* evaluate expression for each single sample and for each channel */
-    for (i = 0; i < nb_samples; i++, eval->n++) {
-        eval->var_values[VAR_N] = eval->n;
-        eval->var_values[VAR_T] = t0 + i * (double)1/inlink->sample_rate;
+    if (!eval->uses_val) {
+        int ret = alloc_sample_values(eval, nb_samples);
 
-        for (j = 0; j < inlink->channels; j++)
-            eval->channel_values[j] = *((double *) in->extended_data[j] + i);
+        if (ret < 0) {
+            av_frame_free(&in);
+            av_frame_free(&out);
+            return ret;
+        }
+
+        /* evaluate expression for all the samples of each channel at once */
+        for (i = 0; i < nb_samples; i++, eval->n++) {
+            eval->sample_values[VAR_N][i] = eval->n;
+            eval->sample_values[VAR_T][i] = t0 + i * (double)1/inlink->sample_rate;
+        }
 
         for (j = 0; j < outlink->channels; j++) {
             eval->var_values[VAR_CH] = j;
-            *((double *) out->extended_data[j] + i) =
-                av_expr_eval(eval->expr[j], eval->var_values, eval);
+            ret = av_expr_eval_array(eval->expr[j], (double *)out->extended_data[j],
+                                     nb_samples, eval->var_values,
+                                     (const double * const *)eval->sample_values, eval);
+            if (ret < 0) {
+                av_frame_free(&in);
+                av_frame_free(&out);
+                return ret;
+            }
+        }
+    } else {
+        /* evaluate expression for each single sample and for each channel */
+        for (i = 0; i < nb_samples; i++, eval->n++) {
+            eval->var_values[VAR_N] = eval->n;
+            eval->var_values[VAR_T] = t0 + i * (double)1/inlink->sample_rate;
+
+            for (j = 0; j < inlink->channels; j++)
+                eval->channel_values[j] = *((double *) in->extended_data[j] + i);
+
+            for (j = 0; j < outlink->channels; j++) {
+                eval->var_values[VAR_CH] = j;
+                *((double *) out->extended_data[j] + i) =
+                    av_expr_eval(eval->expr[j], eval->var_values, eval);
+            }
         }
     }
 
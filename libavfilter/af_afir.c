@@ -31,7 +31,6 @@
 #include "libavutil/intreadwrite.h"
 #include "libavutil/opt.h"
 #include "libavutil/xga_font_data.h"
-#include "libavcodec/avfft.h"
 
 #include "audio.h"
 #include "avfilter.h"
@@ -57,7 +56,7 @@ static void fcmul_add_c(float *sum, const float *t, const float *c, ptrdiff_t le
     sum[2 * n] += t[2 * n] * c[2 * n];
 }
 
-static void direct(const float *in, const FFTComplex *ir, int len, float *out)
+static void direct(const float *in, const AVComplexFloat *ir, int len, float *out)
 {
     for (int n = 0; n < len; n++)
         for (int m = 0; m <= n; m++)
@@ -114,7 +113,7 @@ static int fir_quantum(AVFilterContext *ctx, AVFrame *out, int ch, int offset)
 
             for (i = 0; i < seg->nb_partitions; i++) {
                 const int coffset = j * seg->coeff_size;
-                const FFTComplex *coeff = (const FFTComplex *)seg->coeff->extended_data[ch * !s->one2many] + coffset;
+                const AVComplexFloat *coeff = (const AVComplexFloat *)seg->coeff->extended_data[ch * !s->one2many] + coffset;
 
                 direct(src, coeff, nb_samples, dst);
 
@@ -139,16 +138,14 @@ static int fir_quantum(AVFilterContext *ctx, AVFrame *out, int ch, int offset)
 
         memcpy(block, src, sizeof(*src) * seg->part_size);
 
-        av_rdft_calc(seg->rdft[ch], block);
-        block[2 * seg->part_size] = block[1];
-        block[1] = 0;
+        seg->tx_fn(seg->rdft[ch], block, block, sizeof(float));
 
         j = seg->part_index[ch];
 
         for (i = 0; i < seg->nb_partitions; i++) {
             const int coffset = j * seg->coeff_size;
             const float *block = (const float *)seg->block->extended_data[ch] + i * seg->block_size;
-            const FFTComplex *coeff = (const FFTComplex *)seg->coeff->extended_data[ch * !s->one2many] + coffset;
+            const AVComplexFloat *coeff = (const AVComplexFloat *)seg->coeff->extended_data[ch * !s->one2many] + coffset;
 
             s->afirdsp.fcmul_add(sum, block, (const float *)coeff, seg->part_size);
 
@@ -157,8 +154,7 @@ static int fir_quantum(AVFilterContext *ctx, AVFrame *out, int ch, int offset)
             j--;
         }
 
-        sum[1] = sum[2 * seg->part_size];
-        av_rdft_calc(seg->irdft[ch], sum);
+        seg->itx_fn(seg->irdft[ch], sum, sum, sizeof(AVComplexFloat));
 
         buf = (float *)seg->buffer->extended_data[ch];
         fir_fadd(s, buf, sum, seg->part_size);
@@ -385,7 +381,7 @@ static int init_segment(AVFilterContext *ctx, AudioFIRSegment *seg,
     if (!seg->rdft || !seg->irdft)
         return AVERROR(ENOMEM);
 
-    seg->fft_length    = part_size * 2 + 1;
+    seg->fft_length    = part_size * 2 + 2;
     seg->part_size     = part_size;
     seg->block_size    = FFALIGN(seg->fft_length, 32);
     seg->coeff_size    = FFALIGN(seg->part_size + 1, 32);
@@ -399,10 +395,16 @@ static int init_segment(AVFilterContext *ctx, AudioFIRSegment *seg,
         return AVERROR(ENOMEM);
 
     for (int ch = 0; ch < ctx->inputs[0]->channels && part_size >= 8; ch++) {
-        seg->rdft[ch]  = av_rdft_init(av_log2(2 * part_size), DFT_R2C);
-        seg->irdft[ch] = av_rdft_init(av_log2(2 * part_size), IDFT_C2R);
-        if (!seg->rdft[ch] || !seg->irdft[ch])
-            return AVERROR(ENOMEM);
+        int ret;
+
+        ret = av_tx_init(&seg->rdft[ch], &seg->tx_fn, AV_TX_FLOAT_RDFT,
+                         0, 2 * part_size, NULL, 0);
+        if (ret < 0)
+            return ret;
+        ret = av_tx_init(&seg->irdft[ch], &seg->itx_fn, AV_TX_FLOAT_RDFT,
+                         1, 2 * part_size, NULL, 0);
+        if (ret < 0)
+            return ret;
     }
 
     seg->sum    = ff_get_audio_buffer(ctx->inputs[0], seg->fft_length);
@@ -423,14 +425,14 @@ static void uninit_segment(AVFilterContext *ctx, AudioFIRSegment *seg)
 
     if (seg->rdft) {
         for (int ch = 0; ch < s->nb_channels; ch++) {
-            av_rdft_end(seg->rdft[ch]);
+            av_tx_uninit(&seg->rdft[ch]);
         }
     }
     av_freep(&seg->rdft);
 
     if (seg->irdft) {
         for (int ch = 0; ch < s->nb_channels; ch++) {
-            av_rdft_end(seg->irdft[ch]);
+            av_tx_uninit(&seg->irdft[ch]);
         }
     }
     av_freep(&seg->irdft);
@@ -558,12 +560,12 @@ static int convert_coeffs(AVFilterContext *ctx)
         for (int segment = 0; segment < s->nb_segments; segment++) {
             AudioFIRSegment *seg = &s->seg[segment];
             float *block = (float *)seg->block->extended_data[ch];
-            FFTComplex *coeff = (FFTComplex *)seg->coeff->extended_data[ch];
+            AVComplexFloat *coeff = (AVComplexFloat *)seg->coeff->extended_data[ch];
 
             av_log(ctx, AV_LOG_DEBUG, "segment: %d\n", segment);
 
             for (i = 0; i < seg->nb_partitions; i++) {
-                const float scale = 1.f / seg->part_size;
+                const float scale = 1.f / (2 * seg->part_size);
                 const int coffset = i * seg->coeff_size;
                 const int remaining = s->nb_taps - toffset;
                 const int size = remaining >= seg->part_size ? seg->part_size : remaining;
@@ -579,16 +581,12 @@ static int convert_coeffs(AVFilterContext *ctx)
                 memset(block, 0, sizeof(*block) * seg->fft_length);
                 memcpy(block, time + toffset, size * sizeof(*block));
 
-                av_rdft_calc(seg->rdft[0], block);
+                seg->tx_fn(seg->rdft[0], block, block, sizeof(float));
 
-                coeff[coffset].re = block[0] * scale;
-                coeff[coffset].im = 0;
-                for (n = 1; n < seg->part_size; n++) {
+                for (n = 0; n <= seg->part_size; n++) {
                     coeff[coffset + n].re = block[2 * n] * scale;
                     coeff[coffset + n].im = block[2 * n + 1] * scale;
                 }
-                coeff[coffset + seg->part_size].re = block[1] * scale;
-                coeff[coffset + seg->part_size].im = 0;
 
                 toffset += size;
             }
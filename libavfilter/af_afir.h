@@ -24,7 +24,7 @@
 #include "libavutil/common.h"
 #include "libavutil/float_dsp.h"
 #include "libavutil/opt.h"
-#include "libavcodec/avfft.h"
+#include "libavutil/tx.h"
 
 #include "audio.h"
 #include "avfilter.h"
@@ -50,7 +50,8 @@ typedef struct AudioFIRSegment {
     AVFrame *input;
     AVFrame *output;
 
-    RDFTContext **rdft, **irdft;
+    AVTXContext **rdft, **irdft;
+    av_tx_fn tx_fn, itx_fn;
 } AudioFIRSegment;
 
 typedef struct AudioFIRDSPContext {
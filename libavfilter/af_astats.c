@@ -58,7 +58,18 @@
 #define MEASURE_NOISE_FLOOR             (1 << 22)
 #define MEASURE_NOISE_FLOOR_COUNT       (1 << 23)
 
-#define MEASURE_MINMAXPEAK              (MEASURE_MIN_LEVEL | MEASURE_MAX_LEVEL | MEASURE_PEAK_LEVEL)
+#define MEASURE_RUNS                    (MEASURE_FLAT_FACTOR | MEASURE_PEAK_COUNT)
+#define MEASURE_CROSSINGS               (MEASURE_ZERO_CROSSINGS | MEASURE_ZERO_CROSSINGS_RATE)
+#define MEASURE_DIFFERENCES             (MEASURE_MIN_DIFFERENCE | MEASURE_MAX_DIFFERENCE | \
+                                         MEASURE_MEAN_DIFFERENCE | MEASURE_RMS_DIFFERENCE)
+#define MEASURE_RMS_WINDOW              (MEASURE_RMS_PEAK | MEASURE_RMS_TROUGH)
+#define MEASURE_SUMS                    (MEASURE_DC_OFFSET | MEASURE_RMS_LEVEL | \
+                                         MEASURE_CREST_FACTOR | MEASURE_RMS_WINDOW)
+#define MEASURE_NOISE                   (MEASURE_NOISE_FLOOR | MEASURE_NOISE_FLOOR_COUNT)
+#define MEASURE_ORDERED                 (MEASURE_RUNS | MEASURE_CROSSINGS | MEASURE_SUMS | \
+                                         MEASURE_NOISE)
+#define MEASURE_FP_CLASSES              (MEASURE_NUMBER_OF_NANS | MEASURE_NUMBER_OF_INFS | \
+                                         MEASURE_NUMBER_OF_DENORMALS)
 
 typedef struct ChannelStats {
     double last;
@@ -68,7 +79,7 @@ typedef struct ChannelStats {
     double avg_sigma_x2, min_sigma_x2, max_sigma_x2;
     double min, max;
     double nmin, nmax;
-    double min_run, max_run;
+    uint64_t min_run, max_run;
     double min_runs, max_runs;
     double min_diff, max_diff;
     double diff1_sum;
@@ -81,10 +92,10 @@ typedef struct ChannelStats {
     uint64_t nb_nans;
     uint64_t nb_infs;
     uint64_t nb_denormals;
-    double *win_samples;
-    unsigned histogram[HISTOGRAM_SIZE];
+    int *win_samples;           ///< quantized magnitude of the samples in the window
+    int *win_suffix_max;        ///< maxima of the previous window from each position on
+    int win_prefix_max;
     int win_pos;
-    int max_index;
     double noise_floor;
 } ChannelStats;
 
@@ -101,6 +112,8 @@ typedef struct AudioStatsContext {
     int maxbitdepth;
     int measure_perchannel;
     int measure_overall;
+    unsigned measure;
+    double norm;
     int is_float;
     int is_double;
 } AudioStatsContext;
@@ -213,8 +226,8 @@ static void reset_stats(AudioStatsContext *s)
         p->noise_floor = NAN;
         p->noise_floor_count = 0;
         p->win_pos = 0;
+        p->win_prefix_max = 0;
         memset(p->win_samples, 0, s->tc_samples * sizeof(*p->win_samples));
-        memset(p->histogram, 0, sizeof(p->histogram));
     }
 }
 
@@ -233,7 +246,8 @@ static int config_output(AVFilterLink *outlink)
         ChannelStats *p = &s->chstats[i];
 
         p->win_samples = av_calloc(s->tc_samples, sizeof(*p->win_samples));
-        if (!p->win_samples)
+        p->win_suffix_max = av_calloc(s->tc_samples + 1, sizeof(*p->win_suffix_max));
+        if (!p->win_samples || !p->win_suffix_max)
             return AVERROR(ENOMEM);
     }
 
@@ -246,6 +260,18 @@ static int config_output(AVFilterLink *outlink)
     s->is_float = outlink->format == AV_SAMPLE_FMT_FLT  ||
                   outlink->format == AV_SAMPLE_FMT_FLTP;
 
+    switch (av_get_packed_sample_fmt(outlink->format)) {
+    case AV_SAMPLE_FMT_S16: s->norm = INT16_MAX;         break;
+    case AV_SAMPLE_FMT_S32: s->norm = INT32_MAX;         break;
+    case AV_SAMPLE_FMT_S64: s->norm = (double)INT64_MAX; break;
+    default:                s->norm = 1.0;               break;
+    }
+
+    /* Only gather what is printed or exported */
+    s->measure = s->measure_perchannel | s->measure_overall;
+    if (!s->is_float && !s->is_double)
+        s->measure &= ~MEASURE_FP_CLASSES;
+
     reset_stats(s);
 
     return 0;
@@ -267,109 +293,225 @@ static void bit_depth(AudioStatsContext *s, uint64_t mask, uint64_t imask, AVRat
             depth->num++;
 }
 
-static inline void update_minmax(AudioStatsContext *s, ChannelStats *p, double d)
+/* Statistics are gathered over blocks of this many samples of a channel,
+ * and only those that were asked for. Every loop still walks the samples in
+ * order so the results are the same as when updating them sample by sample. */
+#define BLOCK_SIZE 256
+
+#define UPDATE_RUNS(sample, last, peak, run, runs, count)                       \
+    if (sample == peak) {                                                       \
+        count++;                                                                \
+        run = sample == last ? run + 1 : 1;                                     \
+    } else if (last == peak) {                                                  \
+        runs += (double)run * run;                                              \
+    }
+
+/* The noise floor is the lowest maximum magnitude over the windows of
+ * tc_samples samples. As win_pos wraps around every tc_samples samples, the
+ * window ending at it is made of the samples of the current pass up to it
+ * and those of the previous pass after it, so its maximum is the larger of
+ * a running maximum and a suffix maximum computed once per pass. */
+static void update_window(AudioStatsContext *s, ChannelStats *p)
 {
-    if (d < p->min)
-        p->min = d;
-    if (d > p->max)
-        p->max = d;
+    for (int i = s->tc_samples - 1; i >= 0; i--)
+        p->win_suffix_max[i] = FFMAX(p->win_samples[i], p->win_suffix_max[i + 1]);
 }
 
-static inline void update_stat(AudioStatsContext *s, ChannelStats *p, double d, double nd, int64_t i)
+/* Everything depending on the order of the samples, in a single loop so that
+ * the dependency chains of the accumulations overlap. */
+static av_always_inline void update_ordered(AudioStatsContext *s, ChannelStats *p,
+                                           const double *d, const double *nd, int nb,
+                                           const unsigned measure)
 {
-    double drop;
-    int index;
-
-    if (d < p->min) {
-        p->min = d;
-        p->nmin = nd;
-        p->min_run = 1;
-        p->min_runs = 0;
-        p->min_count = 1;
-    } else if (d == p->min) {
-        p->min_count++;
-        p->min_run = d == p->last ? p->min_run + 1 : 1;
-    } else if (p->last == p->min) {
-        p->min_runs += p->min_run * p->min_run;
-    }
-
-    if (d != 0 && FFABS(d) < p->min_non_zero)
-        p->min_non_zero = FFABS(d);
+    const int runs        = measure & MEASURE_RUNS;
+    const int crossings   = measure & MEASURE_CROSSINGS;
+    const int sums        = measure & MEASURE_SUMS;
+    const int window      = measure & MEASURE_RMS_WINDOW;
+    const int noise       = measure & MEASURE_NOISE;
+    const int tc_samples  = s->tc_samples;
+    const int start = p->nb_samples >= tc_samples ? 0 :
+                      FFMIN(tc_samples - p->nb_samples, nb);
+    const double min = p->min, max = p->max;
+    double last = p->last;
+    uint64_t min_run = p->min_run, max_run = p->max_run;
+    double min_runs = p->min_runs, max_runs = p->max_runs;
+    uint64_t min_count = p->min_count, max_count = p->max_count;
+    int last_positive = p->last_non_zero > 0;
+    uint64_t zero_runs = p->zero_runs;
+    double sigma_x = p->sigma_x, sigma_x2 = p->sigma_x2;
+    double avg_sigma_x2 = p->avg_sigma_x2;
+    double min_sigma_x2 = p->min_sigma_x2, max_sigma_x2 = p->max_sigma_x2;
+    int * const win_samples = p->win_samples;
+    const int * const win_suffix_max = p->win_suffix_max;
+    int win_pos = p->win_pos, win_prefix_max = p->win_prefix_max;
+    int noise_floor = isnan(p->noise_floor) ? -1 : lrint(p->noise_floor * HISTOGRAM_MAX);
+    uint64_t noise_floor_count = p->noise_floor_count;
+
+    for (int k = 0; k < nb;) {
+        /* Stop at the end of the window so that it is updated outside of the
+         * loop below */
+        const int end = noise ? FFMIN(nb, k + tc_samples - win_pos) : nb;
+
+        for (; k < end; k++) {
+            if (runs) {
+                UPDATE_RUNS(d[k], last, min, min_run, min_runs, min_count);
+                UPDATE_RUNS(d[k], last, max, max_run, max_runs, max_count);
+            }
+            if (crossings) {
+                const int non_zero = d[k] != 0, positive = d[k] > 0;
 
-    if (d > p->max) {
-        p->max = d;
-        p->nmax = nd;
-        p->max_run = 1;
-        p->max_runs = 0;
-        p->max_count = 1;
-    } else if (d == p->max) {
-        p->max_count++;
-        p->max_run = d == p->last ? p->max_run + 1 : 1;
-    } else if (p->last == p->max) {
-        p->max_runs += p->max_run * p->max_run;
-    }
+                zero_runs += non_zero & (positive ^ last_positive);
+                last_positive = non_zero ? positive : last_positive;
+            }
+            if (sums) {
+                sigma_x  += nd[k];
+                sigma_x2 += nd[k] * nd[k];
+            }
+            if (window) {
+                avg_sigma_x2 = avg_sigma_x2 * s->mult + (1.0 - s->mult) * nd[k] * nd[k];
+                if (k >= start) {
+                    max_sigma_x2 = FFMAX(max_sigma_x2, avg_sigma_x2);
+                    min_sigma_x2 = FFMIN(min_sigma_x2, avg_sigma_x2);
+                }
+            }
+            if (noise) {
+                const int index = av_clip(lrint(av_clipd(fabs(nd[k]), 0.0, 1.0) * HISTOGRAM_MAX), 0, HISTOGRAM_MAX);
+
+                win_samples[win_pos++] = index;
+                win_prefix_max = FFMAX(win_prefix_max, index);
+
+                if (noise_floor >= 0) {
+                    const int max_index = FFMAX(win_prefix_max, win_suffix_max[win_pos]);
+
+                    if (max_index < noise_floor) {
+                        noise_floor = max_index;
+                        noise_floor_count = 1;
+                    } else if (max_index == noise_floor) {
+                        noise_floor_count++;
+                    }
+                }
+            }
+            last = d[k];
+        }
 
-    if (d != 0) {
-        p->zero_runs += FFSIGN(d) != FFSIGN(p->last_non_zero);
-        p->last_non_zero = d;
+        if (noise && win_pos >= tc_samples) {
+            /* The first window is only complete now */
+            if (noise_floor < 0) {
+                noise_floor = win_prefix_max;
+                noise_floor_count = 1;
+            }
+            update_window(s, p);
+            win_prefix_max = 0;
+            win_pos = 0;
+        }
     }
 
-    p->sigma_x += nd;
-    p->sigma_x2 += nd * nd;
-    p->avg_sigma_x2 = p->avg_sigma_x2 * s->mult + (1.0 - s->mult) * nd * nd;
-    if (!isnan(p->last)) {
-        p->min_diff = FFMIN(p->min_diff, fabs(d - p->last));
-        p->max_diff = FFMAX(p->max_diff, fabs(d - p->last));
-        p->diff1_sum += fabs(d - p->last);
-        p->diff1_sum_x2 += (d - p->last) * (d - p->last);
-    }
-    p->last = d;
-    p->mask |= i;
-    p->imask &= i;
-
-    drop = p->win_samples[p->win_pos];
-    p->win_samples[p->win_pos] = nd;
-    index = av_clip(lrint(av_clipd(FFABS(nd), 0.0, 1.0) * HISTOGRAM_MAX), 0, HISTOGRAM_MAX);
-    p->max_index = FFMAX(p->max_index, index);
-    p->histogram[index]++;
-    if (!isnan(p->noise_floor))
-        p->histogram[av_clip(lrint(av_clipd(FFABS(drop), 0.0, 1.0) * HISTOGRAM_MAX), 0, HISTOGRAM_MAX)]--;
-    p->win_pos++;
-
-    while (p->histogram[p->max_index] == 0)
-        p->max_index--;
-    if (p->win_pos >= s->tc_samples || !isnan(p->noise_floor)) {
-        double noise_floor = 1.;
-
-        for (int i = p->max_index; i >= 0; i--) {
-            if (p->histogram[i]) {
-                noise_floor = i / (double)HISTOGRAM_MAX;
+    if (crossings) {
+        for (int k = nb - 1; k >= 0; k--) {
+            if (d[k] != 0) {
+                p->last_non_zero = d[k];
                 break;
             }
         }
+    }
 
-        if (isnan(p->noise_floor)) {
-            p->noise_floor = noise_floor;
-            p->noise_floor_count = 1;
-        } else {
-            if (noise_floor < p->noise_floor) {
-                p->noise_floor = noise_floor;
-                p->noise_floor_count = 1;
-            } else if (noise_floor == p->noise_floor) {
-                p->noise_floor_count++;
-            }
+    p->min_run           = min_run;
+    p->min_runs          = min_runs;
+    p->min_count         = min_count;
+    p->max_run           = max_run;
+    p->max_runs          = max_runs;
+    p->max_count         = max_count;
+    p->zero_runs         = zero_runs;
+    p->sigma_x           = sigma_x;
+    p->sigma_x2          = sigma_x2;
+    p->avg_sigma_x2      = avg_sigma_x2;
+    p->min_sigma_x2      = min_sigma_x2;
+    p->max_sigma_x2      = max_sigma_x2;
+    p->win_pos           = win_pos;
+    p->win_prefix_max    = win_prefix_max;
+    p->noise_floor       = noise_floor < 0 ? NAN : noise_floor / (double)HISTOGRAM_MAX;
+    p->noise_floor_count = noise_floor_count;
+}
+
+static void update_stats(AudioStatsContext *s, ChannelStats *p,
+                         const double *d, const int64_t *i, int nb)
+{
+    const unsigned measure = s->measure;
+    const int dynamic_range = measure & MEASURE_DYNAMIC_RANGE;
+    const int bitdepth      = measure & MEASURE_BIT_DEPTH;
+    const int differences   = measure & MEASURE_DIFFERENCES;
+    double min = p->min, max = p->max;
+    double min_non_zero = p->min_non_zero;
+    uint64_t mask = p->mask, imask = p->imask;
+    double min_diff = p->min_diff, max_diff = p->max_diff;
+    double diff1_sum = p->diff1_sum, diff1_sum_x2 = p->diff1_sum_x2;
+    double last = p->last;
+    double nd[BLOCK_SIZE];
+
+    /* Updates only needing the current and previous samples first, the
+     * peaks found here let the runs be counted without tracking them sample
+     * by sample. */
+    for (int k = 0; k < nb; k++) {
+        min = d[k] < min ? d[k] : min;
+        max = d[k] > max ? d[k] : max;
+        if (differences && !isnan(last)) {
+            const double diff = fabs(d[k] - last);
+
+            min_diff = FFMIN(min_diff, diff);
+            max_diff = FFMAX(max_diff, diff);
+            diff1_sum += diff;
+            diff1_sum_x2 += diff * diff;
+        }
+        if (dynamic_range) {
+            const double a = fabs(d[k]);
+
+            min_non_zero = d[k] != 0 && a < min_non_zero ? a : min_non_zero;
         }
+        if (bitdepth) {
+            mask  |= i[k];
+            imask &= i[k];
+        }
+        last = d[k];
     }
 
-    if (p->win_pos >= s->tc_samples) {
-        p->win_pos = 0;
+    /* Samples before the first occurrence of a new peak are all beyond it,
+     * so nothing counted up to there would have been kept. */
+    if (min < p->min) {
+        p->min_run   = 0;
+        p->min_runs  = 0;
+        p->min_count = 0;
+    }
+    if (max > p->max) {
+        p->max_run   = 0;
+        p->max_runs  = 0;
+        p->max_count = 0;
     }
 
-    if (p->nb_samples >= s->tc_samples) {
-        p->max_sigma_x2 = FFMAX(p->max_sigma_x2, p->avg_sigma_x2);
-        p->min_sigma_x2 = FFMIN(p->min_sigma_x2, p->avg_sigma_x2);
+    p->min  = min;
+    p->max  = max;
+    p->nmin = min / s->norm;
+    p->nmax = max / s->norm;
+    p->min_non_zero = min_non_zero;
+    p->mask  = mask;
+    p->imask = imask;
+    p->min_diff = min_diff;
+    p->max_diff = max_diff;
+    p->diff1_sum = diff1_sum;
+    p->diff1_sum_x2 = diff1_sum_x2;
+
+    if (measure & (MEASURE_SUMS | MEASURE_RMS_WINDOW | MEASURE_NOISE)) {
+        for (int k = 0; k < nb; k++)
+            nd[k] = d[k] / s->norm;
     }
-    p->nb_samples++;
+
+    /* Specialized for the default of measuring everything */
+    if ((measure & MEASURE_ORDERED) == MEASURE_ORDERED)
+        update_ordered(s, p, d, nd, nb, MEASURE_ORDERED);
+    else if (measure & MEASURE_ORDERED)
+        update_ordered(s, p, d, nd, nb, measure);
+
+    p->last = d[nb - 1];
+    p->nb_samples += nb;
 }
 
 static inline void update_float_stat(AudioStatsContext *s, ChannelStats *p, float d)
@@ -553,79 +695,68 @@ static void set_metadata(AudioStatsContext *s, AVDictionary **metadata)
         set_meta(metadata, 0, "Number of denormals", "%f", nb_denormals / (float)s->nb_channels);
 }
 
-#define UPDATE_STATS_P(type, update_func, update_float, channel_func)           \
-    for (int c = start; c < end; c++) {                                         \
-        ChannelStats *p = &s->chstats[c];                                       \
-        const type *src = (const type *)data[c];                                \
-        const type * const srcend = src + samples;                              \
-        for (; src < srcend; src++) {                                           \
-            update_func;                                                        \
-            update_float;                                                       \
+#define LOAD_BLOCK(type, int_sample, update_float)                              \
+    {                                                                           \
+        const type *src = (const type *)data + offset + n * stride;             \
+                                                                                \
+        for (int k = 0; k < nb; k++)                                            \
+            d[k] = src[k * stride];                                             \
+        if (s->measure & MEASURE_BIT_DEPTH) {                                   \
+            for (int k = 0; k < nb; k++)                                        \
+                i[k] = int_sample(src[k * stride]);                             \
         }                                                                       \
-        channel_func;                                                           \
-    }
-
-#define UPDATE_STATS_I(type, update_func, update_float, channel_func)           \
-    for (int c = start; c < end; c++) {                                         \
-        ChannelStats *p = &s->chstats[c];                                       \
-        const type *src = (const type *)data[0];                                \
-        const type * const srcend = src + samples * channels;                   \
-        for (src += c; src < srcend; src += channels) {                         \
-            update_func;                                                        \
-            update_float;                                                       \
+        if (s->measure & MEASURE_FP_CLASSES) {                                  \
+            for (int k = 0; k < nb; k++)                                        \
+                update_float(s, p, src[k * stride]);                            \
         }                                                                       \
-        channel_func;                                                           \
     }
 
-#define UPDATE_STATS(planar, type, sample, normalizer_suffix, int_sample) \
-    if ((s->measure_overall | s->measure_perchannel) & ~MEASURE_MINMAXPEAK) {                          \
-        UPDATE_STATS_##planar(type, update_stat(s, p, sample, sample normalizer_suffix, int_sample), s->is_float ? update_float_stat(s, p, sample) : s->is_double ? update_double_stat(s, p, sample) : (void)NULL, ); \
-    } else {                                                                                           \
-        UPDATE_STATS_##planar(type, update_minmax(s, p, sample), , p->nmin = p->min normalizer_suffix; p->nmax = p->max normalizer_suffix;); \
-    }
+#define DBL_TO_INT(x) llrint((x) * (UINT64_C(1) << 63))
+#define FLT_TO_INT(x) llrint((x) * (UINT64_C(1) << 31))
+#define INT_TO_INT(x) (x)
+#define NO_FLOAT_STAT(s, p, x)
 
 static int filter_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
     AudioStatsContext *s = ctx->priv;
     AVFilterLink *inlink = ctx->inputs[0];
     AVFrame *buf = arg;
-    const uint8_t * const * const data = (const uint8_t * const *)buf->extended_data;
-    const int channels = s->nb_channels;
+    const int planar = av_sample_fmt_is_planar(inlink->format);
+    const int stride = planar ? 1 : s->nb_channels;
     const int samples = buf->nb_samples;
     const int start = (buf->channels * jobnr) / nb_jobs;
     const int end = (buf->channels * (jobnr+1)) / nb_jobs;
+    double d[BLOCK_SIZE];
+    int64_t i[BLOCK_SIZE];
+
+    for (int c = start; c < end; c++) {
+        ChannelStats *p = &s->chstats[c];
+        const uint8_t *data = buf->extended_data[planar ? c : 0];
+        const int offset = planar ? 0 : c;
+
+        for (int n = 0; n < samples; n += BLOCK_SIZE) {
+            const int nb = FFMIN(samples - n, BLOCK_SIZE);
+
+            switch (av_get_packed_sample_fmt(inlink->format)) {
+            case AV_SAMPLE_FMT_DBL:
+                LOAD_BLOCK(double,  DBL_TO_INT, update_double_stat);
+                break;
+            case AV_SAMPLE_FMT_FLT:
+                LOAD_BLOCK(float,   FLT_TO_INT, update_float_stat);
+                break;
+            case AV_SAMPLE_FMT_S64:
+                LOAD_BLOCK(int64_t, INT_TO_INT, NO_FLOAT_STAT);
+                break;
+            case AV_SAMPLE_FMT_S32:
+                LOAD_BLOCK(int32_t, INT_TO_INT, NO_FLOAT_STAT);
+                break;
+            case AV_SAMPLE_FMT_S16:
+                LOAD_BLOCK(int16_t, INT_TO_INT, NO_FLOAT_STAT);
+                break;
+            }
 
-    switch (inlink->format) {
-    case AV_SAMPLE_FMT_DBLP:
-        UPDATE_STATS(P, double, *src, , llrint(*src * (UINT64_C(1) << 63)));
-        break;
-    case AV_SAMPLE_FMT_DBL:
-        UPDATE_STATS(I, double, *src, , llrint(*src * (UINT64_C(1) << 63)));
-        break;
-    case AV_SAMPLE_FMT_FLTP:
-        UPDATE_STATS(P, float, *src, , llrint(*src * (UINT64_C(1) << 31)));
-        break;
-    case AV_SAMPLE_FMT_FLT:
-        UPDATE_STATS(I, float, *src, , llrint(*src * (UINT64_C(1) << 31)));
-        break;
-    case AV_SAMPLE_FMT_S64P:
-        UPDATE_STATS(P, int64_t, *src, / (double)INT64_MAX, *src);
-        break;
-    case AV_SAMPLE_FMT_S64:
-        UPDATE_STATS(I, int64_t, *src, / (double)INT64_MAX, *src);
-        break;
-    case AV_SAMPLE_FMT_S32P:
-        UPDATE_STATS(P, int32_t, *src, / (double)INT32_MAX, *src);
-        break;
-    case AV_SAMPLE_FMT_S32:
-        UPDATE_STATS(I, int32_t, *src, / (double)INT32_MAX, *src);
-        break;
-    case AV_SAMPLE_FMT_S16P:
-        UPDATE_STATS(P, int16_t, *src, / (double)INT16_MAX, *src);
-        break;
-    case AV_SAMPLE_FMT_S16:
-        UPDATE_STATS(I, int16_t, *src, / (double)INT16_MAX, *src);
-        break;
+            update_stats(s, p, d, i, nb);
+        }
     }
 
     return 0;
@@ -814,6 +945,7 @@ static av_cold void uninit(AVFilterContext *ctx)
             ChannelStats *p = &s->chstats[i];
 
             av_freep(&p->win_samples);
+            av_freep(&p->win_suffix_max);
         }
     }
     av_freep(&s->chstats);
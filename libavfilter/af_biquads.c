@@ -64,7 +64,9 @@
 
 #include "libavutil/avassert.h"
 #include "libavutil/ffmath.h"
+#include "libavutil/mem_internal.h"
 #include "libavutil/opt.h"
+#include "af_biquadsdsp.h"
 #include "audio.h"
 #include "avfilter.h"
 #include "internal.h"
@@ -140,6 +142,11 @@ typedef struct BiquadsContext {
                    double *i1, double *i2, double *o1, double *o2,
                    double b0, double b1, double b2, double a1, double a2, int *clippings,
                    int disabled);
+
+    BiquadsDSPContext dsp;
+    /* filters BIQUADS_LANES channels at once, NULL if unsupported */
+    void (*filter_lanes)(double *buf, int len, double *state, const double *coeffs);
+    DECLARE_ALIGNED(32, double, coeffs)[5 * BIQUADS_LANES];
 } BiquadsContext;
 
 static int query_formats(AVFilterContext *ctx)
@@ -433,6 +440,103 @@ BIQUAD_LATT_FILTER(s32, int32_t, INT32_MIN, INT32_MAX, 1)
 BIQUAD_LATT_FILTER(flt, float,   -1., 1., 0)
 BIQUAD_LATT_FILTER(dbl, double,  -1., 1., 0)
 
+/* The lane filters evaluate the expressions of the scalar filters above
+ * in the same order, so that both give bit identical output. */
+static void biquad_di_lanes_c(double *buf, int len, double *state,
+                              const double *coeffs)
+{
+    for (int c = 0; c < BIQUADS_LANES; c++) {
+        const double b0 = coeffs[0 * BIQUADS_LANES + c];
+        const double b1 = coeffs[1 * BIQUADS_LANES + c];
+        const double b2 = coeffs[2 * BIQUADS_LANES + c];
+        const double a1 = coeffs[3 * BIQUADS_LANES + c];
+        const double a2 = coeffs[4 * BIQUADS_LANES + c];
+        double i1 = state[0 * BIQUADS_LANES + c];
+        double i2 = state[1 * BIQUADS_LANES + c];
+        double o1 = state[2 * BIQUADS_LANES + c];
+        double o2 = state[3 * BIQUADS_LANES + c];
+
+        for (int i = 0; i < len; i++) {
+            double *x = &buf[i * BIQUADS_LANES + c];
+            double out = i2 * b2 + i1 * b1 + *x * b0 + o2 * a2 + o1 * a1;
+
+            i2 = i1;
+            i1 = *x;
+            o2 = o1;
+            o1 = out;
+            *x = out;
+        }
+
+        state[0 * BIQUADS_LANES + c] = i1;
+        state[1 * BIQUADS_LANES + c] = i2;
+        state[2 * BIQUADS_LANES + c] = o1;
+        state[3 * BIQUADS_LANES + c] = o2;
+    }
+}
+
+static void biquad_dii_lanes_c(double *buf, int len, double *state,
+                               const double *coeffs)
+{
+    for (int c = 0; c < BIQUADS_LANES; c++) {
+        const double b0 = coeffs[0 * BIQUADS_LANES + c];
+        const double b1 = coeffs[1 * BIQUADS_LANES + c];
+        const double b2 = coeffs[2 * BIQUADS_LANES + c];
+        const double a1 = coeffs[3 * BIQUADS_LANES + c];
+        const double a2 = coeffs[4 * BIQUADS_LANES + c];
+        double w1 = state[0 * BIQUADS_LANES + c];
+        double w2 = state[1 * BIQUADS_LANES + c];
+
+        for (int i = 0; i < len; i++) {
+            double *x = &buf[i * BIQUADS_LANES + c];
+            double w0 = *x + a1 * w1 + a2 * w2;
+
+            *x = b0 * w0 + b1 * w1 + b2 * w2;
+            w2 = w1;
+            w1 = w0;
+        }
+
+        state[0 * BIQUADS_LANES + c] = w1;
+        state[1 * BIQUADS_LANES + c] = w2;
+    }
+}
+
+static void biquad_tdii_lanes_c(double *buf, int len, double *state,
+                                const double *coeffs)
+{
+    for (int c = 0; c < BIQUADS_LANES; c++) {
+        const double b0 = coeffs[0 * BIQUADS_LANES + c];
+        const double b1 = coeffs[1 * BIQUADS_LANES + c];
+        const double b2 = coeffs[2 * BIQUADS_LANES + c];
+        const double a1 = coeffs[3 * BIQUADS_LANES + c];
+        const double a2 = coeffs[4 * BIQUADS_LANES + c];
+        double w1 = state[0 * BIQUADS_LANES + c];
+        double w2 = state[1 * BIQUADS_LANES + c];
+
+        for (int i = 0; i < len; i++) {
+            double *x = &buf[i * BIQUADS_LANES + c];
+            double in = *x;
+            double out = b0 * in + w1;
+
+            w1 = b1 * in + w2 + a1 * out;
+            w2 = b2 * in + a2 * out;
+            *x = out;
+        }
+
+        state[0 * BIQUADS_LANES + c] = w1;
+        state[1 * BIQUADS_LANES + c] = w2;
+    }
+}
+
+av_cold void ff_biquads_init(BiquadsDSPContext *dsp)
+{
+    dsp->filter_di   = biquad_di_lanes_c;
+    dsp->filter_dii  = biquad_dii_lanes_c;
+    dsp->filter_tdii = biquad_tdii_lanes_c;
+
+    if (ARCH_X86)
+        ff_biquads_init_x86(dsp);
+}
+
 static void convert_dir2latt(BiquadsContext *s)
 {
     double k0, k1, v0, v1, v2;
@@ -747,6 +851,24 @@ static int config_filter(AVFilterLink *outlink, int reset)
      if (s->transform_type == LATT)
          convert_dir2latt(s);
 
+    s->filter_lanes = NULL;
+    if (inlink->format == AV_SAMPLE_FMT_FLTP ||
+        inlink->format == AV_SAMPLE_FMT_DBLP) {
+        switch (s->transform_type) {
+        case DI:   s->filter_lanes = s->dsp.filter_di;   break;
+        case DII:  s->filter_lanes = s->dsp.filter_dii;  break;
+        case TDII: s->filter_lanes = s->dsp.filter_tdii; break;
+        }
+    }
+
+    for (int c = 0; c < BIQUADS_LANES; c++) {
+        s->coeffs[0 * BIQUADS_LANES + c] =  s->b0;
+        s->coeffs[1 * BIQUADS_LANES + c] =  s->b1;
+        s->coeffs[2 * BIQUADS_LANES + c] =  s->b2;
+        s->coeffs[3 * BIQUADS_LANES + c] = -s->a1;
+        s->coeffs[4 * BIQUADS_LANES + c] = -s->a2;
+    }
+
     return 0;
 }
 
@@ -759,6 +881,86 @@ typedef struct ThreadData {
     AVFrame *in, *out;
 } ThreadData;
 
+#define LANES_BLOCK 256
+
+/**
+ * Filter the channels listed in chs, interleaving them so that they are
+ * processed together by s->filter_lanes().
+ */
+static void filter_lanes(AVFilterContext *ctx, AVFrame *in, AVFrame *out,
+                         const int *chs)
+{
+    BiquadsContext *s = ctx->priv;
+    LOCAL_ALIGNED_32(double, buf,   [BIQUADS_LANES * LANES_BLOCK]);
+    LOCAL_ALIGNED_32(double, state, [4 * BIQUADS_LANES]);
+    const int nb_samples = in->nb_samples;
+    /* the direct form I filter evaluates a trailing odd sample differently */
+    const int len = s->transform_type == DI ? nb_samples & ~1 : nb_samples;
+    const double wet = s->mix;
+    const double dry = 1. - wet;
+    int c, i, n;
+
+    for (c = 0; c < BIQUADS_LANES; c++) {
+        ChanCache *cache = &s->cache[chs[c]];
+
+        state[0 * BIQUADS_LANES + c] = cache->i1;
+        state[1 * BIQUADS_LANES + c] = cache->i2;
+        state[2 * BIQUADS_LANES + c] = cache->o1;
+        state[3 * BIQUADS_LANES + c] = cache->o2;
+    }
+
+    for (n = 0; n < len; n += LANES_BLOCK) {
+        const int block = FFMIN(len - n, LANES_BLOCK);
+
+        for (c = 0; c < BIQUADS_LANES; c++) {
+            if (s->block_align == sizeof(float)) {
+                const float *src = (const float *)in->extended_data[chs[c]] + n;
+
+                for (i = 0; i < block; i++)
+                    buf[i * BIQUADS_LANES + c] = src[i];
+            } else {
+                const double *src = (const double *)in->extended_data[chs[c]] + n;
+
+                for (i = 0; i < block; i++)
+                    buf[i * BIQUADS_LANES + c] = src[i];
+            }
+        }
+
+        s->filter_lanes(buf, block, state, s->coeffs);
+
+        for (c = 0; c < BIQUADS_LANES; c++) {
+            if (s->block_align == sizeof(float)) {
+                const float *src = (const float *)in->extended_data[chs[c]] + n;
+                float *dst = (float *)out->extended_data[chs[c]] + n;
+
+                for (i = 0; i < block; i++)
+                    dst[i] = buf[i * BIQUADS_LANES + c] * wet + src[i] * dry;
+            } else {
+                const double *src = (const double *)in->extended_data[chs[c]] + n;
+                double *dst = (double *)out->extended_data[chs[c]] + n;
+
+                for (i = 0; i < block; i++)
+                    dst[i] = buf[i * BIQUADS_LANES + c] * wet + src[i] * dry;
+            }
+        }
+    }
+
+    for (c = 0; c < BIQUADS_LANES; c++) {
+        ChanCache *cache = &s->cache[chs[c]];
+
+        cache->i1 = state[0 * BIQUADS_LANES + c];
+        cache->i2 = state[1 * BIQUADS_LANES + c];
+        cache->o1 = state[2 * BIQUADS_LANES + c];
+        cache->o2 = state[3 * BIQUADS_LANES + c];
+
+        if (len < nb_samples)
+            s->filter(s, in->extended_data[chs[c]] + len * s->block_align,
+                      out->extended_data[chs[c]] + len * s->block_align, nb_samples - len,
+                      &cache->i1, &cache->i2, &cache->o1, &cache->o2,
+                      s->b0, s->b1, s->b2, s->a1, s->a2, &cache->clippings, 0);
+    }
+}
+
 static int filter_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
     AVFilterLink *inlink = ctx->inputs[0];
@@ -766,10 +968,20 @@ static int filter_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_job
     AVFrame *buf = td->in;
     AVFrame *out_buf = td->out;
     BiquadsContext *s = ctx->priv;
-    const int start = (buf->channels * jobnr) / nb_jobs;
-    const int end = (buf->channels * (jobnr+1)) / nb_jobs;
+    const int use_lanes = s->filter_lanes && !ctx->is_disabled;
+    int start = (buf->channels * jobnr) / nb_jobs;
+    int end = (buf->channels * (jobnr+1)) / nb_jobs;
+    int chs[BIQUADS_LANES], nb_chs = 0;
     int ch;
 
+    if (use_lanes) {
+        /* split on lane boundaries so that whole groups go to each job */
+        const int nb_groups = (buf->channels + BIQUADS_LANES - 1) / BIQUADS_LANES;
+
+        start = FFMIN(buf->channels, BIQUADS_LANES * ((nb_groups *  jobnr)    / nb_jobs));
+        end   = FFMIN(buf->channels, BIQUADS_LANES * ((nb_groups * (jobnr+1)) / nb_jobs));
+    }
+
     for (ch = start; ch < end; ch++) {
         if (!((av_channel_layout_extract_channel(inlink->channel_layout, ch) & s->channels))) {
             if (buf != out_buf)
@@ -778,11 +990,27 @@ static int filter_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_job
             continue;
         }
 
+        if (use_lanes) {
+            chs[nb_chs++] = ch;
+            if (nb_chs == BIQUADS_LANES) {
+                filter_lanes(ctx, buf, out_buf, chs);
+                nb_chs = 0;
+            }
+            continue;
+        }
+
         s->filter(s, buf->extended_data[ch], out_buf->extended_data[ch], buf->nb_samples,
                   &s->cache[ch].i1, &s->cache[ch].i2, &s->cache[ch].o1, &s->cache[ch].o2,
                   s->b0, s->b1, s->b2, s->a1, s->a2, &s->cache[ch].clippings, ctx->is_disabled);
     }
 
+    for (int i = 0; i < nb_chs; i++) {
+        ch = chs[i];
+        s->filter(s, buf->extended_data[ch], out_buf->extended_data[ch], buf->nb_samples,
+                  &s->cache[ch].i1, &s->cache[ch].i2, &s->cache[ch].o1, &s->cache[ch].o2,
+                  s->b0, s->b1, s->b2, s->a1, s->a2, &s->cache[ch].clippings, 0);
+    }
+
     return 0;
 }
 
@@ -874,6 +1102,7 @@ static av_cold int name_##_init(AVFilterContext *ctx)                   \
 {                                                                       \
     BiquadsContext *s = ctx->priv;                                      \
     s->filter_type = name_;                                             \
+    ff_biquads_init(&s->dsp);                                           \
     return 0;                                                           \
 }                                                                       \
                                                          \
@@ -0,0 +1,50 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_BIQUADSDSP_H
+#define AVFILTER_BIQUADSDSP_H
+
+/**
+ * Number of channels filtered at once by the BiquadsDSPContext functions.
+ */
+#define BIQUADS_LANES 4
+
+/**
+ * The functions below run one biquad section in place over len samples of
+ * BIQUADS_LANES channels, interleaved sample by sample in buf. The filters
+ * using them are made of a single section; there is no cascade of sections.
+ *
+ * coeffs holds b0, b1, b2, -a1 and -a2, each repeated BIQUADS_LANES times.
+ * state holds the filter state variables, each repeated BIQUADS_LANES times:
+ * i1, i2, o1, o2 for direct form I and z1, z2 for the direct form II variants.
+ */
+typedef struct BiquadsDSPContext {
+    /**
+     * Direct form I, len must be even.
+     */
+    void (*filter_di)(double *buf, int len, double *state, const double *coeffs);
+
+    void (*filter_dii)(double *buf, int len, double *state, const double *coeffs);
+
+    void (*filter_tdii)(double *buf, int len, double *state, const double *coeffs);
+} BiquadsDSPContext;
+
+void ff_biquads_init(BiquadsDSPContext *dsp);
+void ff_biquads_init_x86(BiquadsDSPContext *dsp);
+
+#endif /* AVFILTER_BIQUADSDSP_H */
@@ -172,14 +172,39 @@ static double get_volume(CompandContext *s, double in_lin)
     return exp(out_log);
 }
 
-static int compand_nodelay(AVFilterContext *ctx, AVFrame *frame)
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int out_start;              ///< index of the first input sample producing output
+} ThreadData;
+
+static int compand_nodelay_channels(AVFilterContext *ctx, void *arg, int start, int end)
 {
     CompandContext *s    = ctx->priv;
+    ThreadData *td       = arg;
+    const int nb_samples = td->in->nb_samples;
+    int chan, i;
+
+    for (chan = start; chan < end; chan++) {
+        const double *src = (double *)td->in->extended_data[chan];
+        double *dst = (double *)td->out->extended_data[chan];
+        ChanParam *cp = &s->channels[chan];
+
+        for (i = 0; i < nb_samples; i++) {
+            update_volume(cp, fabs(src[i]));
+
+            dst[i] = src[i] * get_volume(s, cp->volume);
+        }
+    }
+
+    return 0;
+}
+
+static int compand_nodelay(AVFilterContext *ctx, AVFrame *frame)
+{
     AVFilterLink *inlink = ctx->inputs[0];
-    const int channels   = inlink->channels;
     const int nb_samples = frame->nb_samples;
     AVFrame *out_frame;
-    int chan, i;
+    ThreadData td;
     int err;
 
     if (av_frame_is_writable(frame)) {
@@ -198,17 +223,9 @@ static int compand_nodelay(AVFilterContext *ctx, AVFrame *frame)
         }
     }
 
-    for (chan = 0; chan < channels; chan++) {
-        const double *src = (double *)frame->extended_data[chan];
-        double *dst = (double *)out_frame->extended_data[chan];
-        ChanParam *cp = &s->channels[chan];
-
-        for (i = 0; i < nb_samples; i++) {
-            update_volume(cp, fabs(src[i]));
-
-            dst[i] = src[i] * get_volume(s, cp->volume);
-        }
-    }
+    td.in  = frame;
+    td.out = out_frame;
+    ff_filter_execute_channels(ctx, compand_nodelay_channels, &td, inlink->channels);
 
     if (frame != out_frame)
         av_frame_free(&frame);
@@ -218,14 +235,46 @@ static int compand_nodelay(AVFilterContext *ctx, AVFrame *frame)
 
 #define MOD(a, b) (((a) >= (b)) ? (a) - (b) : (a))
 
+static int compand_delay_channels(AVFilterContext *ctx, void *arg, int start, int end)
+{
+    CompandContext *s    = ctx->priv;
+    ThreadData *td       = arg;
+    const int nb_samples = td->in->nb_samples;
+    int chan, i, dindex;
+
+    for (chan = start; chan < end; chan++) {
+        AVFrame *delay_frame = s->delay_frame;
+        const double *src    = (double *)td->in->extended_data[chan];
+        double *dbuf         = (double *)delay_frame->extended_data[chan];
+        double *dst          = td->out ? (double *)td->out->extended_data[chan] : NULL;
+        ChanParam *cp        = &s->channels[chan];
+
+        dindex = s->delay_index;
+        for (i = 0; i < nb_samples; i++) {
+            const double in = src[i];
+            update_volume(cp, fabs(in));
+
+            if (i >= td->out_start)
+                dst[i - td->out_start] = dbuf[dindex] * get_volume(s, cp->volume);
+
+            dbuf[dindex] = in;
+            dindex = MOD(dindex + 1, s->delay_samples);
+        }
+    }
+
+    return 0;
+}
+
 static int compand_delay(AVFilterContext *ctx, AVFrame *frame)
 {
     CompandContext *s    = ctx->priv;
     AVFilterLink *inlink = ctx->inputs[0];
     const int channels = inlink->channels;
     const int nb_samples = frame->nb_samples;
-    int chan, i, av_uninit(dindex), oindex, av_uninit(count);
+    /* the output starts once the delay line is full */
+    const int out_start = FFMAX(s->delay_samples - s->delay_count, 0);
     AVFrame *out_frame   = NULL;
+    ThreadData td;
     int err;
 
     if (s->pts == AV_NOPTS_VALUE) {
@@ -234,51 +283,31 @@ static int compand_delay(AVFilterContext *ctx, AVFrame *frame)
 
     av_assert1(channels > 0); /* would corrupt delay_count and delay_index */
 
-    for (chan = 0; chan < channels; chan++) {
-        AVFrame *delay_frame = s->delay_frame;
-        const double *src    = (double *)frame->extended_data[chan];
-        double *dbuf         = (double *)delay_frame->extended_data[chan];
-        ChanParam *cp        = &s->channels[chan];
-        double *dst;
-
-        count  = s->delay_count;
-        dindex = s->delay_index;
-        for (i = 0, oindex = 0; i < nb_samples; i++) {
-            const double in = src[i];
-            update_volume(cp, fabs(in));
-
-            if (count >= s->delay_samples) {
-                if (!out_frame) {
-                    out_frame = ff_get_audio_buffer(ctx->outputs[0], nb_samples - i);
-                    if (!out_frame) {
-                        av_frame_free(&frame);
-                        return AVERROR(ENOMEM);
-                    }
-                    err = av_frame_copy_props(out_frame, frame);
-                    if (err < 0) {
-                        av_frame_free(&out_frame);
-                        av_frame_free(&frame);
-                        return err;
-                    }
-                    out_frame->pts = s->pts;
-                    s->pts += av_rescale_q(nb_samples - i,
-                        (AVRational){ 1, inlink->sample_rate },
-                        inlink->time_base);
-                }
-
-                dst = (double *)out_frame->extended_data[chan];
-                dst[oindex++] = dbuf[dindex] * get_volume(s, cp->volume);
-            } else {
-                count++;
-            }
-
-            dbuf[dindex] = in;
-            dindex = MOD(dindex + 1, s->delay_samples);
+    if (out_start < nb_samples) {
+        out_frame = ff_get_audio_buffer(ctx->outputs[0], nb_samples - out_start);
+        if (!out_frame) {
+            av_frame_free(&frame);
+            return AVERROR(ENOMEM);
         }
+        err = av_frame_copy_props(out_frame, frame);
+        if (err < 0) {
+            av_frame_free(&out_frame);
+            av_frame_free(&frame);
+            return err;
+        }
+        out_frame->pts = s->pts;
+        s->pts += av_rescale_q(nb_samples - out_start,
+            (AVRational){ 1, inlink->sample_rate },
+            inlink->time_base);
     }
 
-    s->delay_count = count;
-    s->delay_index = dindex;
+    td.in        = frame;
+    td.out       = out_frame;
+    td.out_start = out_start;
+    ff_filter_execute_channels(ctx, compand_delay_channels, &td, channels);
+
+    s->delay_count = FFMIN(s->delay_count + nb_samples, s->delay_samples);
+    s->delay_index = (s->delay_index + nb_samples) % s->delay_samples;
 
     av_frame_free(&frame);
 
@@ -596,4 +625,5 @@ AVFilter ff_af_compand = {
     .uninit         = uninit,
     .inputs         = compand_inputs,
     .outputs        = compand_outputs,
+    .flags          = AVFILTER_FLAG_SLICE_THREADS,
 };
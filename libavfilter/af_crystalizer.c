@@ -29,7 +29,7 @@ typedef struct CrystalizerContext {
     float mult;
     int clip;
     AVFrame *prev;
-    int (*filter)(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs);
+    ff_channels_func filter;
 } CrystalizerContext;
 
 #define OFFSET(x) offsetof(CrystalizerContext, x)
@@ -83,7 +83,7 @@ typedef struct ThreadData {
     int clip;
 } ThreadData;
 
-static int filter_flt(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+static int filter_flt(AVFilterContext *ctx, void *arg, int start, int end)
 {
     ThreadData *td = arg;
     void **d = td->d;
@@ -93,8 +93,6 @@ static int filter_flt(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
     const int channels = td->channels;
     const float mult = td->mult;
     const int clip = td->clip;
-    const int start = (channels * jobnr) / nb_jobs;
-    const int end = (channels * (jobnr+1)) / nb_jobs;
     float *prv = p[0];
     int n, c;
 
@@ -118,7 +116,7 @@ static int filter_flt(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
     return 0;
 }
 
-static int filter_dbl(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+static int filter_dbl(AVFilterContext *ctx, void *arg, int start, int end)
 {
     ThreadData *td = arg;
     void **d = td->d;
@@ -128,8 +126,6 @@ static int filter_dbl(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
     const int channels = td->channels;
     double mult = td->mult;
     const int clip = td->clip;
-    const int start = (channels * jobnr) / nb_jobs;
-    const int end = (channels * (jobnr+1)) / nb_jobs;
     double *prv = p[0];
     int n, c;
 
@@ -154,18 +150,15 @@ static int filter_dbl(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
     return 0;
 }
 
-static int filter_fltp(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+static int filter_fltp(AVFilterContext *ctx, void *arg, int start, int end)
 {
     ThreadData *td = arg;
     void **d = td->d;
     void **p = td->p;
     const void **s = td->s;
     const int nb_samples = td->nb_samples;
-    const int channels = td->channels;
     float mult = td->mult;
     const int clip = td->clip;
-    const int start = (channels * jobnr) / nb_jobs;
-    const int end = (channels * (jobnr+1)) / nb_jobs;
     int n, c;
 
     for (c = start; c < end; c++) {
@@ -187,18 +180,15 @@ static int filter_fltp(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
     return 0;
 }
 
-static int filter_dblp(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+static int filter_dblp(AVFilterContext *ctx, void *arg, int start, int end)
 {
     ThreadData *td = arg;
     void **d = td->d;
     void **p = td->p;
     const void **s = td->s;
     const int nb_samples = td->nb_samples;
-    const int channels = td->channels;
     const double mult = td->mult;
     const int clip = td->clip;
-    const int start = (channels * jobnr) / nb_jobs;
-    const int end = (channels * (jobnr+1)) / nb_jobs;
     int n, c;
 
     for (c = start; c < end; c++) {
@@ -220,7 +210,7 @@ static int filter_dblp(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
     return 0;
 }
 
-static int ifilter_flt(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+static int ifilter_flt(AVFilterContext *ctx, void *arg, int start, int end)
 {
     ThreadData *td = arg;
     void **d = td->d;
@@ -231,8 +221,6 @@ static int ifilter_flt(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
     const float mult = -td->mult;
     const float div = -td->mult + 1.f;
     const int clip = td->clip;
-    const int start = (channels * jobnr) / nb_jobs;
-    const int end = (channels * (jobnr+1)) / nb_jobs;
     float *prv = p[0];
     int n, c;
 
@@ -256,7 +244,7 @@ static int ifilter_flt(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
     return 0;
 }
 
-static int ifilter_dbl(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+static int ifilter_dbl(AVFilterContext *ctx, void *arg, int start, int end)
 {
     ThreadData *td = arg;
     void **d = td->d;
@@ -267,8 +255,6 @@ static int ifilter_dbl(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
     const double mult = -td->mult;
     const double div = -td->mult + 1.f;
     const int clip = td->clip;
-    const int start = (channels * jobnr) / nb_jobs;
-    const int end = (channels * (jobnr+1)) / nb_jobs;
     double *prv = p[0];
     int n, c;
 
@@ -293,19 +279,16 @@ static int ifilter_dbl(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
     return 0;
 }
 
-static int ifilter_fltp(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+static int ifilter_fltp(AVFilterContext *ctx, void *arg, int start, int end)
 {
     ThreadData *td = arg;
     void **d = td->d;
     void **p = td->p;
     const void **s = td->s;
     const int nb_samples = td->nb_samples;
-    const int channels = td->channels;
     const float mult = -td->mult;
     const float div = -td->mult + 1.f;
     const int clip = td->clip;
-    const int start = (channels * jobnr) / nb_jobs;
-    const int end = (channels * (jobnr+1)) / nb_jobs;
     int n, c;
 
     for (c = start; c < end; c++) {
@@ -327,19 +310,16 @@ static int ifilter_fltp(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
     return 0;
 }
 
-static int ifilter_dblp(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+static int ifilter_dblp(AVFilterContext *ctx, void *arg, int start, int end)
 {
     ThreadData *td = arg;
     void **d = td->d;
     void **p = td->p;
     const void **s = td->s;
     const int nb_samples = td->nb_samples;
-    const int channels = td->channels;
     const double mult = -td->mult;
     const double div = -td->mult + 1.f;
     const int clip = td->clip;
-    const int start = (channels * jobnr) / nb_jobs;
-    const int end = (channels * (jobnr+1)) / nb_jobs;
     int n, c;
 
     for (c = start; c < end; c++) {
@@ -410,8 +390,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     td.channels = in->channels;
     td.mult = ctx->is_disabled ? 0.f : s->mult;
     td.clip = s->clip;
-    ctx->internal->execute(ctx, s->filter, &td, NULL, FFMIN(inlink->channels,
-                                                            ff_filter_get_nb_threads(ctx)));
+    ff_filter_execute_channels(ctx, s->filter, &td, inlink->channels);
 
     if (out != in)
         av_frame_free(&in);
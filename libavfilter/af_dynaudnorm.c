@@ -540,26 +540,23 @@ static inline double update_value(double new, double old, double aggressiveness)
     return aggressiveness * new + (1.0 - aggressiveness) * old;
 }
 
-static void perform_dc_correction(DynamicAudioNormalizerContext *s, AVFrame *frame)
+static void perform_dc_correction(DynamicAudioNormalizerContext *s, AVFrame *frame,
+                                  int c, int is_first_frame)
 {
     const double diff = 1.0 / frame->nb_samples;
-    int is_first_frame = cqueue_empty(s->gain_history_original[0]);
-    int c, i;
-
-    for (c = 0; c < s->channels; c++) {
-        double *dst_ptr = (double *)frame->extended_data[c];
-        double current_average_value = 0.0;
-        double prev_value;
+    double *dst_ptr = (double *)frame->extended_data[c];
+    double current_average_value = 0.0;
+    double prev_value;
+    int i;
 
-        for (i = 0; i < frame->nb_samples; i++)
-            current_average_value += dst_ptr[i] * diff;
+    for (i = 0; i < frame->nb_samples; i++)
+        current_average_value += dst_ptr[i] * diff;
 
-        prev_value = is_first_frame ? current_average_value : s->dc_correction_value[c];
-        s->dc_correction_value[c] = is_first_frame ? current_average_value : update_value(current_average_value, s->dc_correction_value[c], 0.1);
+    prev_value = is_first_frame ? current_average_value : s->dc_correction_value[c];
+    s->dc_correction_value[c] = is_first_frame ? current_average_value : update_value(current_average_value, s->dc_correction_value[c], 0.1);
 
-        for (i = 0; i < frame->nb_samples; i++) {
-            dst_ptr[i] -= fade(prev_value, s->dc_correction_value[c], i, frame->nb_samples);
-        }
+    for (i = 0; i < frame->nb_samples; i++) {
+        dst_ptr[i] -= fade(prev_value, s->dc_correction_value[c], i, frame->nb_samples);
     }
 }
 
@@ -612,86 +609,122 @@ static double compute_frame_std_dev(DynamicAudioNormalizerContext *s,
     return FFMAX(sqrt(variance), DBL_EPSILON);
 }
 
-static void perform_compression(DynamicAudioNormalizerContext *s, AVFrame *frame)
+static void apply_compression(AVFrame *frame, int c, double prev_actual_thresh,
+                              double curr_actual_thresh)
 {
-    int is_first_frame = cqueue_empty(s->gain_history_original[0]);
-    int c, i;
+    double *const dst_ptr = (double *)frame->extended_data[c];
+    int i;
 
-    if (s->channels_coupled) {
-        const double standard_deviation = compute_frame_std_dev(s, frame, -1);
-        const double current_threshold  = FFMIN(1.0, s->compress_factor * standard_deviation);
+    for (i = 0; i < frame->nb_samples; i++) {
+        const double localThresh = fade(prev_actual_thresh, curr_actual_thresh, i, frame->nb_samples);
+        dst_ptr[i] = copysign(bound(localThresh, fabs(dst_ptr[i])), dst_ptr[i]);
+    }
+}
 
-        const double prev_value = is_first_frame ? current_threshold : s->compress_threshold[0];
-        double prev_actual_thresh, curr_actual_thresh;
-        s->compress_threshold[0] = is_first_frame ? current_threshold : update_value(current_threshold, s->compress_threshold[0], (1.0/3.0));
+static void perform_compression(DynamicAudioNormalizerContext *s, AVFrame *frame,
+                                int c, int is_first_frame)
+{
+    const double standard_deviation = compute_frame_std_dev(s, frame, c);
+    const double current_threshold  = setup_compress_thresh(FFMIN(1.0, s->compress_factor * standard_deviation));
 
-        prev_actual_thresh = setup_compress_thresh(prev_value);
-        curr_actual_thresh = setup_compress_thresh(s->compress_threshold[0]);
+    const double prev_value = is_first_frame ? current_threshold : s->compress_threshold[c];
+    double prev_actual_thresh, curr_actual_thresh;
+    s->compress_threshold[c] = is_first_frame ? current_threshold : update_value(current_threshold, s->compress_threshold[c], 1.0/3.0);
 
-        for (c = 0; c < s->channels; c++) {
-            double *const dst_ptr = (double *)frame->extended_data[c];
-            for (i = 0; i < frame->nb_samples; i++) {
-                const double localThresh = fade(prev_actual_thresh, curr_actual_thresh, i, frame->nb_samples);
-                dst_ptr[i] = copysign(bound(localThresh, fabs(dst_ptr[i])), dst_ptr[i]);
-            }
-        }
-    } else {
-        for (c = 0; c < s->channels; c++) {
-            const double standard_deviation = compute_frame_std_dev(s, frame, c);
-            const double current_threshold  = setup_compress_thresh(FFMIN(1.0, s->compress_factor * standard_deviation));
+    prev_actual_thresh = setup_compress_thresh(prev_value);
+    curr_actual_thresh = setup_compress_thresh(s->compress_threshold[c]);
 
-            const double prev_value = is_first_frame ? current_threshold : s->compress_threshold[c];
-            double prev_actual_thresh, curr_actual_thresh;
-            double *dst_ptr;
-            s->compress_threshold[c] = is_first_frame ? current_threshold : update_value(current_threshold, s->compress_threshold[c], 1.0/3.0);
+    apply_compression(frame, c, prev_actual_thresh, curr_actual_thresh);
+}
 
-            prev_actual_thresh = setup_compress_thresh(prev_value);
-            curr_actual_thresh = setup_compress_thresh(s->compress_threshold[c]);
+typedef struct ThreadData {
+    AVFrame *frame;
+    int is_first_frame;
+    int enabled;
+    double prev_actual_thresh;
+    double curr_actual_thresh;
+} ThreadData;
 
-            dst_ptr = (double *)frame->extended_data[c];
-            for (i = 0; i < frame->nb_samples; i++) {
-                const double localThresh = fade(prev_actual_thresh, curr_actual_thresh, i, frame->nb_samples);
-                dst_ptr[i] = copysign(bound(localThresh, fabs(dst_ptr[i])), dst_ptr[i]);
-            }
+/* everything done per channel before the channels are coupled */
+static int analyze_channels(AVFilterContext *ctx, void *arg, int start, int end)
+{
+    DynamicAudioNormalizerContext *s = ctx->priv;
+    ThreadData *td = arg;
+    int c;
+
+    for (c = start; c < end; c++) {
+        if (s->dc_correction)
+            perform_dc_correction(s, td->frame, c, td->is_first_frame);
+
+        if (!s->channels_coupled) {
+            if (s->compress_factor > DBL_EPSILON)
+                perform_compression(s, td->frame, c, td->is_first_frame);
+
+            update_gain_history(s, c, get_max_local_gain(s, td->frame, c));
         }
     }
+
+    return 0;
 }
 
-static void analyze_frame(DynamicAudioNormalizerContext *s, AVFrame *frame)
+static int compress_channels(AVFilterContext *ctx, void *arg, int start, int end)
 {
-    if (s->dc_correction) {
-        perform_dc_correction(s, frame);
-    }
+    ThreadData *td = arg;
+    int c;
 
-    if (s->compress_factor > DBL_EPSILON) {
-        perform_compression(s, frame);
-    }
+    for (c = start; c < end; c++)
+        apply_compression(td->frame, c, td->prev_actual_thresh, td->curr_actual_thresh);
+
+    return 0;
+}
+
+static void analyze_frame(AVFilterContext *ctx, AVFrame *frame)
+{
+    DynamicAudioNormalizerContext *s = ctx->priv;
+    ThreadData td;
+    int c;
+
+    td.frame          = frame;
+    td.is_first_frame = cqueue_empty(s->gain_history_original[0]);
+
+    if (s->dc_correction || !s->channels_coupled)
+        ff_filter_execute_channels(ctx, analyze_channels, &td, s->channels);
 
     if (s->channels_coupled) {
-        const local_gain gain = get_max_local_gain(s, frame, -1);
-        int c;
+        local_gain gain;
 
-        for (c = 0; c < s->channels; c++)
-            update_gain_history(s, c, gain);
-    } else {
-        int c;
+        if (s->compress_factor > DBL_EPSILON) {
+            const double standard_deviation = compute_frame_std_dev(s, frame, -1);
+            const double current_threshold  = FFMIN(1.0, s->compress_factor * standard_deviation);
+            const double prev_value = td.is_first_frame ? current_threshold : s->compress_threshold[0];
+
+            s->compress_threshold[0] = td.is_first_frame ? current_threshold : update_value(current_threshold, s->compress_threshold[0], (1.0/3.0));
+
+            td.prev_actual_thresh = setup_compress_thresh(prev_value);
+            td.curr_actual_thresh = setup_compress_thresh(s->compress_threshold[0]);
+            ff_filter_execute_channels(ctx, compress_channels, &td, s->channels);
+        }
 
+        gain = get_max_local_gain(s, frame, -1);
         for (c = 0; c < s->channels; c++)
-            update_gain_history(s, c, get_max_local_gain(s, frame, c));
+            update_gain_history(s, c, gain);
     }
 }
 
-static void amplify_frame(DynamicAudioNormalizerContext *s, AVFrame *frame, int enabled)
+static int amplify_channels(AVFilterContext *ctx, void *arg, int start, int end)
 {
+    DynamicAudioNormalizerContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *frame = td->frame;
     int c, i;
 
-    for (c = 0; c < s->channels; c++) {
+    for (c = start; c < end; c++) {
         double *dst_ptr = (double *)frame->extended_data[c];
         double current_amplification_factor;
 
         cqueue_dequeue(s->gain_history_smoothed[c], &current_amplification_factor);
 
-        for (i = 0; i < frame->nb_samples && enabled; i++) {
+        for (i = 0; i < frame->nb_samples && td->enabled; i++) {
             const double amplification_factor = fade(s->prev_amplification_factor[c],
                                                      current_amplification_factor, i,
                                                      frame->nb_samples);
@@ -701,6 +734,18 @@ static void amplify_frame(DynamicAudioNormalizerContext *s, AVFrame *frame, int
 
         s->prev_amplification_factor[c] = current_amplification_factor;
     }
+
+    return 0;
+}
+
+static void amplify_frame(AVFilterContext *ctx, AVFrame *frame, int enabled)
+{
+    DynamicAudioNormalizerContext *s = ctx->priv;
+    ThreadData td;
+
+    td.frame   = frame;
+    td.enabled = enabled;
+    ff_filter_execute_channels(ctx, amplify_channels, &td, s->channels);
 }
 
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
@@ -718,12 +763,12 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 
         cqueue_dequeue(s->is_enabled, &is_enabled);
 
-        amplify_frame(s, out, is_enabled > 0.);
+        amplify_frame(ctx, out, is_enabled > 0.);
         ret = ff_filter_frame(outlink, out);
     }
 
     av_frame_make_writable(in);
-    analyze_frame(s, in);
+    analyze_frame(ctx, in);
     if (!s->eof) {
         ff_bufqueue_add(ctx, &s->queue, in);
         cqueue_enqueue(s->is_enabled, !ctx->is_disabled);
@@ -878,6 +923,7 @@ AVFilter ff_af_dynaudnorm = {
     .inputs        = avfilter_af_dynaudnorm_inputs,
     .outputs       = avfilter_af_dynaudnorm_outputs,
     .priv_class    = &dynaudnorm_class,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL |
+                     AVFILTER_FLAG_SLICE_THREADS,
     .process_command = process_command,
 };
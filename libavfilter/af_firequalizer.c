@@ -21,7 +21,7 @@
 #include "libavutil/opt.h"
 #include "libavutil/eval.h"
 #include "libavutil/avassert.h"
-#include "libavcodec/avfft.h"
+#include "libavutil/tx.h"
 #include "avfilter.h"
 #include "internal.h"
 #include "audio.h"
@@ -65,13 +65,20 @@ typedef struct OverlapIndex {
 typedef struct FIREqualizerContext {
     const AVClass *class;
 
-    RDFTContext   *analysis_rdft;
-    RDFTContext   *analysis_irdft;
-    RDFTContext   *rdft;
-    RDFTContext   *irdft;
-    FFTContext    *fft_ctx;
-    RDFTContext   *cepstrum_rdft;
-    RDFTContext   *cepstrum_irdft;
+    AVTXContext   *analysis_rdft;
+    AVTXContext   *analysis_irdft;
+    AVTXContext   *rdft;
+    AVTXContext   *irdft;
+    AVTXContext   *fft_ctx;
+    AVTXContext   *cepstrum_rdft;
+    AVTXContext   *cepstrum_irdft;
+    av_tx_fn      analysis_rdft_fn;
+    av_tx_fn      analysis_irdft_fn;
+    av_tx_fn      rdft_fn;
+    av_tx_fn      irdft_fn;
+    av_tx_fn      fft_fn;
+    av_tx_fn      cepstrum_rdft_fn;
+    av_tx_fn      cepstrum_irdft_fn;
     int           analysis_rdft_len;
     int           rdft_len;
     int           cepstrum_len;
@@ -82,6 +89,7 @@ typedef struct FIREqualizerContext {
     float         *kernel_buf;
     float         *cepstrum_buf;
     float         *conv_buf;
+    AVComplexFloat *fft_buf;
     OverlapIndex  *conv_idx;
     int           fir_len;
     int           nsamples_max;
@@ -149,17 +157,13 @@ AVFILTER_DEFINE_CLASS(firequalizer);
 
 static void common_uninit(FIREqualizerContext *s)
 {
-    av_rdft_end(s->analysis_rdft);
-    av_rdft_end(s->analysis_irdft);
-    av_rdft_end(s->rdft);
-    av_rdft_end(s->irdft);
-    av_fft_end(s->fft_ctx);
-    av_rdft_end(s->cepstrum_rdft);
-    av_rdft_end(s->cepstrum_irdft);
-    s->analysis_rdft = s->analysis_irdft = s->rdft = s->irdft = NULL;
-    s->fft_ctx = NULL;
-    s->cepstrum_rdft = NULL;
-    s->cepstrum_irdft = NULL;
+    av_tx_uninit(&s->analysis_rdft);
+    av_tx_uninit(&s->analysis_irdft);
+    av_tx_uninit(&s->rdft);
+    av_tx_uninit(&s->irdft);
+    av_tx_uninit(&s->fft_ctx);
+    av_tx_uninit(&s->cepstrum_rdft);
+    av_tx_uninit(&s->cepstrum_irdft);
 
     av_freep(&s->analysis_buf);
     av_freep(&s->dump_buf);
@@ -167,6 +171,7 @@ static void common_uninit(FIREqualizerContext *s)
     av_freep(&s->kernel_buf);
     av_freep(&s->cepstrum_buf);
     av_freep(&s->conv_buf);
+    av_freep(&s->fft_buf);
     av_freep(&s->conv_idx);
 }
 
@@ -215,22 +220,21 @@ static void fast_convolute(FIREqualizerContext *av_restrict s, const float *av_r
     if (nsamples <= s->nsamples_max) {
         float *buf = conv_buf + idx->buf_idx * s->rdft_len;
         float *obuf = conv_buf + !idx->buf_idx * s->rdft_len + idx->overlap_idx;
+        AVComplexFloat *fft_buf = s->fft_buf;
         int center = s->fir_len/2;
         int k;
 
         memset(buf, 0, center * sizeof(*data));
         memcpy(buf + center, data, nsamples * sizeof(*data));
         memset(buf + center + nsamples, 0, (s->rdft_len - nsamples - center) * sizeof(*data));
-        av_rdft_calc(s->rdft, buf);
+        s->rdft_fn(s->rdft, fft_buf, buf, sizeof(float));
 
-        buf[0] *= kernel_buf[0];
-        buf[1] *= kernel_buf[s->rdft_len/2];
-        for (k = 1; k < s->rdft_len/2; k++) {
-            buf[2*k] *= kernel_buf[k];
-            buf[2*k+1] *= kernel_buf[k];
+        for (k = 0; k <= s->rdft_len/2; k++) {
+            fft_buf[k].re *= kernel_buf[k];
+            fft_buf[k].im *= kernel_buf[k];
         }
 
-        av_rdft_calc(s->irdft, buf);
+        s->irdft_fn(s->irdft, buf, fft_buf, sizeof(AVComplexFloat));
         for (k = 0; k < s->rdft_len - idx->overlap_idx; k++)
             buf[k] += obuf[k];
         memcpy(data, buf, nsamples * sizeof(*data));
@@ -254,23 +258,25 @@ static void fast_convolute_nonlinear(FIREqualizerContext *av_restrict s, const f
     if (nsamples <= s->nsamples_max) {
         float *buf = conv_buf + idx->buf_idx * s->rdft_len;
         float *obuf = conv_buf + !idx->buf_idx * s->rdft_len + idx->overlap_idx;
+        AVComplexFloat *fft_buf = s->fft_buf;
         int k;
 
         memcpy(buf, data, nsamples * sizeof(*data));
         memset(buf + nsamples, 0, (s->rdft_len - nsamples) * sizeof(*data));
-        av_rdft_calc(s->rdft, buf);
+        s->rdft_fn(s->rdft, fft_buf, buf, sizeof(float));
 
-        buf[0] *= kernel_buf[0];
-        buf[1] *= kernel_buf[1];
-        for (k = 2; k < s->rdft_len; k += 2) {
+        /* the kernel stores the real gains at DC and Nyquist in its first bin */
+        fft_buf[0].re *= kernel_buf[0];
+        fft_buf[s->rdft_len/2].re *= kernel_buf[1];
+        for (k = 1; k < s->rdft_len/2; k++) {
             float re, im;
-            re = buf[k] * kernel_buf[k] - buf[k+1] * kernel_buf[k+1];
-            im = buf[k] * kernel_buf[k+1] + buf[k+1] * kernel_buf[k];
-            buf[k] = re;
-            buf[k+1] = im;
+            re = fft_buf[k].re * kernel_buf[2*k] - fft_buf[k].im * kernel_buf[2*k+1];
+            im = fft_buf[k].re * kernel_buf[2*k+1] + fft_buf[k].im * kernel_buf[2*k];
+            fft_buf[k].re = re;
+            fft_buf[k].im = im;
         }
 
-        av_rdft_calc(s->irdft, buf);
+        s->irdft_fn(s->irdft, buf, fft_buf, sizeof(AVComplexFloat));
         for (k = 0; k < s->rdft_len - idx->overlap_idx; k++)
             buf[k] += obuf[k];
         memcpy(data, buf, nsamples * sizeof(*data));
@@ -287,45 +293,38 @@ static void fast_convolute_nonlinear(FIREqualizerContext *av_restrict s, const f
     }
 }
 
-static void fast_convolute2(FIREqualizerContext *av_restrict s, const float *av_restrict kernel_buf, FFTComplex *av_restrict conv_buf,
+static void fast_convolute2(FIREqualizerContext *av_restrict s, const float *av_restrict kernel_buf, AVComplexFloat *av_restrict conv_buf,
                             OverlapIndex *av_restrict idx, float *av_restrict data0, float *av_restrict data1, int nsamples)
 {
     if (nsamples <= s->nsamples_max) {
-        FFTComplex *buf = conv_buf + idx->buf_idx * s->rdft_len;
-        FFTComplex *obuf = conv_buf + !idx->buf_idx * s->rdft_len + idx->overlap_idx;
+        AVComplexFloat *buf = conv_buf + idx->buf_idx * s->rdft_len;
+        AVComplexFloat *obuf = conv_buf + !idx->buf_idx * s->rdft_len + idx->overlap_idx;
+        AVComplexFloat *fft_buf = s->fft_buf;
         int center = s->fir_len/2;
         int k;
-        float tmp;
 
-        memset(buf, 0, center * sizeof(*buf));
+        memset(fft_buf, 0, center * sizeof(*fft_buf));
         for (k = 0; k < nsamples; k++) {
-            buf[center+k].re = data0[k];
-            buf[center+k].im = data1[k];
+            fft_buf[center+k].re = data0[k];
+            fft_buf[center+k].im = data1[k];
         }
-        memset(buf + center + nsamples, 0, (s->rdft_len - nsamples - center) * sizeof(*buf));
-        av_fft_permute(s->fft_ctx, buf);
-        av_fft_calc(s->fft_ctx, buf);
+        memset(fft_buf + center + nsamples, 0, (s->rdft_len - nsamples - center) * sizeof(*fft_buf));
+        s->fft_fn(s->fft_ctx, buf, fft_buf, sizeof(AVComplexFloat));
 
         /* swap re <-> im, do backward fft using forward fft_ctx */
-        /* normalize with 0.5f */
-        tmp = buf[0].re;
-        buf[0].re = 0.5f * kernel_buf[0] * buf[0].im;
-        buf[0].im = 0.5f * kernel_buf[0] * tmp;
+        fft_buf[0].re = kernel_buf[0] * buf[0].im;
+        fft_buf[0].im = kernel_buf[0] * buf[0].re;
         for (k = 1; k < s->rdft_len/2; k++) {
             int m = s->rdft_len - k;
-            tmp = buf[k].re;
-            buf[k].re = 0.5f * kernel_buf[k] * buf[k].im;
-            buf[k].im = 0.5f * kernel_buf[k] * tmp;
-            tmp = buf[m].re;
-            buf[m].re = 0.5f * kernel_buf[k] * buf[m].im;
-            buf[m].im = 0.5f * kernel_buf[k] * tmp;
+            fft_buf[k].re = kernel_buf[k] * buf[k].im;
+            fft_buf[k].im = kernel_buf[k] * buf[k].re;
+            fft_buf[m].re = kernel_buf[k] * buf[m].im;
+            fft_buf[m].im = kernel_buf[k] * buf[m].re;
         }
-        tmp = buf[k].re;
-        buf[k].re = 0.5f * kernel_buf[k] * buf[k].im;
-        buf[k].im = 0.5f * kernel_buf[k] * tmp;
+        fft_buf[k].re = kernel_buf[k] * buf[k].im;
+        fft_buf[k].im = kernel_buf[k] * buf[k].re;
 
-        av_fft_permute(s->fft_ctx, buf);
-        av_fft_calc(s->fft_ctx, buf);
+        s->fft_fn(s->fft_ctx, buf, fft_buf, sizeof(AVComplexFloat));
 
         for (k = 0; k < s->rdft_len - idx->overlap_idx; k++) {
             buf[k].re += obuf[k].re;
@@ -363,14 +362,14 @@ static void dump_fir(AVFilterContext *ctx, FILE *fp, int ch)
     double vx, ya, yb;
 
     if (!s->min_phase) {
-        s->analysis_buf[0] *= s->rdft_len/2;
+        s->analysis_buf[0] *= s->rdft_len;
         for (x = 1; x <= center; x++) {
-            s->analysis_buf[x] *= s->rdft_len/2;
-            s->analysis_buf[s->analysis_rdft_len - x] *= s->rdft_len/2;
+            s->analysis_buf[x] *= s->rdft_len;
+            s->analysis_buf[s->analysis_rdft_len - x] *= s->rdft_len;
         }
     } else {
         for (x = 0; x < s->fir_len; x++)
-            s->analysis_buf[x] *= s->rdft_len/2;
+            s->analysis_buf[x] *= s->rdft_len;
     }
 
     if (ch)
@@ -389,17 +388,17 @@ static void dump_fir(AVFilterContext *ctx, FILE *fp, int ch)
             fprintf(fp, "%15.10f %15.10f\n", (double)x / rate, (double) s->analysis_buf[x]);
     }
 
-    av_rdft_calc(s->analysis_rdft, s->analysis_buf);
+    s->analysis_rdft_fn(s->analysis_rdft, s->analysis_buf, s->analysis_buf, sizeof(float));
 
     fprintf(fp, "\n\n# freq[%d] (frequency desired_gain actual_gain)\n", ch);
 
     for (x = 0; x <= s->analysis_rdft_len/2; x++) {
-        int i = (x == s->analysis_rdft_len/2) ? 1 : 2 * x;
+        int i = 2 * x;
         vx = (double)x * rate / s->analysis_rdft_len;
         if (xlog)
             vx = log2(0.05*vx);
         ya = s->dump_buf[i];
-        yb = s->min_phase && (i > 1) ? hypotf(s->analysis_buf[i], s->analysis_buf[i+1]) : s->analysis_buf[i];
+        yb = s->min_phase ? hypotf(s->analysis_buf[i], s->analysis_buf[i+1]) : s->analysis_buf[i];
         if (s->min_phase)
             yb = fabs(yb);
         if (ylog) {
@@ -554,41 +553,37 @@ enum VarOffset {
 static void generate_min_phase_kernel(FIREqualizerContext *s, float *rdft_buf)
 {
     int k, cepstrum_len = s->cepstrum_len, rdft_len = s->rdft_len;
-    double norm = 2.0 / cepstrum_len;
+    double norm = 1.0 / cepstrum_len;
     double minval = 1e-7 / rdft_len;
 
     memset(s->cepstrum_buf, 0, cepstrum_len * sizeof(*s->cepstrum_buf));
     memcpy(s->cepstrum_buf, rdft_buf, rdft_len/2 * sizeof(*rdft_buf));
     memcpy(s->cepstrum_buf + cepstrum_len - rdft_len/2, rdft_buf + rdft_len/2, rdft_len/2  * sizeof(*rdft_buf));
 
-    av_rdft_calc(s->cepstrum_rdft, s->cepstrum_buf);
+    s->cepstrum_rdft_fn(s->cepstrum_rdft, s->cepstrum_buf, s->cepstrum_buf, sizeof(float));
 
-    s->cepstrum_buf[0] = log(FFMAX(s->cepstrum_buf[0], minval));
-    s->cepstrum_buf[1] = log(FFMAX(s->cepstrum_buf[1], minval));
-
-    for (k = 2; k < cepstrum_len; k += 2) {
+    for (k = 0; k <= cepstrum_len; k += 2) {
         s->cepstrum_buf[k] = log(FFMAX(s->cepstrum_buf[k], minval));
         s->cepstrum_buf[k+1] = 0;
     }
 
-    av_rdft_calc(s->cepstrum_irdft, s->cepstrum_buf);
+    s->cepstrum_irdft_fn(s->cepstrum_irdft, s->cepstrum_buf, s->cepstrum_buf, sizeof(AVComplexFloat));
 
-    memset(s->cepstrum_buf + cepstrum_len/2 + 1, 0, (cepstrum_len/2 - 1) * sizeof(*s->cepstrum_buf));
-    for (k = 1; k < cepstrum_len/2; k++)
+    for (k = 1; k < cepstrum_len/2; k++) {
         s->cepstrum_buf[k] *= 2;
+        s->cepstrum_buf[cepstrum_len/2 + k] = 0;
+    }
 
-    av_rdft_calc(s->cepstrum_rdft, s->cepstrum_buf);
+    s->cepstrum_rdft_fn(s->cepstrum_rdft, s->cepstrum_buf, s->cepstrum_buf, sizeof(float));
 
-    s->cepstrum_buf[0] = exp(s->cepstrum_buf[0] * norm) * norm;
-    s->cepstrum_buf[1] = exp(s->cepstrum_buf[1] * norm) * norm;
-    for (k = 2; k < cepstrum_len; k += 2) {
+    for (k = 0; k <= cepstrum_len; k += 2) {
         double mag = exp(s->cepstrum_buf[k] * norm) * norm;
         double ph = s->cepstrum_buf[k+1] * norm;
         s->cepstrum_buf[k] = mag * cos(ph);
         s->cepstrum_buf[k+1] = mag * sin(ph);
     }
 
-    av_rdft_calc(s->cepstrum_irdft, s->cepstrum_buf);
+    s->cepstrum_irdft_fn(s->cepstrum_irdft, s->cepstrum_buf, s->cepstrum_buf, sizeof(AVComplexFloat));
     memset(rdft_buf, 0, s->rdft_len * sizeof(*rdft_buf));
     memcpy(rdft_buf, s->cepstrum_buf, s->fir_len * sizeof(*rdft_buf));
 
@@ -649,12 +644,14 @@ static int generate_kernel(AVFilterContext *ctx, const char *gain, const char *g
             vars[VAR_F] = log2(0.05 * vars[VAR_F]);
         result = av_expr_eval(gain_expr, vars, ctx);
         s->analysis_buf[0] = ylog ? pow(10.0, 0.05 * result) : result;
+        s->analysis_buf[1] = 0.0;
 
         vars[VAR_F] = 0.5 * inlink->sample_rate;
         if (xlog)
             vars[VAR_F] = log2(0.05 * vars[VAR_F]);
         result = av_expr_eval(gain_expr, vars, ctx);
-        s->analysis_buf[1] = ylog ? pow(10.0, 0.05 * result) : result;
+        s->analysis_buf[s->analysis_rdft_len] = ylog ? pow(10.0, 0.05 * result) : result;
+        s->analysis_buf[s->analysis_rdft_len + 1] = 0.0;
 
         for (k = 1; k < s->analysis_rdft_len/2; k++) {
             vars[VAR_F] = k * ((double)inlink->sample_rate /(double)s->analysis_rdft_len);
@@ -666,9 +663,9 @@ static int generate_kernel(AVFilterContext *ctx, const char *gain, const char *g
         }
 
         if (s->dump_buf)
-            memcpy(s->dump_buf, s->analysis_buf, s->analysis_rdft_len * sizeof(*s->analysis_buf));
+            memcpy(s->dump_buf, s->analysis_buf, (s->analysis_rdft_len + 2) * sizeof(*s->analysis_buf));
 
-        av_rdft_calc(s->analysis_irdft, s->analysis_buf);
+        s->analysis_irdft_fn(s->analysis_irdft, s->analysis_buf, s->analysis_buf, sizeof(AVComplexFloat));
         center = s->fir_len / 2;
 
         for (k = 0; k <= center; k++) {
@@ -708,7 +705,7 @@ static int generate_kernel(AVFilterContext *ctx, const char *gain, const char *g
             default:
                 av_assert0(0);
             }
-            s->analysis_buf[k] *= (2.0/s->analysis_rdft_len) * (2.0/s->rdft_len) * win;
+            s->analysis_buf[k] *= (1.0/s->analysis_rdft_len) * (1.0/s->rdft_len) * win;
             if (k)
                 s->analysis_buf[s->analysis_rdft_len - k] = s->analysis_buf[k];
         }
@@ -718,10 +715,11 @@ static int generate_kernel(AVFilterContext *ctx, const char *gain, const char *g
         memcpy(rdft_buf + s->rdft_len/2, s->analysis_buf + s->analysis_rdft_len - s->rdft_len/2, s->rdft_len/2 * sizeof(*s->analysis_buf));
         if (s->min_phase)
             generate_min_phase_kernel(s, rdft_buf);
-        av_rdft_calc(s->rdft, rdft_buf);
+        s->rdft_fn(s->rdft, s->fft_buf, rdft_buf, sizeof(float));
 
-        for (k = 0; k < s->rdft_len; k++) {
-            if (isnan(rdft_buf[k]) || isinf(rdft_buf[k])) {
+        for (k = 0; k <= s->rdft_len/2; k++) {
+            if (isnan(s->fft_buf[k].re) || isinf(s->fft_buf[k].re) ||
+                isnan(s->fft_buf[k].im) || isinf(s->fft_buf[k].im)) {
                 av_log(ctx, AV_LOG_ERROR, "filter kernel contains nan or infinity.\n");
                 av_expr_free(gain_expr);
                 if (dump_fp)
@@ -731,10 +729,15 @@ static int generate_kernel(AVFilterContext *ctx, const char *gain, const char *g
         }
 
         if (!s->min_phase) {
-            rdft_buf[s->rdft_len-1] = rdft_buf[1];
-            for (k = 0; k < s->rdft_len/2; k++)
-                rdft_buf[k] = rdft_buf[2*k];
-            rdft_buf[s->rdft_len/2] = rdft_buf[s->rdft_len-1];
+            for (k = 0; k <= s->rdft_len/2; k++)
+                rdft_buf[k] = s->fft_buf[k].re;
+        } else {
+            rdft_buf[0] = s->fft_buf[0].re;
+            rdft_buf[1] = s->fft_buf[s->rdft_len/2].re;
+            for (k = 1; k < s->rdft_len/2; k++) {
+                rdft_buf[2*k]   = s->fft_buf[k].re;
+                rdft_buf[2*k+1] = s->fft_buf[k].im;
+            }
         }
 
         if (dump_fp)
@@ -758,7 +761,7 @@ static int config_input(AVFilterLink *inlink)
 {
     AVFilterContext *ctx = inlink->dst;
     FIREqualizerContext *s = ctx->priv;
-    int rdft_bits;
+    int rdft_bits, ret;
 
     common_uninit(s);
 
@@ -780,11 +783,13 @@ static int config_input(AVFilterLink *inlink)
         return AVERROR(EINVAL);
     }
 
-    if (!(s->rdft = av_rdft_init(rdft_bits, DFT_R2C)) || !(s->irdft = av_rdft_init(rdft_bits, IDFT_C2R)))
-        return AVERROR(ENOMEM);
+    if ((ret = av_tx_init(&s->rdft, &s->rdft_fn, AV_TX_FLOAT_RDFT, 0, s->rdft_len, NULL, 0)) < 0 ||
+        (ret = av_tx_init(&s->irdft, &s->irdft_fn, AV_TX_FLOAT_RDFT, 1, s->rdft_len, NULL, 0)) < 0)
+        return ret;
 
-    if (s->fft2 && !s->multi && inlink->channels > 1 && !(s->fft_ctx = av_fft_init(rdft_bits, 0)))
-        return AVERROR(ENOMEM);
+    if (s->fft2 && !s->multi && inlink->channels > 1 &&
+        (ret = av_tx_init(&s->fft_ctx, &s->fft_fn, AV_TX_FLOAT_FFT, 0, s->rdft_len, NULL, 0)) < 0)
+        return ret;
 
     if (s->min_phase) {
         int cepstrum_bits = rdft_bits + 2;
@@ -794,13 +799,14 @@ static int config_input(AVFilterLink *inlink)
         }
 
         cepstrum_bits = FFMIN(RDFT_BITS_MAX, cepstrum_bits + 1);
-        s->cepstrum_rdft = av_rdft_init(cepstrum_bits, DFT_R2C);
-        s->cepstrum_irdft = av_rdft_init(cepstrum_bits, IDFT_C2R);
-        if (!s->cepstrum_rdft || !s->cepstrum_irdft)
-            return AVERROR(ENOMEM);
-
         s->cepstrum_len = 1 << cepstrum_bits;
-        s->cepstrum_buf = av_malloc_array(s->cepstrum_len, sizeof(*s->cepstrum_buf));
+        if ((ret = av_tx_init(&s->cepstrum_rdft, &s->cepstrum_rdft_fn, AV_TX_FLOAT_RDFT,
+                              0, s->cepstrum_len, NULL, 0)) < 0 ||
+            (ret = av_tx_init(&s->cepstrum_irdft, &s->cepstrum_irdft_fn, AV_TX_FLOAT_RDFT,
+                              1, s->cepstrum_len, NULL, 0)) < 0)
+            return ret;
+
+        s->cepstrum_buf = av_malloc_array(s->cepstrum_len + 2, sizeof(*s->cepstrum_buf));
         if (!s->cepstrum_buf)
             return AVERROR(ENOMEM);
     }
@@ -816,20 +822,23 @@ static int config_input(AVFilterLink *inlink)
         return AVERROR(EINVAL);
     }
 
-    if (!(s->analysis_irdft = av_rdft_init(rdft_bits, IDFT_C2R)))
-        return AVERROR(ENOMEM);
+    if ((ret = av_tx_init(&s->analysis_irdft, &s->analysis_irdft_fn, AV_TX_FLOAT_RDFT,
+                          1, s->analysis_rdft_len, NULL, 0)) < 0)
+        return ret;
 
     if (s->dumpfile) {
-        s->analysis_rdft = av_rdft_init(rdft_bits, DFT_R2C);
-        s->dump_buf = av_malloc_array(s->analysis_rdft_len, sizeof(*s->dump_buf));
+        av_tx_init(&s->analysis_rdft, &s->analysis_rdft_fn, AV_TX_FLOAT_RDFT,
+                   0, s->analysis_rdft_len, NULL, 0);
+        s->dump_buf = av_malloc_array(s->analysis_rdft_len + 2, sizeof(*s->dump_buf));
     }
 
-    s->analysis_buf = av_malloc_array(s->analysis_rdft_len, sizeof(*s->analysis_buf));
+    s->analysis_buf = av_malloc_array(s->analysis_rdft_len + 2, sizeof(*s->analysis_buf));
     s->kernel_tmp_buf = av_malloc_array(s->rdft_len * (s->multi ? inlink->channels : 1), sizeof(*s->kernel_tmp_buf));
     s->kernel_buf = av_malloc_array(s->rdft_len * (s->multi ? inlink->channels : 1), sizeof(*s->kernel_buf));
     s->conv_buf   = av_calloc(2 * s->rdft_len * inlink->channels, sizeof(*s->conv_buf));
+    s->fft_buf    = av_malloc_array(s->rdft_len, sizeof(*s->fft_buf));
     s->conv_idx   = av_calloc(inlink->channels, sizeof(*s->conv_idx));
-    if (!s->analysis_buf || !s->kernel_tmp_buf || !s->kernel_buf || !s->conv_buf || !s->conv_idx)
+    if (!s->analysis_buf || !s->kernel_tmp_buf || !s->kernel_buf || !s->conv_buf || !s->fft_buf || !s->conv_idx)
         return AVERROR(ENOMEM);
 
     av_log(ctx, AV_LOG_DEBUG, "sample_rate = %d, channels = %d, analysis_rdft_len = %d, rdft_len = %d, fir_len = %d, nsamples_max = %d.\n",
@@ -849,7 +858,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
 
     if (!s->min_phase) {
         for (ch = 0; ch + 1 < inlink->channels && s->fft_ctx; ch += 2) {
-            fast_convolute2(s, s->kernel_buf, (FFTComplex *)(s->conv_buf + 2 * ch * s->rdft_len),
+            fast_convolute2(s, s->kernel_buf, (AVComplexFloat *)(s->conv_buf + 2 * ch * s->rdft_len),
                             s->conv_idx + ch, (float *) frame->extended_data[ch],
                             (float *) frame->extended_data[ch+1], frame->nb_samples);
         }
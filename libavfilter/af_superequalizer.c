@@ -20,8 +20,7 @@
  */
 
 #include "libavutil/opt.h"
-
-#include "libavcodec/avfft.h"
+#include "libavutil/tx.h"
 
 #include "audio.h"
 #include "avfilter.h"
@@ -50,7 +49,8 @@ typedef struct SuperEqualizerContext {
     int winlen, tabsize;
 
     AVFrame *in, *out;
-    RDFTContext *rdft, *irdft;
+    AVTXContext *rdft, *irdft;
+    av_tx_fn tx_fn, itx_fn;
 } SuperEqualizerContext;
 
 static const float bands[] = {
@@ -134,20 +134,24 @@ static void process_param(float *bc, EqParameter *param, float fs)
 
 static int equ_init(SuperEqualizerContext *s, int wb)
 {
-    int i,j;
-
-    s->rdft  = av_rdft_init(wb, DFT_R2C);
-    s->irdft = av_rdft_init(wb, IDFT_C2R);
-    if (!s->rdft || !s->irdft)
-        return AVERROR(ENOMEM);
+    float iscale;
+    int i, j, ret;
 
     s->aa = 96;
     s->winlen = (1 << (wb-1))-1;
     s->tabsize  = 1 << wb;
 
-    s->ires     = av_calloc(s->tabsize, sizeof(float));
-    s->irest    = av_calloc(s->tabsize, sizeof(float));
-    s->fsamples = av_calloc(s->tabsize, sizeof(float));
+    iscale = 1.f / s->tabsize;
+    ret = av_tx_init(&s->rdft, &s->tx_fn, AV_TX_FLOAT_RDFT, 0, s->tabsize, NULL, 0);
+    if (ret < 0)
+        return ret;
+    ret = av_tx_init(&s->irdft, &s->itx_fn, AV_TX_FLOAT_RDFT, 1, s->tabsize, &iscale, 0);
+    if (ret < 0)
+        return ret;
+
+    s->ires     = av_calloc(s->tabsize + 2, sizeof(float));
+    s->irest    = av_calloc(s->tabsize + 2, sizeof(float));
+    s->fsamples = av_calloc(s->tabsize + 2, sizeof(float));
 
     for (i = 0; i <= M; i++) {
         s->fact[i] = 1;
@@ -176,9 +180,9 @@ static void make_fir(SuperEqualizerContext *s, float *lbc, float *rbc, EqParamet
     for (; i < tabsize; i++)
         s->irest[i] = 0;
 
-    av_rdft_calc(s->rdft, s->irest);
+    s->tx_fn(s->rdft, s->irest, s->irest, sizeof(float));
     nires = s->ires;
-    for (i = 0; i < tabsize; i++)
+    for (i = 0; i < tabsize + 2; i++)
         nires[i] = s->irest[i];
 }
 
@@ -209,11 +213,9 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         for (; i < s->tabsize; i++)
             fsamples[i] = 0;
 
-        av_rdft_calc(s->rdft, fsamples);
+        s->tx_fn(s->rdft, fsamples, fsamples, sizeof(float));
 
-        fsamples[0] = ires[0] * fsamples[0];
-        fsamples[1] = ires[1] * fsamples[1];
-        for (i = 1; i < s->tabsize / 2; i++) {
+        for (i = 0; i <= s->tabsize / 2; i++) {
             float re, im;
 
             re = ires[i*2  ] * fsamples[i*2] - ires[i*2+1] * fsamples[i*2+1];
@@ -223,12 +225,12 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
             fsamples[i*2+1] = im;
         }
 
-        av_rdft_calc(s->irdft, fsamples);
+        s->itx_fn(s->irdft, fsamples, fsamples, sizeof(AVComplexFloat));
 
         for (i = 0; i < s->winlen; i++)
-            dst[i] += fsamples[i] / s->tabsize * 2;
+            dst[i] += fsamples[i];
         for (i = s->winlen; i < s->tabsize; i++)
-            dst[i]  = fsamples[i] / s->tabsize * 2;
+            dst[i]  = fsamples[i];
         for (i = 0; i < s->winlen; i++)
             ptr[i] = dst[i];
         for (i = 0; i < s->winlen; i++)
@@ -325,8 +327,8 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_freep(&s->irest);
     av_freep(&s->ires);
     av_freep(&s->fsamples);
-    av_rdft_end(s->rdft);
-    av_rdft_end(s->irdft);
+    av_tx_uninit(&s->rdft);
+    av_tx_uninit(&s->irdft);
 }
 
 static const AVFilterPad superequalizer_inputs[] = {
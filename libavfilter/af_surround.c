@@ -22,7 +22,7 @@
 #include "libavutil/audio_fifo.h"
 #include "libavutil/channel_layout.h"
 #include "libavutil/opt.h"
-#include "libavcodec/avfft.h"
+#include "libavutil/tx.h"
 #include "avfilter.h"
 #include "audio.h"
 #include "filters.h"
@@ -104,7 +104,8 @@ typedef struct AudioSurroundContext {
     int buf_size;
     int hop_size;
     AVAudioFifo *fifo;
-    RDFTContext **rdft, **irdft;
+    AVTXContext **rdft, **irdft;
+    av_tx_fn tx_fn, itx_fn;
     float *window_func_lut;
 
     int64_t pts;
@@ -198,16 +199,17 @@ static int config_input(AVFilterLink *inlink)
 {
     AVFilterContext *ctx = inlink->dst;
     AudioSurroundContext *s = ctx->priv;
-    int ch;
+    int ch, ret;
 
     s->rdft = av_calloc(inlink->channels, sizeof(*s->rdft));
     if (!s->rdft)
         return AVERROR(ENOMEM);
 
     for (ch = 0; ch < inlink->channels; ch++) {
-        s->rdft[ch]  = av_rdft_init(ff_log2(s->buf_size), DFT_R2C);
-        if (!s->rdft[ch])
-            return AVERROR(ENOMEM);
+        ret = av_tx_init(&s->rdft[ch], &s->tx_fn, AV_TX_FLOAT_RDFT,
+                         0, s->buf_size, NULL, 0);
+        if (ret < 0)
+            return ret;
     }
     s->nb_in_channels = inlink->channels;
     s->input_levels = av_malloc_array(s->nb_in_channels, sizeof(*s->input_levels));
@@ -261,16 +263,18 @@ static int config_output(AVFilterLink *outlink)
 {
     AVFilterContext *ctx = outlink->src;
     AudioSurroundContext *s = ctx->priv;
-    int ch;
+    const float iscale = 0.5f;
+    int ch, ret;
 
     s->irdft = av_calloc(outlink->channels, sizeof(*s->irdft));
     if (!s->irdft)
         return AVERROR(ENOMEM);
 
     for (ch = 0; ch < outlink->channels; ch++) {
-        s->irdft[ch] = av_rdft_init(ff_log2(s->buf_size), IDFT_C2R);
-        if (!s->irdft[ch])
-            return AVERROR(ENOMEM);
+        ret = av_tx_init(&s->irdft[ch], &s->itx_fn, AV_TX_FLOAT_RDFT,
+                         1, s->buf_size, &iscale, 0);
+        if (ret < 0)
+            return ret;
     }
     s->nb_out_channels = outlink->channels;
     s->output_levels = av_malloc_array(s->nb_out_channels, sizeof(*s->output_levels));
@@ -1102,7 +1106,7 @@ static void filter_stereo(AVFilterContext *ctx)
     srcl = (float *)s->input->extended_data[0];
     srcr = (float *)s->input->extended_data[1];
 
-    for (n = 0; n < s->buf_size; n++) {
+    for (n = 0; n <= s->buf_size / 2; n++) {
         float l_re = srcl[2 * n], r_re = srcr[2 * n];
         float l_im = srcl[2 * n + 1], r_im = srcr[2 * n + 1];
         float c_phase = atan2f(l_im + r_im, l_re + r_re);
@@ -1136,7 +1140,7 @@ static void filter_surround(AVFilterContext *ctx)
     srcr = (float *)s->input->extended_data[1];
     srcc = (float *)s->input->extended_data[2];
 
-    for (n = 0; n < s->buf_size; n++) {
+    for (n = 0; n <= s->buf_size / 2; n++) {
         float l_re = srcl[2 * n], r_re = srcr[2 * n];
         float l_im = srcl[2 * n + 1], r_im = srcr[2 * n + 1];
         float c_re = srcc[2 * n], c_im = srcc[2 * n + 1];
@@ -1172,7 +1176,7 @@ static void filter_2_1(AVFilterContext *ctx)
     srcr = (float *)s->input->extended_data[1];
     srclfe = (float *)s->input->extended_data[2];
 
-    for (n = 0; n < s->buf_size; n++) {
+    for (n = 0; n <= s->buf_size / 2; n++) {
         float l_re = srcl[2 * n], r_re = srcr[2 * n];
         float l_im = srcl[2 * n + 1], r_im = srcr[2 * n + 1];
         float lfe_re = srclfe[2 * n], lfe_im = srclfe[2 * n + 1];
@@ -1209,7 +1213,7 @@ static void filter_5_0_side(AVFilterContext *ctx)
     srcsl = (float *)s->input->extended_data[3];
     srcsr = (float *)s->input->extended_data[4];
 
-    for (n = 0; n < s->buf_size; n++) {
+    for (n = 0; n <= s->buf_size / 2; n++) {
         float fl_re = srcl[2 * n], fr_re = srcr[2 * n];
         float fl_im = srcl[2 * n + 1], fr_im = srcr[2 * n + 1];
         float c_re = srcc[2 * n], c_im = srcc[2 * n + 1];
@@ -1267,7 +1271,7 @@ static void filter_5_1_side(AVFilterContext *ctx)
     srcsl = (float *)s->input->extended_data[4];
     srcsr = (float *)s->input->extended_data[5];
 
-    for (n = 0; n < s->buf_size; n++) {
+    for (n = 0; n <= s->buf_size / 2; n++) {
         float fl_re = srcl[2 * n], fr_re = srcr[2 * n];
         float fl_im = srcl[2 * n + 1], fr_im = srcr[2 * n + 1];
         float c_re = srcc[2 * n], c_im = srcc[2 * n + 1];
@@ -1326,7 +1330,7 @@ static void filter_5_1_back(AVFilterContext *ctx)
     srcbl = (float *)s->input->extended_data[4];
     srcbr = (float *)s->input->extended_data[5];
 
-    for (n = 0; n < s->buf_size; n++) {
+    for (n = 0; n <= s->buf_size / 2; n++) {
         float fl_re = srcl[2 * n], fr_re = srcr[2 * n];
         float fl_im = srcl[2 * n + 1], fr_im = srcr[2 * n + 1];
         float c_re = srcc[2 * n], c_im = srcc[2 * n + 1];
@@ -1535,14 +1539,12 @@ static int fft_channel(AVFilterContext *ctx, void *arg, int ch, int nb_jobs)
     float *dst;
     int n;
 
-    memset(s->input->extended_data[ch] + s->buf_size * sizeof(float), 0, s->buf_size * sizeof(float));
-
     dst = (float *)s->input->extended_data[ch];
     for (n = 0; n < s->buf_size; n++) {
         dst[n] *= s->window_func_lut[n] * level_in;
     }
 
-    av_rdft_calc(s->rdft[ch], (float *)s->input->extended_data[ch]);
+    s->tx_fn(s->rdft[ch], dst, dst, sizeof(float));
 
     return 0;
 }
@@ -1555,9 +1557,9 @@ static int ifft_channel(AVFilterContext *ctx, void *arg, int ch, int nb_jobs)
     float *dst, *ptr;
     int n;
 
-    av_rdft_calc(s->irdft[ch], (float *)s->output->extended_data[ch]);
-
     dst = (float *)s->output->extended_data[ch];
+    s->itx_fn(s->irdft[ch], dst, dst, sizeof(AVComplexFloat));
+
     ptr = (float *)s->overlap_buffer->extended_data[ch];
 
     memmove(s->overlap_buffer->extended_data[ch],
@@ -1674,10 +1676,10 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_frame_free(&s->overlap_buffer);
 
     for (ch = 0; ch < s->nb_in_channels; ch++) {
-        av_rdft_end(s->rdft[ch]);
+        av_tx_uninit(&s->rdft[ch]);
     }
     for (ch = 0; ch < s->nb_out_channels; ch++) {
-        av_rdft_end(s->irdft[ch]);
+        av_tx_uninit(&s->irdft[ch]);
     }
     av_freep(&s->input_levels);
     av_freep(&s->output_levels);
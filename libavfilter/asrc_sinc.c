@@ -21,8 +21,7 @@
 
 #include "libavutil/avassert.h"
 #include "libavutil/opt.h"
-
-#include "libavcodec/avfft.h"
+#include "libavutil/tx.h"
 
 #include "audio.h"
 #include "avfilter.h"
@@ -40,7 +39,8 @@ typedef struct SincContext {
     float *coeffs;
     int64_t pts;
 
-    RDFTContext *rdft, *irdft;
+    AVTXContext *tx, *itx;
+    av_tx_fn tx_fn, itx_fn;
 } SincContext;
 
 static int request_frame(AVFilterLink *outlink)
@@ -206,8 +206,6 @@ static void invert(float *h, int n)
     h[(n - 1) / 2] += 1;
 }
 
-#define PACK(h, n)   h[1] = h[n]
-#define UNPACK(h, n) h[n] = h[1], h[n + 1] = h[1] = 0;
 #define SQR(a) ((a) * (a))
 
 static float safe_log(float x)
@@ -221,13 +219,13 @@ static float safe_log(float x)
 static int fir_to_phase(SincContext *s, float **h, int *len, int *post_len, float phase)
 {
     float *pi_wraps, *work, phase1 = (phase > 50.f ? 100.f - phase : phase) / 50.f;
-    int i, work_len, begin, end, imp_peak = 0, peak = 0;
+    int i, work_len, begin, end, imp_peak = 0, peak = 0, ret;
     float imp_sum = 0, peak_imp_sum = 0;
     float prev_angle2 = 0, cum_2pi = 0, prev_angle1 = 0, cum_1pi = 0;
 
     for (i = *len, work_len = 2 * 2 * 8; i > 1; work_len <<= 1, i >>= 1);
 
-    /* The first part is for work (+2 for (UN)PACK), the latter for pi_wraps. */
+    /* The first part is for work (+2 for the Nyquist bin), the latter for pi_wraps. */
     work = av_calloc((work_len + 2) + (work_len / 2 + 1), sizeof(float));
     if (!work)
         return AVERROR(ENOMEM);
@@ -235,18 +233,17 @@ static int fir_to_phase(SincContext *s, float **h, int *len, int *post_len, floa
 
     memcpy(work, *h, *len * sizeof(*work));
 
-    av_rdft_end(s->rdft);
-    av_rdft_end(s->irdft);
-    s->rdft = s->irdft = NULL;
-    s->rdft  = av_rdft_init(av_log2(work_len), DFT_R2C);
-    s->irdft = av_rdft_init(av_log2(work_len), IDFT_C2R);
-    if (!s->rdft || !s->irdft) {
+    av_tx_uninit(&s->tx);
+    av_tx_uninit(&s->itx);
+    ret = av_tx_init(&s->tx, &s->tx_fn, AV_TX_FLOAT_RDFT, 0, work_len, NULL, 0);
+    if (ret >= 0)
+        ret = av_tx_init(&s->itx, &s->itx_fn, AV_TX_FLOAT_RDFT, 1, work_len, NULL, 0);
+    if (ret < 0) {
         av_free(work);
-        return AVERROR(ENOMEM);
+        return ret;
     }
 
-    av_rdft_calc(s->rdft, work);   /* Cepstral: */
-    UNPACK(work, work_len);
+    s->tx_fn(s->tx, work, work, sizeof(float));   /* Cepstral: */
 
     for (i = 0; i <= work_len; i += 2) {
         float angle = atan2f(work[i + 1], work[i]);
@@ -268,23 +265,22 @@ static int fir_to_phase(SincContext *s, float **h, int *len, int *post_len, floa
         work[i + 1] = 0;
     }
 
-    PACK(work, work_len);
-    av_rdft_calc(s->irdft, work);
+    s->itx_fn(s->itx, work, work, sizeof(AVComplexFloat));
 
     for (i = 0; i < work_len; i++)
-        work[i] *= 2.f / work_len;
+        work[i] *= 1.f / work_len;
 
     for (i = 1; i < work_len / 2; i++) {        /* Window to reject acausal components */
         work[i] *= 2;
         work[i + work_len / 2] = 0;
     }
-    av_rdft_calc(s->rdft, work);
+    s->tx_fn(s->tx, work, work, sizeof(float));
 
     for (i = 2; i < work_len; i += 2)   /* Interpolate between linear & min phase */
         work[i + 1] = phase1 * i / work_len * pi_wraps[work_len >> 1] + (1 - phase1) * (work[i + 1] + pi_wraps[i >> 1]) - pi_wraps[i >> 1];
 
     work[0] = exp(work[0]);
-    work[1] = exp(work[1]);
+    work[work_len] = exp(work[work_len]);
     for (i = 2; i < work_len; i += 2) {
         float x = expf(work[i]);
 
@@ -292,9 +288,9 @@ static int fir_to_phase(SincContext *s, float **h, int *len, int *post_len, floa
         work[i + 1] = x * sinf(work[i + 1]);
     }
 
-    av_rdft_calc(s->irdft, work);
+    s->itx_fn(s->itx, work, work, sizeof(AVComplexFloat));
     for (i = 0; i < work_len; i++)
-        work[i] *= 2.f / work_len;
+        work[i] *= 1.f / work_len;
 
     /* Find peak pos. */
     for (i = 0; i <= (int) (pi_wraps[work_len >> 1] / M_PI + .5f); i++) {
@@ -396,9 +392,8 @@ static int config_output(AVFilterLink *outlink)
         s->coeffs[i] = h[longer][i];
     av_free(h[longer]);
 
-    av_rdft_end(s->rdft);
-    av_rdft_end(s->irdft);
-    s->rdft = s->irdft = NULL;
+    av_tx_uninit(&s->tx);
+    av_tx_uninit(&s->itx);
 
     return 0;
 }
@@ -408,9 +403,8 @@ static av_cold void uninit(AVFilterContext *ctx)
     SincContext *s = ctx->priv;
 
     av_freep(&s->coeffs);
-    av_rdft_end(s->rdft);
-    av_rdft_end(s->irdft);
-    s->rdft = s->irdft = NULL;
+    av_tx_uninit(&s->tx);
+    av_tx_uninit(&s->itx);
 }
 
 static const AVFilterPad sinc_outputs[] = {
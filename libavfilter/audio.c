@@ -95,3 +95,37 @@ AVFrame *ff_get_audio_buffer(AVFilterLink *link, int nb_samples)
 
     return ret;
 }
+
+#define MAX_CHANNEL_JOBS 64
+
+typedef struct ChannelsThreadData {
+    ff_channels_func func;
+    void *arg;
+    int nb_channels;
+} ChannelsThreadData;
+
+static int execute_channels(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    ChannelsThreadData *td = arg;
+    const int start = (td->nb_channels *  jobnr)    / nb_jobs;
+    const int end   = (td->nb_channels * (jobnr+1)) / nb_jobs;
+
+    return td->func(ctx, td->arg, start, end);
+}
+
+int ff_filter_execute_channels(AVFilterContext *ctx, ff_channels_func func,
+                               void *arg, int nb_channels)
+{
+    ChannelsThreadData td = { func, arg, nb_channels };
+    int ret[MAX_CHANNEL_JOBS];
+    int nb_jobs = FFMIN3(nb_channels, ff_filter_get_nb_threads(ctx), MAX_CHANNEL_JOBS);
+
+    if (nb_jobs <= 1)
+        return nb_channels > 0 ? func(ctx, arg, 0, nb_channels) : 0;
+
+    ctx->internal->execute(ctx, execute_channels, &td, ret, nb_jobs);
+    for (int i = 0; i < nb_jobs; i++)
+        if (ret[i] < 0)
+            return ret[i];
+    return 0;
+}
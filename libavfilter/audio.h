@@ -42,4 +42,22 @@ AVFrame *ff_null_get_audio_buffer(AVFilterLink *link, int nb_samples);
  */
 AVFrame *ff_get_audio_buffer(AVFilterLink *link, int nb_samples);
 
+/**
+ * Function processing the channels from start to end - 1 of some audio data.
+ *
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+typedef int (*ff_channels_func)(AVFilterContext *ctx, void *arg, int start, int end);
+
+/**
+ * Call func on contiguous ranges of channels covering nb_channels channels,
+ * spreading the ranges over the threads of the filter. This is meant for
+ * filters processing their channels independently and having
+ * AVFILTER_FLAG_SLICE_THREADS set.
+ *
+ * @return 0 on success, the first negative value returned by func otherwise
+ */
+int ff_filter_execute_channels(AVFilterContext *ctx, ff_channels_func func,
+                               void *arg, int nb_channels);
+
 #endif /* AVFILTER_AUDIO_H */
@@ -232,6 +232,11 @@ void ff_avfilter_link_set_out_status(AVFilterLink *link, int status, int64_t pts
     ff_filter_set_ready(link->src, 200);
 }
 
+int64_t avfilter_link_get_peak_queued_bytes(const AVFilterLink *link)
+{
+    return link->fifo.peak_queued_bytes;
+}
+
 void avfilter_link_set_closed(AVFilterLink *link, int closed)
 {
     ff_avfilter_link_set_out_status(link, closed ? AVERROR_EOF : 0, AV_NOPTS_VALUE);
@@ -1426,6 +1431,20 @@ static int ff_filter_activate_default(AVFilterContext *filter)
      [buffersrc1][testsrc1][buffersrc2][testsrc2]concat=v=2).
  */
 
+/**
+ * Tell if the frames queued on an output of the filter must be consumed
+ * before it can produce more.
+ */
+static int outputs_full(AVFilterContext *filter)
+{
+    unsigned i;
+
+    for (i = 0; i < filter->nb_outputs; i++)
+        if (ff_framequeue_full(&filter->outputs[i]->fifo))
+            return 1;
+    return 0;
+}
+
 int ff_filter_activate(AVFilterContext *filter)
 {
     int ret;
@@ -1434,6 +1453,16 @@ int ff_filter_activate(AVFilterContext *filter)
     av_assert1(!(filter->filter->flags & AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC &&
                  filter->filter->activate));
     filter->ready = 0;
+    /* Back off until the destinations consume the frames; consume_update()
+       activates the filter again. */
+    filter->internal->blocked_on_queue = outputs_full(filter);
+    if (filter->internal->blocked_on_queue) {
+        AVFilterGraphInternal *graphi = filter->graph->internal;
+
+        if (ff_framequeue_global_full(&graphi->frame_queues))
+            graphi->blocked_on_total = 1;
+        return 0;
+    }
     ret = filter->filter->activate ? filter->filter->activate(filter) :
           ff_filter_activate_default(filter);
     if (ret == FFERROR_NOT_READY)
@@ -1478,8 +1507,28 @@ int ff_inlink_check_available_samples(AVFilterLink *link, unsigned min)
     return samples >= min || (link->status_in && samples);
 }
 
+/**
+ * Activate again the filters of the graph that backed off because of the
+ * frame queue limits; those still blocked back off again.
+ */
+static void wake_blocked_filters(AVFilterGraph *graph)
+{
+    unsigned i;
+
+    graph->internal->blocked_on_total = 0;
+    for (i = 0; i < graph->nb_filters; i++)
+        if (graph->filters[i]->internal->blocked_on_queue)
+            ff_filter_set_ready(graph->filters[i], 300);
+}
+
 static void consume_update(AVFilterLink *link, const AVFrame *frame)
 {
+    AVFilterGraphInternal *graphi = link->src->graph->internal;
+
+    if (graphi->blocked_on_total && !ff_framequeue_global_full(&graphi->frame_queues))
+        wake_blocked_filters(link->src->graph);
+    else if (link->src->internal->blocked_on_queue)
+        ff_filter_set_ready(link->src, 300);
     ff_update_link_current_pts(link, frame->pts);
     ff_inlink_process_commands(link, frame);
     link->dst->is_disabled = !ff_inlink_evaluate_timeline_at_frame(link, frame);
@@ -682,6 +682,12 @@ attribute_deprecated
 int avfilter_link_get_channels(AVFilterLink *link);
 #endif
 
+/**
+ * Get the highest size, in bytes, reached by the frame data queued on a
+ * link since it was created.
+ */
+int64_t avfilter_link_get_peak_queued_bytes(const AVFilterLink *link);
+
 /**
  * Set the closed field of a link.
  * @deprecated applications are not supposed to mess with links, they should
@@ -906,6 +912,46 @@ typedef struct AVFilterGraph {
 
     char *aresample_swr_opts; ///< swr options to use for the auto-inserted aresample filters, Access ONLY through AVOptions
 
+    /**
+     * Maximum number of frames and of bytes of frame data queued on each
+     * link, 0 for no limit.
+     *
+     * When the queue of one of its outputs is full, a filter is not
+     * activated until the frames are consumed, and requesting a frame from a
+     * sink may fail with AVERROR(EAGAIN) until another sink is read. The
+     * limits are only exceeded when filters inside the graph would wait for
+     * each other otherwise.
+     *
+     * Access ONLY through AVOptions.
+     */
+    int max_link_frames;
+    int64_t max_link_bytes;
+
+    /**
+     * Same as max_link_frames and max_link_bytes for all the links of the
+     * graph together; links with no frames queued are never full.
+     *
+     * Access ONLY through AVOptions.
+     */
+    int max_queued_frames;
+    int64_t max_queued_bytes;
+
+    /**
+     * Number of samples in the audio frames passed to the filters, except
+     * for the last one of a stream, 0 to pass the frames as they come.
+     *
+     * Frames are merged or split before they reach a filter, so that long
+     * chains of cheap filters run once per quantum instead of once per
+     * decoded frame. Filters requiring a specific frame size, and sinks set
+     * with av_buffersink_set_frame_size(), still get the size they asked for.
+     * Frame properties and per-frame metadata of the merged frames are those
+     * of the first one, and the samples are delayed until a quantum is
+     * available.
+     *
+     * Access ONLY through AVOptions.
+     */
+    int audio_quantum;
+
     /**
      * Private fields
      *
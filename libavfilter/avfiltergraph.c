@@ -32,6 +32,7 @@
 #include "libavutil/internal.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/time.h"
 
 #define FF_INTERNAL_FIELDS 1
 #include "framequeue.h"
@@ -56,6 +57,16 @@ static const AVOption filtergraph_options[] = {
         AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, F|V },
     {"aresample_swr_opts"   , "default aresample filter options"    , OFFSET(aresample_swr_opts)    ,
         AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, F|A },
+    { "max_link_frames",   "maximum number of frames queued on each link",
+        OFFSET(max_link_frames),   AV_OPT_TYPE_INT,   { .i64 = 0 }, 0, INT_MAX,   F|V|A },
+    { "max_link_bytes",    "maximum size of the frames queued on each link",
+        OFFSET(max_link_bytes),    AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, F|V|A },
+    { "max_queued_frames", "maximum number of frames queued in the graph",
+        OFFSET(max_queued_frames), AV_OPT_TYPE_INT,   { .i64 = 0 }, 0, INT_MAX,   F|V|A },
+    { "max_queued_bytes",  "maximum size of the frames queued in the graph",
+        OFFSET(max_queued_bytes),  AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, F|V|A },
+    { "audio_quantum",     "number of samples in the audio frames passed to the filters",
+        OFFSET(audio_quantum),     AV_OPT_TYPE_INT,   { .i64 = 0 }, 0, INT_MAX,     F|A },
     { NULL },
 };
 
@@ -122,6 +133,10 @@ void avfilter_graph_free(AVFilterGraph **graph)
     if (!*graph)
         return;
 
+    if ((*graph)->internal)
+        av_log(*graph, AV_LOG_DEBUG, "Peak size of the queued frames: %"PRIu64" bytes\n",
+               (*graph)->internal->frame_queues.peak_queued_bytes);
+
     while ((*graph)->nb_filters)
         avfilter_free((*graph)->filters[0]);
 
@@ -266,6 +281,41 @@ static int graph_config_links(AVFilterGraph *graph, AVClass *log_ctx)
     return 0;
 }
 
+/**
+ * Make the audio inputs of the filters using filter_frame() get frames of
+ * audio_quantum samples, except for the last one. Filters with an activate
+ * callback consume the samples themselves, and the links where the
+ * destination already set a frame size are left alone.
+ */
+static void graph_config_audio_quantum(AVFilterGraph *graph)
+{
+    const int quantum = graph->audio_quantum;
+    int nb_links = 0;
+
+    if (!quantum)
+        return;
+
+    for (int i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *f = graph->filters[i];
+
+        if (f->filter->activate)
+            continue;
+        for (int j = 0; j < f->nb_inputs; j++) {
+            AVFilterLink *l = f->inputs[j];
+
+            if (l->type != AVMEDIA_TYPE_AUDIO || l->min_samples)
+                continue;
+            l->min_samples      = quantum;
+            l->max_samples      = quantum;
+            l->partial_buf_size = quantum;
+            nb_links++;
+        }
+    }
+
+    av_log(graph, AV_LOG_VERBOSE, "audio quantum of %d samples on %d links\n",
+           quantum, nb_links);
+}
+
 static int graph_check_links(AVFilterGraph *graph, AVClass *log_ctx)
 {
     AVFilterContext *f;
@@ -399,6 +449,79 @@ static int filter_query_formats(AVFilterContext *ctx)
     return 0;
 }
 
+/**
+ * Filters and links whose formats are not negotiated yet, so that the
+ * rounds of query_formats() only revisit them; the filters are then kept
+ * in topological order for the passes propagating the formats downstream.
+ */
+typedef struct NegotiationQueue {
+    AVFilterContext **filters;
+    AVFilterLink **links;
+    int nb_filters, nb_links;
+} NegotiationQueue;
+
+static int init_negotiation_queue(AVFilterGraph *graph, NegotiationQueue *q)
+{
+    int i, j, nb_links = 0;
+
+    for (i = 0; i < graph->nb_filters; i++)
+        nb_links += graph->filters[i]->nb_inputs;
+
+    q->filters = av_malloc_array(graph->nb_filters, sizeof(*q->filters));
+    q->links   = av_malloc_array(nb_links,          sizeof(*q->links));
+    if (!q->filters || (nb_links && !q->links))
+        return AVERROR(ENOMEM);
+
+    memcpy(q->filters, graph->filters, graph->nb_filters * sizeof(*q->filters));
+    q->nb_filters = graph->nb_filters;
+    q->nb_links   = 0;
+    for (i = 0; i < graph->nb_filters; i++)
+        for (j = 0; j < graph->filters[i]->nb_inputs; j++)
+            if (graph->filters[i]->inputs[j])
+                q->links[q->nb_links++] = graph->filters[i]->inputs[j];
+
+    return 0;
+}
+
+/**
+ * Sort the filters of the graph so that each one comes after the sources
+ * of its inputs; filters in a cycle, if any, come last in graph order.
+ */
+static int sort_filters(AVFilterGraph *graph, NegotiationQueue *q)
+{
+    AVFilterContext **order;
+    int i, j, n = 0;
+
+    order = av_realloc_array(q->filters, graph->nb_filters, sizeof(*order));
+    if (!order)
+        return AVERROR(ENOMEM);
+    q->filters = order;
+
+    for (i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *f = graph->filters[i];
+
+        f->internal->nb_unsorted_inputs = f->nb_inputs;
+        if (!f->nb_inputs)
+            order[n++] = f;
+    }
+    for (i = 0; i < n; i++) {
+        AVFilterContext *f = order[i];
+
+        for (j = 0; j < f->nb_outputs; j++) {
+            AVFilterContext *dst = f->outputs[j]->dst;
+
+            if (!--dst->internal->nb_unsorted_inputs)
+                order[n++] = dst;
+        }
+    }
+    for (i = 0; i < graph->nb_filters && n < graph->nb_filters; i++)
+        if (graph->filters[i]->internal->nb_unsorted_inputs)
+            order[n++] = graph->filters[i];
+    q->nb_filters = n;
+
+    return 0;
+}
+
 static int formats_declared(AVFilterContext *f)
 {
     int i;
@@ -432,17 +555,17 @@ static int formats_declared(AVFilterContext *f)
  *          was made and the negotiation is stuck;
  *          a negative error code if some other error happened
  */
-static int query_formats(AVFilterGraph *graph, AVClass *log_ctx)
+static int query_formats(AVFilterGraph *graph, NegotiationQueue *q, AVClass *log_ctx)
 {
-    int i, j, ret;
+    int i, n, ret;
     int scaler_count = 0, resampler_count = 0;
     int count_queried = 0;        /* successful calls to query_formats() */
     int count_merged = 0;         /* successful merge of formats lists */
     int count_already_merged = 0; /* lists already merged */
     int count_delayed = 0;        /* lists that need to be merged later */
 
-    for (i = 0; i < graph->nb_filters; i++) {
-        AVFilterContext *f = graph->filters[i];
+    for (i = n = 0; i < q->nb_filters; i++) {
+        AVFilterContext *f = q->filters[i];
         if (formats_declared(f))
             continue;
         if (f->filter->query_formats)
@@ -453,152 +576,154 @@ static int query_formats(AVFilterGraph *graph, AVClass *log_ctx)
             return ret;
         /* note: EAGAIN could indicate a partial success, not counted yet */
         count_queried += ret >= 0;
+        if (!formats_declared(f))
+            q->filters[n++] = f;
     }
+    q->nb_filters = n;
 
     /* go through and merge as many format lists as possible */
-    for (i = 0; i < graph->nb_filters; i++) {
-        AVFilterContext *filter = graph->filters[i];
-
-        for (j = 0; j < filter->nb_inputs; j++) {
-            AVFilterLink *link = filter->inputs[j];
-            int convert_needed = 0;
-
-            if (!link)
-                continue;
-
-            if (link->incfg.formats != link->outcfg.formats
-                && link->incfg.formats && link->outcfg.formats)
-                if (!ff_can_merge_formats(link->incfg.formats, link->outcfg.formats,
-                                          link->type))
+    for (i = n = 0; i < q->nb_links; i++) {
+        AVFilterLink *link = q->links[i];
+        int delayed = count_delayed;
+        int convert_needed = 0;
+
+        if (link->incfg.formats != link->outcfg.formats
+            && link->incfg.formats && link->outcfg.formats)
+            if (!ff_can_merge_formats(link->incfg.formats, link->outcfg.formats,
+                                      link->type))
+                convert_needed = 1;
+        if (link->type == AVMEDIA_TYPE_AUDIO) {
+            if (link->incfg.samplerates != link->outcfg.samplerates
+                && link->incfg.samplerates && link->outcfg.samplerates)
+                if (!ff_can_merge_samplerates(link->incfg.samplerates,
+                                              link->outcfg.samplerates))
                     convert_needed = 1;
-            if (link->type == AVMEDIA_TYPE_AUDIO) {
-                if (link->incfg.samplerates != link->outcfg.samplerates
-                    && link->incfg.samplerates && link->outcfg.samplerates)
-                    if (!ff_can_merge_samplerates(link->incfg.samplerates,
-                                                  link->outcfg.samplerates))
-                        convert_needed = 1;
-            }
+        }
 
 #define CHECKED_MERGE(field, ...) ((ret = ff_merge_ ## field(__VA_ARGS__)) <= 0)
 #define MERGE_DISPATCH(field, ...)                                           \
-            if (!(link->incfg.field && link->outcfg.field)) {                \
-                count_delayed++;                                             \
-            } else if (link->incfg.field == link->outcfg.field) {            \
-                count_already_merged++;                                      \
-            } else if (!convert_needed) {                                    \
-                count_merged++;                                              \
-                if (CHECKED_MERGE(field, __VA_ARGS__)) {                     \
-                    if (ret < 0)                                             \
-                        return ret;                                          \
-                    convert_needed = 1;                                      \
-                }                                                            \
-            }
+        if (!(link->incfg.field && link->outcfg.field)) {                \
+            count_delayed++;                                             \
+        } else if (link->incfg.field == link->outcfg.field) {            \
+            count_already_merged++;                                      \
+        } else if (!convert_needed) {                                    \
+            count_merged++;                                              \
+            if (CHECKED_MERGE(field, __VA_ARGS__)) {                     \
+                if (ret < 0)                                             \
+                    return ret;                                          \
+                convert_needed = 1;                                      \
+            }                                                            \
+        }
 
-            if (link->type == AVMEDIA_TYPE_AUDIO) {
-                MERGE_DISPATCH(channel_layouts, link->incfg.channel_layouts,
-                                                link->outcfg.channel_layouts)
-                MERGE_DISPATCH(samplerates, link->incfg.samplerates,
-                                            link->outcfg.samplerates)
-            }
-            MERGE_DISPATCH(formats, link->incfg.formats,
-                           link->outcfg.formats, link->type)
+        if (link->type == AVMEDIA_TYPE_AUDIO) {
+            MERGE_DISPATCH(channel_layouts, link->incfg.channel_layouts,
+                                            link->outcfg.channel_layouts)
+            MERGE_DISPATCH(samplerates, link->incfg.samplerates,
+                                        link->outcfg.samplerates)
+        }
+        MERGE_DISPATCH(formats, link->incfg.formats,
+                       link->outcfg.formats, link->type)
 #undef MERGE_DISPATCH
 
-            if (convert_needed) {
-                AVFilterContext *convert;
-                const AVFilter *filter;
-                AVFilterLink *inlink, *outlink;
-                char inst_name[30];
-
-                if (graph->disable_auto_convert) {
-                    av_log(log_ctx, AV_LOG_ERROR,
-                           "The filters '%s' and '%s' do not have a common format "
-                           "and automatic conversion is disabled.\n",
-                           link->src->name, link->dst->name);
-                    return AVERROR(EINVAL);
-                }
+        if (convert_needed) {
+            AVFilterContext *convert;
+            const AVFilter *filter;
+            AVFilterLink *inlink, *outlink;
+            char inst_name[30];
 
-                /* couldn't merge format lists. auto-insert conversion filter */
-                switch (link->type) {
-                case AVMEDIA_TYPE_VIDEO:
-                    if (!(filter = avfilter_get_by_name("scale"))) {
-                        av_log(log_ctx, AV_LOG_ERROR, "'scale' filter "
-                               "not present, cannot convert pixel formats.\n");
-                        return AVERROR(EINVAL);
-                    }
+            if (graph->disable_auto_convert) {
+                av_log(log_ctx, AV_LOG_ERROR,
+                       "The filters '%s' and '%s' do not have a common format "
+                       "and automatic conversion is disabled.\n",
+                       link->src->name, link->dst->name);
+                return AVERROR(EINVAL);
+            }
 
-                    snprintf(inst_name, sizeof(inst_name), "auto_scaler_%d",
-                             scaler_count++);
+            /* couldn't merge format lists. auto-insert conversion filter */
+            switch (link->type) {
+            case AVMEDIA_TYPE_VIDEO:
+                if (!(filter = avfilter_get_by_name("scale"))) {
+                    av_log(log_ctx, AV_LOG_ERROR, "'scale' filter "
+                           "not present, cannot convert pixel formats.\n");
+                    return AVERROR(EINVAL);
+                }
 
-                    if ((ret = avfilter_graph_create_filter(&convert, filter,
-                                                            inst_name, graph->scale_sws_opts, NULL,
-                                                            graph)) < 0)
-                        return ret;
-                    break;
-                case AVMEDIA_TYPE_AUDIO:
-                    if (!(filter = avfilter_get_by_name("aresample"))) {
-                        av_log(log_ctx, AV_LOG_ERROR, "'aresample' filter "
-                               "not present, cannot convert audio formats.\n");
-                        return AVERROR(EINVAL);
-                    }
+                snprintf(inst_name, sizeof(inst_name), "auto_scaler_%d",
+                         scaler_count++);
 
-                    snprintf(inst_name, sizeof(inst_name), "auto_resampler_%d",
-                             resampler_count++);
-                    if ((ret = avfilter_graph_create_filter(&convert, filter,
-                                                            inst_name, graph->aresample_swr_opts,
-                                                            NULL, graph)) < 0)
-                        return ret;
-                    break;
-                default:
+                if ((ret = avfilter_graph_create_filter(&convert, filter,
+                                                        inst_name, graph->scale_sws_opts, NULL,
+                                                        graph)) < 0)
+                    return ret;
+                break;
+            case AVMEDIA_TYPE_AUDIO:
+                if (!(filter = avfilter_get_by_name("aresample"))) {
+                    av_log(log_ctx, AV_LOG_ERROR, "'aresample' filter "
+                           "not present, cannot convert audio formats.\n");
                     return AVERROR(EINVAL);
                 }
 
-                if ((ret = avfilter_insert_filter(link, convert, 0, 0)) < 0)
+                snprintf(inst_name, sizeof(inst_name), "auto_resampler_%d",
+                         resampler_count++);
+                if ((ret = avfilter_graph_create_filter(&convert, filter,
+                                                        inst_name, graph->aresample_swr_opts,
+                                                        NULL, graph)) < 0)
                     return ret;
+                break;
+            default:
+                return AVERROR(EINVAL);
+            }
 
-                if ((ret = filter_query_formats(convert)) < 0)
-                    return ret;
+            if ((ret = avfilter_insert_filter(link, convert, 0, 0)) < 0)
+                return ret;
 
-                inlink  = convert->inputs[0];
-                outlink = convert->outputs[0];
-                av_assert0( inlink->incfg.formats->refcount > 0);
-                av_assert0( inlink->outcfg.formats->refcount > 0);
-                av_assert0(outlink->incfg.formats->refcount > 0);
-                av_assert0(outlink->outcfg.formats->refcount > 0);
-                if (outlink->type == AVMEDIA_TYPE_AUDIO) {
-                    av_assert0( inlink-> incfg.samplerates->refcount > 0);
-                    av_assert0( inlink->outcfg.samplerates->refcount > 0);
-                    av_assert0(outlink-> incfg.samplerates->refcount > 0);
-                    av_assert0(outlink->outcfg.samplerates->refcount > 0);
-                    av_assert0( inlink-> incfg.channel_layouts->refcount > 0);
-                    av_assert0( inlink->outcfg.channel_layouts->refcount > 0);
-                    av_assert0(outlink-> incfg.channel_layouts->refcount > 0);
-                    av_assert0(outlink->outcfg.channel_layouts->refcount > 0);
-                }
-                if (CHECKED_MERGE(formats, inlink->incfg.formats,
-                                  inlink->outcfg.formats, inlink->type)         ||
-                    CHECKED_MERGE(formats, outlink->incfg.formats,
-                                  outlink->outcfg.formats, outlink->type)       ||
-                    inlink->type == AVMEDIA_TYPE_AUDIO &&
-                    (CHECKED_MERGE(samplerates, inlink->incfg.samplerates,
-                                                inlink->outcfg.samplerates)  ||
-                     CHECKED_MERGE(channel_layouts, inlink->incfg.channel_layouts,
-                                   inlink->outcfg.channel_layouts))             ||
-                    outlink->type == AVMEDIA_TYPE_AUDIO &&
-                    (CHECKED_MERGE(samplerates, outlink->incfg.samplerates,
-                                                outlink->outcfg.samplerates) ||
-                     CHECKED_MERGE(channel_layouts, outlink->incfg.channel_layouts,
-                                                    outlink->outcfg.channel_layouts))) {
-                    if (ret < 0)
-                        return ret;
-                    av_log(log_ctx, AV_LOG_ERROR,
-                           "Impossible to convert between the formats supported by the filter "
-                           "'%s' and the filter '%s'\n", link->src->name, link->dst->name);
-                    return AVERROR(ENOSYS);
-                }
+            if ((ret = filter_query_formats(convert)) < 0)
+                return ret;
+
+            inlink  = convert->inputs[0];
+            outlink = convert->outputs[0];
+            av_assert0( inlink->incfg.formats->refcount > 0);
+            av_assert0( inlink->outcfg.formats->refcount > 0);
+            av_assert0(outlink->incfg.formats->refcount > 0);
+            av_assert0(outlink->outcfg.formats->refcount > 0);
+            if (outlink->type == AVMEDIA_TYPE_AUDIO) {
+                av_assert0( inlink-> incfg.samplerates->refcount > 0);
+                av_assert0( inlink->outcfg.samplerates->refcount > 0);
+                av_assert0(outlink-> incfg.samplerates->refcount > 0);
+                av_assert0(outlink->outcfg.samplerates->refcount > 0);
+                av_assert0( inlink-> incfg.channel_layouts->refcount > 0);
+                av_assert0( inlink->outcfg.channel_layouts->refcount > 0);
+                av_assert0(outlink-> incfg.channel_layouts->refcount > 0);
+                av_assert0(outlink->outcfg.channel_layouts->refcount > 0);
+            }
+            if (CHECKED_MERGE(formats, inlink->incfg.formats,
+                              inlink->outcfg.formats, inlink->type)         ||
+                CHECKED_MERGE(formats, outlink->incfg.formats,
+                              outlink->outcfg.formats, outlink->type)       ||
+                inlink->type == AVMEDIA_TYPE_AUDIO &&
+                (CHECKED_MERGE(samplerates, inlink->incfg.samplerates,
+                                            inlink->outcfg.samplerates)  ||
+                 CHECKED_MERGE(channel_layouts, inlink->incfg.channel_layouts,
+                               inlink->outcfg.channel_layouts))             ||
+                outlink->type == AVMEDIA_TYPE_AUDIO &&
+                (CHECKED_MERGE(samplerates, outlink->incfg.samplerates,
+                                            outlink->outcfg.samplerates) ||
+                 CHECKED_MERGE(channel_layouts, outlink->incfg.channel_layouts,
+                                                outlink->outcfg.channel_layouts))) {
+                if (ret < 0)
+                    return ret;
+                av_log(log_ctx, AV_LOG_ERROR,
+                       "Impossible to convert between the formats supported by the filter "
+                       "'%s' and the filter '%s'\n", link->src->name, link->dst->name);
+                return AVERROR(ENOSYS);
             }
         }
+
+        /* links merged or converted are done with */
+        if (count_delayed != delayed)
+            q->links[n++] = link;
     }
+    q->nb_links = n;
 
     av_log(graph, AV_LOG_DEBUG, "query_formats: "
            "%d queried, %d merged, %d already done, %d delayed\n",
@@ -661,6 +786,56 @@ static enum AVSampleFormat find_best_sample_fmt_of_2(enum AVSampleFormat dst_fmt
     return score1 < score2 ? dst_fmt1 : dst_fmt2;
 }
 
+static int same_pix_fmt_layout(const AVPixFmtDescriptor *desc1,
+                               const AVPixFmtDescriptor *desc2)
+{
+    const int flags = AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_PAL;
+
+    return (desc1->flags & flags) == (desc2->flags & flags) &&
+           (desc1->nb_components >= 3) == (desc2->nb_components >= 3) &&
+           desc1->log2_chroma_w == desc2->log2_chroma_w &&
+           desc1->log2_chroma_h == desc2->log2_chroma_h;
+}
+
+/**
+ * Estimate the cost of converting a video frame from src_fmt to dst_fmt.
+ *
+ * The cost is the number of bits per pixel read and written, doubled when
+ * the conversion cannot be done without resampling the chroma planes or
+ * changing the color model; any loss of information outweighs it.
+ */
+static int get_pix_fmt_conversion_cost(enum AVPixelFormat dst_fmt,
+                                       enum AVPixelFormat src_fmt, int has_alpha)
+{
+    const AVPixFmtDescriptor *src_desc = av_pix_fmt_desc_get(src_fmt);
+    const AVPixFmtDescriptor *dst_desc = av_pix_fmt_desc_get(dst_fmt);
+    int loss, cost;
+
+    if (dst_fmt == src_fmt)
+        return 0;
+    if (!src_desc || !dst_desc ||
+        ((src_desc->flags | dst_desc->flags) & AV_PIX_FMT_FLAG_HWACCEL))
+        return INT_MAX;
+
+    loss = av_get_pix_fmt_loss(dst_fmt, src_fmt, has_alpha);
+    if (loss < 0)
+        return INT_MAX;
+    cost = av_get_padded_bits_per_pixel(src_desc) +
+           av_get_padded_bits_per_pixel(dst_desc);
+    if (!same_pix_fmt_layout(src_desc, dst_desc))
+        cost *= 2;
+
+    return cost + 1024 * av_popcount(loss);
+}
+
+static int pix_fmt_has_alpha(enum AVPixelFormat fmt)
+{
+    //FIXME: This should check for AV_PIX_FMT_FLAG_ALPHA after PAL8 pixel format without alpha is implemented
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(fmt);
+
+    return desc && desc->nb_components % 2 == 0;
+}
+
 static int pick_format(AVFilterLink *link, AVFilterLink *ref)
 {
     if (!link || !link->incfg.formats)
@@ -668,8 +843,7 @@ static int pick_format(AVFilterLink *link, AVFilterLink *ref)
 
     if (link->type == AVMEDIA_TYPE_VIDEO) {
         if(ref && ref->type == AVMEDIA_TYPE_VIDEO){
-            //FIXME: This should check for AV_PIX_FMT_FLAG_ALPHA after PAL8 pixel format without alpha is implemented
-            int has_alpha= av_pix_fmt_desc_get(ref->format)->nb_components % 2 == 0;
+            int has_alpha= pix_fmt_has_alpha(ref->format);
             enum AVPixelFormat best= AV_PIX_FMT_NONE;
             int i;
             for (i = 0; i < link->incfg.formats->nb_formats; i++) {
@@ -737,6 +911,77 @@ static int pick_format(AVFilterLink *link, AVFilterLink *ref)
     return 0;
 }
 
+/**
+ * Pick the formats around the filters converting between video formats,
+ * i.e. those flagged with FF_FILTER_FLAG_FORMAT_CONVERSION, when nothing
+ * upstream constrains their input: instead of taking the first format of
+ * each list, choose the pair of input and output formats minimizing the
+ * cost of the conversion.
+ *
+ * @return 1 if a format was picked, 0 if there was nothing to pick,
+ *         a negative AVERROR code on failure
+ */
+static int pick_conversion_formats(NegotiationQueue *q)
+{
+    int i, j, k, ret;
+
+    for (i = 0; i < q->nb_filters; i++) {
+        AVFilterContext *filter = q->filters[i];
+        AVFilterLink *inlink, *outlink;
+        AVFilterFormats *in_fmts, *out_fmts;
+        enum AVPixelFormat best_in = AV_PIX_FMT_NONE, best_out = AV_PIX_FMT_NONE;
+        int best_cost = INT_MAX;
+
+        if (!(filter->filter->flags_internal & FF_FILTER_FLAG_FORMAT_CONVERSION) ||
+            filter->nb_inputs != 1 || !filter->nb_outputs)
+            continue;
+        inlink  = filter->inputs[0];
+        outlink = filter->outputs[0];
+        in_fmts  = inlink->incfg.formats;
+        out_fmts = outlink->incfg.formats;
+        if (inlink->type != AVMEDIA_TYPE_VIDEO || outlink->type != AVMEDIA_TYPE_VIDEO ||
+            inlink->format >= 0 || !in_fmts || in_fmts == out_fmts ||
+            outlink->format < 0 && !out_fmts)
+            continue;
+
+        for (j = 0; j < in_fmts->nb_formats; j++) {
+            enum AVPixelFormat src = in_fmts->formats[j];
+            int has_alpha = pix_fmt_has_alpha(src);
+
+            for (k = 0; k < (out_fmts ? out_fmts->nb_formats : 1); k++) {
+                enum AVPixelFormat dst = out_fmts ? out_fmts->formats[k] : outlink->format;
+                int cost = get_pix_fmt_conversion_cost(dst, src, has_alpha);
+
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best_in   = src;
+                    best_out  = dst;
+                }
+            }
+        }
+        if (best_in == AV_PIX_FMT_NONE)
+            continue;
+
+        av_log(filter, AV_LOG_DEBUG, "picking %s -> %s out of %d x %d, cost %d\n",
+               av_get_pix_fmt_name(best_in), av_get_pix_fmt_name(best_out),
+               in_fmts->nb_formats, out_fmts ? out_fmts->nb_formats : 1, best_cost);
+
+        in_fmts->formats[0] = best_in;
+        in_fmts->nb_formats = 1;
+        if ((ret = pick_format(inlink, NULL)) < 0)
+            return ret;
+        if (out_fmts) {
+            out_fmts->formats[0] = best_out;
+            out_fmts->nb_formats = 1;
+            if ((ret = pick_format(outlink, NULL)) < 0)
+                return ret;
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
 #define REDUCE_FORMATS(fmt_type, list_type, list, var, nb, add_format) \
 do {                                                                   \
     for (i = 0; i < filter->nb_inputs; i++) {                          \
@@ -824,15 +1069,16 @@ static int reduce_formats_on_filter(AVFilterContext *filter)
     return ret;
 }
 
-static int reduce_formats(AVFilterGraph *graph)
+static int reduce_formats(NegotiationQueue *q, int *passes)
 {
     int i, reduced, ret;
 
     do {
         reduced = 0;
+        (*passes)++;
 
-        for (i = 0; i < graph->nb_filters; i++) {
-            if ((ret = reduce_formats_on_filter(graph->filters[i])) < 0)
+        for (i = 0; i < q->nb_filters; i++) {
+            if ((ret = reduce_formats_on_filter(q->filters[i])) < 0)
                 return ret;
             reduced |= ret;
         }
@@ -1090,15 +1336,16 @@ static void swap_sample_fmts(AVFilterGraph *graph)
 
 }
 
-static int pick_formats(AVFilterGraph *graph)
+static int pick_formats(NegotiationQueue *q, int *passes)
 {
     int i, j, ret;
     int change;
 
     do{
         change = 0;
-        for (i = 0; i < graph->nb_filters; i++) {
-            AVFilterContext *filter = graph->filters[i];
+        (*passes)++;
+        for (i = 0; i < q->nb_filters; i++) {
+            AVFilterContext *filter = q->filters[i];
             if (filter->nb_inputs){
                 for (j = 0; j < filter->nb_inputs; j++){
                     if (filter->inputs[j]->incfg.formats && filter->inputs[j]->incfg.formats->nb_formats == 1) {
@@ -1127,10 +1374,17 @@ static int pick_formats(AVFilterGraph *graph)
                 }
             }
         }
+        /* only then fall back to the cost of the conversions left, so that
+         * formats imposed by the rest of the graph are propagated first */
+        if (!change && (ret = pick_conversion_formats(q))) {
+            if (ret < 0)
+                return ret;
+            change = 1;
+        }
     }while(change);
 
-    for (i = 0; i < graph->nb_filters; i++) {
-        AVFilterContext *filter = graph->filters[i];
+    for (i = 0; i < q->nb_filters; i++) {
+        AVFilterContext *filter = q->filters[i];
 
         for (j = 0; j < filter->nb_inputs; j++)
             if ((ret = pick_format(filter->inputs[j], NULL)) < 0)
@@ -1142,35 +1396,103 @@ static int pick_formats(AVFilterGraph *graph)
     return 0;
 }
 
+static void dump_format_plan(AVFilterGraph *graph)
+{
+    int i, j, total = 0;
+
+    for (i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *filter = graph->filters[i];
+
+        for (j = 0; j < filter->nb_outputs; j++) {
+            AVFilterLink *link = filter->outputs[j];
+            const char *name = link->type == AVMEDIA_TYPE_VIDEO ?
+                               av_get_pix_fmt_name(link->format) :
+                               av_get_sample_fmt_name(link->format);
+
+            av_log(graph, AV_LOG_DEBUG, "link %s:%s -> %s:%s: %s\n",
+                   link->src->name, link->srcpad->name,
+                   link->dst->name, link->dstpad->name, name ? name : "none");
+        }
+
+        if (filter->nb_inputs == 1 && filter->nb_outputs &&
+            filter->inputs[0]->type == AVMEDIA_TYPE_VIDEO &&
+            filter->outputs[0]->type == AVMEDIA_TYPE_VIDEO &&
+            filter->inputs[0]->format != filter->outputs[0]->format) {
+            enum AVPixelFormat src = filter->inputs[0]->format;
+            enum AVPixelFormat dst = filter->outputs[0]->format;
+            int cost = get_pix_fmt_conversion_cost(dst, src, pix_fmt_has_alpha(src));
+
+            av_log(graph, AV_LOG_DEBUG, "conversion in %s: %s -> %s, cost %d\n",
+                   filter->name, av_get_pix_fmt_name(src),
+                   av_get_pix_fmt_name(dst), cost);
+            if (cost < INT_MAX)
+                total += cost;
+        }
+    }
+
+    av_log(graph, AV_LOG_DEBUG, "total video conversion cost: %d\n", total);
+}
+
 /**
  * Configure the formats of all the links in the graph.
  */
 static int graph_config_formats(AVFilterGraph *graph, AVClass *log_ctx)
 {
+    NegotiationQueue q = { 0 };
+    int64_t t0, t1, t2, t3, t4;
+    int rounds = 1, reduce_passes = 0, pick_passes = 0;
     int ret;
 
+    t0 = av_gettime_relative();
+
+    if ((ret = init_negotiation_queue(graph, &q)) < 0)
+        goto fail;
+
     /* find supported formats from sub-filters, and merge along links */
-    while ((ret = query_formats(graph, log_ctx)) == AVERROR(EAGAIN))
+    while ((ret = query_formats(graph, &q, log_ctx)) == AVERROR(EAGAIN)) {
         av_log(graph, AV_LOG_DEBUG, "query_formats not finished\n");
+        rounds++;
+    }
     if (ret < 0)
-        return ret;
+        goto fail;
+
+    /* the formats are propagated downstream by the following passes,
+     * visiting the filters in this order saves most of their iterations */
+    if ((ret = sort_filters(graph, &q)) < 0)
+        goto fail;
+    t1 = av_gettime_relative();
 
     /* Once everything is merged, it's possible that we'll still have
      * multiple valid media format choices. We try to minimize the amount
      * of format conversion inside filters */
-    if ((ret = reduce_formats(graph)) < 0)
-        return ret;
+    if ((ret = reduce_formats(&q, &reduce_passes)) < 0)
+        goto fail;
+    t2 = av_gettime_relative();
 
     /* for audio filters, ensure the best format, sample rate and channel layout
      * is selected */
     swap_sample_fmts(graph);
     swap_samplerates(graph);
     swap_channel_layouts(graph);
+    t3 = av_gettime_relative();
 
-    if ((ret = pick_formats(graph)) < 0)
-        return ret;
+    if ((ret = pick_formats(&q, &pick_passes)) < 0)
+        goto fail;
+    t4 = av_gettime_relative();
 
-    return 0;
+    av_log(graph, AV_LOG_DEBUG, "formats of %d filters negotiated in %"PRId64" us: "
+           "query %"PRId64" us (%d rounds), reduce %"PRId64" us (%d passes), "
+           "swap %"PRId64" us, pick %"PRId64" us (%d passes)\n",
+           graph->nb_filters, t4 - t0, t1 - t0, rounds, t2 - t1, reduce_passes,
+           t3 - t2, t4 - t3, pick_passes);
+
+    if (av_log_get_level() >= AV_LOG_DEBUG)
+        dump_format_plan(graph);
+
+fail:
+    av_freep(&q.filters);
+    av_freep(&q.links);
+    return ret;
 }
 
 static int graph_config_pointers(AVFilterGraph *graph,
@@ -1217,19 +1539,34 @@ static int graph_config_pointers(AVFilterGraph *graph,
 
 int avfilter_graph_config(AVFilterGraph *graphctx, void *log_ctx)
 {
+    int64_t t0, t1, t2;
     int ret;
+    FFFrameQueueGlobal *fqg = &graphctx->internal->frame_queues;
+
+    fqg->max_queued_frames = graphctx->max_link_frames;
+    fqg->max_queued_bytes  = graphctx->max_link_bytes;
+    fqg->max_total_frames  = graphctx->max_queued_frames;
+    fqg->max_total_bytes   = graphctx->max_queued_bytes;
 
     if ((ret = graph_check_validity(graphctx, log_ctx)))
         return ret;
+    t0 = av_gettime_relative();
     if ((ret = graph_config_formats(graphctx, log_ctx)))
         return ret;
+    t1 = av_gettime_relative();
     if ((ret = graph_config_links(graphctx, log_ctx)))
         return ret;
+    t2 = av_gettime_relative();
+    graph_config_audio_quantum(graphctx);
     if ((ret = graph_check_links(graphctx, log_ctx)))
         return ret;
     if ((ret = graph_config_pointers(graphctx, log_ctx)))
         return ret;
 
+    av_log(graphctx, AV_LOG_DEBUG, "graph configured in %"PRId64" us: "
+           "formats %"PRId64" us, links %"PRId64" us\n",
+           av_gettime_relative() - t0, t1 - t0, t2 - t1);
+
     return 0;
 }
 
@@ -1380,9 +1717,14 @@ int avfilter_graph_request_oldest(AVFilterGraph *graph)
         r = ff_filter_graph_run_once(graph);
         if (r == AVERROR(EAGAIN) &&
             !oldest->frame_wanted_out && !oldest->frame_blocked_in &&
-            !oldest->status_in)
+            !oldest->status_in) {
             ff_request_frame(oldest);
-        else if (r < 0)
+            continue;
+        }
+        /* the limits of the frame queues may be what keeps the graph from running */
+        if (r == AVERROR(EAGAIN))
+            r = ff_filter_graph_run_blocked(graph);
+        if (r < 0)
             return r;
     }
     return 0;
@@ -1402,3 +1744,31 @@ int ff_filter_graph_run_once(AVFilterGraph *graph)
         return AVERROR(EAGAIN);
     return ff_filter_activate(filter);
 }
+
+int ff_filter_graph_run_blocked(AVFilterGraph *graph)
+{
+    FFFrameQueueGlobal *fqg = &graph->internal->frame_queues;
+    unsigned i, j;
+    int ret;
+
+    for (i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *filter = graph->filters[i];
+
+        if (!filter->internal->blocked_on_queue)
+            continue;
+        /* frames waiting to be read from a sink are up to the application */
+        for (j = 0; j < filter->nb_outputs; j++)
+            if (ff_framequeue_full(&filter->outputs[j]->fifo) &&
+                filter->outputs[j]->dst->nb_outputs)
+                break;
+        if (j == filter->nb_outputs)
+            continue;
+        av_log(filter, AV_LOG_VERBOSE, "Exceeding the frame queue limits "
+               "to avoid stalling the graph\n");
+        fqg->overrun = 1;
+        ret = ff_filter_activate(filter);
+        fqg->overrun = 0;
+        return ret;
+    }
+    return AVERROR(EAGAIN);
+}
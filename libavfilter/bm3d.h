@@ -0,0 +1,44 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_BM3D_H
+#define AVFILTER_BM3D_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct BM3DDSPContext {
+    /**
+     * Sum of squared differences between two size x size blocks.
+     * size must be a multiple of 16.
+     */
+    int64_t (*ssd)(const uint8_t *a, const uint8_t *b, ptrdiff_t stride, int size);
+
+    /**
+     * Matrix product dst = a * b, a being rows x n and b being n x cols.
+     * rows must be even, cols a multiple of 16, and dst and b must be
+     * 32-byte aligned.
+     */
+    void (*mat_mul)(float *dst, const float *a, const float *b,
+                    int rows, int n, int cols);
+} BM3DDSPContext;
+
+void ff_bm3d_init(BM3DDSPContext *dsp, int depth);
+void ff_bm3d_init_x86(BM3DDSPContext *dsp, int depth);
+
+#endif /* AVFILTER_BM3D_H */
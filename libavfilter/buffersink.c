@@ -129,6 +129,8 @@ static int get_frame_internal(AVFilterContext *ctx, AVFrame *frame, int flags, i
             return AVERROR(EAGAIN);
         } else if (inlink->frame_wanted_out) {
             ret = ff_filter_graph_run_once(ctx->graph);
+            if (ret == AVERROR(EAGAIN))
+                ret = ff_filter_graph_run_blocked(ctx->graph);
             if (ret < 0)
                 return ret;
         } else {
@@ -32,6 +32,7 @@
 #include "libavutil/imgutils.h"
 #include "libavutil/internal.h"
 #include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
 #include "libavutil/samplefmt.h"
 #include "libavutil/timestamp.h"
 #include "audio.h"
@@ -57,6 +58,9 @@ typedef struct BufferSourceContext {
 
     AVBufferRef *hw_frames_ctx;
 
+    /* scale filter inserted by av_buffersrc_reconfigure() */
+    AVFilterContext *scaler;
+
     /* audio only */
     int sample_rate;
     enum AVSampleFormat sample_fmt;
@@ -138,6 +142,101 @@ int av_buffersrc_parameters_set(AVFilterContext *ctx, AVBufferSrcParameters *par
     return 0;
 }
 
+static int insert_scaler(AVFilterContext *ctx)
+{
+    BufferSourceContext *s = ctx->priv;
+    AVFilterGraph *graph = ctx->graph;
+    AVFilterLink *link = ctx->outputs[0], *outlink;
+    AVFilterContext *scaler;
+    char name[64], args[256];
+    int i, ret;
+
+    snprintf(name, sizeof(name), "auto_reconfig_scaler_%s", ctx->name);
+    snprintf(args, sizeof(args), "w=%d:h=%d%s%s", link->w, link->h,
+             graph->scale_sws_opts ? ":" : "",
+             graph->scale_sws_opts ? graph->scale_sws_opts : "");
+    ret = avfilter_graph_create_filter(&scaler, avfilter_get_by_name("scale"),
+                                       name, args, NULL, graph);
+    if (ret < 0)
+        return ret;
+    if ((ret = avfilter_insert_filter(link, scaler, 0, 0)) < 0) {
+        avfilter_free(scaler);
+        return ret;
+    }
+
+    /* The link to the rest of the graph keeps the parameters and the state
+       of the former output of the source; the scale filter updates those of
+       its input when it gets a different frame. */
+    outlink = scaler->outputs[0];
+    outlink->graph               = graph;
+    outlink->age_index           = -1;
+    outlink->format              = link->format;
+    outlink->w                   = link->w;
+    outlink->h                   = link->h;
+    outlink->sample_aspect_ratio = link->sample_aspect_ratio;
+    outlink->time_base           = link->time_base;
+    outlink->frame_rate          = link->frame_rate;
+    outlink->frame_count_in      = link->frame_count_in;
+    outlink->frame_count_out     = link->frame_count_out;
+    outlink->current_pts         = link->current_pts;
+    outlink->current_pts_us      = link->current_pts_us;
+    outlink->frame_wanted_out    = link->frame_wanted_out;
+    if ((ret = outlink->srcpad->config_props(outlink)) < 0) {
+        /* Take the scaler out again and link the source back to the rest
+           of the graph, as before the insertion. */
+        link->dst    = outlink->dst;
+        link->dstpad = outlink->dstpad;
+        link->dst->inputs[link->dstpad - link->dst->input_pads] = link;
+        outlink->dst = NULL;
+        scaler->inputs[0] = NULL;
+        avfilter_free(scaler);
+        return ret;
+    }
+    outlink->init_state = AVLINK_INIT;
+
+    for (i = 0; i < graph->sink_links_count; i++) {
+        if (graph->sink_links[i] == link) {
+            graph->sink_links[i] = outlink;
+            outlink->age_index   = link->age_index;
+            link->age_index      = -1;
+        }
+    }
+
+    s->scaler = scaler;
+    return 0;
+}
+
+int av_buffersrc_reconfigure(AVFilterContext *ctx, AVBufferSrcParameters *param)
+{
+    BufferSourceContext *s = ctx->priv;
+    AVFilterLink *link = ctx->outputs[0];
+    int ret;
+
+    if (!link || link->init_state != AVLINK_INIT)
+        return av_buffersrc_parameters_set(ctx, param);
+    if (link->type != AVMEDIA_TYPE_VIDEO || s->hw_frames_ctx || param->hw_frames_ctx)
+        return AVERROR(ENOSYS);
+
+    if (param->format == s->pix_fmt && param->width == s->w && param->height == s->h)
+        return 0;
+
+    if (!s->scaler || link->dst != s->scaler) {
+        if ((ret = insert_scaler(ctx)) < 0)
+            return ret;
+    }
+
+    av_log(ctx, AV_LOG_VERBOSE, "Converting frames of size %dx%d and format %s "
+           "to the configured size %dx%d and format %s\n",
+           param->width, param->height, av_get_pix_fmt_name(param->format),
+           s->scaler->outputs[0]->w, s->scaler->outputs[0]->h,
+           av_get_pix_fmt_name(s->scaler->outputs[0]->format));
+
+    s->pix_fmt = param->format;
+    s->w       = param->width;
+    s->h       = param->height;
+    return 0;
+}
+
 int attribute_align_arg av_buffersrc_write_frame(AVFilterContext *ctx, const AVFrame *frame)
 {
     return av_buffersrc_add_frame_flags(ctx, (AVFrame *)frame,
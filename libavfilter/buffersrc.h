@@ -137,6 +137,22 @@ AVBufferSrcParameters *av_buffersrc_parameters_alloc(void);
  */
 int av_buffersrc_parameters_set(AVFilterContext *ctx, AVBufferSrcParameters *param);
 
+/**
+ * Prepare the buffersrc filter of a configured graph for video frames with
+ * a different size or pixel format, without reconfiguring the rest of the
+ * graph: a scale filter is inserted after the source if it is not there
+ * yet, and converts the frames to the size and pixel format the graph was
+ * configured with. The state of the other filters is kept.
+ *
+ * @param ctx an instance of the buffersrc filter, in a configured graph
+ * @param param the new parameters, only the width, height and format are
+ *              used
+ * @return 0 on success, AVERROR(ENOSYS) if the source cannot be
+ *         reconfigured this way (audio or hardware frames), another
+ *         negative AVERROR code on failure.
+ */
+int av_buffersrc_reconfigure(AVFilterContext *ctx, AVBufferSrcParameters *param);
+
 /**
  * Add a frame to the buffer source.
  *
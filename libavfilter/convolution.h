@@ -60,5 +60,13 @@ typedef struct ConvolutionContext {
                       int dstride, int stride);
 } ConvolutionContext;
 
+void ff_convolution_init(ConvolutionContext *s);
+void ff_prewitt_init(ConvolutionContext *s);
+void ff_roberts_init(ConvolutionContext *s);
+void ff_sobel_init(ConvolutionContext *s);
+
 void ff_convolution_init_x86(ConvolutionContext *s);
+void ff_prewitt_init_x86(ConvolutionContext *s);
+void ff_roberts_init_x86(ConvolutionContext *s);
+void ff_sobel_init_x86(ConvolutionContext *s);
 #endif
@@ -21,6 +21,7 @@
 
 #include <string.h>
 
+#include "config.h"
 #include "libavutil/avassert.h"
 #include "libavutil/avutil.h"
 #include "libavutil/colorspace.h"
@@ -175,6 +176,39 @@ void ff_copy_rectangle(uint8_t *dst[4], int dst_linesize[4],
     }
 }
 
+static av_always_inline void blend_line8_c(uint8_t *dst, int step,
+                                           const uint8_t *mask, int w,
+                                           const uint32_t *src,
+                                           const uint32_t *alpha)
+{
+    for (int x = 0; x < w; x++) {
+        for (int i = 0; i < step; i++) {
+            unsigned a = mask[x] * alpha[i];
+            dst[i] = ((0x1010101 - a) * dst[i] + a * src[i]) >> 24;
+        }
+        dst += step;
+    }
+}
+
+static void blend_line8_step1_c(uint8_t *dst, const uint8_t *mask, int w,
+                                const uint32_t *src, const uint32_t *alpha)
+{
+    blend_line8_c(dst, 1, mask, w, src, alpha);
+}
+
+static void blend_line8_step4_c(uint8_t *dst, const uint8_t *mask, int w,
+                                const uint32_t *src, const uint32_t *alpha)
+{
+    blend_line8_c(dst, 4, mask, w, src, alpha);
+}
+
+static void blend_overlay8_c(uint8_t *dst, const uint8_t *color,
+                             const uint8_t *transp, int w)
+{
+    for (int x = 0; x < w; x++)
+        dst[x] = av_clip_uint8((((dst[x] * transp[x] + 128) * 257) >> 16) + color[x]);
+}
+
 int ff_draw_init(FFDrawContext *draw, enum AVPixelFormat format, unsigned flags)
 {
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
@@ -225,6 +259,11 @@ int ff_draw_init(FFDrawContext *draw, enum AVPixelFormat format, unsigned flags)
     for (i = 0; i < (desc->nb_components - !!(desc->flags & AV_PIX_FMT_FLAG_ALPHA && !(flags & FF_DRAW_PROCESS_ALPHA))); i++)
         draw->comp_mask[desc->comp[i].plane] |=
             1 << desc->comp[i].offset;
+    draw->blend_line8[0] = blend_line8_step1_c;
+    draw->blend_line8[1] = blend_line8_step4_c;
+    draw->blend_overlay8 = blend_overlay8_c;
+    if (ARCH_X86)
+        ff_draw_init_x86(draw);
     return 0;
 }
 
@@ -522,9 +561,9 @@ void ff_blend_rectangle(FFDrawContext *draw, FFDrawColor *color,
     }
 }
 
-static void blend_pixel16(uint8_t *dst, unsigned src, unsigned alpha,
-                          const uint8_t *mask, int mask_linesize, int l2depth,
-                          unsigned w, unsigned h, unsigned shift, unsigned xm0)
+static av_always_inline void blend_pixel16(uint8_t *dst, unsigned src, unsigned alpha,
+                                           const uint8_t *mask, int mask_linesize, int l2depth,
+                                           unsigned w, unsigned h, unsigned shift, unsigned xm0)
 {
     unsigned xm, x, y, t = 0;
     unsigned xmshf = 3 - l2depth;
@@ -546,9 +585,9 @@ static void blend_pixel16(uint8_t *dst, unsigned src, unsigned alpha,
     AV_WL16(dst, ((0x10001 - alpha) * value + alpha * src) >> 16);
 }
 
-static void blend_pixel(uint8_t *dst, unsigned src, unsigned alpha,
-                        const uint8_t *mask, int mask_linesize, int l2depth,
-                        unsigned w, unsigned h, unsigned shift, unsigned xm0)
+static av_always_inline void blend_pixel(uint8_t *dst, unsigned src, unsigned alpha,
+                                         const uint8_t *mask, int mask_linesize, int l2depth,
+                                         unsigned w, unsigned h, unsigned shift, unsigned xm0)
 {
     unsigned xm, x, y, t = 0;
     unsigned xmshf = 3 - l2depth;
@@ -569,11 +608,11 @@ static void blend_pixel(uint8_t *dst, unsigned src, unsigned alpha,
     *dst = ((0x1010101 - alpha) * *dst + alpha * src) >> 24;
 }
 
-static void blend_line_hv16(uint8_t *dst, int dst_delta,
-                            unsigned src, unsigned alpha,
-                            const uint8_t *mask, int mask_linesize, int l2depth, int w,
-                            unsigned hsub, unsigned vsub,
-                            int xm, int left, int right, int hband)
+static av_always_inline void blend_line_hv16_tmpl(uint8_t *dst, int dst_delta,
+                                                  unsigned src, unsigned alpha,
+                                                  const uint8_t *mask, int mask_linesize, int l2depth, int w,
+                                                  unsigned hsub, unsigned vsub,
+                                                  int xm, int left, int right, int hband)
 {
     int x;
 
@@ -594,11 +633,26 @@ static void blend_line_hv16(uint8_t *dst, int dst_delta,
                       right, hband, hsub + vsub, xm);
 }
 
-static void blend_line_hv(uint8_t *dst, int dst_delta,
-                          unsigned src, unsigned alpha,
-                          const uint8_t *mask, int mask_linesize, int l2depth, int w,
-                          unsigned hsub, unsigned vsub,
-                          int xm, int left, int right, int hband)
+/* Specialized for 8 bits masks, the most common */
+static void blend_line_hv16(uint8_t *dst, int dst_delta,
+                            unsigned src, unsigned alpha,
+                            const uint8_t *mask, int mask_linesize, int l2depth, int w,
+                            unsigned hsub, unsigned vsub,
+                            int xm, int left, int right, int hband)
+{
+    if (l2depth == 3)
+        blend_line_hv16_tmpl(dst, dst_delta, src, alpha, mask, mask_linesize, 3, w,
+                                   hsub, vsub, xm, left, right, hband);
+    else
+        blend_line_hv16_tmpl(dst, dst_delta, src, alpha, mask, mask_linesize, l2depth, w,
+                                   hsub, vsub, xm, left, right, hband);
+}
+
+static av_always_inline void blend_line_hv_tmpl(uint8_t *dst, int dst_delta,
+                                                unsigned src, unsigned alpha,
+                                                const uint8_t *mask, int mask_linesize, int l2depth, int w,
+                                                unsigned hsub, unsigned vsub,
+                                                int xm, int left, int right, int hband)
 {
     int x;
 
@@ -619,6 +673,50 @@ static void blend_line_hv(uint8_t *dst, int dst_delta,
                     right, hband, hsub + vsub, xm);
 }
 
+static void blend_line_hv(uint8_t *dst, int dst_delta,
+                          unsigned src, unsigned alpha,
+                          const uint8_t *mask, int mask_linesize, int l2depth, int w,
+                          unsigned hsub, unsigned vsub,
+                          int xm, int left, int right, int hband)
+{
+    if (l2depth == 3)
+        blend_line_hv_tmpl(dst, dst_delta, src, alpha, mask, mask_linesize, 3, w,
+                           hsub, vsub, xm, left, right, hband);
+    else
+        blend_line_hv_tmpl(dst, dst_delta, src, alpha, mask, mask_linesize, l2depth, w,
+                           hsub, vsub, xm, left, right, hband);
+}
+
+/* Same as blend_line_hv() for 8 bits masks and samples without subsampling,
+ * all components of a pixel at once. */
+static void blend_plane8(FFDrawContext *draw, FFDrawColor *color,
+                         unsigned alpha, int plane,
+                         uint8_t *dst, int dst_linesize,
+                         const uint8_t *mask, int mask_linesize, int w, int h)
+{
+    const int step = draw->pixelstep[plane];
+    const int w8 = step == 1 || step == 4 ? w & ~7 : 0;
+    uint32_t src[4] = { 0 }, alphas[4] = { 0 };
+
+    /* Unused components are blended with a null alpha, leaving them as is */
+    for (int i = 0; i < 4; i++) {
+        const int comp = step == 1 ? 0 : i;
+
+        if (comp < step && component_used(draw, plane, comp)) {
+            src[i]    = color->comp[plane].u8[comp];
+            alphas[i] = alpha;
+        }
+    }
+
+    for (int y = 0; y < h; y++) {
+        if (w8)
+            draw->blend_line8[step == 4](dst, mask, w8, src, alphas);
+        blend_line8_c(dst + w8 * step, step, mask + w8, w - w8, src, alphas);
+        dst  += dst_linesize;
+        mask += mask_linesize;
+    }
+}
+
 void ff_blend_mask(FFDrawContext *draw, FFDrawColor *color,
                    uint8_t *dst[], int dst_linesize[], int dst_w, int dst_h,
                    const uint8_t *mask,  int mask_linesize, int mask_w, int mask_h,
@@ -646,6 +744,12 @@ void ff_blend_mask(FFDrawContext *draw, FFDrawColor *color,
     for (plane = 0; plane < nb_planes; plane++) {
         nb_comp = draw->pixelstep[plane];
         p0 = pointer_at(draw, dst, dst_linesize, plane, x0, y0);
+        if (l2depth == 3 && draw->desc->comp[0].depth <= 8 &&
+            !draw->hsub[plane] && !draw->vsub[plane]) {
+            blend_plane8(draw, color, alpha, plane, p0, dst_linesize[plane],
+                         mask + xm0, mask_linesize, mask_w, mask_h);
+            continue;
+        }
         w_sub = mask_w;
         h_sub = mask_h;
         x_sub = x0;
@@ -716,6 +820,43 @@ void ff_blend_mask(FFDrawContext *draw, FFDrawColor *color,
     }
 }
 
+void ff_blend_overlay(FFDrawContext *draw,
+                      uint8_t *dst[], int dst_linesize[],
+                      uint8_t *color[], int color_linesize[],
+                      uint8_t *transp[], int transp_linesize[],
+                      int x0, int y0, int w, int h)
+{
+    const int depth = draw->desc->comp[0].depth;
+    const unsigned max = (1 << depth) - 1;
+
+    for (int plane = 0; plane < draw->nb_planes; plane++) {
+        const int hsub = draw->hsub[plane], vsub = draw->vsub[plane];
+        const int size  = ((w + (1 << hsub) - 1) >> hsub) * draw->pixelstep[plane];
+        const int rows  = (h + (1 << vsub) - 1) >> vsub;
+        uint8_t *d = pointer_at(draw, dst,    dst_linesize,    plane, x0, y0);
+        uint8_t *c = pointer_at(draw, color,  color_linesize,  plane, x0, y0);
+        uint8_t *t = pointer_at(draw, transp, transp_linesize, plane, x0, y0);
+
+        for (int y = 0; y < rows; y++) {
+            if (depth <= 8) {
+                const int size16 = size & ~15;
+
+                if (size16)
+                    draw->blend_overlay8(d, c, t, size16);
+                blend_overlay8_c(d + size16, c + size16, t + size16, size - size16);
+            } else {
+                for (int x = 0; x < size; x += 2) {
+                    unsigned v = ((unsigned)AV_RL16(d + x) * AV_RL16(t + x) + max / 2) / max;
+                    AV_WL16(d + x, FFMIN(v + AV_RL16(c + x), max));
+                }
+            }
+            d += dst_linesize[plane];
+            c += color_linesize[plane];
+            t += transp_linesize[plane];
+        }
+    }
+}
+
 int ff_draw_round_to_sub(FFDrawContext *draw, int sub_dir, int round_dir,
                          int value)
 {
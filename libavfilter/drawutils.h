@@ -57,6 +57,22 @@ typedef struct FFDrawContext {
     uint8_t vsub_max;
     int full_range;
     unsigned flags;
+
+    /**
+     * Blend w pixels of an 8 bits mask with a color into 8 bits samples,
+     * 1 byte apart for blend_line8[0] and 4 bytes apart for blend_line8[1].
+     * Sample i of each pixel is blended with src[i] using alpha[i] times the
+     * mask value. w must be a multiple of 8.
+     */
+    void (*blend_line8[2])(uint8_t *dst, const uint8_t *mask, int w,
+                           const uint32_t *src, const uint32_t *alpha);
+
+    /**
+     * Blend w bytes of an overlay into 8 bits samples, see ff_blend_overlay().
+     * w must be a multiple of 16.
+     */
+    void (*blend_overlay8)(uint8_t *dst, const uint8_t *color,
+                           const uint8_t *transp, int w);
 } FFDrawContext;
 
 typedef struct FFDrawColor {
@@ -83,6 +99,8 @@ typedef struct FFDrawColor {
  */
 int ff_draw_init(FFDrawContext *draw, enum AVPixelFormat format, unsigned flags);
 
+void ff_draw_init_x86(FFDrawContext *draw);
+
 /**
  * Prepare a color.
  */
@@ -140,6 +158,25 @@ void ff_blend_mask(FFDrawContext *draw, FFDrawColor *color,
                    const uint8_t *mask, int mask_linesize, int mask_w, int mask_h,
                    int l2depth, unsigned endianness, int x0, int y0);
 
+/**
+ * Blend a rectangle of an overlay into the same rectangle of an image.
+ *
+ * The overlay is made of two images in the format of the draw context:
+ * color holds its colors premultiplied by its opacity and transp its
+ * transparency, from 0 where it is opaque to the maximum sample value where
+ * it is transparent. They are obtained by blending with ff_blend_mask() the
+ * colors into an image with all samples at 0 for color, and the same masks
+ * with all color components at 0 into an image with all samples at their
+ * maximum for transp.
+ *
+ * The coordinates must be as even as the subsampling requires.
+ */
+void ff_blend_overlay(FFDrawContext *draw,
+                      uint8_t *dst[], int dst_linesize[],
+                      uint8_t *color[], int color_linesize[],
+                      uint8_t *transp[], int transp_linesize[],
+                      int x0, int y0, int w, int h);
+
 /**
  * Round a dimension according to subsampling.
  *
@@ -0,0 +1,199 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/mem.h"
+
+#include "fft2d.h"
+#include "internal.h"
+
+/* Number of columns gathered at once for the column pass: reading them
+ * row by row then touches whole cache lines */
+#define COL_BLOCK 8
+
+av_cold int ff_fft2d_init(FFT2DContext *s, int width, int height, int real, int nb_threads)
+{
+    int ret;
+
+    ff_fft2d_uninit(s);
+
+    if (width < 1 || height < 1 || nb_threads < 1 || (real && (width & 1)))
+        return AVERROR(EINVAL);
+
+    s->width          = width;
+    s->height         = height;
+    s->real           = real;
+    s->nb_threads     = nb_threads;
+    s->spectrum_width = real ? width / 2 + 1 : width;
+    s->linesize       = FFALIGN(s->spectrum_width, 4) * sizeof(AVComplexFloat);
+    s->col_stride     = FFALIGN(height, 4);
+    s->tmp_size       = FFMAX(FFALIGN(width, 4), 2 * COL_BLOCK * s->col_stride);
+
+    if (!(s->tmp = av_malloc_array(nb_threads, s->tmp_size * sizeof(*s->tmp))))
+        return AVERROR(ENOMEM);
+
+    for (int inv = 0; inv < 2; inv++) {
+        s->row_tx[inv] = av_calloc(nb_threads, sizeof(*s->row_tx[inv]));
+        s->col_tx[inv] = av_calloc(nb_threads, sizeof(*s->col_tx[inv]));
+        if (!s->row_tx[inv] || !s->col_tx[inv])
+            return AVERROR(ENOMEM);
+
+        for (int i = 0; i < nb_threads; i++) {
+            ret = av_tx_init(&s->row_tx[inv][i], &s->row_fn[inv],
+                             real ? AV_TX_FLOAT_RDFT : AV_TX_FLOAT_FFT,
+                             inv, width, NULL, 0);
+            if (ret < 0)
+                return ret;
+            ret = av_tx_init(&s->col_tx[inv][i], &s->col_fn[inv],
+                             AV_TX_FLOAT_FFT, inv, height, NULL, 0);
+            if (ret < 0)
+                return ret;
+        }
+    }
+
+    return 0;
+}
+
+av_cold void ff_fft2d_uninit(FFT2DContext *s)
+{
+    for (int inv = 0; inv < 2; inv++) {
+        for (int i = 0; i < s->nb_threads; i++) {
+            if (s->row_tx[inv])
+                av_tx_uninit(&s->row_tx[inv][i]);
+            if (s->col_tx[inv])
+                av_tx_uninit(&s->col_tx[inv][i]);
+        }
+        av_freep(&s->row_tx[inv]);
+        av_freep(&s->col_tx[inv]);
+    }
+    av_freep(&s->tmp);
+    s->nb_threads = 0;
+}
+
+static void transform_rows(FFT2DContext *s, int jobnr, uint8_t *data,
+                           ptrdiff_t linesize, int inv, int start, int end)
+{
+    AVTXContext *tx = s->row_tx[inv][jobnr];
+    const av_tx_fn fn = s->row_fn[inv];
+    AVComplexFloat *tmp = s->tmp + jobnr * s->tmp_size;
+
+    for (int y = start; y < end; y++) {
+        AVComplexFloat *row = (AVComplexFloat *)(data + y * linesize);
+
+        if (s->real) {
+            fn(tx, row, row, sizeof(float));
+        } else {
+            fn(tx, tmp, row, sizeof(*row));
+            memcpy(row, tmp, s->width * sizeof(*row));
+        }
+    }
+}
+
+static void transform_columns(FFT2DContext *s, int jobnr, uint8_t *data,
+                              ptrdiff_t linesize, int inv, int start, int end)
+{
+    AVTXContext *tx = s->col_tx[inv][jobnr];
+    const av_tx_fn fn = s->col_fn[inv];
+    const int height = s->height, stride = s->col_stride;
+    AVComplexFloat *in  = s->tmp + jobnr * s->tmp_size;
+    AVComplexFloat *out = in + COL_BLOCK * stride;
+
+    for (int x = start; x < end; x += COL_BLOCK) {
+        const int nb = FFMIN(COL_BLOCK, end - x);
+
+        for (int y = 0; y < height; y++) {
+            const AVComplexFloat *src = (const AVComplexFloat *)(data + y * linesize) + x;
+
+            for (int i = 0; i < nb; i++)
+                in[i * stride + y] = src[i];
+        }
+
+        for (int i = 0; i < nb; i++)
+            fn(tx, out + i * stride, in + i * stride, sizeof(*in));
+
+        for (int y = 0; y < height; y++) {
+            AVComplexFloat *dst = (AVComplexFloat *)(data + y * linesize) + x;
+
+            for (int i = 0; i < nb; i++)
+                dst[i] = out[i * stride + y];
+        }
+    }
+}
+
+void ff_fft2d_transform_block(FFT2DContext *s, int jobnr,
+                              void *data, ptrdiff_t linesize, int inv)
+{
+    if (!inv) {
+        transform_rows(s, jobnr, data, linesize, 0, 0, s->height);
+        transform_columns(s, jobnr, data, linesize, 0, 0, s->spectrum_width);
+    } else {
+        transform_columns(s, jobnr, data, linesize, 1, 0, s->spectrum_width);
+        transform_rows(s, jobnr, data, linesize, 1, 0, s->height);
+    }
+}
+
+typedef struct ThreadData {
+    FFT2DContext *s;
+    uint8_t *data;
+    ptrdiff_t linesize;
+    int inv;
+} ThreadData;
+
+static int rows_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    ThreadData *td = arg;
+    FFT2DContext *s = td->s;
+    const int start = (s->height *  jobnr)    / nb_jobs;
+    const int end   = (s->height * (jobnr+1)) / nb_jobs;
+
+    transform_rows(s, jobnr, td->data, td->linesize, td->inv, start, end);
+
+    return 0;
+}
+
+static int columns_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    ThreadData *td = arg;
+    FFT2DContext *s = td->s;
+    const int nb_groups = (s->spectrum_width + COL_BLOCK - 1) / COL_BLOCK;
+    const int start = (nb_groups *  jobnr)    / nb_jobs * COL_BLOCK;
+    const int end   = FFMIN((nb_groups * (jobnr+1)) / nb_jobs * COL_BLOCK,
+                            s->spectrum_width);
+
+    transform_columns(s, jobnr, td->data, td->linesize, td->inv, start, end);
+
+    return 0;
+}
+
+void ff_fft2d_transform(AVFilterContext *ctx, FFT2DContext *s,
+                        void *data, ptrdiff_t linesize, int inv)
+{
+    ThreadData td = { s, data, linesize, inv };
+    const int nb_jobs   = FFMIN(s->nb_threads, ff_filter_get_nb_threads(ctx));
+    const int nb_groups = (s->spectrum_width + COL_BLOCK - 1) / COL_BLOCK;
+
+    if (!inv) {
+        ctx->internal->execute(ctx, rows_slice, &td, NULL, FFMIN(nb_jobs, s->height));
+        ctx->internal->execute(ctx, columns_slice, &td, NULL, FFMIN(nb_jobs, nb_groups));
+    } else {
+        ctx->internal->execute(ctx, columns_slice, &td, NULL, FFMIN(nb_jobs, nb_groups));
+        ctx->internal->execute(ctx, rows_slice, &td, NULL, FFMIN(nb_jobs, s->height));
+    }
+}
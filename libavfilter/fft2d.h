@@ -0,0 +1,92 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_FFT2D_H
+#define AVFILTER_FFT2D_H
+
+#include <stddef.h>
+
+#include "libavutil/tx.h"
+
+#include "avfilter.h"
+
+/**
+ * Two-dimensional FFT of width x height values, done as a pass of
+ * transforms over the rows followed by a pass over the columns.
+ *
+ * The data is transformed in place. Row y of it starts linesize bytes after
+ * row y - 1, and linesize must keep every row aligned for av_tx.
+ *
+ * For real transforms, each row of the input holds width floats and each
+ * row of the output the width / 2 + 1 first bins of its spectrum, the
+ * others being their complex conjugates. The inverse transform goes the
+ * other way.
+ *
+ * The output is not normalized, a forward transform followed by an inverse
+ * one multiplies the data by width * height.
+ */
+typedef struct FFT2DContext {
+    int width, height;
+    int real;
+    int nb_threads;
+
+    /**
+     * Number of complex values in each row of the spectrum.
+     */
+    int spectrum_width;
+
+    /**
+     * Smallest linesize in bytes satisfying the requirements above.
+     */
+    ptrdiff_t linesize;
+
+    /* One set of contexts per thread, some transforms need scratch space */
+    AVTXContext **row_tx[2], **col_tx[2];
+    av_tx_fn row_fn[2], col_fn[2];
+
+    AVComplexFloat *tmp;
+    ptrdiff_t tmp_size;
+    int col_stride;
+} FFT2DContext;
+
+/**
+ * Allocate the transforms of a two-dimensional FFT.
+ *
+ * @param real       whether the input of the forward transform is real
+ * @param nb_threads maximum number of threads that will run transforms
+ *                   concurrently, usually ff_filter_get_nb_threads()
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int ff_fft2d_init(FFT2DContext *s, int width, int height, int real, int nb_threads);
+
+void ff_fft2d_uninit(FFT2DContext *s);
+
+/**
+ * Transform data, splitting both passes over the threads of the filter.
+ */
+void ff_fft2d_transform(AVFilterContext *ctx, FFT2DContext *s,
+                        void *data, ptrdiff_t linesize, int inv);
+
+/**
+ * Transform data from a single thread, using the scratch space of thread
+ * jobnr. This is meant for filters transforming many small blocks.
+ */
+void ff_fft2d_transform_block(FFT2DContext *s, int jobnr,
+                              void *data, ptrdiff_t linesize, int inv);
+
+#endif /* AVFILTER_FFT2D_H */
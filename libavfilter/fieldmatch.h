@@ -0,0 +1,60 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_FIELDMATCH_H
+#define AVFILTER_FIELDMATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct FieldMatchDSPContext {
+    /**
+     * Sum of absolute differences between two width x height planes.
+     */
+    int64_t (*sad)(const uint8_t *a, ptrdiff_t a_linesize,
+                   const uint8_t *b, ptrdiff_t b_linesize,
+                   int width, int height);
+
+    /**
+     * Absolute difference of two lines.
+     */
+    void (*abs_diff)(uint8_t *dst, const uint8_t *a, const uint8_t *b, int width);
+
+    /**
+     * Combing mask of one line: dst is set to 0xff where cur differs by more
+     * than cthresh from both m1 and p1 and the [1 -3 4 -3 1] vertical filter
+     * over m2, m1, cur, p1, p2 exceeds 6 * cthresh, and to 0 elsewhere.
+     */
+    void (*comb_mask)(uint8_t *dst, const uint8_t *m2, const uint8_t *m1,
+                      const uint8_t *cur, const uint8_t *p1, const uint8_t *p2,
+                      int width, int cthresh);
+} FieldMatchDSPContext;
+
+void ff_fieldmatch_init(FieldMatchDSPContext *dsp);
+void ff_fieldmatch_init_x86(FieldMatchDSPContext *dsp);
+
+int64_t ff_fieldmatch_sad_c(const uint8_t *a, ptrdiff_t a_linesize,
+                            const uint8_t *b, ptrdiff_t b_linesize,
+                            int width, int height);
+void ff_fieldmatch_abs_diff_c(uint8_t *dst, const uint8_t *a, const uint8_t *b,
+                              int width);
+void ff_fieldmatch_comb_mask_c(uint8_t *dst, const uint8_t *m2, const uint8_t *m1,
+                               const uint8_t *cur, const uint8_t *p1, const uint8_t *p2,
+                               int width, int cthresh);
+
+#endif /* AVFILTER_FIELDMATCH_H */
@@ -19,7 +19,10 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <string.h>
+
 #include "libavutil/avassert.h"
+#include "libavutil/common.h"
 #include "framequeue.h"
 
 static inline FFFrameBucket *bucket(FFFrameQueue *fq, size_t idx)
@@ -29,6 +32,19 @@ static inline FFFrameBucket *bucket(FFFrameQueue *fq, size_t idx)
 
 void ff_framequeue_global_init(FFFrameQueueGlobal *fqg)
 {
+    memset(fqg, 0, sizeof(*fqg));
+}
+
+static size_t frame_bytes(const AVFrame *frame)
+{
+    size_t bytes = 0;
+    int i;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(frame->buf) && frame->buf[i]; i++)
+        bytes += frame->buf[i]->size;
+    for (i = 0; i < frame->nb_extended_buf; i++)
+        bytes += frame->extended_buf[i]->size;
+    return bytes;
 }
 
 static void check_consistency(FFFrameQueue *fq)
@@ -48,6 +64,7 @@ void ff_framequeue_init(FFFrameQueue *fq, FFFrameQueueGlobal *fqg)
 {
     fq->queue = &fq->first_bucket;
     fq->allocated = 1;
+    fq->global = fqg;
 }
 
 void ff_framequeue_free(FFFrameQueue *fq)
@@ -88,9 +105,19 @@ int ff_framequeue_add(FFFrameQueue *fq, AVFrame *frame)
     }
     b = bucket(fq, fq->queued);
     b->frame = frame;
+    b->bytes = frame_bytes(frame);
     fq->queued++;
     fq->total_frames_head++;
     fq->total_samples_head += frame->nb_samples;
+    fq->queued_bytes += b->bytes;
+    fq->peak_queued_bytes = FFMAX(fq->peak_queued_bytes, fq->queued_bytes);
+    if (fq->global) {
+        FFFrameQueueGlobal *fqg = fq->global;
+
+        fqg->queued_frames++;
+        fqg->queued_bytes += b->bytes;
+        fqg->peak_queued_bytes = FFMAX(fqg->peak_queued_bytes, fqg->queued_bytes);
+    }
     check_consistency(fq);
     return 0;
 }
@@ -108,6 +135,11 @@ AVFrame *ff_framequeue_take(FFFrameQueue *fq)
     fq->total_frames_tail++;
     fq->total_samples_tail += b->frame->nb_samples;
     fq->samples_skipped = 0;
+    fq->queued_bytes -= b->bytes;
+    if (fq->global) {
+        fq->global->queued_frames--;
+        fq->global->queued_bytes -= b->bytes;
+    }
     check_consistency(fq);
     return b->frame;
 }
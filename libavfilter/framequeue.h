@@ -33,18 +33,46 @@
 
 typedef struct FFFrameBucket {
     AVFrame *frame;
+    size_t bytes;
 } FFFrameBucket;
 
 /**
  * Structure to hold global options and statistics for frame queues.
  *
- * This structure is intended to allow implementing global control of the
- * frame queues, including memory consumption caps.
- *
- * It is currently empty.
+ * The limits are not enforced by the queues themselves: the producers are
+ * expected to check ff_framequeue_full() and back off.
  */
 typedef struct FFFrameQueueGlobal {
-    char dummy; /* C does not allow empty structs */
+
+    /**
+     * Limits for each queue, 0 for none.
+     */
+    size_t max_queued_frames;
+    uint64_t max_queued_bytes;
+
+    /**
+     * Limits for all the queues together, 0 for none.
+     */
+    size_t max_total_frames;
+    uint64_t max_total_bytes;
+
+    /**
+     * Ignore the limits, to get out of a situation where they would
+     * prevent any progress.
+     */
+    int overrun;
+
+    /**
+     * Number of frames and bytes currently queued in all the queues.
+     */
+    size_t queued_frames;
+    uint64_t queued_bytes;
+
+    /**
+     * Highest value reached by queued_bytes.
+     */
+    uint64_t peak_queued_bytes;
+
 } FFFrameQueueGlobal;
 
 /**
@@ -105,6 +133,21 @@ typedef struct FFFrameQueue {
      */
     int samples_skipped;
 
+    /**
+     * Global structure the queue is attached to.
+     */
+    FFFrameQueueGlobal *global;
+
+    /**
+     * Size of the buffers referenced by the queued frames.
+     */
+    uint64_t queued_bytes;
+
+    /**
+     * Highest value reached by queued_bytes.
+     */
+    uint64_t peak_queued_bytes;
+
 } FFFrameQueue;
 
 /**
@@ -114,6 +157,7 @@ void ff_framequeue_global_init(FFFrameQueueGlobal *fqg);
 
 /**
  * Init a frame queue and attach it to a global structure.
+ * The global structure may be NULL, it must outlive the queue otherwise.
  */
 void ff_framequeue_init(FFFrameQueue *fq, FFFrameQueueGlobal *fqg);
 
@@ -156,6 +200,39 @@ static inline uint64_t ff_framequeue_queued_samples(const FFFrameQueue *fq)
     return fq->total_samples_head - fq->total_samples_tail;
 }
 
+/**
+ * Get the size of the buffers referenced by the queued frames.
+ */
+static inline uint64_t ff_framequeue_queued_bytes(const FFFrameQueue *fq)
+{
+    return fq->queued_bytes;
+}
+
+/**
+ * Tell if all the queues attached to a global structure together reached
+ * one of its limits.
+ */
+static inline int ff_framequeue_global_full(const FFFrameQueueGlobal *fqg)
+{
+    return (fqg->max_total_frames && fqg->queued_frames >= fqg->max_total_frames) ||
+           (fqg->max_total_bytes  && fqg->queued_bytes  >= fqg->max_total_bytes);
+}
+
+/**
+ * Tell if the queue reached one of the limits set in its global structure,
+ * either its own or, if it is not empty, the one of all the queues.
+ */
+static inline int ff_framequeue_full(const FFFrameQueue *fq)
+{
+    const FFFrameQueueGlobal *fqg = fq->global;
+
+    if (!fqg || fqg->overrun || !fq->queued)
+        return 0;
+    return (fqg->max_queued_frames && fq->queued       >= fqg->max_queued_frames) ||
+           (fqg->max_queued_bytes  && fq->queued_bytes >= fqg->max_queued_bytes)  ||
+           ff_framequeue_global_full(fqg);
+}
+
 /**
  * Update the statistics after a frame accessed using ff_framequeue_peek()
  * was modified.
@@ -130,10 +130,29 @@ struct AVFilterGraphInternal {
     void *thread;
     avfilter_execute_func *thread_execute;
     FFFrameQueueGlobal frame_queues;
+
+    /**
+     * A filter backed off while the limits for all the queues together were
+     * reached: it must be activated again as soon as they are not, whichever
+     * queue the frames are taken from.
+     */
+    int blocked_on_total;
 };
 
 struct AVFilterInternal {
     avfilter_execute_func *execute;
+
+    /**
+     * Inputs whose source filter was not sorted yet, only meaningful while
+     * the formats of the graph are negotiated.
+     */
+    int nb_unsorted_inputs;
+
+    /**
+     * The filter backed off because the queue of one of its outputs reached
+     * its limit.
+     */
+    int blocked_on_queue;
 };
 
 /**
@@ -338,11 +357,29 @@ void ff_filter_graph_remove_filter(AVFilterGraph *graph, AVFilterContext *filter
  */
 #define FF_FILTER_FLAG_HWFRAME_AWARE (1 << 0)
 
+/**
+ * The filter converts between any of the video formats it supports, like
+ * the scale filter inserted for automatic conversions, so the formats of
+ * its input and output may be picked to minimize the cost of the conversion.
+ */
+#define FF_FILTER_FLAG_FORMAT_CONVERSION (1 << 1)
+
 /**
  * Run one round of processing on a filter graph.
  */
 int ff_filter_graph_run_once(AVFilterGraph *graph);
 
+/**
+ * Activate a filter that backed off because of the frame queue limits,
+ * ignoring them. This is meant to be used when a frame is needed and
+ * ff_filter_graph_run_once() found nothing to run, since the filter
+ * consuming the full queue may be waiting for the frames it would produce.
+ * Full queues to sinks are left to the application to read.
+ *
+ * @return  AVERROR(EAGAIN) if no filter was activated
+ */
+int ff_filter_graph_run_blocked(AVFilterGraph *graph);
+
 /**
  * Normalize the qscale factor
  * FIXME the H264 qscale is a log based scale, mpeg1/2 is not, the code below
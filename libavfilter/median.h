@@ -53,4 +53,6 @@ typedef struct MedianContext {
                          int slice_h_start, int slice_h_end, int jobnr);
 } MedianContext;
 
+void ff_median_init_x86(MedianContext *s);
+
 #endif
@@ -158,3 +158,63 @@ static void fn(filter_plane)(AVFilterContext *ctx, const uint8_t *ssrc, int src_
         dst += dst_linesize;
     }
 }
+
+/**
+ * Median of the square windows of radius 1 and 2, using sorting networks
+ * instead of the histograms. The edges are replicated like above.
+ */
+static void fn(filter_plane_network)(AVFilterContext *ctx, const uint8_t *ssrc, int src_linesize,
+                                     uint8_t *ddst, int dst_linesize, int width, int height,
+                                     int slice_h_start, int slice_h_end, int jobnr)
+{
+    MedianContext *s = ctx->priv;
+    const int radius = s->radius;
+    const int size = 2 * radius + 1;
+    const pixel *src = (const pixel *)ssrc;
+    pixel *dst = (pixel *)ddst;
+
+    src_linesize /= sizeof(pixel);
+    dst_linesize /= sizeof(pixel);
+
+    for (int i = slice_h_start; i < slice_h_end; i++) {
+        const pixel *rows[5];
+        int p[25];
+
+        for (int k = 0; k < size; k++)
+            rows[k] = src + av_clip(i + k - radius, 0, height - 1) * src_linesize;
+
+        for (int j = 0; j < width; j++) {
+            /* the inner columns do not need their positions clipped */
+            if (j == radius) {
+                if (radius == 1) {
+                    for (; j < width - 1; j++) {
+                        for (int k = 0; k < 3; k++) {
+                            p[3 * k    ] = rows[k][j - 1];
+                            p[3 * k + 1] = rows[k][j    ];
+                            p[3 * k + 2] = rows[k][j + 1];
+                        }
+                        dst[j] = median9(p);
+                    }
+                } else {
+                    for (; j < width - 2; j++) {
+                        for (int k = 0; k < 5; k++) {
+                            p[5 * k    ] = rows[k][j - 2];
+                            p[5 * k + 1] = rows[k][j - 1];
+                            p[5 * k + 2] = rows[k][j    ];
+                            p[5 * k + 3] = rows[k][j + 1];
+                            p[5 * k + 4] = rows[k][j + 2];
+                        }
+                        dst[j] = median25(p);
+                    }
+                }
+            }
+
+            for (int k = 0; k < size; k++)
+                for (int l = 0; l < size; l++)
+                    p[size * k + l] = rows[k][av_clip(j + l - radius, 0, width - 1)];
+            dst[j] = radius == 1 ? median9(p) : median25(p);
+        }
+
+        dst += dst_linesize;
+    }
+}
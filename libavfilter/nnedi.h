@@ -0,0 +1,51 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef AVFILTER_NNEDI_H
+#define AVFILTER_NNEDI_H
+
+typedef struct NNEDIDSPContext {
+    /**
+     * Evaluate the four neurons of the first prescreener layer.
+     * The kernel is stored input-major, kernel[4 * k + c] being the weight
+     * of input k for neuron c. n must be a multiple of 4.
+     */
+    void (*prescreen_l0)(float *dst, const float *kernel,
+                         const float *input, int n);
+
+    /**
+     * dst[c] = scale * sum(weights[k * cols + c] * input[k]) + bias[c]
+     * for every c < cols. The weights are stored input-major, cols must be
+     * a multiple of 32 and dst, weights and bias must be 32-byte aligned.
+     */
+    void (*predict)(float *dst, const float *weights, const float *bias,
+                    const float *input, int n, int cols, float scale);
+
+    /**
+     * Weighted average of the elliott neurons by the exponentiated softmax
+     * neurons, sums[0] receives the weighted sum and sums[1] the sum of
+     * weights. n must be a multiple of 16.
+     */
+    void (*wae5)(const float *softmax, const float *elliott, int n,
+                 float *sums);
+} NNEDIDSPContext;
+
+void ff_nnedi_init(NNEDIDSPContext *dsp);
+void ff_nnedi_init_x86(NNEDIDSPContext *dsp);
+
+#endif /* AVFILTER_NNEDI_H */
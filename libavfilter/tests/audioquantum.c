@@ -0,0 +1,98 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+
+#include "libavutil/adler32.h"
+#include "libavutil/error.h"
+#include "libavutil/frame.h"
+#include "libavutil/opt.h"
+#include "libavutil/samplefmt.h"
+
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+
+/**
+ * Print the size and checksum of every frame from the output of an audio
+ * graph, then the checksum of all the samples.
+ */
+static int run(int quantum, const char *desc)
+{
+    AVFilterInOut *inputs = NULL, *outputs = NULL;
+    AVFilterContext *sink;
+    AVFilterGraph *graph;
+    AVFrame *frame;
+    uint32_t total = 0;
+    int64_t nb_samples = 0;
+    int ret;
+
+    printf("audio_quantum=%d %s\n", quantum, desc);
+
+    graph = avfilter_graph_alloc();
+    frame = av_frame_alloc();
+    if (!graph || !frame) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    graph->nb_threads = 1;
+    if ((ret = av_opt_set_int(graph, "audio_quantum", quantum, 0)) < 0 ||
+        (ret = avfilter_graph_parse2(graph, desc, &inputs, &outputs)) < 0 ||
+        (ret = avfilter_graph_create_filter(&sink, avfilter_get_by_name("abuffersink"),
+                                            "out", NULL, NULL, graph)) < 0 ||
+        (ret = avfilter_link(outputs->filter_ctx, outputs->pad_idx, sink, 0)) < 0 ||
+        (ret = avfilter_graph_config(graph, NULL)) < 0)
+        goto end;
+
+    while ((ret = av_buffersink_get_frame(sink, frame)) >= 0) {
+        int size = av_samples_get_buffer_size(NULL, frame->channels, frame->nb_samples,
+                                              frame->format, 1);
+        uint32_t crc = av_adler32_update(0, frame->extended_data[0], size);
+
+        total = av_adler32_update(total, frame->extended_data[0], size);
+        nb_samples += frame->nb_samples;
+        printf("%"PRId64", %d, 0x%08"PRIx32"\n", frame->pts, frame->nb_samples, crc);
+        av_frame_unref(frame);
+    }
+    if (ret == AVERROR_EOF)
+        ret = 0;
+    printf("%"PRId64" samples, 0x%08"PRIx32"\n", nb_samples, total);
+
+end:
+    if (ret < 0)
+        printf("error: %s\n", av_err2str(ret));
+    avfilter_inout_free(&inputs);
+    avfilter_inout_free(&outputs);
+    av_frame_free(&frame);
+    avfilter_graph_free(&graph);
+    return ret;
+}
+
+int main(void)
+{
+    static const char *small  = "sine=r=8000:samples_per_frame=1000:d=1.3,volume=0.5,volume=2";
+    static const char *large  = "sine=r=8000:samples_per_frame=1500:d=1.3,volume=0.5,volume=2";
+    int ret = 0;
+
+    ret |= run(0,    small);
+    /* frames merged up to the quantum, then a last partial frame */
+    ret |= run(4096, small);
+    /* frames split down to the quantum */
+    ret |= run(1024, large);
+
+    return !!ret;
+}
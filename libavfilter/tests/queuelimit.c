@@ -0,0 +1,134 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stdio.h>
+
+#include "libavutil/error.h"
+#include "libavutil/frame.h"
+#include "libavutil/opt.h"
+
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+
+#define MAX_SINKS 4
+
+/**
+ * Build a graph whose outputs, labeled a, b, ..., go to buffersinks, then
+ * read a frame from the sink designated by each letter of reads, or for o
+ * request a frame from the oldest sink and read what the sinks got, the
+ * way ffmpeg does.
+ */
+static int run(const char *opts, const char *desc, const char *reads)
+{
+    AVFilterContext *sinks[MAX_SINKS] = { NULL };
+    AVFilterInOut *inputs = NULL, *outputs = NULL, *cur;
+    AVFilterGraph *graph;
+    AVFrame *frame;
+    int ret;
+
+    printf("%s %s\n", opts, desc);
+
+    graph = avfilter_graph_alloc();
+    frame = av_frame_alloc();
+    if (!graph || !frame) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    graph->nb_threads = 1;
+    if ((ret = av_set_options_string(graph, opts, "=", ":")) < 0 ||
+        (ret = avfilter_graph_parse2(graph, desc, &inputs, &outputs)) < 0)
+        goto end;
+
+    for (cur = outputs; cur; cur = cur->next) {
+        int idx = cur->name[0] - 'a';
+
+        if (idx < 0 || idx >= MAX_SINKS) {
+            ret = AVERROR(EINVAL);
+            goto end;
+        }
+        if ((ret = avfilter_graph_create_filter(&sinks[idx], avfilter_get_by_name("buffersink"),
+                                                cur->name, NULL, NULL, graph)) < 0 ||
+            (ret = avfilter_link(cur->filter_ctx, cur->pad_idx, sinks[idx], 0)) < 0)
+            goto end;
+    }
+    if ((ret = avfilter_graph_config(graph, NULL)) < 0)
+        goto end;
+
+    for (; *reads; reads++) {
+        if (*reads == 'o') {
+            ret = avfilter_graph_request_oldest(graph);
+            printf("oldest: %s\n", ret >= 0 ? "ok" : av_err2str(ret));
+            if (ret < 0 && ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+                goto end;
+            for (int i = 0; i < MAX_SINKS; i++) {
+                while (sinks[i] &&
+                       av_buffersink_get_frame_flags(sinks[i], frame,
+                                                     AV_BUFFERSINK_FLAG_NO_REQUEST) >= 0) {
+                    printf("%c: pts %"PRId64"\n", 'a' + i, frame->pts);
+                    av_frame_unref(frame);
+                }
+            }
+            continue;
+        }
+        ret = av_buffersink_get_frame(sinks[*reads - 'a'], frame);
+        if (ret == AVERROR(EAGAIN)) {
+            printf("%c: EAGAIN\n", *reads);
+        } else if (ret < 0) {
+            goto end;
+        } else {
+            printf("%c: pts %"PRId64"\n", *reads, frame->pts);
+            av_frame_unref(frame);
+        }
+    }
+    ret = 0;
+
+end:
+    if (ret < 0)
+        printf("error: %s\n", av_err2str(ret));
+    avfilter_inout_free(&inputs);
+    avfilter_inout_free(&outputs);
+    av_frame_free(&frame);
+    avfilter_graph_free(&graph);
+    return ret;
+}
+
+int main(void)
+{
+    int ret = 0;
+
+    /* b fills up: split backs off until b is read */
+    ret |= run("max_link_frames=3", "testsrc=s=32x32:r=25,split[a][b]",
+               "aaaaabaabbbbbaa");
+    ret |= run("max_link_bytes=4096", "testsrc=s=32x32:r=25,format=rgba,split[a][b]",
+               "aaaabaa");
+    /* the first split is blocked by the frames queued on d, and must
+     * resume when they are read */
+    ret |= run("max_queued_frames=4",
+               "testsrc=s=32x32:r=25,split[a][b];testsrc=s=32x32:r=25,split[c][d]",
+               "ccaaadaadbba");
+    /* a split merged again must not stall */
+    ret |= run("max_link_frames=1:max_queued_frames=1",
+               "testsrc=s=32x32:r=25,split[x][y];[x][y]hstack[a]", "aaaa");
+    /* same through avfilter_graph_request_oldest(), with a sink of each kind */
+    ret |= run("max_link_frames=1:max_queued_frames=1",
+               "testsrc=s=32x32:r=25:d=0.2,split[x][y];[y]select=gte(n\\,3)[z];[x][z]hstack[a]", "oooooo");
+    ret |= run("max_link_frames=1:max_queued_frames=1",
+               "testsrc=s=32x32:r=25:d=0.2,split[x][y];[y]select=gte(n\\,3)[z];[x][z]hstack,nullsink", "oooooo");
+
+    return !!ret;
+}
@@ -36,8 +36,8 @@
 #include "libavutil/imgutils.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
-#include "libavcodec/avfft.h"
 #include "avfilter.h"
+#include "bm3d.h"
 #include "filters.h"
 #include "formats.h"
 #include "framesync.h"
@@ -45,6 +45,7 @@
 #include "video.h"
 
 #define MAX_NB_THREADS 32
+#define MAX_CACHE_SIZE (4 << 20)
 
 enum FilterModes {
     BASIC,
@@ -69,18 +70,25 @@ typedef struct PosPairCode {
     int x, y;
 } PosPairCode;
 
+typedef struct BlockCache {
+    float *data;
+    int *pos;
+    int nb_entries;
+    int wbits;
+    int wmask, hmask;
+} BlockCache;
+
 typedef struct SliceContext {
-    DCTContext *gdctf, *gdcti;
-    DCTContext *dctf, *dcti;
-    FFTSample *bufferh;
-    FFTSample *bufferv;
-    FFTSample *bufferz;
-    FFTSample *buffer;
-    FFTSample *rbufferh;
-    FFTSample *rbufferv;
-    FFTSample *rbufferz;
-    FFTSample *rbuffer;
+    float *bufferh;
+    float *bufferv;
+    float *bufferz;
+    float *bufferg;
+    float *buffer;
+    float *rbufferz;
+    float *rbuffer;
     float *num, *den;
+    BlockCache cache;
+    BlockCache rcache;
     PosPairCode match_blocks[256];
     int nb_match_blocks;
     PosCode *search_positions;
@@ -111,14 +119,17 @@ typedef struct BM3DContext {
 
     SliceContext slices[MAX_NB_THREADS];
 
+    float *dct, *dctt;
+    float *idct, *idctt;
+    float *gdctt, *gidctt;
+
     FFFrameSync fs;
     int nb_threads;
 
+    BM3DDSPContext dsp;
+
     void (*get_block_row)(const uint8_t *srcp, int src_linesize,
                           int y, int x, int block_size, float *dst);
-    double (*do_block_ssd)(struct BM3DContext *s, PosCode *pos,
-                           const uint8_t *src, int src_stride,
-                           int r_y, int r_x);
     void (*do_output)(struct BM3DContext *s, uint8_t *dst, int dst_linesize,
                       int plane, int nb_jobs);
     void (*block_filtering)(struct BM3DContext *s,
@@ -232,48 +243,74 @@ static int cmp_scores(const void *a, const void *b)
     return FFDIFFSIGN(pair1->score, pair2->score);
 }
 
-static double do_block_ssd(BM3DContext *s, PosCode *pos, const uint8_t *src, int src_stride, int r_y, int r_x)
+static int64_t block_ssd(const uint8_t *srcp, const uint8_t *refp,
+                         ptrdiff_t stride, int block_size)
 {
-    const uint8_t *srcp = src + pos->y * src_stride + pos->x;
-    const uint8_t *refp = src + r_y * src_stride + r_x;
-    const int block_size = s->block_size;
-    double dist = 0.;
+    int64_t dist = 0;
     int x, y;
 
     for (y = 0; y < block_size; y++) {
         for (x = 0; x < block_size; x++) {
-            double temp = refp[x] - srcp[x];
+            int temp = refp[x] - srcp[x];
             dist += temp * temp;
         }
 
-        srcp += src_stride;
-        refp += src_stride;
+        srcp += stride;
+        refp += stride;
     }
 
     return dist;
 }
 
-static double do_block_ssd16(BM3DContext *s, PosCode *pos, const uint8_t *src, int src_stride, int r_y, int r_x)
+static int64_t block_ssd16(const uint8_t *srcpp, const uint8_t *refpp,
+                           ptrdiff_t stride, int block_size)
 {
-    const uint16_t *srcp = (uint16_t *)src + pos->y * src_stride / 2 + pos->x;
-    const uint16_t *refp = (uint16_t *)src + r_y * src_stride / 2 + r_x;
-    const int block_size = s->block_size;
-    double dist = 0.;
+    const uint16_t *srcp = (const uint16_t *)srcpp;
+    const uint16_t *refp = (const uint16_t *)refpp;
+    int64_t dist = 0;
     int x, y;
 
     for (y = 0; y < block_size; y++) {
         for (x = 0; x < block_size; x++) {
-            double temp = refp[x] - srcp[x];
+            int64_t temp = refp[x] - srcp[x];
             dist += temp * temp;
         }
 
-        srcp += src_stride / 2;
-        refp += src_stride / 2;
+        srcp += stride / 2;
+        refp += stride / 2;
     }
 
     return dist;
 }
 
+static void mat_mul(float *dst, const float *a, const float *b,
+                    int rows, int n, int cols)
+{
+    for (int y = 0; y < rows; y++) {
+        float *d = dst + y * cols;
+
+        for (int x = 0; x < cols; x++)
+            d[x] = 0.f;
+
+        for (int k = 0; k < n; k++) {
+            const float *bk = b + k * cols;
+            const float ak = a[y * n + k];
+
+            for (int x = 0; x < cols; x++)
+                d[x] += ak * bk[x];
+        }
+    }
+}
+
+av_cold void ff_bm3d_init(BM3DDSPContext *dsp, int depth)
+{
+    dsp->ssd = depth > 8 ? block_ssd16 : block_ssd;
+    dsp->mat_mul = mat_mul;
+
+    if (ARCH_X86)
+        ff_bm3d_init_x86(dsp, depth);
+}
+
 static void do_block_matching_multi(BM3DContext *s, const uint8_t *src, int src_stride, int src_range,
                                     const PosCode *search_pos, int search_size, float th_mse,
                                     int r_y, int r_x, int plane, int jobnr)
@@ -282,13 +319,16 @@ static void do_block_matching_multi(BM3DContext *s, const uint8_t *src, int src_
     double MSE2SSE = s->group_size * s->block_size * s->block_size * src_range * src_range / (s->max * s->max);
     double distMul = 1. / MSE2SSE;
     double th_sse = th_mse * MSE2SSE;
+    const int bpc = (s->depth + 7) / 8;
+    const uint8_t *refp = src + r_y * src_stride + r_x * bpc;
     int i, index = sc->nb_match_blocks;
 
     for (i = 0; i < search_size; i++) {
         PosCode pos = search_pos[i];
         double dist;
 
-        dist = s->do_block_ssd(s, &pos, src, src_stride, r_y, r_x);
+        dist = s->dsp.ssd(src + pos.y * src_stride + pos.x * bpc, refp,
+                          src_stride, s->block_size);
 
         // Only match similar blocks but not identical blocks
         if (dist <= th_sse && dist != 0) {
@@ -391,6 +431,121 @@ static void get_block_row16(const uint8_t *srcp, int src_linesize,
     }
 }
 
+static void block_dct(BM3DContext *s, float *dst, float *tmp, const float *src)
+{
+    const int block_size = s->block_size;
+
+    s->dsp.mat_mul(tmp, s->dct, src, block_size, block_size, block_size);
+    s->dsp.mat_mul(dst, tmp, s->dctt, block_size, block_size, block_size);
+}
+
+static void block_idct(BM3DContext *s, float *dst, float *tmp, const float *src)
+{
+    const int block_size = s->block_size;
+
+    s->dsp.mat_mul(tmp, s->idct, src, block_size, block_size, block_size);
+    s->dsp.mat_mul(dst, tmp, s->idctt, block_size, block_size, block_size);
+}
+
+static void reset_cache(BlockCache *cache)
+{
+    if (cache->pos)
+        memset(cache->pos, 0xff, 2 * cache->nb_entries * sizeof(*cache->pos));
+}
+
+/*
+ * Return the 2D DCT of the block at (y, x). The search windows of
+ * neighbouring reference blocks overlap, so the transforms are kept in a
+ * small direct-mapped cache indexed by the low bits of the position.
+ */
+static const float *get_block_dct(BM3DContext *s, SliceContext *sc, BlockCache *cache,
+                                  const uint8_t *src, int src_linesize, int y, int x)
+{
+    const int block_size = s->block_size;
+    const int idx = ((y & cache->hmask) << cache->wbits) | (x & cache->wmask);
+    float *block = cache->data + idx * block_size * block_size;
+
+    if (cache->pos[2 * idx] != y || cache->pos[2 * idx + 1] != x) {
+        for (int i = 0; i < block_size; i++)
+            s->get_block_row(src, src_linesize, y + i, x, block_size, sc->bufferh + block_size * i);
+        block_dct(s, block, sc->bufferv, sc->bufferh);
+        cache->pos[2 * idx]     = y;
+        cache->pos[2 * idx + 1] = x;
+    }
+
+    return block;
+}
+
+/*
+ * 1D DCT of every coefficient along the group of matched blocks, zero-padded
+ * to pgroup_size. The result is stored coefficient-major with a stride of
+ * pgroup_size. Without grouping the single block is processed in place.
+ */
+static float *group_dct(BM3DContext *s, SliceContext *sc, float *buffer,
+                        float *bufferz, int nb_match_blocks)
+{
+    const int buffer_linesize = s->block_size * s->block_size;
+    float *bufferg = sc->bufferg;
+
+    if (s->group_size == 1)
+        return buffer;
+
+    for (int i = 0; i < buffer_linesize; i++) {
+        for (int k = 0; k < nb_match_blocks; k++)
+            bufferg[i * nb_match_blocks + k] = buffer[k * buffer_linesize + i];
+    }
+
+    s->dsp.mat_mul(bufferz, bufferg, s->gdctt, buffer_linesize,
+                   nb_match_blocks, s->pgroup_size);
+
+    return bufferz;
+}
+
+static void group_idct(BM3DContext *s, SliceContext *sc, float *buffer,
+                       const float *bufferz, int nb_match_blocks)
+{
+    const int buffer_linesize = s->block_size * s->block_size;
+    const int pgroup_size = s->pgroup_size;
+    float *bufferg = sc->bufferg;
+
+    if (s->group_size == 1)
+        return;
+
+    s->dsp.mat_mul(bufferg, bufferz, s->gidctt, buffer_linesize,
+                   pgroup_size, pgroup_size);
+
+    for (int i = 0; i < buffer_linesize; i++) {
+        for (int k = 0; k < nb_match_blocks; k++)
+            buffer[k * buffer_linesize + i] = bufferg[i * pgroup_size + k];
+    }
+}
+
+static void aggregate(BM3DContext *s, SliceContext *sc, const float *buffer,
+                      int y, int x, int plane, float num_weight, float den_weight)
+{
+    const int buffer_linesize = s->block_size * s->block_size;
+    const int block_size = s->block_size;
+    const int width = s->planewidth[plane];
+    float *bufferh = sc->bufferh;
+    int i, j, k;
+
+    for (k = 0; k < sc->nb_match_blocks; k++) {
+        float *num = sc->num + y * width + x;
+        float *den = sc->den + y * width + x;
+
+        block_idct(s, bufferh, sc->bufferv, buffer + k * buffer_linesize);
+
+        for (i = 0; i < block_size; i++) {
+            for (j = 0; j < block_size; j++) {
+                num[j] += bufferh[i * block_size + j] * num_weight;
+                den[j] += den_weight;
+            }
+            num += width;
+            den += width;
+        }
+    }
+}
+
 static void basic_block_filtering(BM3DContext *s, const uint8_t *src, int src_linesize,
                                   const uint8_t *ref, int ref_linesize,
                                   int y, int x, int plane, int jobnr)
@@ -399,55 +554,27 @@ static void basic_block_filtering(BM3DContext *s, const uint8_t *src, int src_li
     const int buffer_linesize = s->block_size * s->block_size;
     const int nb_match_blocks = sc->nb_match_blocks;
     const int block_size = s->block_size;
-    const int width = s->planewidth[plane];
-    const int pgroup_size = s->pgroup_size;
-    const int group_size = s->group_size;
+    const int zstride = s->group_size > 1 ? s->pgroup_size : 1;
     float *buffer = sc->buffer;
-    float *bufferh = sc->bufferh;
-    float *bufferv = sc->bufferv;
-    float *bufferz = sc->bufferz;
+    float *bufferz;
     float threshold[4];
     float den_weight, num_weight;
     int retained = 0;
     int i, j, k;
 
     for (k = 0; k < nb_match_blocks; k++) {
-        const int y = sc->match_blocks[k].y;
-        const int x = sc->match_blocks[k].x;
-
-        for (i = 0; i < block_size; i++) {
-            s->get_block_row(src, src_linesize, y + i, x, block_size, bufferh + block_size * i);
-            av_dct_calc(sc->dctf, bufferh + block_size * i);
-        }
+        const float *block = get_block_dct(s, sc, &sc->cache, src, src_linesize,
+                                           sc->match_blocks[k].y, sc->match_blocks[k].x);
 
-        for (i = 0; i < block_size; i++) {
-            for (j = 0; j < block_size; j++) {
-                bufferv[i * block_size + j] = bufferh[j * block_size + i];
-            }
-            av_dct_calc(sc->dctf, bufferv + i * block_size);
-        }
-
-        for (i = 0; i < block_size; i++) {
-            memcpy(buffer + k * buffer_linesize + i * block_size,
-                   bufferv + i * block_size, block_size * 4);
-        }
+        memcpy(buffer + k * buffer_linesize, block, buffer_linesize * sizeof(*buffer));
     }
 
-    for (i = 0; i < block_size; i++) {
-        for (j = 0; j < block_size; j++) {
-            for (k = 0; k < nb_match_blocks; k++)
-                bufferz[k] = buffer[buffer_linesize * k + i * block_size + j];
-            if (group_size > 1)
-                av_dct_calc(sc->gdctf, bufferz);
-            bufferz += pgroup_size;
-        }
-    }
+    bufferz = group_dct(s, sc, buffer, sc->bufferz, nb_match_blocks);
 
     threshold[0] = s->hard_threshold * s->sigma * M_SQRT2 * block_size * block_size * (1 << (s->depth - 8)) / 255.f;
     threshold[1] = threshold[0] * sqrtf(2.f);
     threshold[2] = threshold[0] * 2.f;
     threshold[3] = threshold[0] * sqrtf(8.f);
-    bufferz = sc->bufferz;
 
     for (i = 0; i < block_size; i++) {
         for (j = 0; j < block_size; j++) {
@@ -460,54 +587,16 @@ static void basic_block_filtering(BM3DContext *s, const uint8_t *src, int src_li
                     bufferz[k] = 0;
                 }
             }
-            bufferz += pgroup_size;
+            bufferz += zstride;
         }
     }
 
-    bufferz = sc->bufferz;
-    buffer = sc->buffer;
-    for (i = 0; i < block_size; i++) {
-        for (j = 0; j < block_size; j++) {
-            if (group_size > 1)
-                av_dct_calc(sc->gdcti, bufferz);
-            for (k = 0; k < nb_match_blocks; k++) {
-                buffer[buffer_linesize * k + i * block_size + j] = bufferz[k];
-            }
-            bufferz += pgroup_size;
-        }
-    }
+    group_idct(s, sc, buffer, sc->bufferz, nb_match_blocks);
 
     den_weight = retained < 1 ? 1.f : 1.f / retained;
     num_weight = den_weight;
 
-    buffer = sc->buffer;
-    for (k = 0; k < nb_match_blocks; k++) {
-        float *num = sc->num + y * width + x;
-        float *den = sc->den + y * width + x;
-
-        for (i = 0; i < block_size; i++) {
-            memcpy(bufferv + i * block_size,
-                   buffer + k * buffer_linesize + i * block_size,
-                   block_size * 4);
-        }
-
-        for (i = 0; i < block_size; i++) {
-            av_dct_calc(sc->dcti, bufferv + block_size * i);
-            for (j = 0; j < block_size; j++) {
-                bufferh[j * block_size + i] = bufferv[i * block_size + j];
-            }
-        }
-
-        for (i = 0; i < block_size; i++) {
-            av_dct_calc(sc->dcti, bufferh + block_size * i);
-            for (j = 0; j < block_size; j++) {
-                num[j] += bufferh[i * block_size + j] * num_weight;
-                den[j] += den_weight;
-            }
-            num += width;
-            den += width;
-        }
-    }
+    aggregate(s, sc, buffer, y, x, plane, num_weight, den_weight);
 }
 
 static void final_block_filtering(BM3DContext *s, const uint8_t *src, int src_linesize,
@@ -518,18 +607,11 @@ static void final_block_filtering(BM3DContext *s, const uint8_t *src, int src_li
     const int buffer_linesize = s->block_size * s->block_size;
     const int nb_match_blocks = sc->nb_match_blocks;
     const int block_size = s->block_size;
-    const int width = s->planewidth[plane];
-    const int pgroup_size = s->pgroup_size;
-    const int group_size = s->group_size;
+    const int zstride = s->group_size > 1 ? s->pgroup_size : 1;
     const float sigma_sqr = s->sigma * s->sigma;
     float *buffer = sc->buffer;
-    float *bufferh = sc->bufferh;
-    float *bufferv = sc->bufferv;
-    float *bufferz = sc->bufferz;
     float *rbuffer = sc->rbuffer;
-    float *rbufferh = sc->rbufferh;
-    float *rbufferv = sc->rbufferv;
-    float *rbufferz = sc->rbufferz;
+    float *bufferz, *rbufferz;
     float den_weight, num_weight;
     float l2_wiener = 0;
     int i, j, k;
@@ -537,48 +619,15 @@ static void final_block_filtering(BM3DContext *s, const uint8_t *src, int src_li
     for (k = 0; k < nb_match_blocks; k++) {
         const int y = sc->match_blocks[k].y;
         const int x = sc->match_blocks[k].x;
+        const float *block  = get_block_dct(s, sc, &sc->cache,  src, src_linesize, y, x);
+        const float *rblock = get_block_dct(s, sc, &sc->rcache, ref, ref_linesize, y, x);
 
-        for (i = 0; i < block_size; i++) {
-            s->get_block_row(src, src_linesize, y + i, x, block_size, bufferh + block_size * i);
-            s->get_block_row(ref, ref_linesize, y + i, x, block_size, rbufferh + block_size * i);
-            av_dct_calc(sc->dctf, bufferh + block_size * i);
-            av_dct_calc(sc->dctf, rbufferh + block_size * i);
-        }
-
-        for (i = 0; i < block_size; i++) {
-            for (j = 0; j < block_size; j++) {
-                bufferv[i * block_size + j] = bufferh[j * block_size + i];
-                rbufferv[i * block_size + j] = rbufferh[j * block_size + i];
-            }
-            av_dct_calc(sc->dctf, bufferv + i * block_size);
-            av_dct_calc(sc->dctf, rbufferv + i * block_size);
-        }
-
-        for (i = 0; i < block_size; i++) {
-            memcpy(buffer + k * buffer_linesize + i * block_size,
-                   bufferv + i * block_size, block_size * 4);
-            memcpy(rbuffer + k * buffer_linesize + i * block_size,
-                   rbufferv + i * block_size, block_size * 4);
-        }
-    }
-
-    for (i = 0; i < block_size; i++) {
-        for (j = 0; j < block_size; j++) {
-            for (k = 0; k < nb_match_blocks; k++) {
-                bufferz[k] = buffer[buffer_linesize * k + i * block_size + j];
-                rbufferz[k] = rbuffer[buffer_linesize * k + i * block_size + j];
-            }
-            if (group_size > 1) {
-                av_dct_calc(sc->gdctf, bufferz);
-                av_dct_calc(sc->gdctf, rbufferz);
-            }
-            bufferz += pgroup_size;
-            rbufferz += pgroup_size;
-        }
+        memcpy(buffer  + k * buffer_linesize, block,  buffer_linesize * sizeof(*buffer));
+        memcpy(rbuffer + k * buffer_linesize, rblock, buffer_linesize * sizeof(*rbuffer));
     }
 
-    bufferz = sc->bufferz;
-    rbufferz = sc->rbufferz;
+    bufferz  = group_dct(s, sc, buffer,  sc->bufferz,  nb_match_blocks);
+    rbufferz = group_dct(s, sc, rbuffer, sc->rbufferz, nb_match_blocks);
 
     for (i = 0; i < block_size; i++) {
         for (j = 0; j < block_size; j++) {
@@ -591,55 +640,18 @@ static void final_block_filtering(BM3DContext *s, const uint8_t *src, int src_li
                 bufferz[k] *= wiener_coef;
                 l2_wiener += wiener_coef * wiener_coef;
             }
-            bufferz += pgroup_size;
-            rbufferz += pgroup_size;
+            bufferz += zstride;
+            rbufferz += zstride;
         }
     }
 
-    bufferz = sc->bufferz;
-    buffer = sc->buffer;
-    for (i = 0; i < block_size; i++) {
-        for (j = 0; j < block_size; j++) {
-            if (group_size > 1)
-                av_dct_calc(sc->gdcti, bufferz);
-            for (k = 0; k < nb_match_blocks; k++) {
-                buffer[buffer_linesize * k + i * block_size + j] = bufferz[k];
-            }
-            bufferz += pgroup_size;
-        }
-    }
+    group_idct(s, sc, buffer, sc->bufferz, nb_match_blocks);
 
     l2_wiener = FFMAX(l2_wiener, 1e-15f);
     den_weight = 1.f / l2_wiener;
     num_weight = den_weight;
 
-    for (k = 0; k < nb_match_blocks; k++) {
-        float *num = sc->num + y * width + x;
-        float *den = sc->den + y * width + x;
-
-        for (i = 0; i < block_size; i++) {
-            memcpy(bufferv + i * block_size,
-                   buffer + k * buffer_linesize + i * block_size,
-                   block_size * 4);
-        }
-
-        for (i = 0; i < block_size; i++) {
-            av_dct_calc(sc->dcti, bufferv + block_size * i);
-            for (j = 0; j < block_size; j++) {
-                bufferh[j * block_size + i] = bufferv[i * block_size + j];
-            }
-        }
-
-        for (i = 0; i < block_size; i++) {
-            av_dct_calc(sc->dcti, bufferh + block_size * i);
-            for (j = 0; j < block_size; j++) {
-                num[j] += bufferh[i * block_size + j] * num_weight;
-                den[j] += den_weight;
-            }
-            num += width;
-            den += width;
-        }
-    }
+    aggregate(s, sc, buffer, y, x, plane, num_weight, den_weight);
 }
 
 static void do_output(BM3DContext *s, uint8_t *dst, int dst_linesize,
@@ -717,8 +729,10 @@ static int filter_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
                           (((height + block_step - 1) / block_step) * (jobnr + 1) / nb_jobs) * block_step;
     int i, j;
 
-    memset(sc->num, 0, width * height * sizeof(FFTSample));
-    memset(sc->den, 0, width * height * sizeof(FFTSample));
+    memset(sc->num, 0, width * height * sizeof(*sc->num));
+    memset(sc->den, 0, width * height * sizeof(*sc->den));
+    reset_cache(&sc->cache);
+    reset_cache(&sc->rcache);
 
     for (j = slice_start; j < slice_end; j += block_step) {
         if (j > block_pos_bottom) {
@@ -777,12 +791,73 @@ static int filter_frame(AVFilterContext *ctx, AVFrame **out, AVFrame *in, AVFram
 
 #define SQR(x) ((x) * (x))
 
+/*
+ * DCT-II, X[k] = sum(x[n] * cos(pi / size * (n + 0.5) * k)), or its inverse
+ * as matrix, optionally transposed.
+ */
+static int init_dct(float **dst, int size, int inverse, int transpose)
+{
+    float *m = av_malloc_array(size * size, sizeof(*m));
+
+    if (!m)
+        return AVERROR(ENOMEM);
+
+    for (int k = 0; k < size; k++) {
+        for (int n = 0; n < size; n++) {
+            const double c = cos(M_PI / size * (n + 0.5) * k);
+            int row = inverse ? n : k;
+            int col = inverse ? k : n;
+
+            if (transpose)
+                FFSWAP(int, row, col);
+            m[row * size + col] = inverse ? c * (k ? 2. : 1.) / size : c;
+        }
+    }
+
+    av_freep(dst);
+    *dst = m;
+
+    return 0;
+}
+
+static int init_cache(BM3DContext *s, BlockCache *cache)
+{
+    const int block_area = s->block_size * s->block_size;
+    const int range = FFMIN(s->bm_range, FFMAX(s->planewidth[0], s->planeheight[0]));
+    int wbits = 0, hbits = 0;
+
+    /* Cover the search window of a reference block plus the next one to
+     * its right, unless nothing is searched at all. */
+    if (s->group_size > 1 && s->th_mse > 0.f) {
+        wbits = av_ceil_log2(2 * range + 1 + s->block_step);
+        hbits = av_ceil_log2(2 * range + 1);
+    }
+
+    while ((block_area << (wbits + hbits)) > MAX_CACHE_SIZE / sizeof(float)) {
+        if (hbits > 0)
+            hbits--;
+        else
+            wbits--;
+    }
+
+    cache->wbits = wbits;
+    cache->wmask = (1 << wbits) - 1;
+    cache->hmask = (1 << hbits) - 1;
+    cache->nb_entries = 1 << (wbits + hbits);
+    cache->data = av_calloc(cache->nb_entries, block_area * sizeof(*cache->data));
+    cache->pos  = av_calloc(cache->nb_entries, 2 * sizeof(*cache->pos));
+    if (!cache->data || !cache->pos)
+        return AVERROR(ENOMEM);
+
+    return 0;
+}
+
 static int config_input(AVFilterLink *inlink)
 {
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
     AVFilterContext *ctx = inlink->dst;
     BM3DContext *s = ctx->priv;
-    int i, group_bits;
+    int i, group_bits, ret;
 
     s->nb_threads = FFMIN(ff_filter_get_nb_threads(ctx), MAX_NB_THREADS);
     s->nb_planes = av_pix_fmt_count_planes(inlink->format);
@@ -797,40 +872,45 @@ static int config_input(AVFilterLink *inlink)
     s->group_bits = group_bits;
     s->pgroup_size = 1 << group_bits;
 
+    if ((ret = init_dct(&s->dct,   s->block_size, 0, 0)) < 0 ||
+        (ret = init_dct(&s->dctt,  s->block_size, 0, 1)) < 0 ||
+        (ret = init_dct(&s->idct,  s->block_size, 1, 0)) < 0 ||
+        (ret = init_dct(&s->idctt, s->block_size, 1, 1)) < 0)
+        return ret;
+
+    if (s->group_size > 1) {
+        if ((ret = init_dct(&s->gdctt,  s->pgroup_size, 0, 1)) < 0 ||
+            (ret = init_dct(&s->gidctt, s->pgroup_size, 1, 1)) < 0)
+            return ret;
+    }
+
     for (i = 0; i < s->nb_threads; i++) {
         SliceContext *sc = &s->slices[i];
 
-        sc->num = av_calloc(FFALIGN(s->planewidth[0], s->block_size) * FFALIGN(s->planeheight[0], s->block_size), sizeof(FFTSample));
-        sc->den = av_calloc(FFALIGN(s->planewidth[0], s->block_size) * FFALIGN(s->planeheight[0], s->block_size), sizeof(FFTSample));
+        sc->num = av_calloc(FFALIGN(s->planewidth[0], s->block_size) * FFALIGN(s->planeheight[0], s->block_size), sizeof(*sc->num));
+        sc->den = av_calloc(FFALIGN(s->planewidth[0], s->block_size) * FFALIGN(s->planeheight[0], s->block_size), sizeof(*sc->den));
         if (!sc->num || !sc->den)
             return AVERROR(ENOMEM);
 
-        sc->dctf = av_dct_init(av_log2(s->block_size), DCT_II);
-        sc->dcti = av_dct_init(av_log2(s->block_size), DCT_III);
-        if (!sc->dctf || !sc->dcti)
-            return AVERROR(ENOMEM);
-
-        if (s->group_bits > 1) {
-            sc->gdctf = av_dct_init(s->group_bits, DCT_II);
-            sc->gdcti = av_dct_init(s->group_bits, DCT_III);
-            if (!sc->gdctf || !sc->gdcti)
-                return AVERROR(ENOMEM);
-        }
-
         sc->buffer = av_calloc(s->block_size * s->block_size * s->pgroup_size, sizeof(*sc->buffer));
         sc->bufferz = av_calloc(s->block_size * s->block_size * s->pgroup_size, sizeof(*sc->bufferz));
+        sc->bufferg = av_calloc(s->block_size * s->block_size * s->pgroup_size, sizeof(*sc->bufferg));
         sc->bufferh = av_calloc(s->block_size * s->block_size, sizeof(*sc->bufferh));
         sc->bufferv = av_calloc(s->block_size * s->block_size, sizeof(*sc->bufferv));
-        if (!sc->bufferh || !sc->bufferv || !sc->buffer || !sc->bufferz)
+        if (!sc->bufferh || !sc->bufferv || !sc->buffer || !sc->bufferz || !sc->bufferg)
             return AVERROR(ENOMEM);
 
+        if ((ret = init_cache(s, &sc->cache)) < 0)
+            return ret;
+
         if (s->mode == FINAL) {
             sc->rbuffer = av_calloc(s->block_size * s->block_size * s->pgroup_size, sizeof(*sc->rbuffer));
             sc->rbufferz = av_calloc(s->block_size * s->block_size * s->pgroup_size, sizeof(*sc->rbufferz));
-            sc->rbufferh = av_calloc(s->block_size * s->block_size, sizeof(*sc->rbufferh));
-            sc->rbufferv = av_calloc(s->block_size * s->block_size, sizeof(*sc->rbufferv));
-            if (!sc->rbufferh || !sc->rbufferv || !sc->rbuffer || !sc->rbufferz)
+            if (!sc->rbuffer || !sc->rbufferz)
                 return AVERROR(ENOMEM);
+
+            if ((ret = init_cache(s, &sc->rcache)) < 0)
+                return ret;
         }
 
         sc->search_positions = av_calloc(SQR(2 * s->bm_range / s->bm_step + 1), sizeof(*sc->search_positions));
@@ -839,15 +919,15 @@ static int config_input(AVFilterLink *inlink)
     }
 
     s->do_output = do_output;
-    s->do_block_ssd = do_block_ssd;
     s->get_block_row = get_block_row;
 
     if (s->depth > 8) {
         s->do_output = do_output16;
-        s->do_block_ssd = do_block_ssd16;
         s->get_block_row = get_block_row16;
     }
 
+    ff_bm3d_init(&s->dsp, s->depth);
+
     return 0;
 }
 
@@ -1028,22 +1108,28 @@ static av_cold void uninit(AVFilterContext *ctx)
         av_freep(&sc->num);
         av_freep(&sc->den);
 
-        av_dct_end(sc->gdctf);
-        av_dct_end(sc->gdcti);
-        av_dct_end(sc->dctf);
-        av_dct_end(sc->dcti);
-
         av_freep(&sc->buffer);
         av_freep(&sc->bufferh);
         av_freep(&sc->bufferv);
         av_freep(&sc->bufferz);
+        av_freep(&sc->bufferg);
         av_freep(&sc->rbuffer);
-        av_freep(&sc->rbufferh);
-        av_freep(&sc->rbufferv);
         av_freep(&sc->rbufferz);
 
+        av_freep(&sc->cache.data);
+        av_freep(&sc->cache.pos);
+        av_freep(&sc->rcache.data);
+        av_freep(&sc->rcache.pos);
+
         av_freep(&sc->search_positions);
     }
+
+    av_freep(&s->dct);
+    av_freep(&s->dctt);
+    av_freep(&s->idct);
+    av_freep(&s->idctt);
+    av_freep(&s->gdctt);
+    av_freep(&s->gidctt);
 }
 
 static const AVFilterPad bm3d_outputs[] = {
@@ -294,26 +294,6 @@ static void filter16_row(uint8_t *dstp, int width,
     }
 }
 
-static void filter16_column(uint8_t *dstp, int height,
-                            float rdiv, float bias, const int *const matrix,
-                            const uint8_t *c[], int peak, int radius,
-                            int dstride, int stride)
-{
-    uint16_t *dst = (uint16_t *)dstp;
-    int y;
-
-    for (y = 0; y < height; y++) {
-        int i, sum = 0;
-
-        for (i = 0; i < 2 * radius + 1; i++)
-            sum += AV_RN16A(&c[i][0 + y * stride]) * matrix[i];
-
-        sum = (int)(sum * rdiv + bias + 0.5f);
-        dst[0] = av_clip(sum, 0, peak);
-        dst += dstride / 2;
-    }
-}
-
 static void filter_7x7(uint8_t *dst, int width,
                        float rdiv, float bias, const int *const matrix,
                        const uint8_t *c[], int peak, int radius,
@@ -387,25 +367,6 @@ static void filter_row(uint8_t *dst, int width,
     }
 }
 
-static void filter_column(uint8_t *dst, int height,
-                          float rdiv, float bias, const int *const matrix,
-                          const uint8_t *c[], int peak, int radius,
-                          int dstride, int stride)
-{
-    int y;
-
-    for (y = 0; y < height; y++) {
-        int i, sum = 0;
-
-        for (i = 0; i < 2 * radius + 1; i++)
-            sum += c[i][0 + y * stride] * matrix[i];
-
-        sum = (int)(sum * rdiv + bias + 0.5f);
-        dst[0] = av_clip_uint8(sum);
-        dst += dstride;
-    }
-}
-
 static void setup_3x3(int radius, const uint8_t *c[], const uint8_t *src, int stride,
                       int x, int w, int y, int h, int bpc)
 {
@@ -474,11 +435,11 @@ static void setup_column(int radius, const uint8_t *c[], const uint8_t *src, int
     int i;
 
     for (i = 0; i < radius * 2 + 1; i++) {
-        int xoff = FFABS(x + i - radius);
+        int yoff = FFABS(y + i - radius);
 
-        xoff = xoff >= h ? 2 * h - 1 - xoff : xoff;
+        yoff = yoff >= h ? 2 * h - 1 - yoff : yoff;
 
-        c[i] = src + y * bpc + xoff * stride;
+        c[i] = src + x * bpc + yoff * stride;
     }
 }
 
@@ -498,69 +459,109 @@ static int filter_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
         const int width  = s->planewidth[plane];
         const int stride = in->linesize[plane];
         const int dstride = out->linesize[plane];
-        const int sizeh = mode == MATRIX_COLUMN ? width : height;
-        const int sizew = mode == MATRIX_COLUMN ? height : width;
-        const int slice_start = (sizeh * jobnr) / nb_jobs;
-        const int slice_end = (sizeh * (jobnr+1)) / nb_jobs;
+        const int slice_start = (height * jobnr) / nb_jobs;
+        const int slice_end = (height * (jobnr+1)) / nb_jobs;
         const float rdiv = s->rdiv[plane];
         const float bias = s->bias[plane];
         const uint8_t *src = in->data[plane];
-        const int dst_pos = slice_start * (mode == MATRIX_COLUMN ? bpc : dstride);
-        uint8_t *dst = out->data[plane] + dst_pos;
+        uint8_t *dst = out->data[plane] + slice_start * dstride;
         const int *matrix = s->matrix[plane];
+        /* column matrices need no horizontal edge handling */
+        const int hradius = mode == MATRIX_COLUMN ? 0 : radius;
         const uint8_t *c[49];
         int y, x;
 
         if (s->copy[plane]) {
-            if (mode == MATRIX_COLUMN)
-                av_image_copy_plane(dst, dstride, src + slice_start * bpc, stride,
-                                    (slice_end - slice_start) * bpc, height);
-            else
-                av_image_copy_plane(dst, dstride, src + slice_start * stride, stride,
-                                    width * bpc, slice_end - slice_start);
+            av_image_copy_plane(dst, dstride, src + slice_start * stride, stride,
+                                width * bpc, slice_end - slice_start);
             continue;
         }
 
         for (y = slice_start; y < slice_end; y++) {
-            const int xoff = mode == MATRIX_COLUMN ? (y - slice_start) * bpc : radius * bpc;
-            const int yoff = mode == MATRIX_COLUMN ? radius * dstride : 0;
-
-            for (x = 0; x < radius; x++) {
-                const int xoff = mode == MATRIX_COLUMN ? (y - slice_start) * bpc : x * bpc;
-                const int yoff = mode == MATRIX_COLUMN ? x * dstride : 0;
-
+            for (x = 0; x < hradius; x++) {
                 s->setup[plane](radius, c, src, stride, x, width, y, height, bpc);
-                s->filter[plane](dst + yoff + xoff, 1, rdiv,
+                s->filter[plane](dst + x * bpc, 1, rdiv,
                                  bias, matrix, c, s->max, radius,
                                  dstride, stride);
             }
-            s->setup[plane](radius, c, src, stride, radius, width, y, height, bpc);
-            s->filter[plane](dst + yoff + xoff, sizew - 2 * radius,
+            s->setup[plane](radius, c, src, stride, hradius, width, y, height, bpc);
+            s->filter[plane](dst + hradius * bpc, width - 2 * hradius,
                              rdiv, bias, matrix, c, s->max, radius,
                              dstride, stride);
-            for (x = sizew - radius; x < sizew; x++) {
-                const int xoff = mode == MATRIX_COLUMN ? (y - slice_start) * bpc : x * bpc;
-                const int yoff = mode == MATRIX_COLUMN ? x * dstride : 0;
-
+            for (x = width - hradius; x < width; x++) {
                 s->setup[plane](radius, c, src, stride, x, width, y, height, bpc);
-                s->filter[plane](dst + yoff + xoff, 1, rdiv,
+                s->filter[plane](dst + x * bpc, 1, rdiv,
                                  bias, matrix, c, s->max, radius,
                                  dstride, stride);
             }
-            if (mode != MATRIX_COLUMN)
-                dst += dstride;
+            dst += dstride;
         }
     }
 
     return 0;
 }
 
+av_cold void ff_convolution_init(ConvolutionContext *s)
+{
+    int p;
+
+    for (p = 0; p < 4; p++) {
+        if (s->mode[p] == MATRIX_ROW || s->mode[p] == MATRIX_COLUMN)
+            s->filter[p] = s->depth > 8 ? filter16_row : filter_row;
+        else if (s->size[p] == 3)
+            s->filter[p] = s->depth > 8 ? filter16_3x3 : filter_3x3;
+        else if (s->size[p] == 5)
+            s->filter[p] = s->depth > 8 ? filter16_5x5 : filter_5x5;
+        else if (s->size[p] == 7)
+            s->filter[p] = s->depth > 8 ? filter16_7x7 : filter_7x7;
+    }
+
+#if CONFIG_CONVOLUTION_FILTER && ARCH_X86_64
+    ff_convolution_init_x86(s);
+#endif
+}
+
+av_cold void ff_prewitt_init(ConvolutionContext *s)
+{
+    int p;
+
+    for (p = 0; p < 4; p++)
+        s->filter[p] = s->depth > 8 ? filter16_prewitt : filter_prewitt;
+
+#if CONFIG_PREWITT_FILTER && ARCH_X86_64
+    ff_prewitt_init_x86(s);
+#endif
+}
+
+av_cold void ff_roberts_init(ConvolutionContext *s)
+{
+    int p;
+
+    for (p = 0; p < 4; p++)
+        s->filter[p] = s->depth > 8 ? filter16_roberts : filter_roberts;
+
+#if CONFIG_ROBERTS_FILTER && ARCH_X86_64
+    ff_roberts_init_x86(s);
+#endif
+}
+
+av_cold void ff_sobel_init(ConvolutionContext *s)
+{
+    int p;
+
+    for (p = 0; p < 4; p++)
+        s->filter[p] = s->depth > 8 ? filter16_sobel : filter_sobel;
+
+#if CONFIG_SOBEL_FILTER && ARCH_X86_64
+    ff_sobel_init_x86(s);
+#endif
+}
+
 static int config_input(AVFilterLink *inlink)
 {
     AVFilterContext *ctx = inlink->dst;
     ConvolutionContext *s = ctx->priv;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
-    int p;
 
     s->depth = desc->comp[0].depth;
     s->max = (1 << s->depth) - 1;
@@ -574,37 +575,14 @@ static int config_input(AVFilterLink *inlink)
     s->nb_threads = ff_filter_get_nb_threads(ctx);
     s->bpc = (s->depth + 7) / 8;
 
-    if (!strcmp(ctx->filter->name, "convolution")) {
-        if (s->depth > 8) {
-            for (p = 0; p < s->nb_planes; p++) {
-                if (s->mode[p] == MATRIX_ROW)
-                    s->filter[p] = filter16_row;
-                else if (s->mode[p] == MATRIX_COLUMN)
-                    s->filter[p] = filter16_column;
-                else if (s->size[p] == 3)
-                    s->filter[p] = filter16_3x3;
-                else if (s->size[p] == 5)
-                    s->filter[p] = filter16_5x5;
-                else if (s->size[p] == 7)
-                    s->filter[p] = filter16_7x7;
-            }
-        }
-#if CONFIG_CONVOLUTION_FILTER && ARCH_X86_64
-        ff_convolution_init_x86(s);
-#endif
-    } else if (!strcmp(ctx->filter->name, "prewitt")) {
-        if (s->depth > 8)
-            for (p = 0; p < s->nb_planes; p++)
-                s->filter[p] = filter16_prewitt;
-    } else if (!strcmp(ctx->filter->name, "roberts")) {
-        if (s->depth > 8)
-            for (p = 0; p < s->nb_planes; p++)
-                s->filter[p] = filter16_roberts;
-    } else if (!strcmp(ctx->filter->name, "sobel")) {
-        if (s->depth > 8)
-            for (p = 0; p < s->nb_planes; p++)
-                s->filter[p] = filter16_sobel;
-    }
+    if (!strcmp(ctx->filter->name, "convolution"))
+        ff_convolution_init(s);
+    else if (!strcmp(ctx->filter->name, "prewitt"))
+        ff_prewitt_init(s);
+    else if (!strcmp(ctx->filter->name, "roberts"))
+        ff_roberts_init(s);
+    else if (!strcmp(ctx->filter->name, "sobel"))
+        ff_sobel_init(s);
 
     return 0;
 }
@@ -626,7 +604,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 
     td.in = in;
     td.out = out;
-    ctx->internal->execute(ctx, filter_slice, &td, NULL, FFMIN3(s->planeheight[1], s->planewidth[1], s->nb_threads));
+    ctx->internal->execute(ctx, filter_slice, &td, NULL, FFMIN(s->planeheight[1], s->nb_threads));
 
     av_frame_free(&in);
     return ff_filter_frame(outlink, out);
@@ -668,7 +646,7 @@ static av_cold int init(AVFilterContext *ctx)
                 s->setup[i] = setup_row;
                 s->size[i] = s->matrix_length[i];
             } else if (s->mode[i] == MATRIX_COLUMN) {
-                s->filter[i] = filter_column;
+                s->filter[i] = filter_row;
                 s->setup[i] = setup_column;
                 s->size[i] = s->matrix_length[i];
             } else if (s->matrix_length[i] == 9) {
@@ -758,7 +736,11 @@ static int process_command(AVFilterContext *ctx, const char *cmd, const char *ar
     if (ret < 0)
         return ret;
 
-    return init(ctx);
+    ret = init(ctx);
+    if (ret < 0)
+        return ret;
+
+    return config_input(ctx->inputs[0]);
 }
 
 static const AVFilterPad convolution_inputs[] = {
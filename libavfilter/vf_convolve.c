@@ -23,32 +23,26 @@
 #include "libavutil/imgutils.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
-#include "libavcodec/avfft.h"
 
 #include "avfilter.h"
+#include "fft2d.h"
 #include "formats.h"
 #include "framesync.h"
 #include "internal.h"
 #include "video.h"
 
-#define MAX_THREADS 16
-
 typedef struct ConvolveContext {
     const AVClass *class;
     FFFrameSync fs;
 
-    FFTContext *fft[4][MAX_THREADS];
-    FFTContext *ifft[4][MAX_THREADS];
+    FFT2DContext fft[4];
 
-    int fft_bits[4];
     int fft_len[4];
     int planewidth[4];
     int planeheight[4];
 
-    FFTComplex *fft_hdata[4];
-    FFTComplex *fft_vdata[4];
-    FFTComplex *fft_hdata_impulse[4];
-    FFTComplex *fft_vdata_impulse[4];
+    AVComplexFloat *fft_data[4];
+    AVComplexFloat *fft_data_impulse[4];
 
     int depth;
     int planes;
@@ -105,7 +99,7 @@ static int config_input_main(AVFilterLink *inlink)
 {
     ConvolveContext *s = inlink->dst->priv;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
-    int fft_bits, i;
+    int fft_bits, i, ret;
 
     s->planewidth[1] = s->planewidth[2] = AV_CEIL_RSHIFT(inlink->w, desc->log2_chroma_w);
     s->planewidth[0] = s->planewidth[3] = inlink->w;
@@ -122,19 +116,19 @@ static int config_input_main(AVFilterLink *inlink)
 
         for (fft_bits = 1; 1 << fft_bits < n; fft_bits++);
 
-        s->fft_bits[i] = fft_bits;
-        s->fft_len[i] = 1 << s->fft_bits[i];
-
-        if (!(s->fft_hdata[i] = av_calloc(s->fft_len[i], s->fft_len[i] * sizeof(FFTComplex))))
-            return AVERROR(ENOMEM);
+        s->fft_len[i] = 1 << fft_bits;
 
-        if (!(s->fft_vdata[i] = av_calloc(s->fft_len[i], s->fft_len[i] * sizeof(FFTComplex))))
-            return AVERROR(ENOMEM);
+        ret = ff_fft2d_init(&s->fft[i], s->fft_len[i], s->fft_len[i], 1,
+                            ff_filter_get_nb_threads(inlink->dst));
+        if (ret < 0)
+            return ret;
 
-        if (!(s->fft_hdata_impulse[i] = av_calloc(s->fft_len[i], s->fft_len[i] * sizeof(FFTComplex))))
+        av_freep(&s->fft_data[i]);
+        av_freep(&s->fft_data_impulse[i]);
+        if (!(s->fft_data[i] = av_calloc(s->fft_len[i], s->fft[i].linesize)))
             return AVERROR(ENOMEM);
 
-        if (!(s->fft_vdata_impulse[i] = av_calloc(s->fft_len[i], s->fft_len[i] * sizeof(FFTComplex))))
+        if (!(s->fft_data_impulse[i] = av_calloc(s->fft_len[i], s->fft[i].linesize)))
             return AVERROR(ENOMEM);
     }
 
@@ -159,176 +153,56 @@ static int config_input_impulse(AVFilterLink *inlink)
 }
 
 typedef struct ThreadData {
-    FFTComplex *hdata, *vdata;
-    int plane, n;
+    AVComplexFloat *input, *filter;
+    int plane;
 } ThreadData;
 
-static int fft_horizontal(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
-{
-    ConvolveContext *s = ctx->priv;
-    ThreadData *td = arg;
-    FFTComplex *hdata = td->hdata;
-    const int plane = td->plane;
-    const int n = td->n;
-    int start = (n * jobnr) / nb_jobs;
-    int end = (n * (jobnr+1)) / nb_jobs;
-    int y;
-
-    for (y = start; y < end; y++) {
-        av_fft_permute(s->fft[plane][jobnr], hdata + y * n);
-        av_fft_calc(s->fft[plane][jobnr], hdata + y * n);
-    }
-
-    return 0;
-}
-
-static void get_input(ConvolveContext *s, FFTComplex *fft_hdata,
+static void get_input(ConvolveContext *s, AVComplexFloat *fft_data,
                       AVFrame *in, int w, int h, int n, int plane, float scale)
 {
+    const ptrdiff_t linesize = s->fft[plane].linesize / sizeof(float);
     const int iw = (n - w) / 2, ih = (n - h) / 2;
+    float *data = (float *)fft_data;
     int y, x;
 
     if (s->depth == 8) {
         for (y = 0; y < h; y++) {
             const uint8_t *src = in->data[plane] + in->linesize[plane] * y;
 
-            for (x = 0; x < w; x++) {
-                fft_hdata[(y + ih) * n + iw + x].re = src[x] * scale;
-                fft_hdata[(y + ih) * n + iw + x].im = 0;
-            }
-
-            for (x = 0; x < iw; x++) {
-                fft_hdata[(y + ih) * n + x].re = fft_hdata[(y + ih) * n + iw].re;
-                fft_hdata[(y + ih) * n + x].im = 0;
-            }
-
-            for (x = n - iw; x < n; x++) {
-                fft_hdata[(y + ih) * n + x].re = fft_hdata[(y + ih) * n + n - iw - 1].re;
-                fft_hdata[(y + ih) * n + x].im = 0;
-            }
-        }
-
-        for (y = 0; y < ih; y++) {
-            for (x = 0; x < n; x++) {
-                fft_hdata[y * n + x].re = fft_hdata[ih * n + x].re;
-                fft_hdata[y * n + x].im = 0;
-            }
-        }
-
-        for (y = n - ih; y < n; y++) {
-            for (x = 0; x < n; x++) {
-                fft_hdata[y * n + x].re = fft_hdata[(n - ih - 1) * n + x].re;
-                fft_hdata[y * n + x].im = 0;
-            }
+            for (x = 0; x < w; x++)
+                data[(y + ih) * linesize + iw + x] = src[x] * scale;
         }
     } else {
         for (y = 0; y < h; y++) {
             const uint16_t *src = (const uint16_t *)(in->data[plane] + in->linesize[plane] * y);
 
-            for (x = 0; x < w; x++) {
-                fft_hdata[(y + ih) * n + iw + x].re = src[x] * scale;
-                fft_hdata[(y + ih) * n + iw + x].im = 0;
-            }
-
-            for (x = 0; x < iw; x++) {
-                fft_hdata[(y + ih) * n + x].re = fft_hdata[(y + ih) * n + iw].re;
-                fft_hdata[(y + ih) * n + x].im = 0;
-            }
-
-            for (x = n - iw; x < n; x++) {
-                fft_hdata[(y + ih) * n + x].re = fft_hdata[(y + ih) * n + n - iw - 1].re;
-                fft_hdata[(y + ih) * n + x].im = 0;
-            }
-        }
-
-        for (y = 0; y < ih; y++) {
-            for (x = 0; x < n; x++) {
-                fft_hdata[y * n + x].re = fft_hdata[ih * n + x].re;
-                fft_hdata[y * n + x].im = 0;
-            }
-        }
-
-        for (y = n - ih; y < n; y++) {
-            for (x = 0; x < n; x++) {
-                fft_hdata[y * n + x].re = fft_hdata[(n - ih - 1) * n + x].re;
-                fft_hdata[y * n + x].im = 0;
-            }
-        }
-    }
-}
-
-static int fft_vertical(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
-{
-    ConvolveContext *s = ctx->priv;
-    ThreadData *td = arg;
-    FFTComplex *hdata = td->hdata;
-    FFTComplex *vdata = td->vdata;
-    const int plane = td->plane;
-    const int n = td->n;
-    int start = (n * jobnr) / nb_jobs;
-    int end = (n * (jobnr+1)) / nb_jobs;
-    int y, x;
-
-    for (y = start; y < end; y++) {
-        for (x = 0; x < n; x++) {
-            vdata[y * n + x].re = hdata[x * n + y].re;
-            vdata[y * n + x].im = hdata[x * n + y].im;
+            for (x = 0; x < w; x++)
+                data[(y + ih) * linesize + iw + x] = src[x] * scale;
         }
-
-        av_fft_permute(s->fft[plane][jobnr], vdata + y * n);
-        av_fft_calc(s->fft[plane][jobnr], vdata + y * n);
     }
 
-    return 0;
-}
+    for (y = 0; y < h; y++) {
+        float *row = data + (y + ih) * linesize;
 
-static int ifft_vertical(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
-{
-    ConvolveContext *s = ctx->priv;
-    ThreadData *td = arg;
-    FFTComplex *hdata = td->hdata;
-    FFTComplex *vdata = td->vdata;
-    const int plane = td->plane;
-    const int n = td->n;
-    int start = (n * jobnr) / nb_jobs;
-    int end = (n * (jobnr+1)) / nb_jobs;
-    int y, x;
-
-    for (y = start; y < end; y++) {
-        av_fft_permute(s->ifft[plane][jobnr], vdata + y * n);
-        av_fft_calc(s->ifft[plane][jobnr], vdata + y * n);
+        for (x = 0; x < iw; x++)
+            row[x] = row[iw];
 
-        for (x = 0; x < n; x++) {
-            hdata[x * n + y].re = vdata[y * n + x].re;
-            hdata[x * n + y].im = vdata[y * n + x].im;
-        }
+        for (x = n - iw; x < n; x++)
+            row[x] = row[n - iw - 1];
     }
 
-    return 0;
-}
-
-static int ifft_horizontal(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
-{
-    ConvolveContext *s = ctx->priv;
-    ThreadData *td = arg;
-    FFTComplex *hdata = td->hdata;
-    const int plane = td->plane;
-    const int n = td->n;
-    int start = (n * jobnr) / nb_jobs;
-    int end = (n * (jobnr+1)) / nb_jobs;
-    int y;
+    for (y = 0; y < ih; y++)
+        memcpy(data + y * linesize, data + ih * linesize, n * sizeof(*data));
 
-    for (y = start; y < end; y++) {
-        av_fft_permute(s->ifft[plane][jobnr], hdata + y * n);
-        av_fft_calc(s->ifft[plane][jobnr], hdata + y * n);
-    }
-
-    return 0;
+    for (y = n - ih; y < n; y++)
+        memcpy(data + y * linesize, data + (n - ih - 1) * linesize, n * sizeof(*data));
 }
 
-static void get_output(ConvolveContext *s, FFTComplex *input, AVFrame *out,
+static void get_output(ConvolveContext *s, AVComplexFloat *fft_data, AVFrame *out,
                        int w, int h, int n, int plane, float scale)
 {
+    const ptrdiff_t linesize = s->fft[plane].linesize / sizeof(float);
+    const float *input = (const float *)fft_data;
     const int max = (1 << s->depth) - 1;
     const int hh = h / 2;
     const int hw = w / 2;
@@ -338,43 +212,43 @@ static void get_output(ConvolveContext *s, FFTComplex *input, AVFrame *out,
         for (y = 0; y < hh; y++) {
             uint8_t *dst = out->data[plane] + (y + hh) * out->linesize[plane] + hw;
             for (x = 0; x < hw; x++)
-                dst[x] = av_clip_uint8(input[y * n + x].re * scale);
+                dst[x] = av_clip_uint8(input[y * linesize + x] * scale);
         }
         for (y = 0; y < hh; y++) {
             uint8_t *dst = out->data[plane] + (y + hh) * out->linesize[plane];
             for (x = 0; x < hw; x++)
-                dst[x] = av_clip_uint8(input[y * n + n - hw + x].re * scale);
+                dst[x] = av_clip_uint8(input[y * linesize + n - hw + x] * scale);
         }
         for (y = 0; y < hh; y++) {
             uint8_t *dst = out->data[plane] + y * out->linesize[plane] + hw;
             for (x = 0; x < hw; x++)
-                dst[x] = av_clip_uint8(input[(n - hh + y) * n + x].re * scale);
+                dst[x] = av_clip_uint8(input[(n - hh + y) * linesize + x] * scale);
         }
         for (y = 0; y < hh; y++) {
             uint8_t *dst = out->data[plane] + y * out->linesize[plane];
             for (x = 0; x < hw; x++)
-                dst[x] = av_clip_uint8(input[(n - hh + y) * n + n - hw + x].re * scale);
+                dst[x] = av_clip_uint8(input[(n - hh + y) * linesize + n - hw + x] * scale);
         }
     } else {
         for (y = 0; y < hh; y++) {
             uint16_t *dst = (uint16_t *)(out->data[plane] + (y + hh) * out->linesize[plane] + hw * 2);
             for (x = 0; x < hw; x++)
-                dst[x] = av_clip(input[y * n + x].re * scale, 0, max);
+                dst[x] = av_clip(input[y * linesize + x] * scale, 0, max);
         }
         for (y = 0; y < hh; y++) {
             uint16_t *dst = (uint16_t *)(out->data[plane] + (y + hh) * out->linesize[plane]);
             for (x = 0; x < hw; x++)
-                dst[x] = av_clip(input[y * n + n - hw + x].re * scale, 0, max);
+                dst[x] = av_clip(input[y * linesize + n - hw + x] * scale, 0, max);
         }
         for (y = 0; y < hh; y++) {
             uint16_t *dst = (uint16_t *)(out->data[plane] + y * out->linesize[plane] + hw * 2);
             for (x = 0; x < hw; x++)
-                dst[x] = av_clip(input[(n - hh + y) * n + x].re * scale, 0, max);
+                dst[x] = av_clip(input[(n - hh + y) * linesize + x] * scale, 0, max);
         }
         for (y = 0; y < hh; y++) {
             uint16_t *dst = (uint16_t *)(out->data[plane] + y * out->linesize[plane]);
             for (x = 0; x < hw; x++)
-                dst[x] = av_clip(input[(n - hh + y) * n + n - hw + x].re * scale, 0, max);
+                dst[x] = av_clip(input[(n - hh + y) * linesize + n - hw + x] * scale, 0, max);
         }
     }
 }
@@ -383,27 +257,28 @@ static int complex_multiply(AVFilterContext *ctx, void *arg, int jobnr, int nb_j
 {
     ConvolveContext *s = ctx->priv;
     ThreadData *td = arg;
-    FFTComplex *input = td->hdata;
-    FFTComplex *filter = td->vdata;
+    const ptrdiff_t linesize = s->fft[td->plane].linesize / sizeof(AVComplexFloat);
+    const int w = s->fft[td->plane].spectrum_width;
+    const int n = s->fft_len[td->plane];
     const float noise = s->noise;
-    const int n = td->n;
     int start = (n * jobnr) / nb_jobs;
     int end = (n * (jobnr+1)) / nb_jobs;
     int y, x;
 
     for (y = start; y < end; y++) {
-        int yn = y * n;
+        AVComplexFloat *input = td->input + y * linesize;
+        const AVComplexFloat *filter = td->filter + y * linesize;
 
-        for (x = 0; x < n; x++) {
-            FFTSample re, im, ire, iim;
+        for (x = 0; x < w; x++) {
+            float re, im, ire, iim;
 
-            re = input[yn + x].re;
-            im = input[yn + x].im;
-            ire = filter[yn + x].re + noise;
-            iim = filter[yn + x].im;
+            re = input[x].re;
+            im = input[x].im;
+            ire = filter[x].re + noise;
+            iim = filter[x].im;
 
-            input[yn + x].re = ire * re - iim * im;
-            input[yn + x].im = iim * re + ire * im;
+            input[x].re = ire * re - iim * im;
+            input[x].im = iim * re + ire * im;
         }
     }
 
@@ -414,28 +289,29 @@ static int complex_divide(AVFilterContext *ctx, void *arg, int jobnr, int nb_job
 {
     ConvolveContext *s = ctx->priv;
     ThreadData *td = arg;
-    FFTComplex *input = td->hdata;
-    FFTComplex *filter = td->vdata;
+    const ptrdiff_t linesize = s->fft[td->plane].linesize / sizeof(AVComplexFloat);
+    const int w = s->fft[td->plane].spectrum_width;
+    const int n = s->fft_len[td->plane];
     const float noise = s->noise;
-    const int n = td->n;
     int start = (n * jobnr) / nb_jobs;
     int end = (n * (jobnr+1)) / nb_jobs;
     int y, x;
 
     for (y = start; y < end; y++) {
-        int yn = y * n;
+        AVComplexFloat *input = td->input + y * linesize;
+        const AVComplexFloat *filter = td->filter + y * linesize;
 
-        for (x = 0; x < n; x++) {
-            FFTSample re, im, ire, iim, div;
+        for (x = 0; x < w; x++) {
+            float re, im, ire, iim, div;
 
-            re = input[yn + x].re;
-            im = input[yn + x].im;
-            ire = filter[yn + x].re;
-            iim = filter[yn + x].im;
+            re = input[x].re;
+            im = input[x].im;
+            ire = filter[x].re;
+            iim = filter[x].im;
             div = ire * ire + iim * iim + noise;
 
-            input[yn + x].re = (ire * re + iim * im) / div;
-            input[yn + x].im = (ire * im - iim * re) / div;
+            input[x].re = (ire * re + iim * im) / div;
+            input[x].im = (ire * im - iim * re) / div;
         }
     }
 
@@ -457,8 +333,9 @@ static int do_convolve(FFFrameSync *fs)
         return ff_filter_frame(outlink, mainpic);
 
     for (plane = 0; plane < s->nb_planes; plane++) {
-        FFTComplex *filter = s->fft_vdata_impulse[plane];
-        FFTComplex *input = s->fft_vdata[plane];
+        FFT2DContext *fft = &s->fft[plane];
+        AVComplexFloat *filter = s->fft_data_impulse[plane];
+        AVComplexFloat *input = s->fft_data[plane];
         const int n = s->fft_len[plane];
         const int w = s->planewidth[plane];
         const int h = s->planeheight[plane];
@@ -469,14 +346,8 @@ static int do_convolve(FFFrameSync *fs)
             continue;
         }
 
-        td.plane = plane, td.n = n;
-        get_input(s, s->fft_hdata[plane], mainpic, w, h, n, plane, 1.f);
-
-        td.hdata = s->fft_hdata[plane];
-        td.vdata = s->fft_vdata[plane];
-
-        ctx->internal->execute(ctx, fft_horizontal, &td, NULL, FFMIN3(MAX_THREADS, n, ff_filter_get_nb_threads(ctx)));
-        ctx->internal->execute(ctx, fft_vertical, &td, NULL, FFMIN3(MAX_THREADS, n, ff_filter_get_nb_threads(ctx)));
+        get_input(s, input, mainpic, w, h, n, plane, 1.f);
+        ff_fft2d_transform(ctx, fft, input, fft->linesize, 0);
 
         if ((!s->impulse && !s->got_impulse[plane]) || s->impulse) {
             if (s->depth == 8) {
@@ -496,29 +367,21 @@ static int do_convolve(FFFrameSync *fs)
             }
             total = FFMAX(1, total);
 
-            get_input(s, s->fft_hdata_impulse[plane], impulsepic, w, h, n, plane, 1.f / total);
-
-            td.hdata = s->fft_hdata_impulse[plane];
-            td.vdata = s->fft_vdata_impulse[plane];
-
-            ctx->internal->execute(ctx, fft_horizontal, &td, NULL, FFMIN3(MAX_THREADS, n, ff_filter_get_nb_threads(ctx)));
-            ctx->internal->execute(ctx, fft_vertical, &td, NULL, FFMIN3(MAX_THREADS, n, ff_filter_get_nb_threads(ctx)));
+            get_input(s, filter, impulsepic, w, h, n, plane, 1.f / total);
+            ff_fft2d_transform(ctx, fft, filter, fft->linesize, 0);
 
             s->got_impulse[plane] = 1;
         }
 
-        td.hdata = input;
-        td.vdata = filter;
-
-        ctx->internal->execute(ctx, s->filter, &td, NULL, FFMIN3(MAX_THREADS, n, ff_filter_get_nb_threads(ctx)));
+        td.input  = input;
+        td.filter = filter;
+        td.plane  = plane;
 
-        td.hdata = s->fft_hdata[plane];
-        td.vdata = s->fft_vdata[plane];
+        ctx->internal->execute(ctx, s->filter, &td, NULL, FFMIN(n, ff_filter_get_nb_threads(ctx)));
 
-        ctx->internal->execute(ctx, ifft_vertical, &td, NULL, FFMIN3(MAX_THREADS, n, ff_filter_get_nb_threads(ctx)));
-        ctx->internal->execute(ctx, ifft_horizontal, &td, NULL, FFMIN3(MAX_THREADS, n, ff_filter_get_nb_threads(ctx)));
+        ff_fft2d_transform(ctx, fft, input, fft->linesize, 1);
 
-        get_output(s, s->fft_hdata[plane], mainpic, w, h, n, plane, 1.f / (n * n));
+        get_output(s, input, mainpic, w, h, n, plane, 1.f / (n * n));
     }
 
     return ff_filter_frame(outlink, mainpic);
@@ -529,7 +392,7 @@ static int config_output(AVFilterLink *outlink)
     AVFilterContext *ctx = outlink->src;
     ConvolveContext *s = ctx->priv;
     AVFilterLink *mainlink = ctx->inputs[0];
-    int ret, i, j;
+    int ret;
 
     s->fs.on_event = do_convolve;
     ret = ff_framesync_init_dualinput(&s->fs, ctx);
@@ -544,15 +407,6 @@ static int config_output(AVFilterLink *outlink)
     if ((ret = ff_framesync_configure(&s->fs)) < 0)
         return ret;
 
-    for (i = 0; i < s->nb_planes; i++) {
-        for (j = 0; j < MAX_THREADS; j++) {
-            s->fft[i][j]  = av_fft_init(s->fft_bits[i], 0);
-            s->ifft[i][j] = av_fft_init(s->fft_bits[i], 1);
-            if (!s->fft[i][j] || !s->ifft[i][j])
-                return AVERROR(ENOMEM);
-        }
-    }
-
     return 0;
 }
 
@@ -580,20 +434,12 @@ static av_cold int init(AVFilterContext *ctx)
 static av_cold void uninit(AVFilterContext *ctx)
 {
     ConvolveContext *s = ctx->priv;
-    int i, j;
+    int i;
 
     for (i = 0; i < 4; i++) {
-        av_freep(&s->fft_hdata[i]);
-        av_freep(&s->fft_vdata[i]);
-        av_freep(&s->fft_hdata_impulse[i]);
-        av_freep(&s->fft_vdata_impulse[i]);
-
-        for (j = 0; j < MAX_THREADS; j++) {
-            av_fft_end(s->fft[i][j]);
-            s->fft[i][j] = NULL;
-            av_fft_end(s->ifft[i][j]);
-            s->ifft[i][j] = NULL;
-        }
+        av_freep(&s->fft_data[i]);
+        av_freep(&s->fft_data_impulse[i]);
+        ff_fft2d_uninit(&s->fft[i]);
     }
 
     ff_framesync_uninit(&s->fs);
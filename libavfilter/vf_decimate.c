@@ -21,6 +21,7 @@
 
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/pixelutils.h"
 #include "libavutil/timestamp.h"
 #include "avfilter.h"
 #include "filters.h"
@@ -52,6 +53,8 @@ typedef struct DecimateContext {
     int nxblocks, nyblocks;
     int bdiffsize;
     int64_t *bdiffs;
+    av_pixelutils_sad_fn sad[2];    ///< luma and chroma full block SAD, if available
+    int nb_threads;
 
     /* options */
     int cycle;
@@ -80,53 +83,95 @@ static const AVOption decimate_options[] = {
 
 AVFILTER_DEFINE_CLASS(decimate);
 
-static void calc_diffs(const DecimateContext *dm, struct qitem *q,
-                       const AVFrame *f1, const AVFrame *f2)
+typedef struct ThreadData {
+    const AVFrame *f1, *f2;
+} ThreadData;
+
+#define BLOCK_SAD(nbits)                                                        \
+static int64_t block_sad##nbits(const uint8_t *f1p, int linesize1,              \
+                                const uint8_t *f2p, int linesize2,              \
+                                int w, int h)                                   \
+{                                                                               \
+    int64_t acc = 0;                                                            \
+                                                                                \
+    for (int y = 0; y < h; y++) {                                               \
+        for (int x = 0; x < w; x++)                                             \
+            acc += abs(((const uint##nbits##_t *)f1p)[x] -                      \
+                       ((const uint##nbits##_t *)f2p)[x]);                      \
+        f1p += linesize1;                                                       \
+        f2p += linesize2;                                                       \
+    }                                                                           \
+    return acc;                                                                 \
+}
+
+BLOCK_SAD(8)
+BLOCK_SAD(16)
+
+static int calc_diffs_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    int64_t maxdiff = -1;
+    const DecimateContext *dm = ctx->priv;
+    const ThreadData *td = arg;
+    const AVFrame *f1 = td->f1;
+    const AVFrame *f2 = td->f2;
+    const int slice_start = (dm->nyblocks *  jobnr   ) / nb_jobs;
+    const int slice_end   = (dm->nyblocks * (jobnr+1)) / nb_jobs;
+    const int bpc = (dm->depth + 7) / 8;
     int64_t *bdiffs = dm->bdiffs;
-    int plane, i, j;
+    int plane;
 
-    memset(bdiffs, 0, dm->bdiffsize * sizeof(*bdiffs));
+    memset(bdiffs + slice_start * dm->nxblocks, 0,
+           (slice_end - slice_start) * dm->nxblocks * sizeof(*bdiffs));
 
     for (plane = 0; plane < (dm->chroma && f1->data[2] ? 3 : 1); plane++) {
-        int x, y, xl;
+        int x, xdest, ydest;
         const int linesize1 = f1->linesize[plane];
         const int linesize2 = f2->linesize[plane];
-        const uint8_t *f1p = f1->data[plane];
-        const uint8_t *f2p = f2->data[plane];
         int width    = plane ? AV_CEIL_RSHIFT(f1->width,  dm->hsub) : f1->width;
         int height   = plane ? AV_CEIL_RSHIFT(f1->height, dm->vsub) : f1->height;
         int hblockx  = dm->blockx / 2;
         int hblocky  = dm->blocky / 2;
+        av_pixelutils_sad_fn sad = dm->sad[!!plane];
 
         if (plane) {
             hblockx >>= dm->hsub;
             hblocky >>= dm->vsub;
         }
 
-        for (y = 0; y < height; y++) {
-            int ydest = y / hblocky;
-            int xdest = 0;
-
-#define CALC_DIFF(nbits) do {                               \
-    for (x = 0; x < width; x += hblockx) {                  \
-        int64_t acc = 0;                                    \
-        int m = FFMIN(width, x + hblockx);                  \
-        for (xl = x; xl < m; xl++)                          \
-            acc += abs(((const uint##nbits##_t *)f1p)[xl] - \
-                       ((const uint##nbits##_t *)f2p)[xl]); \
-        bdiffs[ydest * dm->nxblocks + xdest] += acc;        \
-        xdest++;                                            \
-    }                                                       \
-} while (0)
-            if (dm->depth == 8) CALC_DIFF(8);
-            else                CALC_DIFF(16);
-
-            f1p += linesize1;
-            f2p += linesize2;
+        for (ydest = slice_start; ydest < slice_end; ydest++) {
+            const int bh = FFMIN(hblocky, height - ydest * hblocky);
+            const uint8_t *f1p = f1->data[plane] + ydest * hblocky * linesize1;
+            const uint8_t *f2p = f2->data[plane] + ydest * hblocky * linesize2;
+
+            if (bh <= 0)
+                break;
+
+            for (x = 0, xdest = 0; x < width; x += hblockx, xdest++) {
+                const int bw = FFMIN(hblockx, width - x);
+                int64_t *dst = &bdiffs[ydest * dm->nxblocks + xdest];
+
+                if (sad && bw == hblockx && bh == hblocky)
+                    *dst += sad(f1p + x, linesize1, f2p + x, linesize2);
+                else if (dm->depth == 8)
+                    *dst += block_sad8(f1p + x, linesize1, f2p + x, linesize2, bw, bh);
+                else
+                    *dst += block_sad16(f1p + x * bpc, linesize1, f2p + x * bpc, linesize2, bw, bh);
+            }
         }
     }
+    return 0;
+}
+
+static void calc_diffs(AVFilterContext *ctx, struct qitem *q,
+                       const AVFrame *f1, const AVFrame *f2)
+{
+    const DecimateContext *dm = ctx->priv;
+    ThreadData td = { .f1 = f1, .f2 = f2 };
+    int64_t maxdiff = -1;
+    int64_t *bdiffs = dm->bdiffs;
+    int i, j;
+
+    ctx->internal->execute(ctx, calc_diffs_slice, &td, NULL,
+                           FFMIN(dm->nyblocks, dm->nb_threads));
 
     for (i = 0; i < dm->nyblocks - 1; i++) {
         for (j = 0; j < dm->nxblocks - 1; j++) {
@@ -176,7 +221,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
             dm->queue[dm->fid].maxbdiff = INT64_MAX;
             dm->queue[dm->fid].totdiff  = INT64_MAX;
         } else {
-            calc_diffs(dm, &dm->queue[dm->fid], prv, in);
+            calc_diffs(ctx, &dm->queue[dm->fid], prv, in);
         }
         if (++dm->fid != dm->cycle)
             return 0;
@@ -397,6 +442,17 @@ static int config_output(AVFilterLink *outlink)
     if (!dm->bdiffs || !dm->queue)
         return AVERROR(ENOMEM);
 
+    dm->nb_threads = ff_filter_get_nb_threads(ctx);
+    if (dm->depth == 8) {
+        for (int i = 0; i < 2; i++) {
+            const int hblockx = (dm->blockx / 2) >> (i ? dm->hsub : 0);
+            const int hblocky = (dm->blocky / 2) >> (i ? dm->vsub : 0);
+
+            if (hblockx == hblocky && hblockx > 1)
+                dm->sad[i] = av_pixelutils_get_sad_fn(av_log2(hblockx), av_log2(hblocky), 0, ctx);
+        }
+    }
+
     if (dm->ppsrc) {
         dm->clean_src = av_calloc(dm->cycle, sizeof(*dm->clean_src));
         if (!dm->clean_src)
@@ -444,5 +500,5 @@ AVFilter ff_vf_decimate = {
     .query_formats = query_formats,
     .outputs       = decimate_outputs,
     .priv_class    = &decimate_class,
-    .flags         = AVFILTER_FLAG_DYNAMIC_INPUTS,
+    .flags         = AVFILTER_FLAG_DYNAMIC_INPUTS | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -203,6 +203,14 @@ typedef struct DrawTextContext {
     int text_shaping;               ///< 1 to shape the text before drawing it
 #endif
     AVDictionary *metadata;
+
+    char *rendered_text;            ///< expanded text the masks were rendered for
+    unsigned int rendered_fontsize; ///< font size the masks were rendered with
+    int text_w, text_h;             ///< size of the laid out text
+    uint8_t *text_mask;             ///< coverage of the glyphs, then of their border
+    unsigned int text_mask_size;
+    int mask_x, mask_y;             ///< position of the masks relative to the text
+    int mask_w, mask_h;             ///< size of each of the masks
 } DrawTextContext;
 
 #define OFFSET(x) offsetof(DrawTextContext, x)
@@ -823,6 +831,10 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     av_bprint_finalize(&s->expanded_text, NULL);
     av_bprint_finalize(&s->expanded_fontcolor, NULL);
+
+    av_freep(&s->rendered_text);
+    av_freep(&s->text_mask);
+    s->text_mask_size = 0;
 }
 
 static int config_input(AVFilterLink *inlink)
@@ -1213,19 +1225,39 @@ static int expand_text(AVFilterContext *ctx, char *text, AVBPrint *bp)
     return 0;
 }
 
-static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
-                       int width, int height,
-                       FFDrawColor *color,
-                       int x, int y, int borderw)
+/* Add the coverage of a glyph to a mask, overlapping glyphs covering each
+ * other as if they were blended in turn */
+static void render_glyph(uint8_t *dst, int dst_linesize, const FT_Bitmap *bitmap)
+{
+    const uint8_t *src = bitmap->buffer;
+
+    for (int y = 0; y < bitmap->rows; y++) {
+        for (int x = 0; x < bitmap->width; x++) {
+            const unsigned a = bitmap->pixel_mode == FT_PIXEL_MODE_MONO ?
+                               (src[x >> 3] >> (~x & 7) & 1) * 255 : src[x];
+
+            dst[x] += a - (dst[x] * a + 127) / 255;
+        }
+        src += bitmap->pitch;
+        dst += dst_linesize;
+    }
+}
+
+/**
+ * Render the laid out text into the masks, which are only blended into the
+ * frames afterwards and reused as long as the text does not change.
+ */
+static int render_text(DrawTextContext *s)
 {
+    const int borderw = s->borderw;
+    int x0 = INT_MAX, y0 = INT_MAX, x1 = INT_MIN, y1 = INT_MIN;
     char *text = s->expanded_text.str;
     uint32_t code = 0;
-    int i, x1, y1;
+    Glyph *glyph;
     uint8_t *p;
-    Glyph *glyph = NULL;
+    int i;
 
     for (i = 0, p = text; *p; i++) {
-        FT_Bitmap bitmap;
         Glyph dummy = { 0 };
         GET_UTF8(code, *p ? *p++ : 0, code = 0xfffd; goto continue_on_invalid;);
 continue_on_invalid:
@@ -1238,26 +1270,118 @@ continue_on_invalid:
         dummy.fontsize = s->fontsize;
         glyph = av_tree_find(s->glyphs, &dummy, glyph_cmp, NULL);
 
-        bitmap = borderw ? glyph->border_bitmap : glyph->bitmap;
-
         if (glyph->bitmap.pixel_mode != FT_PIXEL_MODE_MONO &&
             glyph->bitmap.pixel_mode != FT_PIXEL_MODE_GRAY)
             return AVERROR(EINVAL);
 
-        x1 = s->positions[i].x+s->x+x - borderw;
-        y1 = s->positions[i].y+s->y+y - borderw;
+        x0 = FFMIN(x0, s->positions[i].x);
+        y0 = FFMIN(y0, s->positions[i].y);
+        x1 = FFMAX(x1, s->positions[i].x + (int)glyph->bitmap.width);
+        y1 = FFMAX(y1, s->positions[i].y + (int)glyph->bitmap.rows);
+        if (borderw) {
+            x0 = FFMIN(x0, s->positions[i].x - borderw);
+            y0 = FFMIN(y0, s->positions[i].y - borderw);
+            x1 = FFMAX(x1, s->positions[i].x - borderw + (int)glyph->border_bitmap.width);
+            y1 = FFMAX(y1, s->positions[i].y - borderw + (int)glyph->border_bitmap.rows);
+        }
+    }
+
+    s->mask_x = x0;
+    s->mask_y = y0;
+    s->mask_w = FFMAX(x1 - x0, 0);
+    s->mask_h = FFMAX(y1 - y0, 0);
+    if (!s->mask_w || !s->mask_h)
+        return 0;
 
-        ff_blend_mask(&s->dc, color,
-                      frame->data, frame->linesize, width, height,
-                      bitmap.buffer, bitmap.pitch,
-                      bitmap.width, bitmap.rows,
-                      bitmap.pixel_mode == FT_PIXEL_MODE_MONO ? 0 : 3,
-                      0, x1, y1);
+    av_fast_malloc(&s->text_mask, &s->text_mask_size, 2 * s->mask_w * s->mask_h);
+    if (!s->text_mask)
+        return AVERROR(ENOMEM);
+    memset(s->text_mask, 0, 2 * s->mask_w * s->mask_h);
+
+    for (i = 0, p = text; *p; i++) {
+        Glyph dummy = { 0 };
+        uint8_t *mask = s->text_mask;
+        GET_UTF8(code, *p ? *p++ : 0, code = 0xfffd; goto continue_on_invalid2;);
+continue_on_invalid2:
+
+        if (code == '\n' || code == '\r' || code == '\t')
+            continue;
+
+        dummy.code = code;
+        dummy.fontsize = s->fontsize;
+        glyph = av_tree_find(s->glyphs, &dummy, glyph_cmp, NULL);
+
+        render_glyph(mask + (s->positions[i].y - y0) * s->mask_w +
+                     s->positions[i].x - x0, s->mask_w, &glyph->bitmap);
+        if (borderw) {
+            mask += s->mask_w * s->mask_h;
+            render_glyph(mask + (s->positions[i].y - borderw - y0) * s->mask_w +
+                         s->positions[i].x - borderw - x0, s->mask_w,
+                         &glyph->border_bitmap);
+        }
     }
 
     return 0;
 }
 
+typedef struct ThreadData {
+    AVFrame *frame;
+    FFDrawColor fontcolor;
+    FFDrawColor shadowcolor;
+    FFDrawColor bordercolor;
+    FFDrawColor boxcolor;
+    int y0, y1;                     ///< range of rows drawn into
+} ThreadData;
+
+static void blend_text_mask(DrawTextContext *s, uint8_t *data[4], int linesize[4],
+                            int width, int height, FFDrawColor *color,
+                            const uint8_t *mask, int x, int y)
+{
+    ff_blend_mask(&s->dc, color, data, linesize, width, height,
+                  mask, s->mask_w, s->mask_w, s->mask_h, 3, 0,
+                  x + s->mask_x, y + s->mask_y);
+}
+
+static int draw_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    DrawTextContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *frame = td->frame;
+    const int align = 1 << s->dc.vsub_max;
+    const int nb_rows = (td->y1 - td->y0 + align - 1) / align;
+    const int start = td->y0 + (nb_rows *  jobnr)    / nb_jobs * align;
+    const int end   = FFMIN(td->y0 + (nb_rows * (jobnr+1)) / nb_jobs * align,
+                            td->y1);
+    const int y = s->y - start;
+    const uint8_t *mask = s->text_mask;
+    uint8_t *data[4] = { NULL };
+
+    /* Every slice blends into its own rows of the frame, as a smaller frame */
+    for (int i = 0; i < s->dc.nb_planes; i++)
+        data[i] = frame->data[i] + (start >> s->dc.vsub[i]) * frame->linesize[i];
+
+    if (s->draw_box)
+        ff_blend_rectangle(&s->dc, &td->boxcolor,
+                           data, frame->linesize, frame->width, end - start,
+                           s->x - s->boxborderw, y - s->boxborderw,
+                           s->text_w + s->boxborderw * 2, s->text_h + s->boxborderw * 2);
+
+    if (!s->mask_w || !s->mask_h)
+        return 0;
+
+    if (s->shadowx || s->shadowy)
+        blend_text_mask(s, data, frame->linesize, frame->width, end - start,
+                        &td->shadowcolor, mask, s->x + s->shadowx, y + s->shadowy);
+
+    if (s->borderw)
+        blend_text_mask(s, data, frame->linesize, frame->width, end - start,
+                        &td->bordercolor, mask + s->mask_w * s->mask_h, s->x, y);
+
+    blend_text_mask(s, data, frame->linesize, frame->width, end - start,
+                    &td->fontcolor, mask, s->x, y);
+
+    return 0;
+}
 
 static void update_color_with_alpha(DrawTextContext *s, FFDrawColor *color, const FFDrawColor incolor)
 {
@@ -1303,10 +1427,8 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
     struct tm ltime;
     AVBPrint *bp = &s->expanded_text;
 
-    FFDrawColor fontcolor;
-    FFDrawColor shadowcolor;
-    FFDrawColor bordercolor;
-    FFDrawColor boxcolor;
+    ThreadData td;
+    int y0, y1, nb_jobs;
 
     av_bprint_clear(bp);
 
@@ -1364,6 +1486,12 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
     if ((ret = update_fontsize(ctx)) < 0)
         return ret;
 
+    /* The layout and the rendered text only change with the text */
+    if (s->rendered_text && !strcmp(s->rendered_text, text) &&
+        s->rendered_fontsize == s->fontsize)
+        goto draw;
+    av_freep(&s->rendered_text);
+
     /* load and cache glyphs */
     for (i = 0, p = text; *p; i++) {
         GET_UTF8(code, *p ? *p++ : 0, code = 0xfffd; goto continue_on_invalid;);
@@ -1438,19 +1566,29 @@ continue_on_invalid2:
 
     s->var_values[VAR_LINE_H] = s->var_values[VAR_LH] = s->max_glyph_h;
 
+    s->text_w = max_text_line_w;
+    s->text_h = y + s->max_glyph_h;
+
+    if ((ret = render_text(s)) < 0)
+        return ret;
+    if (!(s->rendered_text = av_strdup(text)))
+        return AVERROR(ENOMEM);
+    s->rendered_fontsize = s->fontsize;
+
+draw:
     s->x = s->var_values[VAR_X] = av_expr_eval(s->x_pexpr, s->var_values, &s->prng);
     s->y = s->var_values[VAR_Y] = av_expr_eval(s->y_pexpr, s->var_values, &s->prng);
     /* It is necessary if x is expressed from y  */
     s->x = s->var_values[VAR_X] = av_expr_eval(s->x_pexpr, s->var_values, &s->prng);
 
     update_alpha(s);
-    update_color_with_alpha(s, &fontcolor  , s->fontcolor  );
-    update_color_with_alpha(s, &shadowcolor, s->shadowcolor);
-    update_color_with_alpha(s, &bordercolor, s->bordercolor);
-    update_color_with_alpha(s, &boxcolor   , s->boxcolor   );
+    update_color_with_alpha(s, &td.fontcolor  , s->fontcolor  );
+    update_color_with_alpha(s, &td.shadowcolor, s->shadowcolor);
+    update_color_with_alpha(s, &td.bordercolor, s->bordercolor);
+    update_color_with_alpha(s, &td.boxcolor   , s->boxcolor   );
 
-    box_w = max_text_line_w;
-    box_h = y + s->max_glyph_h;
+    box_w = s->text_w;
+    box_h = s->text_h;
 
     if (s->fix_bounds) {
 
@@ -1478,27 +1616,28 @@ continue_on_invalid2:
             s->y = FFMAX(height - box_h - offsetbottom, 0);
     }
 
-    /* draw box */
-    if (s->draw_box)
-        ff_blend_rectangle(&s->dc, &boxcolor,
-                           frame->data, frame->linesize, width, height,
-                           s->x - s->boxborderw, s->y - s->boxborderw,
-                           box_w + s->boxborderw * 2, box_h + s->boxborderw * 2);
-
-    if (s->shadowx || s->shadowy) {
-        if ((ret = draw_glyphs(s, frame, width, height,
-                               &shadowcolor, s->shadowx, s->shadowy, 0)) < 0)
-            return ret;
+    /* rows covered by the box, the shadow, the border and the text */
+    y0 = INT_MAX;
+    y1 = INT_MIN;
+    if (s->mask_w && s->mask_h) {
+        y0 = s->y + s->mask_y + FFMIN(s->shadowy, 0);
+        y1 = s->y + s->mask_y + s->mask_h + FFMAX(s->shadowy, 0);
     }
-
-    if (s->borderw) {
-        if ((ret = draw_glyphs(s, frame, width, height,
-                               &bordercolor, 0, 0, s->borderw)) < 0)
-            return ret;
+    if (s->draw_box) {
+        y0 = FFMIN(y0, s->y - s->boxborderw);
+        y1 = FFMAX(y1, s->y + box_h + s->boxborderw);
     }
-    if ((ret = draw_glyphs(s, frame, width, height,
-                           &fontcolor, 0, 0, 0)) < 0)
-        return ret;
+    y0 = FFMAX(y0, 0) & ~((1 << s->dc.vsub_max) - 1);
+    y1 = FFMIN(y1, height);
+    if (y0 >= y1)
+        return 0;
+
+    td.frame = frame;
+    td.y0    = y0;
+    td.y1    = y1;
+    nb_jobs  = (y1 - y0 + (1 << s->dc.vsub_max) - 1) >> s->dc.vsub_max;
+    ctx->internal->execute(ctx, draw_slice, &td, NULL,
+                           FFMIN(nb_jobs, ff_filter_get_nb_threads(ctx)));
 
     return 0;
 }
@@ -1574,5 +1713,5 @@ AVFilter ff_vf_drawtext = {
     .inputs        = avfilter_vf_drawtext_inputs,
     .outputs       = avfilter_vf_drawtext_outputs,
     .process_command = command,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -23,8 +23,8 @@
 #include "libavutil/imgutils.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
+#include "fft2d.h"
 #include "internal.h"
-#include "libavcodec/avfft.h"
 
 enum BufferTypes {
     CURRENT,
@@ -41,11 +41,10 @@ typedef struct PlaneContext {
     float n;
 
     float *buffer[BSIZE];
-    FFTComplex *hdata, *vdata;
-    int data_linesize;
+    float *hdata;
     int buffer_linesize;
 
-    FFTContext *fft, *ifft;
+    FFT2DContext fft;
 } PlaneContext;
 
 typedef struct FFTdnoizContext {
@@ -63,10 +62,11 @@ typedef struct FFTdnoizContext {
 
     int depth;
     int nb_planes;
+    int nb_threads;
     PlaneContext planes[4];
 
-    void (*import_row)(FFTComplex *dst, uint8_t *src, int rw);
-    void (*export_row)(FFTComplex *src, uint8_t *dst, int rw, float scale, int depth);
+    void (*import_row)(float *dst, uint8_t *src, int rw);
+    void (*export_row)(float *src, uint8_t *dst, int rw, float scale, int depth);
 } FFTdnoizContext;
 
 #define OFFSET(x) offsetof(FFTdnoizContext, x)
@@ -91,23 +91,6 @@ static const AVOption fftdnoiz_options[] = {
 
 AVFILTER_DEFINE_CLASS(fftdnoiz);
 
-static av_cold int init(AVFilterContext *ctx)
-{
-    FFTdnoizContext *s = ctx->priv;
-    int i;
-
-    for (i = 0; i < 4; i++) {
-        PlaneContext *p = &s->planes[i];
-
-        p->fft  = av_fft_init(s->block_bits, 0);
-        p->ifft = av_fft_init(s->block_bits, 1);
-        if (!p->fft || !p->ifft)
-            return AVERROR(ENOMEM);
-    }
-
-    return 0;
-}
-
 static int query_formats(AVFilterContext *ctx)
 {
     static const enum AVPixelFormat pix_fmts[] = {
@@ -143,45 +126,44 @@ static int query_formats(AVFilterContext *ctx)
 }
 
 typedef struct ThreadData {
-    float *src, *dst;
+    uint8_t *data;
+    int linesize;
+    float *buffer, *pbuffer, *nbuffer;
+    int plane;
 } ThreadData;
 
-static void import_row8(FFTComplex *dst, uint8_t *src, int rw)
+static void import_row8(float *dst, uint8_t *src, int rw)
 {
     int j;
 
-    for (j = 0; j < rw; j++) {
-        dst[j].re = src[j];
-        dst[j].im = 0;
-    }
+    for (j = 0; j < rw; j++)
+        dst[j] = src[j];
 }
 
-static void export_row8(FFTComplex *src, uint8_t *dst, int rw, float scale, int depth)
+static void export_row8(float *src, uint8_t *dst, int rw, float scale, int depth)
 {
     int j;
 
     for (j = 0; j < rw; j++)
-        dst[j] = av_clip_uint8(src[j].re * scale + 0.5f);
+        dst[j] = av_clip_uint8(src[j] * scale + 0.5f);
 }
 
-static void import_row16(FFTComplex *dst, uint8_t *srcp, int rw)
+static void import_row16(float *dst, uint8_t *srcp, int rw)
 {
     uint16_t *src = (uint16_t *)srcp;
     int j;
 
-    for (j = 0; j < rw; j++) {
-        dst[j].re = src[j];
-        dst[j].im = 0;
-    }
+    for (j = 0; j < rw; j++)
+        dst[j] = src[j];
 }
 
-static void export_row16(FFTComplex *src, uint8_t *dstp, int rw, float scale, int depth)
+static void export_row16(float *src, uint8_t *dstp, int rw, float scale, int depth)
 {
     uint16_t *dst = (uint16_t *)dstp;
     int j;
 
     for (j = 0; j < rw; j++)
-        dst[j] = av_clip_uintp2_c(src[j].re * scale + 0.5f, depth);
+        dst[j] = av_clip_uintp2_c(src[j] * scale + 0.5f, depth);
 }
 
 static int config_input(AVFilterLink *inlink)
@@ -189,7 +171,7 @@ static int config_input(AVFilterLink *inlink)
     AVFilterContext *ctx = inlink->dst;
     const AVPixFmtDescriptor *desc;
     FFTdnoizContext *s = ctx->priv;
-    int i;
+    int i, ret;
 
     desc = av_pix_fmt_desc_get(inlink->format);
     s->depth = desc->comp[0].depth;
@@ -209,12 +191,17 @@ static int config_input(AVFilterLink *inlink)
     s->planes[0].planeheight = s->planes[3].planeheight = inlink->h;
 
     s->nb_planes = av_pix_fmt_count_planes(inlink->format);
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
 
     for (i = 0; i < s->nb_planes; i++) {
         PlaneContext *p = &s->planes[i];
         int size;
 
         p->b = 1 << s->block_bits;
+        ret = ff_fft2d_init(&p->fft, p->b, p->b, 1, s->nb_threads);
+        if (ret < 0)
+            return ret;
+
         p->n = 1.f / (p->b * p->b);
         p->o = p->b * s->overlap;
         size = p->b - p->o;
@@ -223,7 +210,7 @@ static int config_input(AVFilterLink *inlink)
 
         av_log(ctx, AV_LOG_DEBUG, "nox:%d noy:%d size:%d\n", p->nox, p->noy, size);
 
-        p->buffer_linesize = p->b * p->nox * sizeof(FFTComplex);
+        p->buffer_linesize = p->fft.spectrum_width * p->nox * sizeof(AVComplexFloat);
         p->buffer[CURRENT] = av_calloc(p->b * p->noy, p->buffer_linesize);
         if (!p->buffer[CURRENT])
             return AVERROR(ENOMEM);
@@ -237,21 +224,19 @@ static int config_input(AVFilterLink *inlink)
             if (!p->buffer[NEXT])
                 return AVERROR(ENOMEM);
         }
-        p->data_linesize = 2 * p->b * sizeof(float);
-        p->hdata = av_calloc(p->b, p->data_linesize);
-        p->vdata = av_calloc(p->b, p->data_linesize);
-        if (!p->hdata || !p->vdata)
+        p->hdata = av_calloc(s->nb_threads * p->b, p->fft.linesize);
+        if (!p->hdata)
             return AVERROR(ENOMEM);
     }
 
     return 0;
 }
 
-static void import_plane(FFTdnoizContext *s,
-                         uint8_t *srcp, int src_linesize,
-                         float *buffer, int buffer_linesize, int plane)
+static int import_plane(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    PlaneContext *p = &s->planes[plane];
+    FFTdnoizContext *s = ctx->priv;
+    ThreadData *td = arg;
+    PlaneContext *p = &s->planes[td->plane];
     const int width = p->planewidth;
     const int height = p->planeheight;
     const int block = p->b;
@@ -259,63 +244,57 @@ static void import_plane(FFTdnoizContext *s,
     const int size = block - overlap;
     const int nox = p->nox;
     const int noy = p->noy;
+    const int bw = p->fft.spectrum_width;
     const int bpp = (s->depth + 7) / 8;
-    const int data_linesize = p->data_linesize / sizeof(FFTComplex);
-    FFTComplex *hdata = p->hdata;
-    FFTComplex *vdata = p->vdata;
+    const int src_linesize = td->linesize;
+    const int data_linesize = p->fft.linesize / sizeof(float);
+    const int buffer_linesize = p->buffer_linesize / sizeof(float);
+    const int slice_start = (noy *  jobnr)    / nb_jobs;
+    const int slice_end   = (noy * (jobnr+1)) / nb_jobs;
+    float *hdata = p->hdata + jobnr * block * data_linesize;
     int x, y, i, j;
 
-    buffer_linesize /= sizeof(float);
-    for (y = 0; y < noy; y++) {
+    for (y = slice_start; y < slice_end; y++) {
         for (x = 0; x < nox; x++) {
             const int rh = FFMIN(block, height - y * size);
             const int rw = FFMIN(block, width  - x * size);
-            uint8_t *src = srcp + src_linesize * y * size + x * size * bpp;
-            float *bdst = buffer + buffer_linesize * y * block + x * block * 2;
-            FFTComplex *ssrc, *dst = hdata;
+            uint8_t *src = td->data + src_linesize * y * size + x * size * bpp;
+            float *bdst = td->buffer + buffer_linesize * y * block + x * bw * 2;
+            float *dst = hdata;
 
+            /* Mirror the incomplete blocks at the right and bottom edges */
             for (i = 0; i < rh; i++) {
                 s->import_row(dst, src, rw);
-                for (j = rw; j < block; j++) {
-                    dst[j].re = dst[block - j - 1].re;
-                    dst[j].im = 0;
-                }
-                av_fft_permute(p->fft, dst);
-                av_fft_calc(p->fft, dst);
+                for (j = rw; j < block; j++)
+                    dst[j] = dst[FFMAX(2 * rw - j - 1, 0)];
 
                 src += src_linesize;
                 dst += data_linesize;
             }
 
-            dst = hdata;
             for (; i < block; i++) {
-                for (j = 0; j < block; j++) {
-                    dst[j].re = dst[(block - i - 1) * data_linesize + j].re;
-                    dst[j].im = dst[(block - i - 1) * data_linesize + j].im;
-                }
+                memcpy(dst, hdata + FFMAX(2 * rh - i - 1, 0) * data_linesize,
+                       block * sizeof(*dst));
+                dst += data_linesize;
             }
 
-            ssrc = hdata;
-            dst = vdata;
-            for (i = 0; i < block; i++) {
-                for (j = 0; j < block; j++)
-                    dst[j] = ssrc[j * data_linesize + i];
-                av_fft_permute(p->fft, dst);
-                av_fft_calc(p->fft, dst);
-                memcpy(bdst, dst, block * sizeof(FFTComplex));
+            ff_fft2d_transform_block(&p->fft, jobnr, hdata, p->fft.linesize, 0);
 
-                dst += data_linesize;
+            for (i = 0; i < block; i++) {
+                memcpy(bdst, hdata + i * data_linesize, bw * sizeof(AVComplexFloat));
                 bdst += buffer_linesize;
             }
         }
     }
+
+    return 0;
 }
 
-static void export_plane(FFTdnoizContext *s,
-                         uint8_t *dstp, int dst_linesize,
-                         float *buffer, int buffer_linesize, int plane)
+static int export_plane(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    PlaneContext *p = &s->planes[plane];
+    FFTdnoizContext *s = ctx->priv;
+    ThreadData *td = arg;
+    PlaneContext *p = &s->planes[td->plane];
     const int depth = s->depth;
     const int bpp = (depth + 7) / 8;
     const int width = p->planewidth;
@@ -326,40 +305,41 @@ static void export_plane(FFTdnoizContext *s,
     const int size = block - overlap;
     const int nox = p->nox;
     const int noy = p->noy;
-    const int data_linesize = p->data_linesize / sizeof(FFTComplex);
+    const int bw = p->fft.spectrum_width;
+    const int dst_linesize = td->linesize;
+    const int data_linesize = p->fft.linesize / sizeof(float);
+    const int buffer_linesize = p->buffer_linesize / sizeof(float);
+    const int slice_start = (noy *  jobnr)    / nb_jobs;
+    const int slice_end   = (noy * (jobnr+1)) / nb_jobs;
     const float scale = 1.f / (block * block);
-    FFTComplex *hdata = p->hdata;
-    FFTComplex *vdata = p->vdata;
-    int x, y, i, j;
+    float *hdata = p->hdata + jobnr * block * data_linesize;
+    int x, y, i;
 
-    buffer_linesize /= sizeof(float);
-    for (y = 0; y < noy; y++) {
+    for (y = slice_start; y < slice_end; y++) {
         for (x = 0; x < nox; x++) {
+            /* The first block of a row or column also covers the overlap
+             * with the next one up to where that one starts writing, so
+             * that each output sample is written by a single block. */
             const int woff = x == 0 ? 0 : hoverlap;
             const int hoff = y == 0 ? 0 : hoverlap;
-            const int rw = x == 0 ? block : FFMIN(size, width  - x * size - woff);
-            const int rh = y == 0 ? block : FFMIN(size, height - y * size - hoff);
-            float *bsrc = buffer + buffer_linesize * y * block + x * block * 2;
-            uint8_t *dst = dstp + dst_linesize * (y * size + hoff) + (x * size + woff) * bpp;
-            FFTComplex *hdst, *ddst = vdata;
+            const int rw = x == 0 ? FFMIN(nox > 1 ? size + hoverlap : block, width)
+                                  : FFMIN(size, width  - x * size - woff);
+            const int rh = y == 0 ? FFMIN(noy > 1 ? size + hoverlap : block, height)
+                                  : FFMIN(size, height - y * size - hoff);
+            float *bsrc = td->buffer + buffer_linesize * y * block + x * bw * 2;
+            uint8_t *dst = td->data + dst_linesize * (y * size + hoff) + (x * size + woff) * bpp;
+            float *hdst = hdata;
 
-            hdst = hdata;
             for (i = 0; i < block; i++) {
-                memcpy(ddst, bsrc, block * sizeof(FFTComplex));
-                av_fft_permute(p->ifft, ddst);
-                av_fft_calc(p->ifft, ddst);
-                for (j = 0; j < block; j++) {
-                    hdst[j * data_linesize + i] = ddst[j];
-                }
-
-                ddst += data_linesize;
+                memcpy(hdst, bsrc, bw * sizeof(AVComplexFloat));
+                hdst += data_linesize;
                 bsrc += buffer_linesize;
             }
 
+            ff_fft2d_transform_block(&p->fft, jobnr, hdata, p->fft.linesize, 1);
+
             hdst = hdata + hoff * data_linesize;
             for (i = 0; i < rh; i++) {
-                av_fft_permute(p->ifft, hdst);
-                av_fft_calc(p->ifft, hdst);
                 s->export_row(hdst + woff, dst, rw, scale, depth);
 
                 hdst += data_linesize;
@@ -367,30 +347,39 @@ static void export_plane(FFTdnoizContext *s,
             }
         }
     }
+
+    return 0;
 }
 
-static void filter_plane3d2(FFTdnoizContext *s, int plane, float *pbuffer, float *nbuffer)
+static int filter_plane3d2(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    PlaneContext *p = &s->planes[plane];
+    FFTdnoizContext *s = ctx->priv;
+    ThreadData *td = arg;
+    PlaneContext *p = &s->planes[td->plane];
     const int block = p->b;
+    const int bw = p->fft.spectrum_width;
     const int nox = p->nox;
     const int noy = p->noy;
     const int buffer_linesize = p->buffer_linesize / sizeof(float);
+    const int slice_start = (noy *  jobnr)    / nb_jobs;
+    const int slice_end   = (noy * (jobnr+1)) / nb_jobs;
     const float sigma = s->sigma * s->sigma * block * block;
     const float limit = 1.f - s->amount;
     float *cbuffer = p->buffer[CURRENT];
+    float *pbuffer = td->pbuffer;
+    float *nbuffer = td->nbuffer;
     const float cfactor = sqrtf(3.f) * 0.5f;
     const float scale = 1.f / 3.f;
     int y, x, i, j;
 
-    for (y = 0; y < noy; y++) {
+    for (y = slice_start; y < slice_end; y++) {
         for (x = 0; x < nox; x++) {
-            float *cbuff = cbuffer + buffer_linesize * y * block + x * block * 2;
-            float *pbuff = pbuffer + buffer_linesize * y * block + x * block * 2;
-            float *nbuff = nbuffer + buffer_linesize * y * block + x * block * 2;
+            float *cbuff = cbuffer + buffer_linesize * y * block + x * bw * 2;
+            float *pbuff = pbuffer + buffer_linesize * y * block + x * bw * 2;
+            float *nbuff = nbuffer + buffer_linesize * y * block + x * bw * 2;
 
             for (i = 0; i < block; i++) {
-                for (j = 0; j < block; j++) {
+                for (j = 0; j < bw; j++) {
                     float sumr, sumi, difr, difi, mpr, mpi, mnr, mni;
                     float factor, power, sumpnr, sumpni;
 
@@ -427,27 +416,35 @@ static void filter_plane3d2(FFTdnoizContext *s, int plane, float *pbuffer, float
             }
         }
     }
+
+    return 0;
 }
 
-static void filter_plane3d1(FFTdnoizContext *s, int plane, float *pbuffer)
+static int filter_plane3d1(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    PlaneContext *p = &s->planes[plane];
+    FFTdnoizContext *s = ctx->priv;
+    ThreadData *td = arg;
+    PlaneContext *p = &s->planes[td->plane];
     const int block = p->b;
+    const int bw = p->fft.spectrum_width;
     const int nox = p->nox;
     const int noy = p->noy;
     const int buffer_linesize = p->buffer_linesize / sizeof(float);
+    const int slice_start = (noy *  jobnr)    / nb_jobs;
+    const int slice_end   = (noy * (jobnr+1)) / nb_jobs;
     const float sigma = s->sigma * s->sigma * block * block;
     const float limit = 1.f - s->amount;
     float *cbuffer = p->buffer[CURRENT];
+    float *pbuffer = td->pbuffer ? td->pbuffer : td->nbuffer;
     int y, x, i, j;
 
-    for (y = 0; y < noy; y++) {
+    for (y = slice_start; y < slice_end; y++) {
         for (x = 0; x < nox; x++) {
-            float *cbuff = cbuffer + buffer_linesize * y * block + x * block * 2;
-            float *pbuff = pbuffer + buffer_linesize * y * block + x * block * 2;
+            float *cbuff = cbuffer + buffer_linesize * y * block + x * bw * 2;
+            float *pbuff = pbuffer + buffer_linesize * y * block + x * bw * 2;
 
             for (i = 0; i < block; i++) {
-                for (j = 0; j < block; j++) {
+                for (j = 0; j < bw; j++) {
                     float factor, power, re, im, pre, pim;
                     float sumr, sumi, difr, difi;
 
@@ -479,26 +476,33 @@ static void filter_plane3d1(FFTdnoizContext *s, int plane, float *pbuffer)
             }
         }
     }
+
+    return 0;
 }
 
-static void filter_plane2d(FFTdnoizContext *s, int plane)
+static int filter_plane2d(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    PlaneContext *p = &s->planes[plane];
+    FFTdnoizContext *s = ctx->priv;
+    ThreadData *td = arg;
+    PlaneContext *p = &s->planes[td->plane];
     const int block = p->b;
+    const int bw = p->fft.spectrum_width;
     const int nox = p->nox;
     const int noy = p->noy;
     const int buffer_linesize = p->buffer_linesize / 4;
+    const int slice_start = (noy *  jobnr)    / nb_jobs;
+    const int slice_end   = (noy * (jobnr+1)) / nb_jobs;
     const float sigma = s->sigma * s->sigma * block * block;
     const float limit = 1.f - s->amount;
     float *buffer = p->buffer[CURRENT];
     int y, x, i, j;
 
-    for (y = 0; y < noy; y++) {
+    for (y = slice_start; y < slice_end; y++) {
         for (x = 0; x < nox; x++) {
-            float *buff = buffer + buffer_linesize * y * block + x * block * 2;
+            float *buff = buffer + buffer_linesize * y * block + x * bw * 2;
 
             for (i = 0; i < block; i++) {
-                for (j = 0; j < block; j++) {
+                for (j = 0; j < bw; j++) {
                     float factor, power, re, im;
 
                     re = buff[j * 2    ];
@@ -513,6 +517,8 @@ static void filter_plane2d(FFTdnoizContext *s, int plane)
             }
         }
     }
+
+    return 0;
 }
 
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
@@ -569,6 +575,8 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 
     for (plane = 0; plane < s->nb_planes; plane++) {
         PlaneContext *p = &s->planes[plane];
+        const int nb_jobs = FFMIN(p->noy, s->nb_threads);
+        ThreadData td;
 
         if (!((1 << plane) & s->planesf) || ctx->is_disabled) {
             if (!direct)
@@ -578,31 +586,40 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
             continue;
         }
 
+        td.plane   = plane;
+        td.pbuffer = s->prev ? p->buffer[PREV] : NULL;
+        td.nbuffer = s->next ? p->buffer[NEXT] : NULL;
+
         if (s->next) {
-            import_plane(s, s->next->data[plane], s->next->linesize[plane],
-                         p->buffer[NEXT], p->buffer_linesize, plane);
+            td.data     = s->next->data[plane];
+            td.linesize = s->next->linesize[plane];
+            td.buffer   = p->buffer[NEXT];
+            ctx->internal->execute(ctx, import_plane, &td, NULL, nb_jobs);
         }
 
         if (s->prev) {
-            import_plane(s, s->prev->data[plane], s->prev->linesize[plane],
-                         p->buffer[PREV], p->buffer_linesize, plane);
+            td.data     = s->prev->data[plane];
+            td.linesize = s->prev->linesize[plane];
+            td.buffer   = p->buffer[PREV];
+            ctx->internal->execute(ctx, import_plane, &td, NULL, nb_jobs);
         }
 
-        import_plane(s, s->cur->data[plane], s->cur->linesize[plane],
-                     p->buffer[CURRENT], p->buffer_linesize, plane);
+        td.data     = s->cur->data[plane];
+        td.linesize = s->cur->linesize[plane];
+        td.buffer   = p->buffer[CURRENT];
+        ctx->internal->execute(ctx, import_plane, &td, NULL, nb_jobs);
 
         if (s->next && s->prev) {
-            filter_plane3d2(s, plane, p->buffer[PREV], p->buffer[NEXT]);
-        } else if (s->next) {
-            filter_plane3d1(s, plane, p->buffer[NEXT]);
-        } else  if (s->prev) {
-            filter_plane3d1(s, plane, p->buffer[PREV]);
+            ctx->internal->execute(ctx, filter_plane3d2, &td, NULL, nb_jobs);
+        } else if (s->next || s->prev) {
+            ctx->internal->execute(ctx, filter_plane3d1, &td, NULL, nb_jobs);
         } else {
-            filter_plane2d(s, plane);
+            ctx->internal->execute(ctx, filter_plane2d, &td, NULL, nb_jobs);
         }
 
-        export_plane(s, out->data[plane], out->linesize[plane],
-                     p->buffer[CURRENT], p->buffer_linesize, plane);
+        td.data     = out->data[plane];
+        td.linesize = out->linesize[plane];
+        ctx->internal->execute(ctx, export_plane, &td, NULL, nb_jobs);
     }
 
     if (s->nb_next == 0 && s->nb_prev == 0) {
@@ -653,12 +670,10 @@ static av_cold void uninit(AVFilterContext *ctx)
         PlaneContext *p = &s->planes[i];
 
         av_freep(&p->hdata);
-        av_freep(&p->vdata);
         av_freep(&p->buffer[PREV]);
         av_freep(&p->buffer[CURRENT]);
         av_freep(&p->buffer[NEXT]);
-        av_fft_end(p->fft);
-        av_fft_end(p->ifft);
+        ff_fft2d_uninit(&p->fft);
     }
 
     av_frame_free(&s->prev);
@@ -689,11 +704,10 @@ AVFilter ff_vf_fftdnoiz = {
     .name          = "fftdnoiz",
     .description   = NULL_IF_CONFIG_SMALL("Denoise frames using 3D FFT."),
     .priv_size     = sizeof(FFTdnoizContext),
-    .init          = init,
     .uninit        = uninit,
     .query_formats = query_formats,
     .inputs        = fftdnoiz_inputs,
     .outputs       = fftdnoiz_outputs,
     .priv_class    = &fftdnoiz_class,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL | AVFILTER_FLAG_SLICE_THREADS,
 };
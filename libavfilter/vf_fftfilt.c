@@ -29,8 +29,8 @@
 #include "libavutil/imgutils.h"
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
-#include "libavcodec/avfft.h"
 #include "libavutil/eval.h"
+#include "fft2d.h"
 
 #define MAX_PLANES 4
 
@@ -49,24 +49,18 @@ typedef struct FFTFILTContext {
     int planewidth[MAX_PLANES];
     int planeheight[MAX_PLANES];
 
-    RDFTContext *hrdft[MAX_PLANES];
-    RDFTContext *vrdft[MAX_PLANES];
-    RDFTContext *ihrdft[MAX_PLANES];
-    RDFTContext *ivrdft[MAX_PLANES];
-    int rdft_hbits[MAX_PLANES];
-    int rdft_vbits[MAX_PLANES];
-    size_t rdft_hlen[MAX_PLANES];
-    size_t rdft_vlen[MAX_PLANES];
-    FFTSample *rdft_hdata[MAX_PLANES];
-    FFTSample *rdft_vdata[MAX_PLANES];
+    FFT2DContext fft[MAX_PLANES];
+    int rdft_hlen[MAX_PLANES];
+    int rdft_vlen[MAX_PLANES];
+    float *rdft_data[MAX_PLANES];
 
     int dc[MAX_PLANES];
     char *weight_str[MAX_PLANES];
     AVExpr *weight_expr[MAX_PLANES];
     double *weight[MAX_PLANES];
 
-    void (*rdft_horizontal)(struct FFTFILTContext *s, AVFrame *in, int w, int h, int plane);
-    void (*irdft_horizontal)(struct FFTFILTContext *s, AVFrame *out, int w, int h, int plane);
+    void (*rdft_horizontal)(struct FFTFILTContext *s, AVFrame *in, int plane, int start, int end);
+    void (*irdft_horizontal)(struct FFTFILTContext *s, AVFrame *out, int plane, int start, int end);
 } FFTFILTContext;
 
 static const char *const var_names[] = {   "X",   "Y",   "W",   "H",   "N", NULL        };
@@ -92,17 +86,28 @@ static const AVOption fftfilt_options[] = {
 
 AVFILTER_DEFINE_CLASS(fftfilt);
 
+static inline AVComplexFloat *spectrum_row(FFTFILTContext *s, int plane, int y)
+{
+    return (AVComplexFloat *)((uint8_t *)s->rdft_data[plane] + y * s->fft[plane].linesize);
+}
+
+/* The X and Y coordinates of the expressions are twice the horizontal and
+ * vertical frequencies of the bins, that is where they used to be in the
+ * packed real spectrum of the 1D transforms. */
 static inline double lum(void *priv, double x, double y, int plane)
 {
     FFTFILTContext *s = priv;
-    return s->rdft_vdata[plane][(int)x * s->rdft_vlen[plane] + (int)y];
+    const int k = av_clip(x / 2, 0, s->fft[plane].spectrum_width - 1);
+    const int l = av_clip(y / 2, 0, s->rdft_vlen[plane] / 2);
+
+    return spectrum_row(s, plane, l)[k].re;
 }
 
 static double weight_Y(void *priv, double x, double y) { return lum(priv, x, y, Y); }
 static double weight_U(void *priv, double x, double y) { return lum(priv, x, y, U); }
 static double weight_V(void *priv, double x, double y) { return lum(priv, x, y, V); }
 
-static void copy_rev (FFTSample *dest, int w, int w2)
+static void copy_rev (float *dest, int w, int w2)
 {
     int i;
 
@@ -113,100 +118,83 @@ static void copy_rev (FFTSample *dest, int w, int w2)
         dest[i] = dest[w2 - i];
 }
 
-/*Horizontal pass - RDFT*/
-static void rdft_horizontal8(FFTFILTContext *s, AVFrame *in, int w, int h, int plane)
+/*Horizontal pass - import and pad the rows*/
+static void rdft_horizontal8(FFTFILTContext *s, AVFrame *in, int plane, int start, int end)
 {
+    const int w = s->planewidth[plane];
     int i, j;
 
-    for (i = 0; i < h; i++) {
+    for (i = start; i < end; i++) {
+        const uint8_t *src = in->data[plane] + in->linesize[plane] * i;
+        float *dst = (float *)spectrum_row(s, plane, i);
+
         for (j = 0; j < w; j++)
-            s->rdft_hdata[plane][i * s->rdft_hlen[plane] + j] = *(in->data[plane] + in->linesize[plane] * i + j);
+            dst[j] = src[j];
 
-        copy_rev(s->rdft_hdata[plane] + i * s->rdft_hlen[plane], w, s->rdft_hlen[plane]);
+        copy_rev(dst, w, s->rdft_hlen[plane]);
     }
-
-    for (i = 0; i < h; i++)
-        av_rdft_calc(s->hrdft[plane], s->rdft_hdata[plane] + i * s->rdft_hlen[plane]);
 }
 
-static void rdft_horizontal16(FFTFILTContext *s, AVFrame *in, int w, int h, int plane)
+static void rdft_horizontal16(FFTFILTContext *s, AVFrame *in, int plane, int start, int end)
 {
-    const uint16_t *src = (const uint16_t *)in->data[plane];
-    int linesize = in->linesize[plane] / 2;
+    const int w = s->planewidth[plane];
     int i, j;
 
-    for (i = 0; i < h; i++) {
+    for (i = start; i < end; i++) {
+        const uint16_t *src = (const uint16_t *)(in->data[plane] + in->linesize[plane] * i);
+        float *dst = (float *)spectrum_row(s, plane, i);
+
         for (j = 0; j < w; j++)
-            s->rdft_hdata[plane][i * s->rdft_hlen[plane] + j] = *(src + linesize * i + j);
+            dst[j] = src[j];
 
-        copy_rev(s->rdft_hdata[plane] + i * s->rdft_hlen[plane], w, s->rdft_hlen[plane]);
+        copy_rev(dst, w, s->rdft_hlen[plane]);
     }
-
-    for (i = 0; i < h; i++)
-        av_rdft_calc(s->hrdft[plane], s->rdft_hdata[plane] + i * s->rdft_hlen[plane]);
 }
 
-/*Vertical pass - RDFT*/
-static void rdft_vertical(FFTFILTContext *s, int h, int plane)
+/*Vertical padding, mirrors the rows like copy_rev()*/
+static void pad_vertical(FFTFILTContext *s, int plane)
 {
-    int i, j;
-
-    for (i = 0; i < s->rdft_hlen[plane]; i++) {
-        for (j = 0; j < h; j++)
-            s->rdft_vdata[plane][i * s->rdft_vlen[plane] + j] =
-            s->rdft_hdata[plane][j * s->rdft_hlen[plane] + i];
-        copy_rev(s->rdft_vdata[plane] + i * s->rdft_vlen[plane], h, s->rdft_vlen[plane]);
-    }
-
-    for (i = 0; i < s->rdft_hlen[plane]; i++)
-        av_rdft_calc(s->vrdft[plane], s->rdft_vdata[plane] + i * s->rdft_vlen[plane]);
-}
-/*Vertical pass - IRDFT*/
-static void irdft_vertical(FFTFILTContext *s, int h, int plane)
-{
-    int i, j;
+    const int h = s->planeheight[plane], vlen = s->rdft_vlen[plane];
+    const size_t size = s->rdft_hlen[plane] * sizeof(float);
+    int i;
 
-    for (i = 0; i < s->rdft_hlen[plane]; i++)
-        av_rdft_calc(s->ivrdft[plane], s->rdft_vdata[plane] + i * s->rdft_vlen[plane]);
+    for (i = h; i < h + (vlen - h) / 2; i++)
+        memcpy(spectrum_row(s, plane, i), spectrum_row(s, plane, 2 * h - i - 1), size);
 
-    for (i = 0; i < s->rdft_hlen[plane]; i++)
-        for (j = 0; j < h; j++)
-            s->rdft_hdata[plane][j * s->rdft_hlen[plane] + i] =
-            s->rdft_vdata[plane][i * s->rdft_vlen[plane] + j];
+    for (; i < vlen; i++)
+        memcpy(spectrum_row(s, plane, i), spectrum_row(s, plane, vlen - i), size);
 }
 
-/*Horizontal pass - IRDFT*/
-static void irdft_horizontal8(FFTFILTContext *s, AVFrame *out, int w, int h, int plane)
+/*Horizontal pass - export the rows*/
+static void irdft_horizontal8(FFTFILTContext *s, AVFrame *out, int plane, int start, int end)
 {
+    const int w = s->planewidth[plane];
+    const float scale = 1.f / (s->rdft_hlen[plane] * s->rdft_vlen[plane]);
     int i, j;
 
-    for (i = 0; i < h; i++)
-        av_rdft_calc(s->ihrdft[plane], s->rdft_hdata[plane] + i * s->rdft_hlen[plane]);
+    for (i = start; i < end; i++) {
+        const float *src = (const float *)spectrum_row(s, plane, i);
+        uint8_t *dst = out->data[plane] + out->linesize[plane] * i;
 
-    for (i = 0; i < h; i++)
         for (j = 0; j < w; j++)
-            *(out->data[plane] + out->linesize[plane] * i + j) = av_clip(s->rdft_hdata[plane][i
-                                                                         *s->rdft_hlen[plane] + j] * 4 /
-                                                                         (s->rdft_hlen[plane] *
-                                                                          s->rdft_vlen[plane]), 0, 255);
+            dst[j] = av_clip_uint8(src[j] * scale);
+    }
 }
 
-static void irdft_horizontal16(FFTFILTContext *s, AVFrame *out, int w, int h, int plane)
+static void irdft_horizontal16(FFTFILTContext *s, AVFrame *out, int plane, int start, int end)
 {
-    uint16_t *dst = (uint16_t *)out->data[plane];
-    int linesize = out->linesize[plane] / 2;
-    int max = (1 << s->depth) - 1;
+    const int w = s->planewidth[plane];
+    const float scale = 1.f / (s->rdft_hlen[plane] * s->rdft_vlen[plane]);
+    const int max = (1 << s->depth) - 1;
     int i, j;
 
-    for (i = 0; i < h; i++)
-        av_rdft_calc(s->ihrdft[plane], s->rdft_hdata[plane] + i * s->rdft_hlen[plane]);
+    for (i = start; i < end; i++) {
+        const float *src = (const float *)spectrum_row(s, plane, i);
+        uint16_t *dst = (uint16_t *)(out->data[plane] + out->linesize[plane] * i);
 
-    for (i = 0; i < h; i++)
         for (j = 0; j < w; j++)
-            *(dst + linesize * i + j) = av_clip(s->rdft_hdata[plane][i
-                                                *s->rdft_hlen[plane] + j] * 4 /
-                                                (s->rdft_hlen[plane] *
-                                                s->rdft_vlen[plane]), 0, max);
+            dst[j] = av_clip(src[j] * scale, 0, max);
+    }
 }
 
 static av_cold int initialize(AVFilterContext *ctx)
@@ -245,6 +233,8 @@ static av_cold int initialize(AVFilterContext *ctx)
 
 static void do_eval(FFTFILTContext *s, AVFilterLink *inlink, int plane)
 {
+    const int sw = s->fft[plane].spectrum_width;
+    const int vlen = s->rdft_vlen[plane];
     double values[VAR_VARS_NB];
     int i, j;
 
@@ -252,11 +242,11 @@ static void do_eval(FFTFILTContext *s, AVFilterLink *inlink, int plane)
     values[VAR_W] = s->planewidth[plane];
     values[VAR_H] = s->planeheight[plane];
 
-    for (i = 0; i < s->rdft_hlen[plane]; i++) {
-        values[VAR_X] = i;
-        for (j = 0; j < s->rdft_vlen[plane]; j++) {
-            values[VAR_Y] = j;
-            s->weight[plane][i * s->rdft_vlen[plane] + j] =
+    for (i = 0; i < vlen; i++) {
+        values[VAR_Y] = 2 * FFMIN(i, vlen - i);
+        for (j = 0; j < sw; j++) {
+            values[VAR_X] = 2 * j;
+            s->weight[plane][i * sw + j] =
             av_expr_eval(s->weight_expr[plane], values, s);
         }
     }
@@ -264,9 +254,10 @@ static void do_eval(FFTFILTContext *s, AVFilterLink *inlink, int plane)
 
 static int config_props(AVFilterLink *inlink)
 {
-    FFTFILTContext *s = inlink->dst->priv;
+    AVFilterContext *ctx = inlink->dst;
+    FFTFILTContext *s = ctx->priv;
     const AVPixFmtDescriptor *desc;
-    int rdft_hbits, rdft_vbits, i, plane;
+    int rdft_hbits, rdft_vbits, i, plane, ret;
 
     desc = av_pix_fmt_desc_get(inlink->format);
     s->depth = desc->comp[0].depth;
@@ -281,34 +272,26 @@ static int config_props(AVFilterLink *inlink)
         int w = s->planewidth[i];
         int h = s->planeheight[i];
 
-        /* RDFT - Array initialization for Horizontal pass*/
         for (rdft_hbits = 1; 1 << rdft_hbits < w*10/9; rdft_hbits++);
-        s->rdft_hbits[i] = rdft_hbits;
-        s->rdft_hlen[i] = 1 << rdft_hbits;
-        if (!(s->rdft_hdata[i] = av_malloc_array(h, s->rdft_hlen[i] * sizeof(FFTSample))))
-            return AVERROR(ENOMEM);
-
-        if (!(s->hrdft[i] = av_rdft_init(s->rdft_hbits[i], DFT_R2C)))
-            return AVERROR(ENOMEM);
-        if (!(s->ihrdft[i] = av_rdft_init(s->rdft_hbits[i], IDFT_C2R)))
-            return AVERROR(ENOMEM);
-
-        /* RDFT - Array initialization for Vertical pass*/
         for (rdft_vbits = 1; 1 << rdft_vbits < h*10/9; rdft_vbits++);
-        s->rdft_vbits[i] = rdft_vbits;
+        s->rdft_hlen[i] = 1 << rdft_hbits;
         s->rdft_vlen[i] = 1 << rdft_vbits;
-        if (!(s->rdft_vdata[i] = av_malloc_array(s->rdft_hlen[i], s->rdft_vlen[i] * sizeof(FFTSample))))
-            return AVERROR(ENOMEM);
 
-        if (!(s->vrdft[i] = av_rdft_init(s->rdft_vbits[i], DFT_R2C)))
-            return AVERROR(ENOMEM);
-        if (!(s->ivrdft[i] = av_rdft_init(s->rdft_vbits[i], IDFT_C2R)))
+        ret = ff_fft2d_init(&s->fft[i], s->rdft_hlen[i], s->rdft_vlen[i], 1,
+                            ff_filter_get_nb_threads(ctx));
+        if (ret < 0)
+            return ret;
+
+        av_freep(&s->rdft_data[i]);
+        if (!(s->rdft_data[i] = av_calloc(s->rdft_vlen[i], s->fft[i].linesize)))
             return AVERROR(ENOMEM);
     }
 
     /*Luminance value - Array initialization*/
     for (plane = 0; plane < 3; plane++) {
-        if(!(s->weight[plane] = av_malloc_array(s->rdft_hlen[plane], s->rdft_vlen[plane] * sizeof(double))))
+        av_freep(&s->weight[plane]);
+        if(!(s->weight[plane] = av_malloc_array(s->rdft_vlen[plane],
+                                                s->fft[plane].spectrum_width * sizeof(double))))
             return AVERROR(ENOMEM);
 
         if (s->eval_mode == EVAL_MODE_INIT)
@@ -327,13 +310,66 @@ static int config_props(AVFilterLink *inlink)
     return 0;
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int plane;
+} ThreadData;
+
+static int import_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    FFTFILTContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int h = s->planeheight[td->plane];
+
+    s->rdft_horizontal(s, td->in, td->plane, (h * jobnr) / nb_jobs, (h * (jobnr+1)) / nb_jobs);
+
+    return 0;
+}
+
+static int export_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    FFTFILTContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int h = s->planeheight[td->plane];
+
+    s->irdft_horizontal(s, td->out, td->plane, (h * jobnr) / nb_jobs, (h * (jobnr+1)) / nb_jobs);
+
+    return 0;
+}
+
+/*Change user defined parameters*/
+static int weight_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    FFTFILTContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int plane = td->plane;
+    const int sw = s->fft[plane].spectrum_width;
+    const int vlen = s->rdft_vlen[plane];
+    const int start = (vlen *  jobnr)    / nb_jobs;
+    const int end   = (vlen * (jobnr+1)) / nb_jobs;
+    int i, j;
+
+    for (i = start; i < end; i++) {
+        AVComplexFloat *row = spectrum_row(s, plane, i);
+        const double *weight = s->weight[plane] + i * sw;
+
+        for (j = 0; j < sw; j++) {
+            row[j].re *= weight[j];
+            row[j].im *= weight[j];
+        }
+    }
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
     AVFilterLink *outlink = inlink->dst->outputs[0];
     FFTFILTContext *s = ctx->priv;
+    const int nb_threads = ff_filter_get_nb_threads(ctx);
     AVFrame *out;
-    int i, j, plane;
+    int plane;
 
     out = ff_get_video_buffer(outlink, inlink->w, inlink->h);
     if (!out) {
@@ -344,25 +380,22 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     av_frame_copy_props(out, in);
 
     for (plane = 0; plane < s->nb_planes; plane++) {
-        int w = s->planewidth[plane];
-        int h = s->planeheight[plane];
+        const int h = s->planeheight[plane];
+        ThreadData td = { in, out, plane };
 
         if (s->eval_mode == EVAL_MODE_FRAME)
             do_eval(s, inlink, plane);
 
-        s->rdft_horizontal(s, in, w, h, plane);
-        rdft_vertical(s, h, plane);
+        ctx->internal->execute(ctx, import_slice, &td, NULL, FFMIN(h, nb_threads));
+        pad_vertical(s, plane);
+        ff_fft2d_transform(ctx, &s->fft[plane], s->rdft_data[plane], s->fft[plane].linesize, 0);
 
-        /*Change user defined parameters*/
-        for (i = 0; i < s->rdft_hlen[plane]; i++)
-            for (j = 0; j < s->rdft_vlen[plane]; j++)
-                s->rdft_vdata[plane][i * s->rdft_vlen[plane] + j] *=
-                  s->weight[plane][i * s->rdft_vlen[plane] + j];
+        ctx->internal->execute(ctx, weight_slice, &td, NULL, FFMIN(s->rdft_vlen[plane], nb_threads));
 
-        s->rdft_vdata[plane][0] += s->rdft_hlen[plane] * s->rdft_vlen[plane] * s->dc[plane];
+        spectrum_row(s, plane, 0)[0].re += s->rdft_hlen[plane] * s->rdft_vlen[plane] * s->dc[plane];
 
-        irdft_vertical(s, h, plane);
-        s->irdft_horizontal(s, out, w, h, plane);
+        ff_fft2d_transform(ctx, &s->fft[plane], s->rdft_data[plane], s->fft[plane].linesize, 1);
+        ctx->internal->execute(ctx, export_slice, &td, NULL, FFMIN(h, nb_threads));
     }
 
     av_frame_free(&in);
@@ -374,14 +407,10 @@ static av_cold void uninit(AVFilterContext *ctx)
     FFTFILTContext *s = ctx->priv;
     int i;
     for (i = 0; i < MAX_PLANES; i++) {
-        av_free(s->rdft_hdata[i]);
-        av_free(s->rdft_vdata[i]);
+        av_free(s->rdft_data[i]);
         av_expr_free(s->weight_expr[i]);
         av_free(s->weight[i]);
-        av_rdft_end(s->hrdft[i]);
-        av_rdft_end(s->ihrdft[i]);
-        av_rdft_end(s->vrdft[i]);
-        av_rdft_end(s->ivrdft[i]);
+        ff_fft2d_uninit(&s->fft[i]);
     }
 }
 
@@ -438,5 +467,5 @@ AVFilter ff_vf_fftfilt = {
     .query_formats   = query_formats,
     .init            = initialize,
     .uninit          = uninit,
-    .flags           = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags           = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
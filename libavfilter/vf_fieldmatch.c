@@ -37,6 +37,7 @@
 #include "libavutil/opt.h"
 #include "libavutil/timestamp.h"
 #include "avfilter.h"
+#include "fieldmatch.h"
 #include "filters.h"
 #include "internal.h"
 
@@ -109,6 +110,10 @@ typedef struct FieldMatchContext {
     int *c_array;
     int tpitchy, tpitchuv;
     uint8_t *tbuffer;
+    uint64_t (*sums)[6];            ///< per-slice accumulators
+
+    int nb_threads;
+    FieldMatchDSPContext dsp;
 } FieldMatchContext;
 
 #define OFFSET(x) offsetof(FieldMatchContext, x)
@@ -163,26 +168,86 @@ static int get_height(const FieldMatchContext *fm, const AVFrame *f, int plane)
     return plane ? AV_CEIL_RSHIFT(f->height, fm->vsub) : f->height;
 }
 
-static int64_t luma_abs_diff(const AVFrame *f1, const AVFrame *f2)
+int64_t ff_fieldmatch_sad_c(const uint8_t *a, ptrdiff_t a_linesize,
+                            const uint8_t *b, ptrdiff_t b_linesize,
+                            int width, int height)
 {
-    int x, y;
-    const uint8_t *srcp1 = f1->data[0];
-    const uint8_t *srcp2 = f2->data[0];
-    const int src1_linesize = f1->linesize[0];
-    const int src2_linesize = f2->linesize[0];
-    const int width  = f1->width;
-    const int height = f1->height;
     int64_t acc = 0;
 
-    for (y = 0; y < height; y++) {
-        for (x = 0; x < width; x++)
-            acc += abs(srcp1[x] - srcp2[x]);
-        srcp1 += src1_linesize;
-        srcp2 += src2_linesize;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++)
+            acc += abs(a[x] - b[x]);
+        a += a_linesize;
+        b += b_linesize;
     }
     return acc;
 }
 
+void ff_fieldmatch_abs_diff_c(uint8_t *dst, const uint8_t *a, const uint8_t *b,
+                              int width)
+{
+    for (int x = 0; x < width; x++)
+        dst[x] = FFABS(a[x] - b[x]);
+}
+
+void ff_fieldmatch_comb_mask_c(uint8_t *dst, const uint8_t *m2, const uint8_t *m1,
+                               const uint8_t *cur, const uint8_t *p1, const uint8_t *p2,
+                               int width, int cthresh)
+{
+    const int cthresh6 = cthresh * 6;
+
+    for (int x = 0; x < width; x++) {
+        const int s1 = abs(cur[x] - m1[x]);
+        const int s2 = abs(cur[x] - p1[x]);
+
+        /* [1 -3 4 -3 1] vertical filter */
+        dst[x] = s1 > cthresh && s2 > cthresh &&
+                 abs(4 * cur[x] - 3 * (m1[x] + p1[x]) + (m2[x] + p2[x])) > cthresh6 ? 0xff : 0;
+    }
+}
+
+av_cold void ff_fieldmatch_init(FieldMatchDSPContext *dsp)
+{
+    dsp->sad       = ff_fieldmatch_sad_c;
+    dsp->abs_diff  = ff_fieldmatch_abs_diff_c;
+    dsp->comb_mask = ff_fieldmatch_comb_mask_c;
+
+    if (ARCH_X86)
+        ff_fieldmatch_init_x86(dsp);
+}
+
+typedef struct ThreadData {
+    const AVFrame *f1, *f2;
+} ThreadData;
+
+static int luma_abs_diff_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    FieldMatchContext *fm = ctx->priv;
+    const ThreadData *td = arg;
+    const AVFrame *f1 = td->f1;
+    const AVFrame *f2 = td->f2;
+    const int slice_start = (f1->height *  jobnr   ) / nb_jobs;
+    const int slice_end   = (f1->height * (jobnr+1)) / nb_jobs;
+
+    fm->sums[jobnr][0] = fm->dsp.sad(f1->data[0] + slice_start * f1->linesize[0], f1->linesize[0],
+                                     f2->data[0] + slice_start * f2->linesize[0], f2->linesize[0],
+                                     f1->width, slice_end - slice_start);
+    return 0;
+}
+
+static int64_t luma_abs_diff(AVFilterContext *ctx, const AVFrame *f1, const AVFrame *f2)
+{
+    FieldMatchContext *fm = ctx->priv;
+    const int nb_jobs = FFMIN(f1->height, fm->nb_threads);
+    ThreadData td = { .f1 = f1, .f2 = f2 };
+    int64_t acc = 0;
+
+    ctx->internal->execute(ctx, luma_abs_diff_slice, &td, NULL, nb_jobs);
+    for (int i = 0; i < nb_jobs; i++)
+        acc += fm->sums[i][0];
+    return acc;
+}
+
 static void fill_buf(uint8_t *data, int w, int h, int linesize, uint8_t v)
 {
     int y;
@@ -193,80 +258,51 @@ static void fill_buf(uint8_t *data, int w, int h, int linesize, uint8_t v)
     }
 }
 
-static int calc_combed_score(const FieldMatchContext *fm, const AVFrame *src)
+/* lines outside of the plane are mirrored */
+static int comb_mask_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    int x, y, plane, max_v = 0;
-    const int cthresh = fm->cthresh;
-    const int cthresh6 = cthresh * 6;
+    FieldMatchContext *fm = ctx->priv;
+    const ThreadData *td = arg;
+    const AVFrame *src = td->f1;
 
-    for (plane = 0; plane < (fm->chroma ? 3 : 1); plane++) {
-        const uint8_t *srcp = src->data[plane];
+    for (int plane = 0; plane < (fm->chroma ? 3 : 1); plane++) {
         const int src_linesize = src->linesize[plane];
+        const int cmk_linesize = fm->cmask_linesize[plane];
         const int width  = get_width (fm, src, plane);
         const int height = get_height(fm, src, plane);
-        uint8_t *cmkp = fm->cmask_data[plane];
-        const int cmk_linesize = fm->cmask_linesize[plane];
+        const int slice_start = (height *  jobnr   ) / nb_jobs;
+        const int slice_end   = (height * (jobnr+1)) / nb_jobs;
+        uint8_t *cmkp = fm->cmask_data[plane] + slice_start * cmk_linesize;
 
-        if (cthresh < 0) {
-            fill_buf(cmkp, width, height, cmk_linesize, 0xff);
+        if (fm->cthresh < 0) {
+            fill_buf(cmkp, width, slice_end - slice_start, cmk_linesize, 0xff);
             continue;
         }
-        fill_buf(cmkp, width, height, cmk_linesize, 0);
 
-        /* [1 -3 4 -3 1] vertical filter */
-#define FILTER(xm2, xm1, xp1, xp2) \
-        abs(  4 * srcp[x] \
-             -3 * (srcp[x + (xm1)*src_linesize] + srcp[x + (xp1)*src_linesize]) \
-             +    (srcp[x + (xm2)*src_linesize] + srcp[x + (xp2)*src_linesize])) > cthresh6
-
-        /* first line */
-        for (x = 0; x < width; x++) {
-            const int s1 = abs(srcp[x] - srcp[x + src_linesize]);
-            if (s1 > cthresh && FILTER(2, 1, 1, 2))
-                cmkp[x] = 0xff;
-        }
-        srcp += src_linesize;
-        cmkp += cmk_linesize;
-
-        /* second line */
-        for (x = 0; x < width; x++) {
-            const int s1 = abs(srcp[x] - srcp[x - src_linesize]);
-            const int s2 = abs(srcp[x] - srcp[x + src_linesize]);
-            if (s1 > cthresh && s2 > cthresh && FILTER(2, -1, 1, 2))
-                cmkp[x] = 0xff;
-        }
-        srcp += src_linesize;
-        cmkp += cmk_linesize;
-
-        /* all lines minus first two and last two */
-        for (y = 2; y < height-2; y++) {
-            for (x = 0; x < width; x++) {
-                const int s1 = abs(srcp[x] - srcp[x - src_linesize]);
-                const int s2 = abs(srcp[x] - srcp[x + src_linesize]);
-                if (s1 > cthresh && s2 > cthresh && FILTER(-2, -1, 1, 2))
-                    cmkp[x] = 0xff;
-            }
-            srcp += src_linesize;
-            cmkp += cmk_linesize;
-        }
+        for (int y = slice_start; y < slice_end; y++) {
+            const uint8_t *srcp = src->data[plane] + y * src_linesize;
+            const int m2 = y > 1          ? -2 : 2;
+            const int m1 = y > 0          ? -1 : 1;
+            const int p1 = y < height - 1 ?  1 : -1;
+            const int p2 = y < height - 2 ?  2 : -2;
 
-        /* before-last line */
-        for (x = 0; x < width; x++) {
-            const int s1 = abs(srcp[x] - srcp[x - src_linesize]);
-            const int s2 = abs(srcp[x] - srcp[x + src_linesize]);
-            if (s1 > cthresh && s2 > cthresh && FILTER(-2, -1, 1, -2))
-                cmkp[x] = 0xff;
-        }
-        srcp += src_linesize;
-        cmkp += cmk_linesize;
-
-        /* last line */
-        for (x = 0; x < width; x++) {
-            const int s1 = abs(srcp[x] - srcp[x - src_linesize]);
-            if (s1 > cthresh && FILTER(-2, -1, -1, -2))
-                cmkp[x] = 0xff;
+            fm->dsp.comb_mask(cmkp, srcp + m2 * src_linesize, srcp + m1 * src_linesize,
+                              srcp, srcp + p1 * src_linesize, srcp + p2 * src_linesize,
+                              width, fm->cthresh);
+            cmkp += cmk_linesize;
         }
     }
+    return 0;
+}
+
+static int calc_combed_score(AVFilterContext *ctx, const AVFrame *src)
+{
+    const FieldMatchContext *fm = ctx->priv;
+    ThreadData td = { .f1 = src };
+    int x, y, max_v = 0;
+
+    ctx->internal->execute(ctx, comb_mask_slice, &td, NULL,
+                           FFMIN(src->height, fm->nb_threads));
 
     if (fm->chroma) {
         uint8_t *cmkp  = fm->cmask_data[0];
@@ -390,86 +426,161 @@ static int calc_combed_score(const FieldMatchContext *fm, const AVFrame *src)
     return max_v;
 }
 
+typedef struct CompareThreadData {
+    int plane;
+    int width, height;
+    const uint8_t *prvp, *nxtp;     ///< fields the diff map is built from
+    int prv_linesize, nxt_linesize;
+    uint8_t *dstp;                  ///< diff map line of the first matched line
+    const uint8_t *mapp;
+    const uint8_t *srcpf, *srcf, *srcnf;
+    const uint8_t *prvpf, *prvnf, *nxtpf, *nxtnf;
+    int map_linesize, srcf_linesize, prvf_linesize, nxtf_linesize;
+    int y0a, y1a, startx, stopx;
+} CompareThreadData;
+
 // the secret is that tbuffer is an interlaced, offset subset of all the lines
-static void build_abs_diff_mask(const uint8_t *prvp, int prv_linesize,
-                                const uint8_t *nxtp, int nxt_linesize,
-                                uint8_t *tbuffer,    int tbuf_linesize,
-                                int width, int height)
+static int build_abs_diff_mask(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    int y, x;
-
-    prvp -= prv_linesize;
-    nxtp -= nxt_linesize;
-    for (y = 0; y < height; y++) {
-        for (x = 0; x < width; x++)
-            tbuffer[x] = FFABS(prvp[x] - nxtp[x]);
-        prvp += prv_linesize;
-        nxtp += nxt_linesize;
-        tbuffer += tbuf_linesize;
-    }
+    FieldMatchContext *fm = ctx->priv;
+    const CompareThreadData *td = arg;
+    const int tpitch = td->plane ? fm->tpitchuv : fm->tpitchy;
+    const int height = td->height >> 1;
+    const int slice_start = (height *  jobnr   ) / nb_jobs;
+    const int slice_end   = (height * (jobnr+1)) / nb_jobs;
+
+    for (int y = slice_start; y < slice_end; y++)
+        fm->dsp.abs_diff(fm->tbuffer + y * tpitch,
+                         td->prvp + (y - 1) * td->prv_linesize,
+                         td->nxtp + (y - 1) * td->nxt_linesize, td->width);
+    return 0;
 }
 
 /**
- * Build a map over which pixels differ a lot/a little
+ * Build a line of the map over which pixels differ a lot/a little
  */
-static void build_diff_map(FieldMatchContext *fm,
-                           const uint8_t *prvp, int prv_linesize,
-                           const uint8_t *nxtp, int nxt_linesize,
-                           uint8_t *dstp, int dst_linesize, int height,
-                           int width, int plane)
+static void build_diff_map(const uint8_t *dp, int tpitch, uint8_t *dstp,
+                           int width, int height, int y)
 {
-    int x, y, u, diff, count;
-    int tpitch = plane ? fm->tpitchuv : fm->tpitchy;
-    const uint8_t *dp = fm->tbuffer + tpitch;
-
-    build_abs_diff_mask(prvp, prv_linesize, nxtp, nxt_linesize,
-                        fm->tbuffer, tpitch, width, height>>1);
-
-    for (y = 2; y < height - 2; y += 2) {
-        for (x = 1; x < width - 1; x++) {
-            diff = dp[x];
-            if (diff > 3) {
-                for (count = 0, u = x-1; u < x+2 && count < 2; u++) {
-                    count += dp[u-tpitch] > 3;
-                    count += dp[u       ] > 3;
-                    count += dp[u+tpitch] > 3;
-                }
-                if (count > 1) {
-                    dstp[x] = 1;
-                    if (diff > 19) {
-                        int upper = 0, lower = 0;
-                        for (count = 0, u = x-1; u < x+2 && count < 6; u++) {
-                            if (dp[u-tpitch] > 19) { count++; upper = 1; }
-                            if (dp[u       ] > 19)   count++;
-                            if (dp[u+tpitch] > 19) { count++; lower = 1; }
-                        }
-                        if (count > 3) {
-                            if (upper && lower) {
-                                dstp[x] |= 1<<1;
-                            } else {
-                                int upper2 = 0, lower2 = 0;
-                                for (u = FFMAX(x-4,0); u < FFMIN(x+5,width); u++) {
-                                    if (y != 2 &&        dp[u-2*tpitch] > 19) upper2 = 1;
-                                    if (                 dp[u-  tpitch] > 19) upper  = 1;
-                                    if (                 dp[u+  tpitch] > 19) lower  = 1;
-                                    if (y != height-4 && dp[u+2*tpitch] > 19) lower2 = 1;
-                                }
-                                if ((upper && (lower || upper2)) ||
-                                    (lower && (upper || lower2)))
-                                    dstp[x] |= 1<<1;
-                                else if (count > 5)
-                                    dstp[x] |= 1<<2;
+    int x, u, diff, count;
+
+    for (x = 1; x < width - 1; x++) {
+        diff = dp[x];
+        if (diff > 3) {
+            for (count = 0, u = x-1; u < x+2 && count < 2; u++) {
+                count += dp[u-tpitch] > 3;
+                count += dp[u       ] > 3;
+                count += dp[u+tpitch] > 3;
+            }
+            if (count > 1) {
+                dstp[x] = 1;
+                if (diff > 19) {
+                    int upper = 0, lower = 0;
+                    for (count = 0, u = x-1; u < x+2 && count < 6; u++) {
+                        if (dp[u-tpitch] > 19) { count++; upper = 1; }
+                        if (dp[u       ] > 19)   count++;
+                        if (dp[u+tpitch] > 19) { count++; lower = 1; }
+                    }
+                    if (count > 3) {
+                        if (upper && lower) {
+                            dstp[x] |= 1<<1;
+                        } else {
+                            int upper2 = 0, lower2 = 0;
+                            for (u = FFMAX(x-4,0); u < FFMIN(x+5,width); u++) {
+                                if (y != 2 &&        dp[u-2*tpitch] > 19) upper2 = 1;
+                                if (                 dp[u-  tpitch] > 19) upper  = 1;
+                                if (                 dp[u+  tpitch] > 19) lower  = 1;
+                                if (y != height-4 && dp[u+2*tpitch] > 19) lower2 = 1;
                             }
+                            if ((upper && (lower || upper2)) ||
+                                (lower && (upper || lower2)))
+                                dstp[x] |= 1<<1;
+                            else if (count > 5)
+                                dstp[x] |= 1<<2;
                         }
                     }
                 }
             }
         }
-        dp += tpitch;
-        dstp += dst_linesize;
     }
 }
 
+static int build_diff_map_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    FieldMatchContext *fm = ctx->priv;
+    const CompareThreadData *td = arg;
+    const int tpitch = td->plane ? fm->tpitchuv : fm->tpitchy;
+    const int nb_lines = FFMAX(td->height - 3, 0) / 2;
+    const int slice_start = (nb_lines *  jobnr   ) / nb_jobs;
+    const int slice_end   = (nb_lines * (jobnr+1)) / nb_jobs;
+
+    for (int i = slice_start; i < slice_end; i++)
+        build_diff_map(fm->tbuffer + (i + 1) * tpitch, tpitch,
+                       td->dstp + i * td->map_linesize, td->width, td->height, 2 + 2 * i);
+    return 0;
+}
+
+static int compare_fields_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    FieldMatchContext *fm = ctx->priv;
+    const CompareThreadData *td = arg;
+    const int nb_lines = FFMAX(td->height - 3, 0) / 2;
+    const int slice_start = (nb_lines *  jobnr   ) / nb_jobs;
+    const int slice_end   = (nb_lines * (jobnr+1)) / nb_jobs;
+    uint64_t accumPc = 0, accumPm = 0, accumPml = 0;
+    uint64_t accumNc = 0, accumNm = 0, accumNml = 0;
+    const int map_linesize = td->map_linesize;
+
+    for (int i = slice_start; i < slice_end; i++) {
+        const int y = 2 + 2 * i;
+        const uint8_t *mapp  = td->mapp  + i * map_linesize;
+        const uint8_t *srcpf = td->srcpf + i * td->srcf_linesize;
+        const uint8_t *srcf  = td->srcf  + i * td->srcf_linesize;
+        const uint8_t *srcnf = td->srcnf + i * td->srcf_linesize;
+        const uint8_t *prvpf = td->prvpf + i * td->prvf_linesize;
+        const uint8_t *prvnf = td->prvnf + i * td->prvf_linesize;
+        const uint8_t *nxtpf = td->nxtpf + i * td->nxtf_linesize;
+        const uint8_t *nxtnf = td->nxtnf + i * td->nxtf_linesize;
+
+        if (td->y0a == td->y1a || y < td->y0a || y > td->y1a) {
+            for (int x = td->startx; x < td->stopx; x++) {
+                if (mapp[x] > 0 || mapp[x + map_linesize] > 0) {
+                    const int temp1 = srcpf[x] + (srcf[x] << 2) + srcnf[x]; // [1 4 1]
+                    int temp2;
+
+                    temp2 = abs(3 * (prvpf[x] + prvnf[x]) - temp1);
+                    if (temp2 > 23 && ((mapp[x]&1) || (mapp[x + map_linesize]&1)))
+                        accumPc += temp2;
+                    if (temp2 > 42) {
+                        if ((mapp[x]&2) || (mapp[x + map_linesize]&2))
+                            accumPm += temp2;
+                        if ((mapp[x]&4) || (mapp[x + map_linesize]&4))
+                            accumPml += temp2;
+                    }
+
+                    temp2 = abs(3 * (nxtpf[x] + nxtnf[x]) - temp1);
+                    if (temp2 > 23 && ((mapp[x]&1) || (mapp[x + map_linesize]&1)))
+                        accumNc += temp2;
+                    if (temp2 > 42) {
+                        if ((mapp[x]&2) || (mapp[x + map_linesize]&2))
+                            accumNm += temp2;
+                        if ((mapp[x]&4) || (mapp[x + map_linesize]&4))
+                            accumNml += temp2;
+                    }
+                }
+            }
+        }
+    }
+
+    fm->sums[jobnr][0] = accumPc;
+    fm->sums[jobnr][1] = accumPm;
+    fm->sums[jobnr][2] = accumPml;
+    fm->sums[jobnr][3] = accumNc;
+    fm->sums[jobnr][4] = accumNm;
+    fm->sums[jobnr][5] = accumNml;
+    return 0;
+}
+
 enum { mP, mC, mN, mB, mU };
 
 static int get_field_base(int match, int field)
@@ -484,8 +595,9 @@ static AVFrame *select_frame(FieldMatchContext *fm, int match)
     else  /* match == mC */              return fm->src;
 }
 
-static int compare_fields(FieldMatchContext *fm, int match1, int match2, int field)
+static int compare_fields(AVFilterContext *ctx, int match1, int match2, int field)
 {
+    FieldMatchContext *fm = ctx->priv;
     int plane, ret;
     uint64_t accumPc = 0, accumPm = 0, accumPml = 0;
     uint64_t accumNc = 0, accumNm = 0, accumNml = 0;
@@ -494,7 +606,8 @@ static int compare_fields(FieldMatchContext *fm, int match1, int match2, int fie
     const AVFrame *src = fm->src;
 
     for (plane = 0; plane < (fm->mchroma ? 3 : 1); plane++) {
-        int x, y, temp1, temp2, fbase;
+        CompareThreadData td;
+        int fbase, nb_jobs;
         const AVFrame *prev, *next;
         uint8_t *mapp    = fm->map_data[plane];
         int map_linesize = fm->map_linesize[plane];
@@ -505,10 +618,6 @@ static int compare_fields(FieldMatchContext *fm, int match1, int match2, int fie
         int prvf_linesize, nxtf_linesize;
         const int width  = get_width (fm, src, plane);
         const int height = get_height(fm, src, plane);
-        const int y0a = fm->y0 >> (plane ? fm->vsub : 0);
-        const int y1a = fm->y1 >> (plane ? fm->vsub : 0);
-        const int startx = (plane == 0 ? 8 : 8 >> fm->hsub);
-        const int stopx  = width - startx;
         const uint8_t *srcpf, *srcf, *srcnf;
         const uint8_t *prvpf, *prvnf, *nxtpf, *nxtnf;
 
@@ -535,49 +644,51 @@ static int compare_fields(FieldMatchContext *fm, int match1, int match2, int fie
         nxtnf = nxtpf + nxtf_linesize;                      // next frame, next     field
 
         map_linesize <<= 1;
-        if ((match1 >= 3 && field == 1) || (match1 < 3 && field != 1))
-            build_diff_map(fm, prvpf, prvf_linesize, nxtpf, nxtf_linesize,
-                           mapp, map_linesize, height, width, plane);
-        else
-            build_diff_map(fm, prvnf, prvf_linesize, nxtnf, nxtf_linesize,
-                           mapp + map_linesize, map_linesize, height, width, plane);
-
-        for (y = 2; y < height - 2; y += 2) {
-            if (y0a == y1a || y < y0a || y > y1a) {
-                for (x = startx; x < stopx; x++) {
-                    if (mapp[x] > 0 || mapp[x + map_linesize] > 0) {
-                        temp1 = srcpf[x] + (srcf[x] << 2) + srcnf[x]; // [1 4 1]
-
-                        temp2 = abs(3 * (prvpf[x] + prvnf[x]) - temp1);
-                        if (temp2 > 23 && ((mapp[x]&1) || (mapp[x + map_linesize]&1)))
-                            accumPc += temp2;
-                        if (temp2 > 42) {
-                            if ((mapp[x]&2) || (mapp[x + map_linesize]&2))
-                                accumPm += temp2;
-                            if ((mapp[x]&4) || (mapp[x + map_linesize]&4))
-                                accumPml += temp2;
-                        }
 
-                        temp2 = abs(3 * (nxtpf[x] + nxtnf[x]) - temp1);
-                        if (temp2 > 23 && ((mapp[x]&1) || (mapp[x + map_linesize]&1)))
-                            accumNc += temp2;
-                        if (temp2 > 42) {
-                            if ((mapp[x]&2) || (mapp[x + map_linesize]&2))
-                                accumNm += temp2;
-                            if ((mapp[x]&4) || (mapp[x + map_linesize]&4))
-                                accumNml += temp2;
-                        }
-                    }
-                }
-            }
-            prvpf += prvf_linesize;
-            prvnf += prvf_linesize;
-            srcpf += srcf_linesize;
-            srcf  += srcf_linesize;
-            srcnf += srcf_linesize;
-            nxtpf += nxtf_linesize;
-            nxtnf += nxtf_linesize;
-            mapp  += map_linesize;
+        td = (CompareThreadData) {
+            .plane  = plane,
+            .width  = width,
+            .height = height,
+            .prv_linesize = prvf_linesize,
+            .nxt_linesize = nxtf_linesize,
+            .mapp  = mapp,
+            .srcpf = srcpf, .srcf  = srcf,  .srcnf = srcnf,
+            .prvpf = prvpf, .prvnf = prvnf,
+            .nxtpf = nxtpf, .nxtnf = nxtnf,
+            .map_linesize  = map_linesize,
+            .srcf_linesize = srcf_linesize,
+            .prvf_linesize = prvf_linesize,
+            .nxtf_linesize = nxtf_linesize,
+            .y0a    = fm->y0 >> (plane ? fm->vsub : 0),
+            .y1a    = fm->y1 >> (plane ? fm->vsub : 0),
+            .startx = plane == 0 ? 8 : 8 >> fm->hsub,
+            .stopx  = width - (plane == 0 ? 8 : 8 >> fm->hsub),
+        };
+        if ((match1 >= 3 && field == 1) || (match1 < 3 && field != 1)) {
+            td.prvp = prvpf;
+            td.nxtp = nxtpf;
+            td.dstp = mapp;
+        } else {
+            td.prvp = prvnf;
+            td.nxtp = nxtnf;
+            td.dstp = mapp + map_linesize;
+        }
+
+        ctx->internal->execute(ctx, build_abs_diff_mask, &td, NULL,
+                               av_clip(height >> 1, 1, fm->nb_threads));
+
+        /* the accumulation reads the lines of the map above and below its
+           own, so the whole map must be built first */
+        nb_jobs = av_clip(FFMAX(height - 3, 0) / 2, 1, fm->nb_threads);
+        ctx->internal->execute(ctx, build_diff_map_slice, &td, NULL, nb_jobs);
+        ctx->internal->execute(ctx, compare_fields_slice, &td, NULL, nb_jobs);
+        for (int i = 0; i < nb_jobs; i++) {
+            accumPc  += fm->sums[i][0];
+            accumPm  += fm->sums[i][1];
+            accumPml += fm->sums[i][2];
+            accumNc  += fm->sums[i][3];
+            accumNm  += fm->sums[i][4];
+            accumNml += fm->sums[i][5];
         }
     }
 
@@ -656,7 +767,7 @@ static int checkmm(AVFilterContext *ctx, int *combs, int m1, int m2,
         if (!gen_frames[mid])                                                   \
             gen_frames[mid] = create_weave_frame(ctx, mid, field,               \
                                                  fm->prv, fm->src, fm->nxt);    \
-        combs[mid] = calc_combed_score(fm, gen_frames[mid]);                    \
+        combs[mid] = calc_combed_score(ctx, gen_frames[mid]);                   \
     }                                                                           \
 } while (0)
 
@@ -729,7 +840,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
                 ret = AVERROR(ENOMEM);
                 goto fail;
             }
-            combs[i] = calc_combed_score(fm, gen_frames[i]);
+            combs[i] = calc_combed_score(ctx, gen_frames[i]);
         }
         av_log(ctx, AV_LOG_INFO, "COMBS: %3d %3d %3d %3d %3d\n",
                combs[0], combs[1], combs[2], combs[3], combs[4]);
@@ -742,22 +853,22 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     }
 
     /* p/c selection and optional 3-way p/c/n matches */
-    match = compare_fields(fm, fxo[mC], fxo[mP], field);
+    match = compare_fields(ctx, fxo[mC], fxo[mP], field);
     if (fm->mode == MODE_PCN || fm->mode == MODE_PCN_UB)
-        match = compare_fields(fm, match, fxo[mN], field);
+        match = compare_fields(ctx, match, fxo[mN], field);
 
     /* scene change check */
     if (fm->combmatch == COMBMATCH_SC) {
         if (fm->lastn == outlink->frame_count_in - 1) {
             if (fm->lastscdiff > fm->scthresh)
                 sc = 1;
-        } else if (luma_abs_diff(fm->prv, fm->src) > fm->scthresh) {
+        } else if (luma_abs_diff(ctx, fm->prv, fm->src) > fm->scthresh) {
             sc = 1;
         }
 
         if (!sc) {
             fm->lastn = outlink->frame_count_in;
-            fm->lastscdiff = luma_abs_diff(fm->src, fm->nxt);
+            fm->lastscdiff = luma_abs_diff(ctx, fm->src, fm->nxt);
             sc = fm->lastscdiff > fm->scthresh;
         }
     }
@@ -954,9 +1065,13 @@ static int config_input(AVFilterLink *inlink)
     fm->c_array = av_malloc_array((((w + fm->blockx/2)/fm->blockx)+1) *
                             (((h + fm->blocky/2)/fm->blocky)+1),
                             4 * sizeof(*fm->c_array));
-    if (!fm->tbuffer || !fm->c_array)
+    fm->nb_threads = ff_filter_get_nb_threads(ctx);
+    fm->sums = av_calloc(fm->nb_threads, sizeof(*fm->sums));
+    if (!fm->tbuffer || !fm->c_array || !fm->sums)
         return AVERROR(ENOMEM);
 
+    ff_fieldmatch_init(&fm->dsp);
+
     return 0;
 }
 
@@ -1012,6 +1127,7 @@ static av_cold void fieldmatch_uninit(AVFilterContext *ctx)
     av_freep(&fm->cmask_data[0]);
     av_freep(&fm->tbuffer);
     av_freep(&fm->c_array);
+    av_freep(&fm->sums);
 }
 
 static int config_output(AVFilterLink *outlink)
@@ -1051,5 +1167,5 @@ AVFilter ff_vf_fieldmatch = {
     .inputs         = NULL,
     .outputs        = fieldmatch_outputs,
     .priv_class     = &fieldmatch_class,
-    .flags          = AVFILTER_FLAG_DYNAMIC_INPUTS,
+    .flags          = AVFILTER_FLAG_DYNAMIC_INPUTS | AVFILTER_FLAG_SLICE_THREADS,
 };
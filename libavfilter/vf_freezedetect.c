@@ -21,6 +21,8 @@
  * video freeze detection filter
  */
 
+#include <stdatomic.h>
+
 #include "libavutil/avassert.h"
 #include "libavutil/imgutils.h"
 #include "libavutil/opt.h"
@@ -31,13 +33,20 @@
 #include "filters.h"
 #include "scene_sad.h"
 
+/* Number of rows compared between two checks of the noise threshold */
+#define CHECK_ROWS 32
+
 typedef struct FreezeDetectContext {
     const AVClass *class;
 
     ptrdiff_t width[4];
     ptrdiff_t height[4];
+    uint64_t count;
     ff_scene_sad_fn sad;
     int bitdepth;
+    uint64_t *job_sad;
+    int nb_jobs;
+    atomic_int moving;
     AVFrame *reference_frame;
     int64_t n;
     int64_t reference_n;
@@ -104,13 +113,21 @@ static int config_input(AVFilterLink *inlink)
     const AVPixFmtDescriptor *pix_desc = av_pix_fmt_desc_get(inlink->format);
 
     s->bitdepth = pix_desc->comp[0].depth;
+    s->count = 0;
 
     for (int plane = 0; plane < 4; plane++) {
         ptrdiff_t line_size = av_image_get_linesize(inlink->format, inlink->w, plane);
         s->width[plane] = line_size >> (s->bitdepth > 8);
         s->height[plane] = inlink->h >> ((plane == 1 || plane == 2) ? pix_desc->log2_chroma_h : 0);
+        s->count += s->width[plane] * s->height[plane];
     }
 
+    s->nb_jobs = FFMAX(1, FFMIN(inlink->h / CHECK_ROWS, ff_filter_get_nb_threads(ctx)));
+    av_freep(&s->job_sad);
+    s->job_sad = av_calloc(s->nb_jobs, sizeof(*s->job_sad));
+    if (!s->job_sad)
+        return AVERROR(ENOMEM);
+
     s->sad = ff_scene_sad_get_fn(s->bitdepth == 8 ? 8 : 16);
     if (!s->sad)
         return AVERROR(EINVAL);
@@ -122,26 +139,74 @@ static av_cold void uninit(AVFilterContext *ctx)
 {
     FreezeDetectContext *s = ctx->priv;
     av_frame_free(&s->reference_frame);
+    av_freep(&s->job_sad);
 }
 
-static int is_frozen(FreezeDetectContext *s, AVFrame *reference, AVFrame *frame)
+static int above_noise(FreezeDetectContext *s, uint64_t sad)
 {
+    const double mafd = (double)sad / s->count / (1ULL << s->bitdepth);
+    return mafd > s->noise;
+}
+
+typedef struct ThreadData {
+    AVFrame *reference, *frame;
+} ThreadData;
+
+/**
+ * Sum the absolute differences in a slice of the planes, stopping as soon as
+ * the differences of any slice alone are above the noise tolerance.
+ */
+static int sad_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    FreezeDetectContext *s = ctx->priv;
+    const ThreadData *td = arg;
     uint64_t sad = 0;
-    uint64_t count = 0;
-    double mafd;
+
     for (int plane = 0; plane < 4; plane++) {
-        if (s->width[plane]) {
-            uint64_t plane_sad;
-            s->sad(frame->data[plane], frame->linesize[plane],
-                   reference->data[plane], reference->linesize[plane],
-                   s->width[plane], s->height[plane], &plane_sad);
-            sad += plane_sad;
-            count += s->width[plane] * s->height[plane];
+        const ptrdiff_t ref_linesize   = td->reference->linesize[plane];
+        const ptrdiff_t frame_linesize = td->frame->linesize[plane];
+        const int slice_start = (s->height[plane] *  jobnr   ) / nb_jobs;
+        const int slice_end   = (s->height[plane] * (jobnr+1)) / nb_jobs;
+
+        if (!s->width[plane])
+            continue;
+
+        for (int y = slice_start; y < slice_end; y += CHECK_ROWS) {
+            uint64_t rows_sad;
+
+            if (atomic_load_explicit(&s->moving, memory_order_relaxed))
+                goto end;
+            s->sad(td->frame->data[plane] + y * frame_linesize, frame_linesize,
+                   td->reference->data[plane] + y * ref_linesize, ref_linesize,
+                   s->width[plane], FFMIN(CHECK_ROWS, slice_end - y), &rows_sad);
+            sad += rows_sad;
+            if (above_noise(s, sad)) {
+                atomic_store_explicit(&s->moving, 1, memory_order_relaxed);
+                goto end;
+            }
         }
     }
+
+end:
     emms_c();
-    mafd = (double)sad / count / (1ULL << s->bitdepth);
-    return (mafd <= s->noise);
+    s->job_sad[jobnr] = sad;
+    return 0;
+}
+
+static int is_frozen(AVFilterContext *ctx, AVFrame *reference, AVFrame *frame)
+{
+    FreezeDetectContext *s = ctx->priv;
+    ThreadData td = { reference, frame };
+    uint64_t sad = 0;
+
+    atomic_init(&s->moving, 0);
+    ctx->internal->execute(ctx, sad_slice, &td, NULL, s->nb_jobs);
+    if (atomic_load(&s->moving))
+        return 0;
+
+    for (int i = 0; i < s->nb_jobs; i++)
+        sad += s->job_sad[i];
+    return !above_noise(s, sad);
 }
 
 static int set_meta(FreezeDetectContext *s, AVFrame *frame, const char *key, const char *value)
@@ -175,7 +240,7 @@ static int activate(AVFilterContext *ctx)
             else
                 duration = av_rescale_q(frame->pts - s->reference_frame->pts, inlink->time_base, AV_TIME_BASE_Q);
 
-            frozen = is_frozen(s, s->reference_frame, frame);
+            frozen = is_frozen(ctx, s->reference_frame, frame);
             if (duration >= s->duration) {
                 if (!s->frozen)
                     set_meta(s, frame, "lavfi.freezedetect.freeze_start", av_ts2timestr(s->reference_frame->pts, &inlink->time_base));
@@ -232,4 +297,5 @@ AVFilter ff_vf_freezedetect = {
     .inputs        = freezedetect_inputs,
     .outputs       = freezedetect_outputs,
     .activate      = activate,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -61,6 +61,9 @@ typedef struct GEQContext {
 
     double *pixel_sums[NB_PLANES];
     int needs_sum[NB_PLANES];
+
+    double *x_values;           ///< abscissas of a line, 0 to width - 1
+    double *line_values;        ///< evaluated line for each thread
 } GEQContext;
 
 enum { Y = 0, U, V, A, G, B, R };
@@ -348,8 +351,10 @@ static int geq_query_formats(AVFilterContext *ctx)
 
 static int geq_config_props(AVFilterLink *inlink)
 {
-    GEQContext *geq = inlink->dst->priv;
+    AVFilterContext *ctx = inlink->dst;
+    GEQContext *geq = ctx->priv;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
+    const int nb_threads = FFMIN(MAX_NB_THREADS, ff_filter_get_nb_threads(ctx));
 
     av_assert0(desc);
 
@@ -357,6 +362,15 @@ static int geq_config_props(AVFilterLink *inlink)
     geq->vsub = desc->log2_chroma_h;
     geq->bps = desc->comp[0].depth;
     geq->planes = desc->nb_components;
+
+    av_freep(&geq->x_values);
+    av_freep(&geq->line_values);
+    geq->x_values    = av_malloc_array(inlink->w, sizeof(*geq->x_values));
+    geq->line_values = av_malloc_array(inlink->w, nb_threads * sizeof(*geq->line_values));
+    if (!geq->x_values || !geq->line_values)
+        return AVERROR(ENOMEM);
+    for (int x = 0; x < inlink->w; x++)
+        geq->x_values[x] = x;
     return 0;
 }
 
@@ -377,8 +391,10 @@ static int slice_geq_filter(AVFilterContext *ctx, void *arg, int jobnr, int nb_j
     const int linesize = td->linesize;
     const int slice_start = (height *  jobnr) / nb_jobs;
     const int slice_end = (height * (jobnr+1)) / nb_jobs;
-    int x, y;
+    int x, y, ret;
 
+    double *line = geq->line_values + jobnr * ctx->inputs[0]->w;
+    const double *arrays[VAR_VARS_NB] = { [VAR_X] = geq->x_values };
     double values[VAR_VARS_NB];
     values[VAR_W] = geq->values[VAR_W];
     values[VAR_H] = geq->values[VAR_H];
@@ -392,20 +408,22 @@ static int slice_geq_filter(AVFilterContext *ctx, void *arg, int jobnr, int nb_j
         for (y = slice_start; y < slice_end; y++) {
             values[VAR_Y] = y;
 
-            for (x = 0; x < width; x++) {
-                values[VAR_X] = x;
-                ptr[x] = av_expr_eval(geq->e[plane][jobnr], values, geq);
-            }
+            ret = av_expr_eval_array(geq->e[plane][jobnr], line, width, values, arrays, geq);
+            if (ret < 0)
+                return ret;
+            for (x = 0; x < width; x++)
+                ptr[x] = line[x];
             ptr += linesize;
         }
     } else {
         uint16_t *ptr16 = geq->dst16 + (linesize/2) * slice_start;
         for (y = slice_start; y < slice_end; y++) {
             values[VAR_Y] = y;
-            for (x = 0; x < width; x++) {
-                values[VAR_X] = x;
-                ptr16[x] = av_expr_eval(geq->e[plane][jobnr], values, geq);
-            }
+            ret = av_expr_eval_array(geq->e[plane][jobnr], line, width, values, arrays, geq);
+            if (ret < 0)
+                return ret;
+            for (x = 0; x < width; x++)
+                ptr16[x] = line[x];
             ptr16 += linesize/2;
         }
     }
@@ -415,9 +433,10 @@ static int slice_geq_filter(AVFilterContext *ctx, void *arg, int jobnr, int nb_j
 
 static int geq_filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
-    int plane;
+    int plane, i;
     AVFilterContext *ctx = inlink->dst;
     const int nb_threads = FFMIN(MAX_NB_THREADS, ff_filter_get_nb_threads(ctx));
+    int ret[MAX_NB_THREADS];
     GEQContext *geq = ctx->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
     AVFrame *out;
@@ -455,7 +474,14 @@ static int geq_filter_frame(AVFilterLink *inlink, AVFrame *in)
         if (geq->needs_sum[plane])
             calculate_sums(geq, plane, width, height);
 
-        ctx->internal->execute(ctx, slice_geq_filter, &td, NULL, FFMIN(height, nb_threads));
+        ctx->internal->execute(ctx, slice_geq_filter, &td, ret, FFMIN(height, nb_threads));
+        for (i = 0; i < FFMIN(height, nb_threads); i++) {
+            if (ret[i] < 0) {
+                av_frame_free(&geq->picref);
+                av_frame_free(&out);
+                return ret[i];
+            }
+        }
     }
 
     av_frame_free(&geq->picref);
@@ -472,6 +498,8 @@ static av_cold void geq_uninit(AVFilterContext *ctx)
             av_expr_free(geq->e[i][j]);
     for (i = 0; i < NB_PLANES; i++)
         av_freep(&geq->pixel_sums);
+    av_freep(&geq->x_values);
+    av_freep(&geq->line_values);
 }
 
 static const AVFilterPad geq_inputs[] = {
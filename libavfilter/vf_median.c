@@ -30,6 +30,56 @@
 #include "median.h"
 #include "video.h"
 
+#define PIX_SORT(a, b) do {                 \
+    const int min_ = FFMIN(p[a], p[b]);     \
+    p[b] = FFMAX(p[a], p[b]);               \
+    p[a] = min_;                            \
+} while (0)
+
+/* Median selection networks, from "Fast median search: an ANSI C
+ * implementation" by N. Devillard, after J. L. Smith */
+static av_always_inline int median9(int *p)
+{
+    PIX_SORT(1, 2); PIX_SORT(4, 5); PIX_SORT(7, 8);
+    PIX_SORT(0, 1); PIX_SORT(3, 4); PIX_SORT(6, 7);
+    PIX_SORT(1, 2); PIX_SORT(4, 5); PIX_SORT(7, 8);
+    PIX_SORT(0, 3); PIX_SORT(5, 8); PIX_SORT(4, 7);
+    PIX_SORT(3, 6); PIX_SORT(1, 4); PIX_SORT(2, 5);
+    PIX_SORT(4, 7); PIX_SORT(4, 2); PIX_SORT(6, 4);
+    PIX_SORT(4, 2);
+    return p[4];
+}
+
+static av_always_inline int median25(int *p)
+{
+    PIX_SORT( 0,  1); PIX_SORT( 3,  4); PIX_SORT( 2,  4); PIX_SORT( 2,  3);
+    PIX_SORT( 6,  7); PIX_SORT( 5,  7); PIX_SORT( 5,  6); PIX_SORT( 9, 10);
+    PIX_SORT( 8, 10); PIX_SORT( 8,  9); PIX_SORT(12, 13); PIX_SORT(11, 13);
+    PIX_SORT(11, 12); PIX_SORT(15, 16); PIX_SORT(14, 16); PIX_SORT(14, 15);
+    PIX_SORT(18, 19); PIX_SORT(17, 19); PIX_SORT(17, 18); PIX_SORT(21, 22);
+    PIX_SORT(20, 22); PIX_SORT(20, 21); PIX_SORT(23, 24); PIX_SORT( 2,  5);
+    PIX_SORT( 3,  6); PIX_SORT( 0,  6); PIX_SORT( 0,  3); PIX_SORT( 4,  7);
+    PIX_SORT( 1,  7); PIX_SORT( 1,  4); PIX_SORT(11, 14); PIX_SORT( 8, 14);
+    PIX_SORT( 8, 11); PIX_SORT(12, 15); PIX_SORT( 9, 15); PIX_SORT( 9, 12);
+    PIX_SORT(13, 16); PIX_SORT(10, 16); PIX_SORT(10, 13); PIX_SORT(20, 23);
+    PIX_SORT(17, 23); PIX_SORT(17, 20); PIX_SORT(21, 24); PIX_SORT(18, 24);
+    PIX_SORT(18, 21); PIX_SORT(19, 22); PIX_SORT( 8, 17); PIX_SORT( 9, 18);
+    PIX_SORT( 0, 18); PIX_SORT( 0,  9); PIX_SORT(10, 19); PIX_SORT( 1, 19);
+    PIX_SORT( 1, 10); PIX_SORT(11, 20); PIX_SORT( 2, 20); PIX_SORT( 2, 11);
+    PIX_SORT(12, 21); PIX_SORT( 3, 21); PIX_SORT( 3, 12); PIX_SORT(13, 22);
+    PIX_SORT( 4, 22); PIX_SORT( 4, 13); PIX_SORT(14, 23); PIX_SORT( 5, 23);
+    PIX_SORT( 5, 14); PIX_SORT(15, 24); PIX_SORT( 6, 24); PIX_SORT( 6, 15);
+    PIX_SORT( 7, 16); PIX_SORT( 7, 19); PIX_SORT(13, 21); PIX_SORT(15, 23);
+    PIX_SORT( 7, 13); PIX_SORT( 7, 15); PIX_SORT( 1,  9); PIX_SORT( 3, 11);
+    PIX_SORT( 5, 17); PIX_SORT(11, 17); PIX_SORT( 9, 17); PIX_SORT( 4, 10);
+    PIX_SORT( 6, 12); PIX_SORT( 7, 14); PIX_SORT( 4,  6); PIX_SORT( 4,  7);
+    PIX_SORT(12, 14); PIX_SORT(10, 14); PIX_SORT( 6,  7); PIX_SORT(10, 12);
+    PIX_SORT( 6, 10); PIX_SORT( 6, 17); PIX_SORT(12, 17); PIX_SORT( 7, 17);
+    PIX_SORT( 7, 10); PIX_SORT(12, 18); PIX_SORT( 7, 12); PIX_SORT(10, 18);
+    PIX_SORT(12, 20); PIX_SORT(10, 20); PIX_SORT(10, 12);
+    return p[12];
+}
+
 #define DEPTH 8
 #include "median_template.c"
 
@@ -131,6 +181,24 @@ static void check_params(MedianContext *s, AVFilterLink *inlink)
     s->t = (2 * s->radius * s->radiusV + s->radiusV + s->radius) * 2.f * s->percentile;
 }
 
+static void set_filter_plane(MedianContext *s)
+{
+    /* The sorting networks only pick the median of square windows. The
+     * histograms of 8 bits samples only have 16 bins, and are faster than
+     * the larger network. */
+    const int network = s->radius == s->radiusV && s->t == 2 * s->radius * (s->radius + 1) &&
+                        (s->radius == 1 || (s->radius == 2 && s->depth > 8));
+
+    switch (s->depth) {
+    case  8: s->filter_plane = network ? filter_plane_network_8  : filter_plane_8;  break;
+    case  9: s->filter_plane = network ? filter_plane_network_9  : filter_plane_9;  break;
+    case 10: s->filter_plane = network ? filter_plane_network_10 : filter_plane_10; break;
+    case 12: s->filter_plane = network ? filter_plane_network_12 : filter_plane_12; break;
+    case 14: s->filter_plane = network ? filter_plane_network_14 : filter_plane_14; break;
+    case 16: s->filter_plane = network ? filter_plane_network_16 : filter_plane_16; break;
+    }
+}
+
 static int config_input(AVFilterLink *inlink)
 {
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
@@ -166,14 +234,10 @@ static int config_input(AVFilterLink *inlink)
     s->hsub = hsub;
     s->hmuladd = hmuladd;
 
-    switch (s->depth) {
-    case  8: s->filter_plane = filter_plane_8;  break;
-    case  9: s->filter_plane = filter_plane_9;  break;
-    case 10: s->filter_plane = filter_plane_10; break;
-    case 12: s->filter_plane = filter_plane_12; break;
-    case 14: s->filter_plane = filter_plane_14; break;
-    case 16: s->filter_plane = filter_plane_16; break;
-    }
+    if (ARCH_X86)
+        ff_median_init_x86(s);
+
+    set_filter_plane(s);
 
     return 0;
 }
@@ -263,6 +327,7 @@ static int process_command(AVFilterContext *ctx, const char *cmd, const char *ar
     if (!s->radiusV)
         s->radiusV = s->radius;
     check_params(s, ctx->inputs[0]);
+    set_filter_plane(s);
 
     return 0;
 }
@@ -24,6 +24,8 @@
  * Rich Felker.
  */
 
+#include <stdatomic.h>
+
 #include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/pixelutils.h"
@@ -31,8 +33,14 @@
 #include "avfilter.h"
 #include "internal.h"
 #include "formats.h"
+#include "scene_sad.h"
 #include "video.h"
 
+typedef struct DiffJob {
+    int count;                     ///< number of blocks above the lower threshold
+    int hi;                        ///< difference of the block above the higher threshold, -1 if none
+} DiffJob;
+
 typedef struct DecimateContext {
     const AVClass *class;
     int lo, hi;                    ///< lower and higher threshold number of differences
@@ -47,8 +55,14 @@ typedef struct DecimateContext {
                                    ///< if negative: number of sequential frames which were not dropped
 
     int hsub, vsub;                ///< chroma subsampling values
+    int depth;                     ///< bit depth of the samples
     AVFrame *ref;                  ///< reference picture
     av_pixelutils_sad_fn sad;      ///< sum of absolute difference function
+    ff_scene_sad_fn sad16;         ///< sum of absolute difference function for depth > 8
+
+    DiffJob *jobs;
+    int nb_jobs;
+    atomic_int different;          ///< set when the plane is known to differ
 } DecimateContext;
 
 #define OFFSET(x) offsetof(DecimateContext, x)
@@ -65,6 +79,69 @@ static const AVOption mpdecimate_options[] = {
 
 AVFILTER_DEFINE_CLASS(mpdecimate);
 
+static av_always_inline int block_sad(DecimateContext *decimate,
+                                      const uint8_t *cur, ptrdiff_t cur_linesize,
+                                      const uint8_t *ref, ptrdiff_t ref_linesize)
+{
+    uint64_t sad;
+
+    if (decimate->depth == 8)
+        return decimate->sad(cur, cur_linesize, ref, ref_linesize);
+
+    /* keep the thresholds relative to 8 bits samples */
+    decimate->sad16(cur, cur_linesize, ref, ref_linesize, 8, 8, &sad);
+    return sad >> (decimate->depth - 8);
+}
+
+typedef struct ThreadData {
+    uint8_t *cur, *ref;
+    int cur_linesize, ref_linesize;
+    int w, h, t;
+} ThreadData;
+
+/**
+ * Compare the blocks of a slice of rows, stopping as soon as the planes are
+ * known to be different.
+ */
+static int diff_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    DecimateContext *decimate = ctx->priv;
+    const ThreadData *td = arg;
+    DiffJob *job = &decimate->jobs[jobnr];
+    const int bpp = 1 + (decimate->depth > 8);
+    const int nb_rows = (td->h - 8) / 4 + 1;
+    const int row_start = (nb_rows *  jobnr   ) / nb_jobs;
+    const int row_end   = (nb_rows * (jobnr+1)) / nb_jobs;
+    int x, y, d;
+
+    job->count = 0;
+    job->hi    = -1;
+
+    /* compute difference for blocks of 8x8 bytes */
+    for (y = row_start * 4; y < row_end * 4; y += 4) {
+        if (atomic_load_explicit(&decimate->different, memory_order_relaxed))
+            break;
+        for (x = 8; x < td->w-7; x += 4) {
+            d = block_sad(decimate,
+                          td->cur + y*td->cur_linesize + x*bpp, td->cur_linesize,
+                          td->ref + y*td->ref_linesize + x*bpp, td->ref_linesize);
+            if (d > decimate->hi) {
+                job->hi = d;
+                atomic_store_explicit(&decimate->different, 1, memory_order_relaxed);
+                goto end;
+            }
+            if (d > decimate->lo && ++job->count > td->t) {
+                atomic_store_explicit(&decimate->different, 1, memory_order_relaxed);
+                goto end;
+            }
+        }
+    }
+
+end:
+    emms_c();
+    return 0;
+}
+
 /**
  * Return 1 if the two planes are different, 0 otherwise.
  */
@@ -74,31 +151,31 @@ static int diff_planes(AVFilterContext *ctx,
                        int w, int h)
 {
     DecimateContext *decimate = ctx->priv;
+    ThreadData td = { cur, ref, cur_linesize, ref_linesize, w, h };
+    int i, c = 0, nb_jobs;
 
-    int x, y;
-    int d, c = 0;
-    int t = (w/16)*(h/16)*decimate->frac;
+    td.t = (w/16)*(h/16)*decimate->frac;
+    if (h < 8)
+        goto end;
 
-    /* compute difference for blocks of 8x8 bytes */
-    for (y = 0; y < h-7; y += 4) {
-        for (x = 8; x < w-7; x += 4) {
-            d = decimate->sad(cur + y*cur_linesize + x, cur_linesize,
-                              ref + y*ref_linesize + x, ref_linesize);
-            if (d > decimate->hi) {
-                av_log(ctx, AV_LOG_DEBUG, "%d>=hi ", d);
-                return 1;
-            }
-            if (d > decimate->lo) {
-                c++;
-                if (c > t) {
-                    av_log(ctx, AV_LOG_DEBUG, "lo:%d>=%d ", c, t);
-                    return 1;
-                }
-            }
+    nb_jobs = FFMIN(decimate->nb_jobs, (h - 8) / 4 + 1);
+    atomic_init(&decimate->different, 0);
+    ctx->internal->execute(ctx, diff_slice, &td, NULL, nb_jobs);
+
+    for (i = 0; i < nb_jobs; i++) {
+        if (decimate->jobs[i].hi >= 0) {
+            av_log(ctx, AV_LOG_DEBUG, "%d>=hi ", decimate->jobs[i].hi);
+            return 1;
         }
+        c += decimate->jobs[i].count;
+    }
+    if (c > td.t) {
+        av_log(ctx, AV_LOG_DEBUG, "lo:%d>=%d ", c, td.t);
+        return 1;
     }
 
-    av_log(ctx, AV_LOG_DEBUG, "lo:%d<%d ", c, t);
+end:
+    av_log(ctx, AV_LOG_DEBUG, "lo:%d<%d ", c, td.t);
     return 0;
 }
 
@@ -131,13 +208,10 @@ static int decimate_frame(AVFilterContext *ctx,
                         cur->data[plane], cur->linesize[plane],
                         ref->data[plane], ref->linesize[plane],
                         AV_CEIL_RSHIFT(ref->width,  hsub),
-                        AV_CEIL_RSHIFT(ref->height, vsub))) {
-            emms_c();
+                        AV_CEIL_RSHIFT(ref->height, vsub)))
             return 0;
-        }
     }
 
-    emms_c();
     return 1;
 }
 
@@ -159,6 +233,7 @@ static av_cold void uninit(AVFilterContext *ctx)
 {
     DecimateContext *decimate = ctx->priv;
     av_frame_free(&decimate->ref);
+    av_freep(&decimate->jobs);
 }
 
 static int query_formats(AVFilterContext *ctx)
@@ -176,6 +251,13 @@ static int query_formats(AVFilterContext *ctx)
         AV_PIX_FMT_YUVA444P,
         AV_PIX_FMT_YUVA422P,
 
+        AV_PIX_FMT_YUV420P10,    AV_PIX_FMT_YUV422P10,    AV_PIX_FMT_YUV444P10,
+        AV_PIX_FMT_YUV420P12,    AV_PIX_FMT_YUV422P12,    AV_PIX_FMT_YUV444P12,
+        AV_PIX_FMT_YUV420P16,    AV_PIX_FMT_YUV422P16,    AV_PIX_FMT_YUV444P16,
+        AV_PIX_FMT_YUVA420P10,   AV_PIX_FMT_YUVA422P10,   AV_PIX_FMT_YUVA444P10,
+        AV_PIX_FMT_YUVA420P16,   AV_PIX_FMT_YUVA422P16,   AV_PIX_FMT_YUVA444P16,
+        AV_PIX_FMT_GBRP10,       AV_PIX_FMT_GBRP12,       AV_PIX_FMT_GBRP16,
+
         AV_PIX_FMT_NONE
     };
     AVFilterFormats *fmts_list = ff_make_format_list(pix_fmts);
@@ -191,6 +273,19 @@ static int config_input(AVFilterLink *inlink)
     const AVPixFmtDescriptor *pix_desc = av_pix_fmt_desc_get(inlink->format);
     decimate->hsub = pix_desc->log2_chroma_w;
     decimate->vsub = pix_desc->log2_chroma_h;
+    decimate->depth = pix_desc->comp[0].depth;
+
+    if (decimate->depth > 8) {
+        decimate->sad16 = ff_scene_sad_get_fn(16);
+        if (!decimate->sad16)
+            return AVERROR(EINVAL);
+    }
+
+    decimate->nb_jobs = ff_filter_get_nb_threads(ctx);
+    av_freep(&decimate->jobs);
+    decimate->jobs = av_calloc(decimate->nb_jobs, sizeof(*decimate->jobs));
+    if (!decimate->jobs)
+        return AVERROR(ENOMEM);
 
     return 0;
 }
@@ -252,4 +347,5 @@ AVFilter ff_vf_mpdecimate = {
     .query_formats = query_formats,
     .inputs        = mpdecimate_inputs,
     .outputs       = mpdecimate_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
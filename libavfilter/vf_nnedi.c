@@ -23,7 +23,6 @@
 
 #include "libavutil/avassert.h"
 #include "libavutil/common.h"
-#include "libavutil/float_dsp.h"
 #include "libavutil/imgutils.h"
 #include "libavutil/mem_internal.h"
 #include "libavutil/opt.h"
@@ -31,6 +30,7 @@
 #include "avfilter.h"
 #include "formats.h"
 #include "internal.h"
+#include "nnedi.h"
 #include "video.h"
 
 static const size_t NNEDI_WEIGHTS_SIZE = 13574928;
@@ -60,6 +60,12 @@ typedef struct PredictorCoefficients {
     float *elliott_q2;
     float *softmax_bias_q2;
     float *elliott_bias_q2;
+
+    /* softmax and elliott filters interleaved input-major, see prepare_predictor() */
+    float *weights_q1;
+    float *bias_q1;
+    float *weights_q2;
+    float *bias_q2;
 } PredictorCoefficients;
 
 typedef struct NNEDIContext {
@@ -71,7 +77,7 @@ typedef struct NNEDIContext {
     int eof;
     int64_t pts;
 
-    AVFloatDSPContext *fdsp;
+    NNEDIDSPContext dsp;
     int depth;
     int nb_planes;
     int nb_threads;
@@ -213,16 +219,44 @@ static int query_formats(AVFilterContext *ctx)
     return ff_set_common_formats(ctx, fmts_list);
 }
 
-static float dot_dsp(const NNEDIContext *const s, const float *kernel, const float *input,
-                     int n, float scale, float bias)
+static float dot(const float *kernel, const float *input, int n)
 {
-    float sum, y;
+    float sum = 0.f;
 
-    sum = s->fdsp->scalarproduct_float(kernel, input, n);
+    for (int i = 0; i < n; i++)
+        sum += kernel[i] * input[i];
+
+    return sum;
+}
 
-    y = sum * scale + bias + 1e-20f;
+static void prescreen_l0_c(float *dst, const float *kernel,
+                           const float *input, int n)
+{
+    for (int c = 0; c < 4; c++)
+        dst[c] = 0.f;
 
-    return y;
+    for (int k = 0; k < n; k++) {
+        for (int c = 0; c < 4; c++)
+            dst[c] += kernel[4 * k + c] * input[k];
+    }
+}
+
+static void predict_c(float *dst, const float *weights, const float *bias,
+                      const float *input, int n, int cols, float scale)
+{
+    for (int c = 0; c < cols; c++)
+        dst[c] = 0.f;
+
+    for (int k = 0; k < n; k++) {
+        const float *w = weights + k * cols;
+        const float in = input[k];
+
+        for (int c = 0; c < cols; c++)
+            dst[c] += w[c] * in;
+    }
+
+    for (int c = 0; c < cols; c++)
+        dst[c] = dst[c] * scale + bias[c];
 }
 
 static float elliott(float x)
@@ -255,18 +289,19 @@ static void process_old(AVFilterContext *ctx,
             memcpy(input + i * 12, window + i * src_stride + j, 12 * sizeof(float));
 
         // Layer 0.
+        s->dsp.prescreen_l0(state, m_data->kernel_l0[0], input, 48);
         for (int n = 0; n < 4; n++)
-            state[n] = dot_dsp(s, m_data->kernel_l0[n], input, 48, 1.0f, m_data->bias_l0[n]);
+            state[n] += m_data->bias_l0[n];
         transform_elliott(state + 1, 3);
 
         // Layer 1.
         for (int n = 0; n < 4; n++)
-            state[n + 4] = dot_dsp(s, m_data->kernel_l1[n], state, 4, 1.0f, m_data->bias_l1[n]);
+            state[n + 4] = dot(m_data->kernel_l1[n], state, 4) + m_data->bias_l1[n];
         transform_elliott(state + 4, 3);
 
         // Layer 2.
         for (int n = 0; n < 4; n++)
-            state[n + 8] = dot_dsp(s, m_data->kernel_l2[n], state, 8, 1.0f, m_data->bias_l2[n]);
+            state[n + 8] = dot(m_data->kernel_l2[n], state, 8) + m_data->bias_l2[n];
 
         prescreen[j] = FFMAX(state[10], state[11]) <= FFMAX(state[8], state[9]) ? 255 : 0;
     }
@@ -290,47 +325,19 @@ static void process_new(AVFilterContext *ctx,
         for (int i = 0; i < 4; i++)
             memcpy(input + i * 16, window + i * src_stride + j, 16 * sizeof(float));
 
+        s->dsp.prescreen_l0(state, m_data->kernel_l0[0], input, 64);
         for (int n = 0; n < 4; n++)
-            state[n] = dot_dsp(s, m_data->kernel_l0[n], input, 64, 1.0f, m_data->bias_l0[n]);
+            state[n] += m_data->bias_l0[n];
         transform_elliott(state, 4);
 
         for (int n = 0; n < 4; n++)
-            state[n + 4] = dot_dsp(s, m_data->kernel_l1[n], state, 4, 1.0f, m_data->bias_l1[n]);
+            state[n + 4] = dot(m_data->kernel_l1[n], state, 4) + m_data->bias_l1[n];
 
         for (int n = 0; n < 4; n++)
             prescreen[j + n] = state[n + 4] > 0.f;
     }
 }
 
-static int filter_offset(int nn, const PredictorCoefficients *const model)
-{
-    return nn * model->nsize;
-}
-
-static const float *softmax_q1_filter(int nn,
-                                      const PredictorCoefficients *const model)
-{
-    return model->softmax_q1 + filter_offset(nn, model);
-}
-
-static const float *elliott_q1_filter(int nn,
-                                      const PredictorCoefficients *const model)
-{
-    return model->elliott_q1 + filter_offset(nn, model);
-}
-
-static const float *softmax_q2_filter(int nn,
-                                      const PredictorCoefficients *const model)
-{
-    return model->softmax_q2 + filter_offset(nn, model);
-}
-
-static const float *elliott_q2_filter(int nn,
-                                      const PredictorCoefficients *const model)
-{
-    return model->elliott_q2 + filter_offset(nn, model);
-}
-
 static void gather_input(const float *src, ptrdiff_t src_stride,
                          float *buf, float mstd[4],
                          const PredictorCoefficients *const model)
@@ -372,24 +379,31 @@ static float softmax_exp(float x)
     return expf(av_clipf(x, -80.f, 80.f));
 }
 
-static void transform_softmax_exp(float *input, int size)
+static void wae5_c(const float *softmax, const float *el,
+                   int n, float *sums)
 {
-    for (int i = 0; i < size; i++)
-        input[i] = softmax_exp(input[i]);
+    float vsum = 0.0f, wsum = 0.0f;
+
+    for (int i = 0; i < n; i++) {
+        const float w = softmax_exp(softmax[i]);
+
+        vsum += w * elliott(el[i]);
+        wsum += w;
+    }
+
+    sums[0] = vsum;
+    sums[1] = wsum;
 }
 
-static void wae5(const float *softmax, const float *el,
+static void wae5(const NNEDIContext *const s, const float *activation,
                  int n, float mstd[4])
 {
-    float vsum = 0.0f, wsum = 0.0f;
+    float sums[2];
 
-    for (int i = 0; i < n; i++) {
-        vsum += softmax[i] * elliott(el[i]);
-        wsum += softmax[i];
-    }
+    s->dsp.wae5(activation, activation + n, n, sums);
 
-    if (wsum > 1e-10f)
-        mstd[3] += (5.0f * vsum) / wsum * mstd[1] + mstd[0];
+    if (sums[1] > 1e-10f)
+        mstd[3] += (5.0f * sums[0]) / sums[1] * mstd[1] + mstd[0];
     else
         mstd[3] += mstd[0];
 }
@@ -410,7 +424,7 @@ static void predictor(AVFilterContext *ctx,
 
     for (int i = 0; i < N; i++) {
         LOCAL_ALIGNED_32(float, input, [48 * 6]);
-        float activation[256 * 2];
+        LOCAL_ALIGNED_32(float, activation, [256 * 2]);
         float mstd[4];
         float scale;
 
@@ -420,24 +434,14 @@ static void predictor(AVFilterContext *ctx,
         gather_input(window + i, src_stride, input, mstd, model);
         scale = mstd[2];
 
-        for (int nn = 0; nn < nns; nn++)
-            activation[nn] = dot_dsp(s, softmax_q1_filter(nn, model), input, filter_size, scale, model->softmax_bias_q1[nn]);
-
-        for (int nn = 0; nn < nns; nn++)
-            activation[nns + nn] = dot_dsp(s, elliott_q1_filter(nn, model), input, filter_size, scale, model->elliott_bias_q1[nn]);
-
-        transform_softmax_exp(activation, nns);
-        wae5(activation, activation + nns, nns, mstd);
+        s->dsp.predict(activation, model->weights_q1, model->bias_q1,
+                       input, filter_size, 2 * nns, scale);
+        wae5(s, activation, nns, mstd);
 
         if (use_q2) {
-            for (int nn = 0; nn < nns; nn++)
-                activation[nn] = dot_dsp(s, softmax_q2_filter(nn, model), input, filter_size, scale, model->softmax_bias_q2[nn]);
-
-            for (int nn = 0; nn < nns; nn++)
-                activation[nns + nn] = dot_dsp(s, elliott_q2_filter(nn, model), input, filter_size, scale, model->elliott_bias_q2[nn]);
-
-            transform_softmax_exp(activation, nns);
-            wae5(activation, activation + nns, nns, mstd);
+            s->dsp.predict(activation, model->weights_q2, model->bias_q2,
+                           input, filter_size, 2 * nns, scale);
+            wae5(s, activation, nns, mstd);
         }
 
         dst_p[i] = mstd[3] * (use_q2 ? 0.5f : 1.f);
@@ -903,7 +907,7 @@ static void subtract_mean_predictor(PredictorCoefficients *model)
 
     double softmax_means[256]; // Average of individual softmax filters.
     double elliott_means[256]; // Average of individual elliott filters.
-    double mean_filter[48 * 6]; // Pointwise average of all softmax filters.
+    double mean_filter[48 * 6] = { 0 }; // Pointwise average of all softmax filters.
     double mean_bias;
 
     // Quality 1.
@@ -955,6 +959,106 @@ static void subtract_mean_predictor(PredictorCoefficients *model)
     }
 }
 
+static void prepare_prescreener(PrescreenerCoefficients *coeffs, int n)
+{
+    float kernel[4 * 64];
+
+    // Store the first layer input-major so all four neurons are evaluated at once.
+    for (int k = 0; k < n; k++) {
+        for (int c = 0; c < 4; c++)
+            kernel[4 * k + c] = coeffs->kernel_l0[c][k];
+    }
+    memcpy(coeffs->kernel_l0, kernel, 4 * n * sizeof(*kernel));
+
+    for (int c = 0; c < 4; c++) {
+        coeffs->bias_l0[c] += 1e-20f;
+        coeffs->bias_l1[c] += 1e-20f;
+        coeffs->bias_l2[c] += 1e-20f;
+    }
+}
+
+static int interleave_filters(float *filters, float *bias, int cols, int nsize)
+{
+    float *tmp = av_malloc_array(cols * nsize, sizeof(*tmp));
+
+    if (!tmp)
+        return AVERROR(ENOMEM);
+
+    for (int c = 0; c < cols; c++) {
+        for (int k = 0; k < nsize; k++)
+            tmp[k * cols + c] = filters[c * nsize + k];
+    }
+    memcpy(filters, tmp, cols * nsize * sizeof(*tmp));
+    av_free(tmp);
+
+    for (int c = 0; c < cols; c++)
+        bias[c] += 1e-20f;
+
+    return 0;
+}
+
+static int prepare_predictor(PredictorCoefficients *model)
+{
+    int ret;
+
+    subtract_mean_predictor(model);
+
+    /* The elliott filters and biases directly follow the softmax ones, so
+     * both sets are transposed together into one input-major matrix of
+     * 2 * nns columns, evaluated in a single pass over the input window. */
+    ret = interleave_filters(model->softmax_q1, model->softmax_bias_q1,
+                             2 * model->nns, model->nsize);
+    if (ret < 0)
+        return ret;
+    model->weights_q1 = model->softmax_q1;
+    model->bias_q1    = model->softmax_bias_q1;
+
+    ret = interleave_filters(model->softmax_q2, model->softmax_bias_q2,
+                             2 * model->nns, model->nsize);
+    if (ret < 0)
+        return ret;
+    model->weights_q2 = model->softmax_q2;
+    model->bias_q2    = model->softmax_bias_q2;
+
+    return 0;
+}
+
+static int prepare_weights(NNEDIContext *s)
+{
+    int ret;
+
+    subtract_mean_old(&s->prescreener[0], s->half);
+    subtract_mean_new(&s->prescreener[1], s->half);
+    subtract_mean_new(&s->prescreener[2], s->half);
+    subtract_mean_new(&s->prescreener[3], s->half);
+
+    prepare_prescreener(&s->prescreener[0], 48);
+    for (int i = 1; i < 4; i++)
+        prepare_prescreener(&s->prescreener[i], 64);
+
+    for (int i = 0; i < 2; i++) {
+        for (int j = 0; j < 5; j++) {
+            for (int k = 0; k < 7; k++) {
+                ret = prepare_predictor(&s->coeffs[i][j][k]);
+                if (ret < 0)
+                    return ret;
+            }
+        }
+    }
+
+    return 0;
+}
+
+void ff_nnedi_init(NNEDIDSPContext *dsp)
+{
+    dsp->prescreen_l0 = prescreen_l0_c;
+    dsp->predict      = predict_c;
+    dsp->wae5         = wae5_c;
+
+    if (ARCH_X86)
+        ff_nnedi_init_x86(dsp);
+}
+
 static av_cold int init(AVFilterContext *ctx)
 {
     NNEDIContext *s = ctx->priv;
@@ -1010,16 +1114,17 @@ static av_cold int init(AVFilterContext *ctx)
 
     fclose(weights_file);
 
-    s->fdsp = avpriv_float_dsp_alloc(0);
-    if (!s->fdsp) {
-        ret = AVERROR(ENOMEM);
+    ret = read_weights(ctx, bdata);
+    if (ret < 0)
         goto fail;
-    }
 
-    ret = read_weights(ctx, bdata);
+    s->half = ((1 << 8) - 1) / 2.f;
+    ret = prepare_weights(s);
     if (ret < 0)
         goto fail;
 
+    ff_nnedi_init(&s->dsp);
+
 fail:
     av_free(bdata);
     return ret;
@@ -1043,7 +1148,6 @@ static int config_input(AVFilterLink *inlink)
     s->planeheight[1] = s->planeheight[2] = AV_CEIL_RSHIFT(inlink->h, desc->log2_chroma_h);
     s->planeheight[0] = s->planeheight[3] = inlink->h;
 
-    s->half = ((1 << 8) - 1) / 2.f;
     s->out_scale = 1 << (s->depth - 8);
     s->in_scale = 1.f / s->out_scale;
 
@@ -1058,21 +1162,9 @@ static int config_input(AVFilterLink *inlink)
         break;
     }
 
-    subtract_mean_old(&s->prescreener[0], s->half);
-    subtract_mean_new(&s->prescreener[1], s->half);
-    subtract_mean_new(&s->prescreener[2], s->half);
-    subtract_mean_new(&s->prescreener[3], s->half);
-
     s->prescreen[0] = process_old;
     s->prescreen[1] = process_new;
 
-    for (int i = 0; i < 2; i++) {
-        for (int j = 0; j < 5; j++) {
-            for (int k = 0; k < 7; k++)
-                subtract_mean_predictor(&s->coeffs[i][j][k]);
-        }
-    }
-
     s->input_size = (s->planewidth[0] + 64) * (s->planeheight[0] + 6);
     s->input_buf = av_calloc(s->nb_threads, sizeof(*s->input_buf));
     if (!s->input_buf)
@@ -1125,7 +1217,6 @@ static av_cold void uninit(AVFilterContext *ctx)
         av_freep(&s->output_buf[i]);
 
     av_freep(&s->output_buf);
-    av_freep(&s->fdsp);
 
     for (int i = 0; i < 2; i++) {
         for (int j = 0; j < 5; j++) {
@@ -433,6 +433,70 @@ static av_always_inline void blend_slice_packed_rgb(AVFilterContext *ctx,
     }
 }
 
+/**
+ * Blend a row of a plane when the main input has no alpha, leaving the last
+ * pixel of subsampled rows to blend_plane() as its alpha is not averaged.
+ * These are the C versions of the blend_row functions.
+ */
+#define DEFINE_BLEND_ROW(depth, nbits)                                                                     \
+static av_always_inline int blend_row_##depth##_##nbits##bits(uint8_t *_d, uint8_t *_s, uint8_t *_a,      \
+                                                              int w, ptrdiff_t alinesize,                  \
+                                                              int hsub, int vsub,                          \
+                                                              int straight, int chroma)                    \
+{                                                                                                          \
+    uint##depth##_t *d = (uint##depth##_t *)_d;                                                            \
+    const uint##depth##_t *s = (const uint##depth##_t *)_s;                                                \
+    const uint##depth##_t *a = (const uint##depth##_t *)_a;                                                \
+    const int max = (1 << nbits) - 1;                                                                      \
+    const int mid = 1 << (nbits - 1);                                                                      \
+    const ptrdiff_t ls = alinesize / (depth / 8);                                                          \
+                                                                                                           \
+    w -= hsub;                                                                                             \
+    for (int k = 0; k < w; k++) {                                                                          \
+        int alpha;                                                                                         \
+                                                                                                           \
+        if (hsub && vsub)                                                                                  \
+            alpha = (a[0] + a[ls] + a[1] + a[ls + 1]) >> 2;                                                \
+        else if (hsub)                                                                                     \
+            alpha = (a[0] + ((a[0] + a[1]) >> 1)) >> 1;                                                    \
+        else                                                                                               \
+            alpha = a[0];                                                                                  \
+                                                                                                           \
+        if (straight) {                                                                                    \
+            if (nbits > 8)                                                                                 \
+                d[k] = (d[k] * (max - alpha) + s[k] * alpha) / max;                                        \
+            else                                                                                           \
+                d[k] = FAST_DIV255(d[k] * (255 - alpha) + s[k] * alpha);                                   \
+        } else {                                                                                           \
+            if (chroma)                                                                                    \
+                d[k] = av_clip(FAST_DIV255((d[k] - mid) * (max - alpha)) + s[k] - mid, -mid, mid) + mid;   \
+            else                                                                                           \
+                d[k] = FFMIN(FAST_DIV255(d[k] * (max - alpha)) + s[k], max);                               \
+        }                                                                                                  \
+        a += 1 << hsub;                                                                                    \
+    }                                                                                                      \
+    return w;                                                                                              \
+}
+DEFINE_BLEND_ROW(8, 8)
+DEFINE_BLEND_ROW(16, 10)
+
+#define DEFINE_OVERLAY_ROW(name, depth, nbits, hsub, vsub, straight, chroma)                               \
+static int overlay_row_##name##_c(uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a,                         \
+                                  int w, ptrdiff_t alinesize)                                              \
+{                                                                                                          \
+    return blend_row_##depth##_##nbits##bits(d, s, a, w, alinesize, hsub, vsub, straight, chroma);        \
+}
+DEFINE_OVERLAY_ROW(44,       8,  8, 0, 0, 1, 0)
+DEFINE_OVERLAY_ROW(22,       8,  8, 1, 0, 1, 0)
+DEFINE_OVERLAY_ROW(20,       8,  8, 1, 1, 1, 0)
+DEFINE_OVERLAY_ROW(44_pm,    8,  8, 0, 0, 0, 0)
+DEFINE_OVERLAY_ROW(44_pm_uv, 8,  8, 0, 0, 0, 1)
+DEFINE_OVERLAY_ROW(22_pm_uv, 8,  8, 1, 0, 0, 1)
+DEFINE_OVERLAY_ROW(20_pm_uv, 8,  8, 1, 1, 0, 1)
+DEFINE_OVERLAY_ROW(44_10,   16, 10, 0, 0, 1, 0)
+DEFINE_OVERLAY_ROW(22_10,   16, 10, 1, 0, 1, 0)
+DEFINE_OVERLAY_ROW(20_10,   16, 10, 1, 1, 1, 0)
+
 #define DEFINE_BLEND_PLANE(depth, nbits)                                                                   \
 static av_always_inline void blend_plane_##depth##_##nbits##bits(AVFilterContext *ctx,                     \
                                          AVFrame *dst, const AVFrame *src,                                 \
@@ -485,7 +549,7 @@ static av_always_inline void blend_plane_##depth##_##nbits##bits(AVFilterContext
         da = dap + ((xp+k) << hsub);                                                                       \
         kmax = FFMIN(-xp + dst_wp, src_wp);                                                                \
                                                                                                            \
-        if (nbits == 8 && ((vsub && j+1 < src_hp) || !vsub) && octx->blend_row[i]) {                       \
+        if (((vsub && j+1 < src_hp) || !vsub) && octx->blend_row[i]) {                                     \
             int c = octx->blend_row[i]((uint8_t*)d, (uint8_t*)da, (uint8_t*)s,                             \
                     (uint8_t*)a, kmax - k, src->linesize[3]);                                              \
                                                                                                            \
@@ -500,13 +564,13 @@ static av_always_inline void blend_plane_##depth##_##nbits##bits(AVFilterContext
                                                                                                            \
             /* average alpha for color components, improve quality */                                      \
             if (hsub && vsub && j+1 < src_hp && k+1 < src_wp) {                                            \
-                alpha = (a[0] + a[src->linesize[3]] +                                                      \
-                         a[1] + a[src->linesize[3]+1]) >> 2;                                               \
+                alpha = (a[0] + a[src->linesize[3] / bytes] +                                                      \
+                         a[1] + a[src->linesize[3] / bytes + 1]) >> 2;                                               \
             } else if (hsub || vsub) {                                                                     \
                 alpha_h = hsub && k+1 < src_wp ?                                                           \
                     (a[0] + a[1]) >> 1 : a[0];                                                             \
                 alpha_v = vsub && j+1 < src_hp ?                                                           \
-                    (a[0] + a[src->linesize[3]]) >> 1 : a[0];                                              \
+                    (a[0] + a[src->linesize[3] / bytes]) >> 1 : a[0];                                              \
                 alpha = (alpha_v + alpha_h) >> 1;                                                          \
             } else                                                                                         \
                 alpha = a[0];                                                                              \
@@ -516,13 +580,13 @@ static av_always_inline void blend_plane_##depth##_##nbits##bits(AVFilterContext
                 /* average alpha for color components, improve quality */                                  \
                 uint8_t alpha_d;                                                                           \
                 if (hsub && vsub && j+1 < src_hp && k+1 < src_wp) {                                        \
-                    alpha_d = (da[0] + da[dst->linesize[3]] +                                              \
-                               da[1] + da[dst->linesize[3]+1]) >> 2;                                       \
+                    alpha_d = (da[0] + da[dst->linesize[3] / bytes] +                                              \
+                               da[1] + da[dst->linesize[3] / bytes + 1]) >> 2;                                       \
                 } else if (hsub || vsub) {                                                                 \
                     alpha_h = hsub && k+1 < src_wp ?                                                       \
                         (da[0] + da[1]) >> 1 : da[0];                                                      \
                     alpha_v = vsub && j+1 < src_hp ?                                                       \
-                        (da[0] + da[dst->linesize[3]]) >> 1 : da[0];                                       \
+                        (da[0] + da[dst->linesize[3] / bytes]) >> 1 : da[0];                                       \
                     alpha_d = (alpha_v + alpha_h) >> 1;                                                    \
                 } else                                                                                     \
                     alpha_d = da[0];                                                                       \
@@ -865,6 +929,51 @@ static int blend_slice_rgba_pm(AVFilterContext *ctx, void *arg, int jobnr, int n
     return 0;
 }
 
+void ff_overlay_init_rows(OverlayContext *s, int format, int pix_format,
+                          int alpha_format, int main_has_alpha)
+{
+    memset(s->blend_row, 0, sizeof(s->blend_row));
+
+    /* The rows do not unpremultiply the alpha of the main input */
+    if (main_has_alpha)
+        return;
+
+    switch (format) {
+    case OVERLAY_FORMAT_YUV420:
+        if (pix_format != AV_PIX_FMT_YUV420P)
+            return;
+        s->blend_row[0] = alpha_format ? overlay_row_44_pm_c    : overlay_row_44_c;
+        s->blend_row[1] = alpha_format ? overlay_row_20_pm_uv_c : overlay_row_20_c;
+        break;
+    case OVERLAY_FORMAT_YUV422:
+        s->blend_row[0] = alpha_format ? overlay_row_44_pm_c    : overlay_row_44_c;
+        s->blend_row[1] = alpha_format ? overlay_row_22_pm_uv_c : overlay_row_22_c;
+        break;
+    case OVERLAY_FORMAT_YUV444:
+        s->blend_row[0] = alpha_format ? overlay_row_44_pm_c    : overlay_row_44_c;
+        s->blend_row[1] = alpha_format ? overlay_row_44_pm_uv_c : overlay_row_44_c;
+        break;
+    case OVERLAY_FORMAT_GBRP:
+        s->blend_row[0] = alpha_format ? overlay_row_44_pm_c    : overlay_row_44_c;
+        s->blend_row[1] = s->blend_row[0];
+        break;
+    case OVERLAY_FORMAT_YUV420P10:
+        s->blend_row[0] = overlay_row_44_10_c;
+        s->blend_row[1] = overlay_row_20_10_c;
+        break;
+    case OVERLAY_FORMAT_YUV422P10:
+        s->blend_row[0] = overlay_row_44_10_c;
+        s->blend_row[1] = overlay_row_22_10_c;
+        break;
+    default:
+        return;
+    }
+    s->blend_row[2] = s->blend_row[1];
+
+    if (ARCH_X86)
+        ff_overlay_init_x86(s, format, pix_format, alpha_format, main_has_alpha);
+}
+
 static int config_input_main(AVFilterLink *inlink)
 {
     OverlayContext *s = inlink->dst->priv;
@@ -982,9 +1091,8 @@ static int config_input_main(AVFilterLink *inlink)
     }
 
 end:
-    if (ARCH_X86)
-        ff_overlay_init_x86(s, s->format, inlink->format,
-                            s->alpha_format, s->main_has_alpha);
+    ff_overlay_init_rows(s, s->format, inlink->format,
+                         s->alpha_format, s->main_has_alpha);
 
     return 0;
 }
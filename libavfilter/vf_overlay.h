@@ -82,6 +82,13 @@ typedef struct OverlayContext {
     int (*blend_slice)(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs);
 } OverlayContext;
 
+/**
+ * Set the blend_row functions for the given formats, they are left NULL
+ * where blending is only done by the generic code.
+ */
+void ff_overlay_init_rows(OverlayContext *s, int format, int pix_format,
+                          int alpha_format, int main_has_alpha);
+
 void ff_overlay_init_x86(OverlayContext *s, int format, int pix_format,
                          int alpha_format, int main_has_alpha);
 
@@ -46,9 +46,14 @@ struct range_box {
     int sorted_by;      // whether range of colors is sorted by red (0), green (1) or blue (2)
 };
 
-struct hist_node {
-    struct color_ref *entries;
+/* Open addressing hash table of the colors, keeping them in the order they
+ * were first seen */
+struct color_table {
+    struct color_ref *entries;  // colors, in insertion order
     int nb_entries;
+    int entries_size;           // number of allocated entries
+    int *slots;                 // index + 1 of the entry of each slot, 0 if empty
+    int slots_bits;             // log2 of the number of slots
 };
 
 enum {
@@ -61,15 +66,22 @@ enum {
 #define NBITS 5
 #define HIST_SIZE (1<<(3*NBITS))
 
+#define TABLE_MIN_BITS 10
+
 typedef struct PaletteGenContext {
     const AVClass *class;
 
     int max_colors;
     int reserve_transparent;
     int stats_mode;
+    int pixel_step;
+    int frame_step;
 
     AVFrame *prev_frame;                    // previous frame used for the diff stats_mode
-    struct hist_node histogram[HIST_SIZE];  // histogram/hashtable of the colors
+    struct color_table *tables;             // histogram of the colors, followed by one per slice job
+    int nb_tables;
+    int *job_ret;
+    int64_t frame_count;
     struct color_ref **refs;                // references of all the colors used in the stream
     int nb_refs;                            // number of color references (or number of different colors)
     struct range_box boxes[256];            // define the segmentation of the colorspace (the final palette)
@@ -88,6 +100,8 @@ static const AVOption palettegen_options[] = {
         { "full", "compute full frame histograms", 0, AV_OPT_TYPE_CONST, {.i64=STATS_MODE_ALL_FRAMES}, INT_MIN, INT_MAX, FLAGS, "mode" },
         { "diff", "compute histograms only for the part that differs from previous frame", 0, AV_OPT_TYPE_CONST, {.i64=STATS_MODE_DIFF_FRAMES}, INT_MIN, INT_MAX, FLAGS, "mode" },
         { "single", "compute new histogram for each frame", 0, AV_OPT_TYPE_CONST, {.i64=STATS_MODE_SINGLE_FRAMES}, INT_MIN, INT_MAX, FLAGS, "mode" },
+    { "pixel_step", "set the distance between the pixels sampled in full stats mode", OFFSET(pixel_step), AV_OPT_TYPE_INT, {.i64=1}, 1, 64, FLAGS },
+    { "frame_step", "set the distance between the frames sampled in full stats mode", OFFSET(frame_step), AV_OPT_TYPE_INT, {.i64=1}, 1, INT_MAX, FLAGS },
     { NULL }
 };
 
@@ -258,25 +272,48 @@ static void write_palette(AVFilterContext *ctx, AVFrame *out)
 }
 
 /**
- * Crawl the histogram to get all the defined colors, and create a linear list
- * of them (each color reference entry is a pointer to the value in the
- * histogram/hash table).
+ * Hashing function for the color.
+ * It keeps the NBITS least significant bit of each component to make it
+ * "random" even if the scene doesn't have much different colors.
  */
-static struct color_ref **load_color_refs(const struct hist_node *hist, int nb_refs)
+static inline unsigned color_hash(uint32_t color)
 {
-    int i, j, k = 0;
-    struct color_ref **refs = av_malloc_array(nb_refs, sizeof(*refs));
+    const uint8_t r = color >> 16 & ((1<<NBITS)-1);
+    const uint8_t g = color >>  8 & ((1<<NBITS)-1);
+    const uint8_t b = color       & ((1<<NBITS)-1);
+    return r<<(NBITS*2) | g<<NBITS | b;
+}
 
-    if (!refs)
-        return NULL;
+/**
+ * Create a linear list of all the colors of the histogram (each color
+ * reference entry is a pointer to the value in the table).
+ *
+ * The colors are ordered by color_hash() and then by first appearance, which
+ * the median cut depends on as it does not use a stable sort.
+ */
+static struct color_ref **load_color_refs(const struct color_table *table)
+{
+    int i, k = 0;
+    struct color_ref **refs = av_malloc_array(table->nb_entries, sizeof(*refs));
+    int *pos = av_calloc(HIST_SIZE, sizeof(*pos));
 
-    for (j = 0; j < HIST_SIZE; j++) {
-        const struct hist_node *node = &hist[j];
+    if (!refs || !pos) {
+        av_freep(&refs);
+        av_freep(&pos);
+        return NULL;
+    }
 
-        for (i = 0; i < node->nb_entries; i++)
-            refs[k++] = &node->entries[i];
+    for (i = 0; i < table->nb_entries; i++)
+        pos[color_hash(table->entries[i].color)]++;
+    for (i = 0; i < HIST_SIZE; i++) {
+        const int n = pos[i];
+        pos[i] = k;
+        k += n;
     }
+    for (i = 0; i < table->nb_entries; i++)
+        refs[pos[color_hash(table->entries[i].color)]++] = &table->entries[i];
 
+    av_freep(&pos);
     return refs;
 }
 
@@ -303,7 +340,7 @@ static AVFrame *get_palette_frame(AVFilterContext *ctx)
     struct range_box *box;
 
     /* reference only the used colors from histogram */
-    s->refs = load_color_refs(s->histogram, s->nb_refs);
+    s->refs = load_color_refs(&s->tables[0]);
     if (!s->refs) {
         av_log(ctx, AV_LOG_ERROR, "Unable to allocate references for %d different colors\n", s->nb_refs);
         return NULL;
@@ -389,88 +426,167 @@ static AVFrame *get_palette_frame(AVFilterContext *ctx)
     return out;
 }
 
-/**
- * Hashing function for the color.
- * It keeps the NBITS least significant bit of each component to make it
- * "random" even if the scene doesn't have much different colors.
- */
-static inline unsigned color_hash(uint32_t color)
+static inline unsigned color_slot(uint32_t color, int bits)
 {
-    const uint8_t r = color >> 16 & ((1<<NBITS)-1);
-    const uint8_t g = color >>  8 & ((1<<NBITS)-1);
-    const uint8_t b = color       & ((1<<NBITS)-1);
-    return r<<(NBITS*2) | g<<NBITS | b;
+    return color * 2654435761U >> (32 - bits);
+}
+
+static int table_alloc_slots(struct color_table *table, int bits)
+{
+    int *slots = av_calloc(1 << bits, sizeof(*slots));
+
+    if (!slots)
+        return AVERROR(ENOMEM);
+    av_freep(&table->slots);
+    table->slots      = slots;
+    table->slots_bits = bits;
+
+    for (int i = 0; i < table->nb_entries; i++) {
+        const unsigned mask = (1 << bits) - 1;
+        unsigned h = color_slot(table->entries[i].color, bits);
+
+        while (slots[h])
+            h = (h + 1) & mask;
+        slots[h] = i + 1;
+    }
+    return 0;
+}
+
+static void table_reset(struct color_table *table)
+{
+    if (table->nb_entries)
+        memset(table->slots, 0, sizeof(*table->slots) << table->slots_bits);
+    table->nb_entries = 0;
+}
+
+static void table_free(struct color_table *table)
+{
+    av_freep(&table->entries);
+    av_freep(&table->slots);
+    table->nb_entries = table->entries_size = 0;
 }
 
 /**
- * Locate the color in the hash table and increment its counter.
+ * Locate the color in the hash table and add count to its counter.
+ *
+ * @return index of the entry, or a negative AVERROR code
  */
-static int color_inc(struct hist_node *hist, uint32_t color)
+static int color_add(struct color_table *table, uint32_t color, uint64_t count)
 {
-    int i;
-    const unsigned hash = color_hash(color);
-    struct hist_node *node = &hist[hash];
+    unsigned mask = (1 << table->slots_bits) - 1;
+    unsigned h = color_slot(color, table->slots_bits);
     struct color_ref *e;
+    int ret;
 
-    for (i = 0; i < node->nb_entries; i++) {
-        e = &node->entries[i];
+    while (table->slots[h]) {
+        e = &table->entries[table->slots[h] - 1];
         if (e->color == color) {
-            e->count++;
-            return 0;
+            e->count += count;
+            return table->slots[h] - 1;
         }
+        h = (h + 1) & mask;
     }
 
-    e = av_dynarray2_add((void**)&node->entries, &node->nb_entries,
-                         sizeof(*node->entries), NULL);
-    if (!e)
-        return AVERROR(ENOMEM);
+    /* keep the table at most half full so that the probes stay short */
+    if (table->nb_entries >= (int)(mask >> 1)) {
+        if ((ret = table_alloc_slots(table, table->slots_bits + 1)) < 0)
+            return ret;
+        mask = (1 << table->slots_bits) - 1;
+        h = color_slot(color, table->slots_bits);
+        while (table->slots[h])
+            h = (h + 1) & mask;
+    }
+
+    if (table->nb_entries == table->entries_size) {
+        const int size = FFMAX(2 * table->entries_size, 256);
+        e = av_realloc_array(table->entries, size, sizeof(*e));
+        if (!e)
+            return AVERROR(ENOMEM);
+        table->entries      = e;
+        table->entries_size = size;
+    }
+
+    e = &table->entries[table->nb_entries];
     e->color = color;
-    e->count = 1;
-    return 1;
+    e->count = count;
+    table->slots[h] = ++table->nb_entries;
+    return table->nb_entries - 1;
 }
 
+typedef struct ThreadData {
+    AVFrame *f, *ref;
+    int step;
+} ThreadData;
+
 /**
- * Update histogram when pixels differ from previous frame.
+ * Update the histogram of the slice job with the pixels of f in its slice,
+ * only with those that differ from ref if it is set.
+ * Runs of the same color are counted without looking them up.
  */
-static int update_histogram_diff(struct hist_node *hist,
-                                 const AVFrame *f1, const AVFrame *f2)
+static int update_histogram(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    int x, y, ret, nb_diff_colors = 0;
+    PaletteGenContext *s = ctx->priv;
+    const ThreadData *td = arg;
+    const AVFrame *f = td->f, *ref = td->ref;
+    struct color_table *table = &s->tables[jobnr];
+    const int step = td->step;
+    const int slice_start = (f->height *  jobnr   ) / nb_jobs;
+    const int slice_end   = (f->height * (jobnr+1)) / nb_jobs;
+    int x, y, last = -1;
+    uint32_t last_color = 0;
 
-    for (y = 0; y < f1->height; y++) {
-        const uint32_t *p = (const uint32_t *)(f1->data[0] + y*f1->linesize[0]);
-        const uint32_t *q = (const uint32_t *)(f2->data[0] + y*f2->linesize[0]);
+    for (y = (slice_start + step - 1) / step * step; y < slice_end; y += step) {
+        const uint32_t *p = (const uint32_t *)(f->data[0] + y*f->linesize[0]);
+        const uint32_t *q = ref ? (const uint32_t *)(ref->data[0] + y*ref->linesize[0]) : NULL;
 
-        for (x = 0; x < f1->width; x++) {
-            if (p[x] == q[x])
+        for (x = 0; x < f->width; x += step) {
+            const uint32_t color = p[x];
+
+            if (q && color == q[x])
+                continue;
+            if (color == last_color && last >= 0) {
+                table->entries[last].count++;
                 continue;
-            ret = color_inc(hist, p[x]);
-            if (ret < 0)
-                return ret;
-            nb_diff_colors += ret;
+            }
+            last = color_add(table, color, 1);
+            if (last < 0)
+                return last;
+            last_color = color;
         }
     }
-    return nb_diff_colors;
+    return 0;
 }
 
 /**
- * Simple histogram of the frame.
+ * Update the histogram with a frame. The first slice job counts directly
+ * into the histogram, the colors counted by the others are then added in
+ * the order of the slices, so that they are found in the same order as when
+ * scanning the frame from a single thread.
  */
-static int update_histogram_frame(struct hist_node *hist, const AVFrame *f)
+static int update_histogram_frame(AVFilterContext *ctx, AVFrame *f, AVFrame *ref, int step)
 {
-    int x, y, ret, nb_diff_colors = 0;
+    PaletteGenContext *s = ctx->priv;
+    ThreadData td = { f, ref, step };
+    const int nb_jobs = FFMIN(s->nb_tables, (f->height + step - 1) / step);
+    int i, j, ret;
 
-    for (y = 0; y < f->height; y++) {
-        const uint32_t *p = (const uint32_t *)(f->data[0] + y*f->linesize[0]);
+    ctx->internal->execute(ctx, update_histogram, &td, s->job_ret, nb_jobs);
+
+    ret = 0;
+    for (i = 0; i < nb_jobs; i++)
+        ret = FFMIN(ret, s->job_ret[i]);
 
-        for (x = 0; x < f->width; x++) {
-            ret = color_inc(hist, p[x]);
-            if (ret < 0)
-                return ret;
-            nb_diff_colors += ret;
+    for (i = 1; i < nb_jobs; i++) {
+        struct color_table *table = &s->tables[i];
+
+        for (j = 0; j < table->nb_entries && ret >= 0; j++) {
+            int r = color_add(&s->tables[0], table->entries[j].color, table->entries[j].count);
+            ret = FFMIN(ret, r);
         }
+        table_reset(table);
     }
-    return nb_diff_colors;
+    s->nb_refs = s->tables[0].nb_entries;
+    return ret;
 }
 
 /**
@@ -480,30 +596,36 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
     PaletteGenContext *s = ctx->priv;
-    int ret = s->prev_frame ? update_histogram_diff(s->histogram, s->prev_frame, in)
-                            : update_histogram_frame(s->histogram, in);
+    int ret = 0;
 
-    if (ret > 0)
-        s->nb_refs += ret;
+    if (s->stats_mode == STATS_MODE_ALL_FRAMES) {
+        if (s->frame_count++ % s->frame_step == 0)
+            ret = update_histogram_frame(ctx, in, NULL, s->pixel_step);
+    } else if (s->prev_frame) {
+        ret = update_histogram_frame(ctx, s->prev_frame, in, 1);
+    } else {
+        ret = update_histogram_frame(ctx, in, NULL, 1);
+    }
+    if (ret < 0) {
+        av_frame_free(&in);
+        return ret;
+    }
 
     if (s->stats_mode == STATS_MODE_DIFF_FRAMES) {
         av_frame_free(&s->prev_frame);
         s->prev_frame = in;
     } else if (s->stats_mode == STATS_MODE_SINGLE_FRAMES) {
         AVFrame *out;
-        int i;
 
         out = get_palette_frame(ctx);
         out->pts = in->pts;
         av_frame_free(&in);
         ret = ff_filter_frame(ctx->outputs[0], out);
-        for (i = 0; i < HIST_SIZE; i++)
-            av_freep(&s->histogram[i].entries);
+        table_reset(&s->tables[0]);
         av_freep(&s->refs);
         s->nb_refs = 0;
         s->nb_boxes = 0;
         memset(s->boxes, 0, sizeof(s->boxes));
-        memset(s->histogram, 0, sizeof(s->histogram));
     } else {
         av_frame_free(&in);
     }
@@ -530,6 +652,35 @@ static int request_frame(AVFilterLink *outlink)
     return r;
 }
 
+static void tables_free(PaletteGenContext *s)
+{
+    for (int i = 0; i < s->nb_tables; i++)
+        table_free(&s->tables[i]);
+    av_freep(&s->tables);
+    av_freep(&s->job_ret);
+    s->nb_tables = 0;
+}
+
+static int config_input(AVFilterLink *inlink)
+{
+    AVFilterContext *ctx = inlink->dst;
+    PaletteGenContext *s = ctx->priv;
+    const int nb_tables = ff_filter_get_nb_threads(ctx);
+    int i, ret;
+
+    tables_free(s);
+    s->tables    = av_calloc(nb_tables, sizeof(*s->tables));
+    s->job_ret   = av_calloc(nb_tables, sizeof(*s->job_ret));
+    if (!s->tables || !s->job_ret)
+        return AVERROR(ENOMEM);
+    s->nb_tables = nb_tables;
+
+    for (i = 0; i < s->nb_tables; i++)
+        if ((ret = table_alloc_slots(&s->tables[i], TABLE_MIN_BITS)) < 0)
+            return ret;
+    return 0;
+}
+
 /**
  * The output is one simple 16x16 squared-pixels palette.
  */
@@ -542,11 +693,9 @@ static int config_output(AVFilterLink *outlink)
 
 static av_cold void uninit(AVFilterContext *ctx)
 {
-    int i;
     PaletteGenContext *s = ctx->priv;
 
-    for (i = 0; i < HIST_SIZE; i++)
-        av_freep(&s->histogram[i].entries);
+    tables_free(s);
     av_freep(&s->refs);
     av_frame_free(&s->prev_frame);
 }
@@ -555,6 +704,7 @@ static const AVFilterPad palettegen_inputs[] = {
     {
         .name         = "default",
         .type         = AVMEDIA_TYPE_VIDEO,
+        .config_props = config_input,
         .filter_frame = filter_frame,
     },
     { NULL }
@@ -579,4 +729,5 @@ AVFilter ff_vf_palettegen = {
     .inputs        = palettegen_inputs,
     .outputs       = palettegen_outputs,
     .priv_class    = &palettegen_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -986,6 +986,7 @@ AVFilter ff_vf_scale = {
     .inputs          = avfilter_vf_scale_inputs,
     .outputs         = avfilter_vf_scale_outputs,
     .process_command = process_command,
+    .flags_internal  = FF_FILTER_FLAG_FORMAT_CONVERSION,
 };
 
 static const AVClass scale2ref_class = {
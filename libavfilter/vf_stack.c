@@ -37,6 +37,25 @@ typedef struct StackItem {
     int height[4];
 } StackItem;
 
+/* Maximum number of output frames waiting for the inputs to be drawn in */
+#define MAX_CANVASES 8
+
+/* Same alignment as the buffers of ff_get_video_buffer() */
+#define VIEW_ALIGN 32
+
+/**
+ * Output frame the inputs are directly drawn into: each input is given a
+ * view of its area of the frame as its buffer.
+ */
+typedef struct StackCanvas {
+    AVFrame *frame;
+    /**
+     * By input and plane, a reference to a buffer held by the view given to
+     * the input until it is freed, NULL if none was given yet.
+     */
+    AVBufferRef **views;
+} StackCanvas;
+
 typedef struct StackContext {
     const AVClass *class;
     const AVPixFmtDescriptor *desc;
@@ -56,6 +75,11 @@ typedef struct StackContext {
     StackItem *items;
     AVFrame **frames;
     FFFrameSync fs;
+
+    int zero_copy;              ///< whether the inputs can draw into the output
+    StackCanvas canvases[MAX_CANVASES];
+    int nb_canvases;
+    uint8_t *copy;              ///< inputs to copy into the output frame
 } StackContext;
 
 static int query_formats(AVFilterContext *ctx)
@@ -77,6 +101,120 @@ static int query_formats(AVFilterContext *ctx)
     return ff_set_common_formats(ctx, formats);
 }
 
+static void remove_canvas(StackContext *s, int n)
+{
+    StackCanvas *c = &s->canvases[n];
+
+    for (int i = 0; i < s->nb_inputs * 4; i++)
+        av_buffer_unref(&c->views[i]);
+    av_freep(&c->views);
+    av_frame_free(&c->frame);
+
+    memmove(c, c + 1, (s->nb_canvases - n - 1) * sizeof(*c));
+    s->nb_canvases--;
+}
+
+static uint8_t *view_data(StackContext *s, StackCanvas *c, int i, int p)
+{
+    return c->frame->data[p] + s->items[i].y[p] * c->frame->linesize[p] + s->items[i].x[p];
+}
+
+static void release_buffer(void *opaque, uint8_t *data)
+{
+    AVBufferRef *buf = opaque;
+
+    av_buffer_unref(&buf);
+}
+
+/**
+ * Give the input a view of its area of an output frame, so that nothing
+ * has to be copied if the frame it sends is drawn there.
+ */
+static AVFrame *get_video_buffer(AVFilterLink *inlink, int w, int h)
+{
+    AVFilterContext *ctx = inlink->dst;
+    AVFilterLink *outlink = ctx->outputs[0];
+    StackContext *s = ctx->priv;
+    const int i = FF_INLINK_IDX(inlink);
+    AVBufferRef *views[4] = { NULL };
+    StackCanvas *c = NULL;
+    AVFrame *frame;
+
+    if (!s->zero_copy || w != inlink->w || h != inlink->h)
+        return ff_default_get_video_buffer(inlink, w, h);
+
+    /* Each input draws its frames into the canvases in turn */
+    for (int n = 0; n < s->nb_canvases && !c; n++)
+        if (!s->canvases[n].views[i * 4])
+            c = &s->canvases[n];
+
+    if (!c) {
+        /* Inputs far ahead of the others get the oldest canvas copied */
+        if (s->nb_canvases == MAX_CANVASES)
+            remove_canvas(s, 0);
+
+        c = &s->canvases[s->nb_canvases];
+        c->views = av_calloc(s->nb_inputs * 4, sizeof(*c->views));
+        c->frame = ff_get_video_buffer(outlink, outlink->w, outlink->h);
+        if (!c->views || !c->frame) {
+            av_freep(&c->views);
+            av_frame_free(&c->frame);
+            return NULL;
+        }
+        s->nb_canvases++;
+
+        if (s->fillcolor_enable)
+            ff_fill_rectangle(&s->draw, &s->color, c->frame->data, c->frame->linesize,
+                              0, 0, outlink->w, outlink->h);
+    }
+
+    frame = av_frame_alloc();
+    if (!frame)
+        return NULL;
+
+    frame->format = inlink->format;
+    frame->width  = w;
+    frame->height = h;
+    frame->sample_aspect_ratio = inlink->sample_aspect_ratio;
+
+    /* The buffers of the view only reference the canvas through views[],
+     * so that the frame stays writable while the canvas can tell if it is
+     * still used. */
+    for (int p = 0; p < s->nb_planes; p++) {
+        AVBufferRef *buf = av_frame_get_plane_buffer(c->frame, p);
+        uint8_t *data = view_data(s, c, i, p);
+        AVBufferRef *ref = av_buffer_ref(buf);
+
+        if (!ref)
+            goto fail;
+        views[p] = av_buffer_create(NULL, 0, release_buffer, ref, 0);
+        if (!views[p]) {
+            av_buffer_unref(&ref);
+            goto fail;
+        }
+
+        if (!(ref = av_buffer_ref(views[p])))
+            goto fail;
+        frame->buf[p] = av_buffer_create(data, buf->data + buf->size - data,
+                                         release_buffer, ref, 0);
+        if (!frame->buf[p]) {
+            av_buffer_unref(&ref);
+            goto fail;
+        }
+        frame->data[p]     = data;
+        frame->linesize[p] = c->frame->linesize[p];
+    }
+
+    memcpy(&c->views[i * 4], views, sizeof(views));
+
+    return frame;
+fail:
+    for (int p = 0; p < 4; p++)
+        av_buffer_unref(&views[p]);
+    av_frame_free(&frame);
+    return NULL;
+}
+
 static av_cold int init(AVFilterContext *ctx)
 {
     StackContext *s = ctx->priv;
@@ -96,6 +234,10 @@ static av_cold int init(AVFilterContext *ctx)
     if (!s->items)
         return AVERROR(ENOMEM);
 
+    s->copy = av_calloc(s->nb_inputs, sizeof(*s->copy));
+    if (!s->copy)
+        return AVERROR(ENOMEM);
+
     if (!strcmp(ctx->filter->name, "xstack")) {
         if (strcmp(s->fillcolor_str, "none") &&
             av_parse_color(s->fillcolor, s->fillcolor_str, -1, ctx) >= 0) {
@@ -119,6 +261,7 @@ static av_cold int init(AVFilterContext *ctx)
         AVFilterPad pad = { 0 };
 
         pad.type = AVMEDIA_TYPE_VIDEO;
+        pad.get_video_buffer = get_video_buffer;
         pad.name = av_asprintf("input%d", i);
         if (!pad.name)
             return AVERROR(ENOMEM);
@@ -143,6 +286,9 @@ static int process_slice(AVFilterContext *ctx, void *arg, int job, int nb_jobs)
     for (int i = start; i < end; i++) {
         StackItem *item = &s->items[i];
 
+        if (!s->copy[i])
+            continue;
+
         for (int p = 0; p < s->nb_planes; p++) {
             av_image_copy_plane(out->data[p] + out->linesize[p] * item->y[p] + item->x[p],
                                 out->linesize[p],
@@ -155,6 +301,47 @@ static int process_slice(AVFilterContext *ctx, void *arg, int job, int nb_jobs)
     return 0;
 }
 
+/**
+ * Find a canvas some inputs were drawn into, where the others can be
+ * copied without overwriting a view still in use.
+ *
+ * @return the index of the canvas, or a negative value if there is none
+ */
+static int find_canvas(StackContext *s)
+{
+    AVFrame **in = s->frames;
+
+    for (int n = 0; n < s->nb_canvases; n++) {
+        StackCanvas *c = &s->canvases[n];
+        int in_place = 0, i;
+
+        for (i = 0; i < s->nb_inputs; i++) {
+            int p;
+
+            for (p = 0; p < s->nb_planes; p++)
+                if (in[i]->data[p] != view_data(s, c, i, p) ||
+                    in[i]->linesize[p] != c->frame->linesize[p])
+                    break;
+            s->copy[i] = p < s->nb_planes;
+            in_place  += !s->copy[i];
+
+            if (s->copy[i]) {
+                for (p = 0; p < s->nb_planes; p++)
+                    if (c->views[i * 4 + p] &&
+                        av_buffer_get_ref_count(c->views[i * 4 + p]) > 1)
+                        break;
+                if (p < s->nb_planes)
+                    break;
+            }
+        }
+
+        if (i == s->nb_inputs && in_place)
+            return n;
+    }
+
+    return -1;
+}
+
 static int process_frame(FFFrameSync *fs)
 {
     AVFilterContext *ctx = fs->parent;
@@ -162,28 +349,72 @@ static int process_frame(FFFrameSync *fs)
     StackContext *s = fs->opaque;
     AVFrame **in = s->frames;
     AVFrame *out;
-    int i, ret;
+    int i, n, ret;
 
     for (i = 0; i < s->nb_inputs; i++) {
         if ((ret = ff_framesync_get_frame(&s->fs, i, &in[i], 0)) < 0)
             return ret;
     }
 
-    out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
-    if (!out)
-        return AVERROR(ENOMEM);
+    if ((n = find_canvas(s)) >= 0) {
+        out = av_frame_clone(s->canvases[n].frame);
+        remove_canvas(s, n);
+        if (!out)
+            return AVERROR(ENOMEM);
+    } else {
+        out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
+        if (!out)
+            return AVERROR(ENOMEM);
+
+        if (s->fillcolor_enable)
+            ff_fill_rectangle(&s->draw, &s->color, out->data, out->linesize,
+                              0, 0, outlink->w, outlink->h);
+        memset(s->copy, 1, s->nb_inputs);
+    }
     out->pts = av_rescale_q(s->fs.pts, s->fs.time_base, outlink->time_base);
     out->sample_aspect_ratio = outlink->sample_aspect_ratio;
 
-    if (s->fillcolor_enable)
-        ff_fill_rectangle(&s->draw, &s->color, out->data, out->linesize,
-                          0, 0, outlink->w, outlink->h);
-
     ctx->internal->execute(ctx, process_slice, out, NULL, FFMIN(s->nb_inputs, ff_filter_get_nb_threads(ctx)));
 
     return ff_filter_frame(outlink, out);
 }
 
+/* The inputs can only draw into the output if their areas are disjoint
+ * and keep the alignment of the buffers */
+static int can_share_output(StackContext *s, enum AVPixelFormat format, int width)
+{
+    int out_linesize[4];
+
+    if (av_image_fill_linesizes(out_linesize, format, width) < 0)
+        return 0;
+
+    for (int i = 0; i < s->nb_inputs; i++) {
+        const StackItem *a = &s->items[i];
+
+        for (int p = 0; p < s->nb_planes; p++) {
+            if (a->x[p] % VIEW_ALIGN)
+                return 0;
+            /* Filters may write their lines up to the alignment, which
+             * must not reach into what is drawn on their right */
+            if (a->linesize[p] % VIEW_ALIGN &&
+                a->x[p] + a->linesize[p] < out_linesize[p])
+                return 0;
+        }
+
+        /* Rounded up chroma sizes can overlap where the luma does not */
+        for (int j = 0; j < i; j++) {
+            const StackItem *b = &s->items[j];
+
+            for (int p = 0; p < s->nb_planes; p++)
+                if (a->x[p] < b->x[p] + b->linesize[p] && b->x[p] < a->x[p] + a->linesize[p] &&
+                    a->y[p] < b->y[p] + b->height[p]   && b->y[p] < a->y[p] + a->height[p])
+                    return 0;
+        }
+    }
+
+    return 1;
+}
+
 static int config_output(AVFilterLink *outlink)
 {
     AVFilterContext *ctx = outlink->src;
@@ -330,6 +561,10 @@ static int config_output(AVFilterLink *outlink)
 
     s->nb_planes = av_pix_fmt_count_planes(outlink->format);
 
+    while (s->nb_canvases)
+        remove_canvas(s, 0);
+    s->zero_copy = can_share_output(s, outlink->format, width);
+
     outlink->w          = width;
     outlink->h          = height;
     outlink->frame_rate = frame_rate;
@@ -374,8 +609,11 @@ static av_cold void uninit(AVFilterContext *ctx)
     int i;
 
     ff_framesync_uninit(&s->fs);
+    while (s->nb_canvases)
+        remove_canvas(s, 0);
     av_freep(&s->frames);
     av_freep(&s->items);
+    av_freep(&s->copy);
 
     for (i = 0; i < ctx->nb_inputs; i++)
         av_freep(&ctx->input_pads[i].name);
@@ -36,6 +36,7 @@
 #endif
 #include "libavutil/avstring.h"
 #include "libavutil/imgutils.h"
+#include "libavutil/intreadwrite.h"
 #include "libavutil/opt.h"
 #include "libavutil/parseutils.h"
 #include "drawutils.h"
@@ -60,6 +61,10 @@ typedef struct AssContext {
     int original_w, original_h;
     int shaping;
     FFDrawContext draw;
+    AVFrame *overlay[2];       ///< premultiplied colors and transparency of the rendered subtitles
+    int overlay_x, overlay_y;  ///< position of the area covered by the subtitles
+    int overlay_w, overlay_h;  ///< size of the area covered by the subtitles
+    int rendered;              ///< whether the overlay holds the last rendered subtitles
 } AssContext;
 
 #define OFFSET(x) offsetof(AssContext, x)
@@ -131,6 +136,9 @@ static av_cold void uninit(AVFilterContext *ctx)
         ass_renderer_done(ass->renderer);
     if (ass->library)
         ass_library_done(ass->library);
+
+    av_frame_free(&ass->overlay[0]);
+    av_frame_free(&ass->overlay[1]);
 }
 
 static int query_formats(AVFilterContext *ctx)
@@ -144,6 +152,13 @@ static int config_input(AVFilterLink *inlink)
 
     ff_draw_init(&ass->draw, inlink->format, ass->alpha ? FF_DRAW_PROCESS_ALPHA : 0);
 
+    for (int i = 0; i < 2; i++) {
+        av_frame_free(&ass->overlay[i]);
+        if (!(ass->overlay[i] = ff_get_video_buffer(inlink, inlink->w, inlink->h)))
+            return AVERROR(ENOMEM);
+    }
+    ass->rendered = 0;
+
     ass_set_frame_size  (ass->renderer, inlink->w, inlink->h);
     if (ass->original_w && ass->original_h)
         ass_set_aspect_ratio(ass->renderer, (double)inlink->w / inlink->h,
@@ -160,19 +175,149 @@ static int config_input(AVFilterLink *inlink)
 #define AB(c)  (((c)>>8) &0xFF)
 #define AA(c)  ((0xFF-(c)) &0xFF)
 
-static void overlay_ass_image(AssContext *ass, AVFrame *picref,
-                              const ASS_Image *image)
+typedef struct ThreadData {
+    AVFrame *frame;
+    const ASS_Image *image;
+} ThreadData;
+
+/* Rows of the overlay handled by a slice, as even as the subsampling requires */
+static void slice_rows(AssContext *ass, int jobnr, int nb_jobs, int *start, int *end)
+{
+    const int align = 1 << ass->draw.vsub_max;
+    const int nb_rows = (ass->overlay_h + align - 1) / align;
+
+    *start = ass->overlay_y + (nb_rows *  jobnr)    / nb_jobs * align;
+    *end   = FFMIN(ass->overlay_y + (nb_rows * (jobnr+1)) / nb_jobs * align,
+                   ass->overlay_y + ass->overlay_h);
+}
+
+/**
+ * Render the images of libass into the overlay: their colors are blended
+ * into the premultiplied colors and their masks alone into the transparency.
+ */
+static int render_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    for (; image; image = image->next) {
+    AssContext *ass = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *color = ass->overlay[0], *transp = ass->overlay[1];
+    const int depth = ass->draw.desc->comp[0].depth;
+    const int max = (1 << depth) - 1;
+    uint8_t *color_data[4] = { NULL }, *transp_data[4] = { NULL };
+    int start, end;
+
+    slice_rows(ass, jobnr, nb_jobs, &start, &end);
+
+    for (int plane = 0; plane < ass->draw.nb_planes; plane++) {
+        const int hsub = ass->draw.hsub[plane], vsub = ass->draw.vsub[plane];
+        const int size = ((ass->overlay_w + (1 << hsub) - 1) >> hsub) * ass->draw.pixelstep[plane];
+        const int x = (ass->overlay_x >> hsub) * ass->draw.pixelstep[plane];
+
+        for (int y = start >> vsub; y < (end + (1 << vsub) - 1) >> vsub; y++) {
+            uint8_t *c = color->data[plane]  + y * color->linesize[plane]  + x;
+            uint8_t *t = transp->data[plane] + y * transp->linesize[plane] + x;
+
+            memset(c, 0, size);
+            if (depth <= 8) {
+                memset(t, max, size);
+            } else {
+                for (int i = 0; i < size; i += 2)
+                    AV_WL16(t + i, max);
+            }
+        }
+
+        /* Every slice blends into its own rows, as a smaller image */
+        color_data[plane]  = color->data[plane]  + (start >> vsub) * color->linesize[plane];
+        transp_data[plane] = transp->data[plane] + (start >> vsub) * transp->linesize[plane];
+    }
+
+    for (const ASS_Image *image = td->image; image; image = image->next) {
         uint8_t rgba_color[] = {AR(image->color), AG(image->color), AB(image->color), AA(image->color)};
+        FFDrawColor opaque = { .rgba = { 0, 0, 0, AA(image->color) } };
         FFDrawColor color;
+
         ff_draw_color(&ass->draw, &color, rgba_color);
         ff_blend_mask(&ass->draw, &color,
-                      picref->data, picref->linesize,
-                      picref->width, picref->height,
+                      color_data, ass->overlay[0]->linesize,
+                      td->frame->width, end - start,
                       image->bitmap, image->stride, image->w, image->h,
-                      3, 0, image->dst_x, image->dst_y);
+                      3, 0, image->dst_x, image->dst_y - start);
+        ff_blend_mask(&ass->draw, &opaque,
+                      transp_data, ass->overlay[1]->linesize,
+                      td->frame->width, end - start,
+                      image->bitmap, image->stride, image->w, image->h,
+                      3, 0, image->dst_x, image->dst_y - start);
+    }
+
+    return 0;
+}
+
+static int blend_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AssContext *ass = ctx->priv;
+    ThreadData *td = arg;
+    int start, end;
+
+    slice_rows(ass, jobnr, nb_jobs, &start, &end);
+
+    ff_blend_overlay(&ass->draw, td->frame->data, td->frame->linesize,
+                     ass->overlay[0]->data, ass->overlay[0]->linesize,
+                     ass->overlay[1]->data, ass->overlay[1]->linesize,
+                     ass->overlay_x, start, ass->overlay_w, end - start);
+
+    return 0;
+}
+
+static void overlay_ass_image(AVFilterContext *ctx, AVFrame *picref,
+                              const ASS_Image *image, int changed)
+{
+    AssContext *ass = ctx->priv;
+    ThreadData td = { picref, image };
+    int nb_jobs;
+
+    /* The images are only rendered again when libass reports a change,
+     * the overlay is blended into every frame */
+    if (changed || !ass->rendered) {
+        const int hmask = (1 << ass->draw.hsub_max) - 1;
+        const int vmask = (1 << ass->draw.vsub_max) - 1;
+        int x0, y0, x1, y1;
+
+        ass->overlay_w = ass->overlay_h = 0;
+        ass->rendered  = 0;
+        if (!image)
+            return;
+
+        x0 = image->dst_x;
+        y0 = image->dst_y;
+        x1 = image->dst_x + image->w;
+        y1 = image->dst_y + image->h;
+        for (image = image->next; image; image = image->next) {
+            x0 = FFMIN(x0, image->dst_x);
+            y0 = FFMIN(y0, image->dst_y);
+            x1 = FFMAX(x1, image->dst_x + image->w);
+            y1 = FFMAX(y1, image->dst_y + image->h);
+        }
+        x0 = FFMAX(x0, 0) & ~hmask;
+        y0 = FFMAX(y0, 0) & ~vmask;
+        x1 = FFMIN(x1, picref->width);
+        y1 = FFMIN(y1, picref->height);
+
+        ass->overlay_x = x0;
+        ass->overlay_y = y0;
+        ass->overlay_w = FFMAX(x1 - x0, 0);
+        ass->overlay_h = FFMAX(y1 - y0, 0);
+    }
+
+    if (!ass->overlay_w || !ass->overlay_h)
+        return;
+
+    nb_jobs = (ass->overlay_h + (1 << ass->draw.vsub_max) - 1) >> ass->draw.vsub_max;
+    nb_jobs = FFMIN(nb_jobs, ff_filter_get_nb_threads(ctx));
+
+    if (!ass->rendered) {
+        ctx->internal->execute(ctx, render_slice, &td, NULL, nb_jobs);
+        ass->rendered = 1;
     }
+    ctx->internal->execute(ctx, blend_slice, &td, NULL, nb_jobs);
 }
 
 static int filter_frame(AVFilterLink *inlink, AVFrame *picref)
@@ -188,7 +333,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *picref)
     if (detect_change)
         av_log(ctx, AV_LOG_DEBUG, "Change happened at time ms:%f\n", time_ms);
 
-    overlay_ass_image(ass, picref, image);
+    overlay_ass_image(ctx, picref, image, detect_change);
 
     return ff_filter_frame(outlink, picref);
 }
@@ -256,6 +401,7 @@ AVFilter ff_vf_ass = {
     .inputs        = ass_inputs,
     .outputs       = ass_outputs,
     .priv_class    = &ass_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
 #endif
 
@@ -490,5 +636,6 @@ AVFilter ff_vf_subtitles = {
     .inputs        = ass_inputs,
     .outputs       = ass_outputs,
     .priv_class    = &subtitles_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
 #endif
@@ -50,6 +50,20 @@ enum TonemapAlgorithm {
     TONEMAP_MAX,
 };
 
+#define LUT_SIZE    4096
+#define CHUNK_WIDTH 64
+
+#define ST2084_MAX_LUMINANCE 10000.0
+#define ST2084_M1 0.1593017578125
+#define ST2084_M2 78.84375
+#define ST2084_C1 0.8359375
+#define ST2084_C2 18.8515625
+#define ST2084_C3 18.6875
+
+#define HLG_A 0.17883277
+#define HLG_B 0.28466892
+#define HLG_C 0.55991073
+
 static const struct LumaCoefficients luma_coefficients[AVCOL_SPC_NB] = {
     [AVCOL_SPC_FCC]        = { 0.30,   0.59,   0.11   },
     [AVCOL_SPC_BT470BG]    = { 0.299,  0.587,  0.114  },
@@ -67,8 +81,18 @@ typedef struct TonemapContext {
     double param;
     double desat;
     double peak;
+    enum AVPixelFormat format;
 
     const struct LumaCoefficients *coeffs;
+
+    /* state of the LUT based path for YUV input */
+    enum AVColorTransferCharacteristic lut_trc;
+    double lut_peak;
+    float lin_lut[LUT_SIZE];
+    float curve_lut[LUT_SIZE];
+    float delin_lut[LUT_SIZE];
+    float yuv2rgb[3][3];
+    float rgb2yuv[3][3];
 } TonemapContext;
 
 static const enum AVPixelFormat pix_fmts[] = {
@@ -77,9 +101,43 @@ static const enum AVPixelFormat pix_fmts[] = {
     AV_PIX_FMT_NONE,
 };
 
+static const enum AVPixelFormat yuv_in_pix_fmts[] = {
+    AV_PIX_FMT_YUV420P10,
+    AV_PIX_FMT_P010,
+    AV_PIX_FMT_NONE,
+};
+
+static const enum AVPixelFormat yuv_out_pix_fmts[] = {
+    AV_PIX_FMT_YUV420P,
+    AV_PIX_FMT_NV12,
+    AV_PIX_FMT_YUV420P10,
+    AV_PIX_FMT_P010,
+    AV_PIX_FMT_NONE,
+};
+
 static int query_formats(AVFilterContext *ctx)
 {
-    return ff_set_common_formats(ctx, ff_make_format_list(pix_fmts));
+    TonemapContext *s = ctx->priv;
+    enum AVPixelFormat out_pix_fmts[] = { s->format, AV_PIX_FMT_NONE };
+    int ret;
+
+    if (s->format == AV_PIX_FMT_NONE)
+        return ff_set_common_formats(ctx, ff_make_format_list(pix_fmts));
+
+    ret = ff_formats_ref(ff_make_format_list(yuv_in_pix_fmts),
+                         &ctx->inputs[0]->outcfg.formats);
+    if (ret < 0)
+        return ret;
+
+    return ff_formats_ref(ff_make_format_list(out_pix_fmts),
+                          &ctx->outputs[0]->incfg.formats);
+}
+
+static int is_yuv_format(enum AVPixelFormat fmt)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(fmt);
+
+    return !(desc->flags & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_FLOAT));
 }
 
 static av_cold int init(AVFilterContext *ctx)
@@ -104,6 +162,21 @@ static av_cold int init(AVFilterContext *ctx)
     if (isnan(s->param))
         s->param = 1.0f;
 
+    if (s->format != AV_PIX_FMT_NONE) {
+        int i;
+
+        for (i = 0; yuv_out_pix_fmts[i] != AV_PIX_FMT_NONE; i++)
+            if (yuv_out_pix_fmts[i] == s->format)
+                break;
+        if (yuv_out_pix_fmts[i] == AV_PIX_FMT_NONE) {
+            av_log(ctx, AV_LOG_ERROR, "Unsupported output format '%s'\n",
+                   av_get_pix_fmt_name(s->format));
+            return AVERROR(EINVAL);
+        }
+    }
+
+    s->lut_trc = AVCOL_TRC_RESERVED;
+
     return 0;
 }
 
@@ -126,6 +199,37 @@ static float mobius(float in, float j, double peak)
     return (b * b + 2.0f * b * j + j * j) / (b - a) * (in + a) / (in + b);
 }
 
+static float map_signal(TonemapContext *s, float sig, double peak)
+{
+    switch(s->tonemap) {
+    default:
+    case TONEMAP_NONE:
+        // do nothing
+        break;
+    case TONEMAP_LINEAR:
+        sig = sig * s->param / peak;
+        break;
+    case TONEMAP_GAMMA:
+        sig = sig > 0.05f ? pow(sig / peak, 1.0f / s->param)
+                          : sig * pow(0.05f / peak, 1.0f / s->param) / 0.05f;
+        break;
+    case TONEMAP_CLIP:
+        sig = av_clipf(sig * s->param, 0, 1.0f);
+        break;
+    case TONEMAP_HABLE:
+        sig = hable(sig) / hable(peak);
+        break;
+    case TONEMAP_REINHARD:
+        sig = sig / (sig + s->param) * (peak + s->param) / peak;
+        break;
+    case TONEMAP_MOBIUS:
+        sig = mobius(sig, s->param, peak);
+        break;
+    }
+
+    return sig;
+}
+
 #define MIX(x,y,a) (x) * (1 - (a)) + (y) * (a)
 static void tonemap(TonemapContext *s, AVFrame *out, const AVFrame *in,
                     const AVPixFmtDescriptor *desc, int x, int y, double peak)
@@ -158,31 +262,7 @@ static void tonemap(TonemapContext *s, AVFrame *out, const AVFrame *in,
     sig = FFMAX(FFMAX3(*r_out, *g_out, *b_out), 1e-6);
     sig_orig = sig;
 
-    switch(s->tonemap) {
-    default:
-    case TONEMAP_NONE:
-        // do nothing
-        break;
-    case TONEMAP_LINEAR:
-        sig = sig * s->param / peak;
-        break;
-    case TONEMAP_GAMMA:
-        sig = sig > 0.05f ? pow(sig / peak, 1.0f / s->param)
-                          : sig * pow(0.05f / peak, 1.0f / s->param) / 0.05f;
-        break;
-    case TONEMAP_CLIP:
-        sig = av_clipf(sig * s->param, 0, 1.0f);
-        break;
-    case TONEMAP_HABLE:
-        sig = hable(sig) / hable(peak);
-        break;
-    case TONEMAP_REINHARD:
-        sig = sig / (sig + s->param) * (peak + s->param) / peak;
-        break;
-    case TONEMAP_MOBIUS:
-        sig = mobius(sig, s->param, peak);
-        break;
-    }
+    sig = map_signal(s, sig, peak);
 
     /* apply the computed scale factor to the color,
      * linearly to prevent discoloration */
@@ -193,7 +273,7 @@ static void tonemap(TonemapContext *s, AVFrame *out, const AVFrame *in,
 
 typedef struct ThreadData {
     AVFrame *in, *out;
-    const AVPixFmtDescriptor *desc;
+    const AVPixFmtDescriptor *desc, *odesc;
     double peak;
 } ThreadData;
 
@@ -215,6 +295,219 @@ static int tonemap_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs
     return 0;
 }
 
+static double eotf_st2084(double x)
+{
+    double p = pow(x, 1.0 / ST2084_M2);
+    double a = FFMAX(p - ST2084_C1, 0.0);
+    double b = FFMAX(ST2084_C2 - ST2084_C3 * p, 1e-6);
+    double c = pow(a / b, 1.0 / ST2084_M1);
+    return x > 0.0 ? c * ST2084_MAX_LUMINANCE / REFERENCE_WHITE : 0.0;
+}
+
+static double inverse_oetf_hlg(double x)
+{
+    return x < 0.5 ? 4.0 * x * x : exp((x - HLG_C) / HLG_A) + HLG_B;
+}
+
+/*
+ * All LUTs are indexed by a value in [0, 1]. The linearization LUT takes the
+ * non-linear R'G'B' signal, while the curve and delinearization LUTs take the
+ * square root of a (normalized) linear value, which spends most of the
+ * entries on the dark end where the output transfers are steepest.
+ */
+static void update_luts(TonemapContext *s, enum AVColorTransferCharacteristic trc,
+                        double peak)
+{
+    if (s->lut_trc == trc && s->lut_peak == peak)
+        return;
+
+    for (int i = 0; i < LUT_SIZE; i++) {
+        double x = i / (double)(LUT_SIZE - 1);
+        float sig = FFMAX(x * x * peak, 1e-6);
+
+        if (trc == AVCOL_TRC_ARIB_STD_B67)
+            s->lin_lut[i] = inverse_oetf_hlg(x) / 12.0 * peak;
+        else
+            s->lin_lut[i] = eotf_st2084(x);
+        s->curve_lut[i] = map_signal(s, sig, peak) / sig;
+        s->delin_lut[i] = pow(x * x, 1.0 / 2.4);
+    }
+
+    s->lut_trc  = trc;
+    s->lut_peak = peak;
+}
+
+static void update_matrices(TonemapContext *s, const struct LumaCoefficients *coeffs)
+{
+    double rgb2yuv[3][3], yuv2rgb[3][3];
+
+    ff_fill_rgb2yuv_table(coeffs, rgb2yuv);
+    ff_matrix_invert_3x3(rgb2yuv, yuv2rgb);
+
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            s->rgb2yuv[i][j] = rgb2yuv[i][j];
+            s->yuv2rgb[i][j] = yuv2rgb[i][j];
+        }
+    }
+}
+
+static av_always_inline int lut_index(float x)
+{
+    return av_clipf(x, 0.0f, 1.0f) * (LUT_SIZE - 1) + 0.5f;
+}
+
+static av_always_inline int read_comp(const AVFrame *frame, const AVPixFmtDescriptor *desc,
+                                      int c, int x, int y)
+{
+    const AVComponentDescriptor *comp = &desc->comp[c];
+    const uint8_t *p = frame->data[comp->plane] + y * frame->linesize[comp->plane] +
+                       comp->offset + x * comp->step;
+
+    return AV_RN16(p) >> comp->shift;
+}
+
+static av_always_inline void write_comp(AVFrame *frame, const AVPixFmtDescriptor *desc,
+                                        int c, int x, int y, int v)
+{
+    const AVComponentDescriptor *comp = &desc->comp[c];
+    uint8_t *p = frame->data[comp->plane] + y * frame->linesize[comp->plane] +
+                 comp->offset + x * comp->step;
+
+    if (comp->depth > 8)
+        AV_WN16(p, v << comp->shift);
+    else
+        *p = v;
+}
+
+/*
+ * Tone map 4:2:0 input directly, without a round trip through float RGB.
+ * Each slice job handles full chroma rows (two luma rows), split into chunks
+ * that are processed stage by stage so that the arithmetic stages vectorize.
+ */
+static int tonemap_yuv_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    TonemapContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const AVFrame *in = td->in;
+    AVFrame *out = td->out;
+    const AVPixFmtDescriptor *desc = td->desc;
+    const AVPixFmtDescriptor *odesc = td->odesc;
+    const int full_range = in->color_range == AVCOL_RANGE_JPEG;
+    const int depth  = desc->comp[0].depth;
+    const int odepth = odesc->comp[0].depth;
+    const int out_max = (1 << odepth) - 1;
+    const float in_yoff  = full_range ? 0 : 16 << (depth - 8);
+    const float in_coff  = 1 << (depth - 1);
+    const float in_ymul  = 1.0f / (full_range ? (1 << depth) - 1 : 219 << (depth - 8));
+    const float in_cmul  = 1.0f / (full_range ? (1 << depth) - 1 : 224 << (depth - 8));
+    const float out_yoff = full_range ? 0.5f : (16 << (odepth - 8)) + 0.5f;
+    const float out_coff = (1 << (odepth - 1)) + 0.5f;
+    const float out_ymul = full_range ? out_max : 219 << (odepth - 8);
+    const float out_cmul = full_range ? out_max : 224 << (odepth - 8);
+    const float inv_peak = 1.0f / td->peak;
+    const float desat = s->desat;
+    const float cr = s->coeffs->cr, cg = s->coeffs->cg, cb = s->coeffs->cb;
+    const float (*m)[3]  = s->yuv2rgb;
+    const float (*mo)[3] = s->rgb2yuv;
+    const int width  = in->width;
+    const int height = in->height;
+    const int cheight = AV_CEIL_RSHIFT(height, 1);
+    const int slice_start = (cheight * jobnr) / nb_jobs;
+    const int slice_end = (cheight * (jobnr+1)) / nb_jobs;
+    float rgb[3][CHUNK_WIDTH], sum[3][CHUNK_WIDTH / 2];
+    float *r = rgb[0], *g = rgb[1], *b = rgb[2];
+
+    for (int cy = slice_start; cy < slice_end; cy++) {
+        for (int x0 = 0; x0 < width; x0 += CHUNK_WIDTH) {
+            const int n  = FFMIN(CHUNK_WIDTH, width - x0);
+            const int cn = (n + 1) >> 1;
+
+            memset(sum, 0, sizeof(sum));
+
+            for (int row = 0; row < 2; row++) {
+                const int y = FFMIN(2 * cy + row, height - 1);
+
+                /* convert to non-linear R'G'B' */
+                for (int i = 0; i < n; i++) {
+                    const int cx = (x0 + i) >> 1;
+                    float yv = (read_comp(in, desc, 0, x0 + i, y) - in_yoff) * in_ymul;
+                    float uv = (read_comp(in, desc, 1, cx, cy)    - in_coff) * in_cmul;
+                    float vv = (read_comp(in, desc, 2, cx, cy)    - in_coff) * in_cmul;
+
+                    r[i] = m[0][0] * yv + m[0][1] * uv + m[0][2] * vv;
+                    g[i] = m[1][0] * yv + m[1][1] * uv + m[1][2] * vv;
+                    b[i] = m[2][0] * yv + m[2][1] * uv + m[2][2] * vv;
+                }
+
+                /* linearize */
+                for (int i = 0; i < n; i++) {
+                    r[i] = s->lin_lut[lut_index(r[i])];
+                    g[i] = s->lin_lut[lut_index(g[i])];
+                    b[i] = s->lin_lut[lut_index(b[i])];
+                }
+
+                /* desaturate overbrights */
+                if (desat > 0) {
+                    for (int i = 0; i < n; i++) {
+                        float luma = cr * r[i] + cg * g[i] + cb * b[i];
+                        float overbright = FFMAX(luma - desat, 1e-6) / FFMAX(luma, 1e-6);
+                        r[i] = MIX(r[i], luma, overbright);
+                        g[i] = MIX(g[i], luma, overbright);
+                        b[i] = MIX(b[i], luma, overbright);
+                    }
+                }
+
+                /* tone map the brightest component */
+                for (int i = 0; i < n; i++) {
+                    float sig = FFMAX3(r[i], g[i], b[i]);
+                    float scale = s->curve_lut[lut_index(sqrtf(FFMAX(sig, 0.0f) * inv_peak))];
+
+                    r[i] *= scale;
+                    g[i] *= scale;
+                    b[i] *= scale;
+                }
+
+                /* delinearize */
+                for (int i = 0; i < n; i++) {
+                    r[i] = s->delin_lut[lut_index(sqrtf(FFMAX(r[i], 0.0f)))];
+                    g[i] = s->delin_lut[lut_index(sqrtf(FFMAX(g[i], 0.0f)))];
+                    b[i] = s->delin_lut[lut_index(sqrtf(FFMAX(b[i], 0.0f)))];
+                }
+
+                if (2 * cy + row < height) {
+                    for (int i = 0; i < n; i++) {
+                        float yv = mo[0][0] * r[i] + mo[0][1] * g[i] + mo[0][2] * b[i];
+                        write_comp(out, odesc, 0, x0 + i, y,
+                                   av_clip(out_yoff + yv * out_ymul, 0, out_max));
+                    }
+                }
+
+                for (int i = 0; i < n; i++) {
+                    sum[0][i >> 1] += r[i];
+                    sum[1][i >> 1] += g[i];
+                    sum[2][i >> 1] += b[i];
+                }
+            }
+
+            /* subsample chroma by averaging the R'G'B' of each 2x2 block */
+            for (int i = 0; i < cn; i++) {
+                const float w = 2 * i + 1 < n ? 0.25f : 0.5f;
+                float rv = sum[0][i] * w, gv = sum[1][i] * w, bv = sum[2][i] * w;
+                float uv = mo[1][0] * rv + mo[1][1] * gv + mo[1][2] * bv;
+                float vv = mo[2][0] * rv + mo[2][1] * gv + mo[2][2] * bv;
+
+                write_comp(out, odesc, 1, (x0 >> 1) + i, cy,
+                           av_clip(out_coff + uv * out_cmul, 0, out_max));
+                write_comp(out, odesc, 2, (x0 >> 1) + i, cy,
+                           av_clip(out_coff + vv * out_cmul, 0, out_max));
+            }
+        }
+    }
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *link, AVFrame *in)
 {
     AVFilterContext *ctx = link->dst;
@@ -224,6 +517,8 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
     AVFrame *out;
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(link->format);
     const AVPixFmtDescriptor *odesc = av_pix_fmt_desc_get(outlink->format);
+    const int yuv = is_yuv_format(link->format);
+    enum AVColorTransferCharacteristic trc;
     int ret, x, y;
     double peak = s->peak;
 
@@ -245,8 +540,22 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
         return ret;
     }
 
-    /* input and output transfer will be linear */
-    if (in->color_trc == AVCOL_TRC_UNSPECIFIED) {
+    if (yuv) {
+        /* the input is linearized internally, the output is SDR */
+        trc = in->color_trc;
+        if (trc == AVCOL_TRC_UNSPECIFIED) {
+            av_log(s, AV_LOG_WARNING, "Untagged transfer, assuming SMPTE ST 2084\n");
+            trc = AVCOL_TRC_SMPTE2084;
+        } else if (trc != AVCOL_TRC_SMPTE2084 && trc != AVCOL_TRC_ARIB_STD_B67) {
+            av_log(s, AV_LOG_ERROR, "Unsupported transfer '%s' for YUV input\n",
+                   av_color_transfer_name(trc));
+            av_frame_free(&in);
+            av_frame_free(&out);
+            return AVERROR(EINVAL);
+        }
+        out->color_trc = AVCOL_TRC_BT709;
+    } else if (in->color_trc == AVCOL_TRC_UNSPECIFIED) {
+        /* input and output transfer will be linear */
         av_log(s, AV_LOG_WARNING, "Untagged transfer, assuming linear light\n");
         out->color_trc = AVCOL_TRC_LINEAR;
     } else if (in->color_trc != AVCOL_TRC_LINEAR)
@@ -274,8 +583,22 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
     td.out = out;
     td.in = in;
     td.desc = desc;
+    td.odesc = odesc;
     td.peak = peak;
-    ctx->internal->execute(ctx, tonemap_slice, &td, NULL, FFMIN(in->height, ff_filter_get_nb_threads(ctx)));
+    if (yuv) {
+        const struct LumaCoefficients *coeffs = ff_get_luma_coefficients(in->colorspace);
+
+        if (!coeffs) {
+            av_log(s, AV_LOG_WARNING, "Missing color space information, assuming BT.2020\n");
+            coeffs = ff_get_luma_coefficients(AVCOL_SPC_BT2020_NCL);
+        }
+        update_matrices(s, coeffs);
+        update_luts(s, trc, peak);
+        ctx->internal->execute(ctx, tonemap_yuv_slice, &td, NULL,
+                               FFMIN(AV_CEIL_RSHIFT(in->height, 1), ff_filter_get_nb_threads(ctx)));
+    } else {
+        ctx->internal->execute(ctx, tonemap_slice, &td, NULL, FFMIN(in->height, ff_filter_get_nb_threads(ctx)));
+    }
 
     /* copy/generate alpha if needed */
     if (desc->flags & AV_PIX_FMT_FLAG_ALPHA && odesc->flags & AV_PIX_FMT_FLAG_ALPHA) {
@@ -312,6 +635,7 @@ static const AVOption tonemap_options[] = {
     { "param",        "tonemap parameter", OFFSET(param), AV_OPT_TYPE_DOUBLE, {.dbl = NAN}, DBL_MIN, DBL_MAX, FLAGS },
     { "desat",        "desaturation strength", OFFSET(desat), AV_OPT_TYPE_DOUBLE, {.dbl = 2}, 0, DBL_MAX, FLAGS },
     { "peak",         "signal peak override", OFFSET(peak), AV_OPT_TYPE_DOUBLE, {.dbl = 0}, 0, DBL_MAX, FLAGS },
+    { "format",       "output pixel format for YUV input", OFFSET(format), AV_OPT_TYPE_PIXEL_FMT, {.i64 = AV_PIX_FMT_NONE}, AV_PIX_FMT_NONE, INT_MAX, FLAGS },
     { NULL }
 };
 
@@ -27,6 +27,7 @@
 #include "internal.h"
 #include "filters.h"
 #include "video.h"
+#include "xfade.h"
 
 enum XFadeTransitions {
     CUSTOM = -1,
@@ -101,6 +102,11 @@ typedef struct XFadeContext {
     uint16_t black[4];
     uint16_t white[4];
 
+    float *rnd;
+    int rnd_linesize;
+
+    XFadeDSPContext dsp;
+
     void (*transitionf)(AVFilterContext *ctx, const AVFrame *a, const AVFrame *b, AVFrame *out, float progress,
                         int slice_start, int slice_end, int jobnr);
 
@@ -148,6 +154,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     XFadeContext *s = ctx->priv;
 
     av_expr_free(s->e);
+    av_freep(&s->rnd);
 }
 
 #define OFFSET(x) offsetof(XFadeContext, x)
@@ -266,34 +273,37 @@ static inline float smoothstep(float edge0, float edge1, float x)
     return t * t * (3.f - 2.f * t);
 }
 
-#define FADE_TRANSITION(name, type, div)                                             \
-static void fade##name##_transition(AVFilterContext *ctx,                            \
-                            const AVFrame *a, const AVFrame *b, AVFrame *out,        \
-                            float progress,                                          \
-                            int slice_start, int slice_end, int jobnr)               \
+#define FADE_ROW(name, type)                                                         \
+static void fade##name##_row(uint8_t *dstp, const uint8_t *xf0p, const uint8_t *xf1p,\
+                             int width, float progress)                              \
 {                                                                                    \
-    XFadeContext *s = ctx->priv;                                                     \
-    const int height = slice_end - slice_start;                                      \
+    const type *xf0 = (const type *)xf0p;                                            \
+    const type *xf1 = (const type *)xf1p;                                            \
+    type *dst = (type *)dstp;                                                        \
                                                                                      \
-    for (int p = 0; p < s->nb_planes; p++) {                                         \
-        const type *xf0 = (const type *)(a->data[p] + slice_start * a->linesize[p]); \
-        const type *xf1 = (const type *)(b->data[p] + slice_start * b->linesize[p]); \
-        type *dst = (type *)(out->data[p] + slice_start * out->linesize[p]);         \
-                                                                                     \
-        for (int y = 0; y < height; y++) {                                           \
-            for (int x = 0; x < out->width; x++) {                                   \
-                dst[x] = mix(xf0[x], xf1[x], progress);                              \
-            }                                                                        \
-                                                                                     \
-            dst += out->linesize[p] / div;                                           \
-            xf0 += a->linesize[p] / div;                                             \
-            xf1 += b->linesize[p] / div;                                             \
-        }                                                                            \
-    }                                                                                \
+    for (int x = 0; x < width; x++)                                                  \
+        dst[x] = mix(xf0[x], xf1[x], progress);                                      \
 }
 
-FADE_TRANSITION(8, uint8_t, 1)
-FADE_TRANSITION(16, uint16_t, 2)
+FADE_ROW(8, uint8_t)
+FADE_ROW(16, uint16_t)
+
+static void fade_transition(AVFilterContext *ctx,
+                            const AVFrame *a, const AVFrame *b, AVFrame *out,
+                            float progress,
+                            int slice_start, int slice_end, int jobnr)
+{
+    XFadeContext *s = ctx->priv;
+
+    for (int p = 0; p < s->nb_planes; p++) {
+        for (int y = slice_start; y < slice_end; y++) {
+            s->dsp.fade(out->data[p] + y * out->linesize[p],
+                        a->data[p] + y * a->linesize[p],
+                        b->data[p] + y * b->linesize[p],
+                        out->width, progress);
+        }
+    }
+}
 
 #define WIPELEFT_TRANSITION(name, type, div)                                         \
 static void wipeleft##name##_transition(AVFilterContext *ctx,                        \
@@ -303,7 +313,8 @@ static void wipeleft##name##_transition(AVFilterContext *ctx,
 {                                                                                    \
     XFadeContext *s = ctx->priv;                                                     \
     const int height = slice_end - slice_start;                                      \
-    const int z = out->width * progress;                                             \
+    const int width = out->width;                                                    \
+    const int z = FFMIN((int)(width * progress) + 1, width);                         \
                                                                                      \
     for (int p = 0; p < s->nb_planes; p++) {                                         \
         const type *xf0 = (const type *)(a->data[p] + slice_start * a->linesize[p]); \
@@ -311,9 +322,8 @@ static void wipeleft##name##_transition(AVFilterContext *ctx,
         type *dst = (type *)(out->data[p] + slice_start * out->linesize[p]);         \
                                                                                      \
         for (int y = 0; y < height; y++) {                                           \
-            for (int x = 0; x < out->width; x++) {                                   \
-                dst[x] = x > z ? xf1[x] : xf0[x];                                    \
-            }                                                                        \
+            memcpy(dst, xf0, z * sizeof(type));                                      \
+            memcpy(dst + z, xf1 + z, (width - z) * sizeof(type));                    \
                                                                                      \
             dst += out->linesize[p] / div;                                           \
             xf0 += a->linesize[p] / div;                                             \
@@ -333,7 +343,8 @@ static void wiperight##name##_transition(AVFilterContext *ctx,
 {                                                                                    \
     XFadeContext *s = ctx->priv;                                                     \
     const int height = slice_end - slice_start;                                      \
-    const int z = out->width * (1.f - progress);                                     \
+    const int width = out->width;                                                    \
+    const int z = FFMIN((int)(width * (1.f - progress)) + 1, width);                 \
                                                                                      \
     for (int p = 0; p < s->nb_planes; p++) {                                         \
         const type *xf0 = (const type *)(a->data[p] + slice_start * a->linesize[p]); \
@@ -341,9 +352,8 @@ static void wiperight##name##_transition(AVFilterContext *ctx,
         type *dst = (type *)(out->data[p] + slice_start * out->linesize[p]);         \
                                                                                      \
         for (int y = 0; y < height; y++) {                                           \
-            for (int x = 0; x < out->width; x++) {                                   \
-                dst[x] = x > z ? xf0[x] : xf1[x];                                    \
-            }                                                                        \
+            memcpy(dst, xf1, z * sizeof(type));                                      \
+            memcpy(dst + z, xf0 + z, (width - z) * sizeof(type));                    \
                                                                                      \
             dst += out->linesize[p] / div;                                           \
             xf0 += a->linesize[p] / div;                                             \
@@ -371,9 +381,7 @@ static void wipeup##name##_transition(AVFilterContext *ctx,
         type *dst = (type *)(out->data[p] + slice_start * out->linesize[p]);         \
                                                                                      \
         for (int y = 0; y < height; y++) {                                           \
-            for (int x = 0; x < out->width; x++) {                                   \
-                dst[x] = slice_start + y > z ? xf1[x] : xf0[x];                      \
-            }                                                                        \
+            memcpy(dst, slice_start + y > z ? xf1 : xf0, out->width * sizeof(type)); \
                                                                                      \
             dst += out->linesize[p] / div;                                           \
             xf0 += a->linesize[p] / div;                                             \
@@ -401,9 +409,7 @@ static void wipedown##name##_transition(AVFilterContext *ctx,
         type *dst = (type *)(out->data[p] + slice_start * out->linesize[p]);         \
                                                                                      \
         for (int y = 0; y < height; y++) {                                           \
-            for (int x = 0; x < out->width; x++) {                                   \
-                dst[x] = slice_start + y > z ? xf0[x] : xf1[x];                      \
-            }                                                                        \
+            memcpy(dst, slice_start + y > z ? xf0 : xf1, out->width * sizeof(type)); \
                                                                                      \
             dst += out->linesize[p] / div;                                           \
             xf0 += a->linesize[p] / div;                                             \
@@ -424,7 +430,7 @@ static void slideleft##name##_transition(AVFilterContext *ctx,
     XFadeContext *s = ctx->priv;                                                     \
     const int height = slice_end - slice_start;                                      \
     const int width = out->width;                                                    \
-    const int z = -progress * width;                                                 \
+    const int z = (int)(progress * width);                                           \
                                                                                      \
     for (int p = 0; p < s->nb_planes; p++) {                                         \
         const type *xf0 = (const type *)(a->data[p] + slice_start * a->linesize[p]); \
@@ -432,10 +438,10 @@ static void slideleft##name##_transition(AVFilterContext *ctx,
         type *dst = (type *)(out->data[p] + slice_start * out->linesize[p]);         \
                                                                                      \
         for (int y = 0; y < height; y++) {                                           \
-            for (int x = 0; x < width; x++) {                                        \
-                const int zx = z + x;                                                \
-                const int zz = zx % width + width * (zx < 0);                        \
-                dst[x] = (zx > 0) && (zx < width) ? xf1[zz] : xf0[zz];               \
+            memcpy(dst, xf0 + width - z, z * sizeof(type));                          \
+            if (z < width) {                                                         \
+                dst[z] = xf0[0];                                                     \
+                memcpy(dst + z + 1, xf1 + 1, (width - z - 1) * sizeof(type));        \
             }                                                                        \
                                                                                      \
             dst += out->linesize[p] / div;                                           \
@@ -465,11 +471,10 @@ static void slideright##name##_transition(AVFilterContext *ctx,
         type *dst = (type *)(out->data[p] + slice_start * out->linesize[p]);         \
                                                                                      \
         for (int y = 0; y < height; y++) {                                           \
-            for (int x = 0; x < out->width; x++) {                                   \
-                const int zx = z + x;                                                \
-                const int zz = zx % width + width * (zx < 0);                        \
-                dst[x] = (zx > 0) && (zx < width) ? xf1[zz] : xf0[zz];               \
-            }                                                                        \
+            memcpy(dst, xf1 + z, (width - z) * sizeof(type));                        \
+            memcpy(dst + width - z, xf0, z * sizeof(type));                          \
+            if (!z)                                                                  \
+                dst[0] = xf0[0];                                                     \
                                                                                      \
             dst += out->linesize[p] / div;                                           \
             xf0 += a->linesize[p] / div;                                             \
@@ -496,13 +501,12 @@ static void slideup##name##_transition(AVFilterContext *ctx,
                                                                                     \
         for (int y = slice_start; y < slice_end; y++) {                             \
             const int zy = z + y;                                                   \
-            const int zz = zy % height + height * (zy < 0);                         \
+            const int zz = (zy % height + height) % height;                         \
             const type *xf0 = (const type *)(a->data[p] + zz * a->linesize[p]);     \
             const type *xf1 = (const type *)(b->data[p] + zz * b->linesize[p]);     \
                                                                                     \
-            for (int x = 0; x < out->width; x++) {                                  \
-                dst[x] = (zy > 0) && (zy < height) ? xf1[x] : xf0[x];               \
-            }                                                                       \
+            memcpy(dst, (zy > 0) && (zy < height) ? xf1 : xf0,                      \
+                   out->width * sizeof(type));                                      \
                                                                                     \
             dst += out->linesize[p] / div;                                          \
         }                                                                           \
@@ -527,13 +531,12 @@ static void slidedown##name##_transition(AVFilterContext *ctx,
                                                                                     \
         for (int y = slice_start; y < slice_end; y++) {                             \
             const int zy = z + y;                                                   \
-            const int zz = zy % height + height * (zy < 0);                         \
+            const int zz = (zy % height + height) % height;                         \
             const type *xf0 = (const type *)(a->data[p] + zz * a->linesize[p]);     \
             const type *xf1 = (const type *)(b->data[p] + zz * b->linesize[p]);     \
                                                                                     \
-            for (int x = 0; x < out->width; x++) {                                  \
-                dst[x] = (zy > 0) && (zy < height) ? xf1[x] : xf0[x];               \
-            }                                                                       \
+            memcpy(dst, (zy > 0) && (zy < height) ? xf1 : xf0,                      \
+                   out->width * sizeof(type));                                      \
                                                                                     \
             dst += out->linesize[p] / div;                                          \
         }                                                                           \
@@ -646,71 +649,61 @@ static void distance##name##_transition(AVFilterContext *ctx,
 DISTANCE_TRANSITION(8, uint8_t, 1)
 DISTANCE_TRANSITION(16, uint16_t, 2)
 
-#define FADEBLACK_TRANSITION(name, type, div)                                        \
-static void fadeblack##name##_transition(AVFilterContext *ctx,                       \
-                            const AVFrame *a, const AVFrame *b, AVFrame *out,        \
-                            float progress,                                          \
-                            int slice_start, int slice_end, int jobnr)               \
+#define FADECOLOR_ROW(name, type)                                                    \
+static void fadecolor##name##_row(uint8_t *dstp, const uint8_t *xf0p,                \
+                                  const uint8_t *xf1p, int width, float progress,    \
+                                  float mix0, float mix1, float color)               \
 {                                                                                    \
-    XFadeContext *s = ctx->priv;                                                     \
-    const int height = slice_end - slice_start;                                      \
-    const float phase = 0.2f;                                                        \
+    const type *xf0 = (const type *)xf0p;                                            \
+    const type *xf1 = (const type *)xf1p;                                            \
+    type *dst = (type *)dstp;                                                        \
                                                                                      \
-    for (int p = 0; p < s->nb_planes; p++) {                                         \
-        const type *xf0 = (const type *)(a->data[p] + slice_start * a->linesize[p]); \
-        const type *xf1 = (const type *)(b->data[p] + slice_start * b->linesize[p]); \
-        type *dst = (type *)(out->data[p] + slice_start * out->linesize[p]);         \
-        const int bg = s->black[p];                                                  \
-                                                                                     \
-        for (int y = 0; y < height; y++) {                                           \
-            for (int x = 0; x < out->width; x++) {                                   \
-                dst[x] = mix(mix(xf0[x], bg, smoothstep(1.f-phase, 1.f, progress)),  \
-                         mix(bg, xf1[x], smoothstep(phase, 1.f, progress)),          \
-                             progress);                                              \
-            }                                                                        \
-                                                                                     \
-            dst += out->linesize[p] / div;                                           \
-            xf0 += a->linesize[p] / div;                                             \
-            xf1 += b->linesize[p] / div;                                             \
-        }                                                                            \
-    }                                                                                \
+    for (int x = 0; x < width; x++)                                                  \
+        dst[x] = mix(mix(xf0[x], color, mix0), mix(color, xf1[x], mix1), progress);  \
 }
 
-FADEBLACK_TRANSITION(8, uint8_t, 1)
-FADEBLACK_TRANSITION(16, uint16_t, 2)
+FADECOLOR_ROW(8, uint8_t)
+FADECOLOR_ROW(16, uint16_t)
 
-#define FADEWHITE_TRANSITION(name, type, div)                                        \
-static void fadewhite##name##_transition(AVFilterContext *ctx,                       \
-                            const AVFrame *a, const AVFrame *b, AVFrame *out,        \
-                            float progress,                                          \
-                            int slice_start, int slice_end, int jobnr)               \
-{                                                                                    \
-    XFadeContext *s = ctx->priv;                                                     \
-    const int height = slice_end - slice_start;                                      \
-    const float phase = 0.2f;                                                        \
-                                                                                     \
-    for (int p = 0; p < s->nb_planes; p++) {                                         \
-        const type *xf0 = (const type *)(a->data[p] + slice_start * a->linesize[p]); \
-        const type *xf1 = (const type *)(b->data[p] + slice_start * b->linesize[p]); \
-        type *dst = (type *)(out->data[p] + slice_start * out->linesize[p]);         \
-        const int bg = s->white[p];                                                  \
-                                                                                     \
-        for (int y = 0; y < height; y++) {                                           \
-            for (int x = 0; x < out->width; x++) {                                   \
-                dst[x] = mix(mix(xf0[x], bg, smoothstep(1.f-phase, 1.f, progress)),  \
-                         mix(bg, xf1[x], smoothstep(phase, 1.f, progress)),          \
-                             progress);                                              \
-            }                                                                        \
-                                                                                     \
-            dst += out->linesize[p] / div;                                           \
-            xf0 += a->linesize[p] / div;                                             \
-            xf1 += b->linesize[p] / div;                                             \
-        }                                                                            \
-    }                                                                                \
+static void fadecolor_transition(AVFilterContext *ctx,
+                                 const AVFrame *a, const AVFrame *b, AVFrame *out,
+                                 float progress, const uint16_t *color,
+                                 int slice_start, int slice_end)
+{
+    XFadeContext *s = ctx->priv;
+    const float phase = 0.2f;
+    const float mix0 = smoothstep(1.f - phase, 1.f, progress);
+    const float mix1 = smoothstep(phase, 1.f, progress);
+
+    for (int p = 0; p < s->nb_planes; p++) {
+        for (int y = slice_start; y < slice_end; y++) {
+            s->dsp.fadecolor(out->data[p] + y * out->linesize[p],
+                             a->data[p] + y * a->linesize[p],
+                             b->data[p] + y * b->linesize[p],
+                             out->width, progress, mix0, mix1, color[p]);
+        }
+    }
 }
 
-FADEWHITE_TRANSITION(8, uint8_t, 1)
-FADEWHITE_TRANSITION(16, uint16_t, 2)
+static void fadeblack_transition(AVFilterContext *ctx,
+                                 const AVFrame *a, const AVFrame *b, AVFrame *out,
+                                 float progress,
+                                 int slice_start, int slice_end, int jobnr)
+{
+    XFadeContext *s = ctx->priv;
+
+    fadecolor_transition(ctx, a, b, out, progress, s->black, slice_start, slice_end);
+}
+
+static void fadewhite_transition(AVFilterContext *ctx,
+                                 const AVFrame *a, const AVFrame *b, AVFrame *out,
+                                 float progress,
+                                 int slice_start, int slice_end, int jobnr)
+{
+    XFadeContext *s = ctx->priv;
+
+    fadecolor_transition(ctx, a, b, out, progress, s->white, slice_start, slice_end);
+}
 
 #define RADIAL_TRANSITION(name, type, div)                                           \
 static void radial##name##_transition(AVFilterContext *ctx,                          \
@@ -1023,31 +1016,44 @@ static float frand(int x, int y)
     return r - floorf(r);
 }
 
-#define DISSOLVE_TRANSITION(name, type, div)                                         \
-static void dissolve##name##_transition(AVFilterContext *ctx,                        \
-                            const AVFrame *a, const AVFrame *b, AVFrame *out,        \
-                            float progress,                                          \
-                            int slice_start, int slice_end, int jobnr)               \
+#define DISSOLVE_ROW(name, type)                                                     \
+static void dissolve##name##_row(uint8_t *dstp, const uint8_t *xf0p,                 \
+                                 const uint8_t *xf1p, const float *rnd,              \
+                                 int width, float progress)                          \
 {                                                                                    \
-    XFadeContext *s = ctx->priv;                                                     \
-    const int width = out->width;                                                    \
-                                                                                     \
-    for (int y = slice_start; y < slice_end; y++) {                                  \
-        for (int x = 0; x < width; x++) {                                            \
-            const float smooth = frand(x, y) * 2.f + progress * 2.f - 1.5f;          \
-            for (int p = 0; p < s->nb_planes; p++) {                                 \
-                const type *xf0 = (const type *)(a->data[p] + y * a->linesize[p]);   \
-                const type *xf1 = (const type *)(b->data[p] + y * b->linesize[p]);   \
-                type *dst = (type *)(out->data[p] + y * out->linesize[p]);           \
+    const type *xf0 = (const type *)xf0p;                                            \
+    const type *xf1 = (const type *)xf1p;                                            \
+    type *dst = (type *)dstp;                                                        \
                                                                                      \
-                dst[x] = smooth >= 0.5f ? xf0[x] : xf1[x];                           \
-            }                                                                        \
-        }                                                                            \
+    for (int x = 0; x < width; x++) {                                                \
+        const float smooth = rnd[x] * 2.f + progress * 2.f - 1.5f;                   \
+        dst[x] = smooth >= 0.5f ? xf0[x] : xf1[x];                                   \
     }                                                                                \
 }
 
-DISSOLVE_TRANSITION(8, uint8_t, 1)
-DISSOLVE_TRANSITION(16, uint16_t, 2)
+DISSOLVE_ROW(8, uint8_t)
+DISSOLVE_ROW(16, uint16_t)
+
+static void dissolve_transition(AVFilterContext *ctx,
+                                const AVFrame *a, const AVFrame *b, AVFrame *out,
+                                float progress,
+                                int slice_start, int slice_end, int jobnr)
+{
+    XFadeContext *s = ctx->priv;
+    float *rnd = s->rnd + jobnr * s->rnd_linesize;
+
+    for (int y = slice_start; y < slice_end; y++) {
+        for (int x = 0; x < s->rnd_linesize; x++)
+            rnd[x] = frand(x, y);
+
+        for (int p = 0; p < s->nb_planes; p++) {
+            s->dsp.dissolve(out->data[p] + y * out->linesize[p],
+                            a->data[p] + y * a->linesize[p],
+                            b->data[p] + y * b->linesize[p],
+                            rnd, out->width, progress);
+        }
+    }
+}
 
 #define PIXELIZE_TRANSITION(name, type, div)                                         \
 static void pixelize##name##_transition(AVFilterContext *ctx,                        \
@@ -1666,6 +1672,22 @@ static double b1(void *priv, double x, double y) { return getpix(priv, x, y, 1,
 static double b2(void *priv, double x, double y) { return getpix(priv, x, y, 2, 1); }
 static double b3(void *priv, double x, double y) { return getpix(priv, x, y, 3, 1); }
 
+void ff_xfade_init(XFadeDSPContext *dsp, int depth)
+{
+    if (depth <= 8) {
+        dsp->fade      = fade8_row;
+        dsp->fadecolor = fadecolor8_row;
+        dsp->dissolve  = dissolve8_row;
+    } else {
+        dsp->fade      = fade16_row;
+        dsp->fadecolor = fadecolor16_row;
+        dsp->dissolve  = dissolve16_row;
+    }
+
+    if (ARCH_X86)
+        ff_xfade_init_x86(dsp, depth);
+}
+
 static int config_output(AVFilterLink *outlink)
 {
     AVFilterContext *ctx = outlink->src;
@@ -1738,7 +1760,7 @@ static int config_output(AVFilterLink *outlink)
 
     switch (s->transition) {
     case CUSTOM:     s->transitionf = s->depth <= 8 ? custom8_transition     : custom16_transition;     break;
-    case FADE:       s->transitionf = s->depth <= 8 ? fade8_transition       : fade16_transition;       break;
+    case FADE:       s->transitionf = fade_transition; break;
     case WIPELEFT:   s->transitionf = s->depth <= 8 ? wipeleft8_transition   : wipeleft16_transition;   break;
     case WIPERIGHT:  s->transitionf = s->depth <= 8 ? wiperight8_transition  : wiperight16_transition;  break;
     case WIPEUP:     s->transitionf = s->depth <= 8 ? wipeup8_transition     : wipeup16_transition;     break;
@@ -1750,8 +1772,8 @@ static int config_output(AVFilterLink *outlink)
     case CIRCLECROP: s->transitionf = s->depth <= 8 ? circlecrop8_transition : circlecrop16_transition; break;
     case RECTCROP:   s->transitionf = s->depth <= 8 ? rectcrop8_transition   : rectcrop16_transition;   break;
     case DISTANCE:   s->transitionf = s->depth <= 8 ? distance8_transition   : distance16_transition;   break;
-    case FADEBLACK:  s->transitionf = s->depth <= 8 ? fadeblack8_transition  : fadeblack16_transition;  break;
-    case FADEWHITE:  s->transitionf = s->depth <= 8 ? fadewhite8_transition  : fadewhite16_transition;  break;
+    case FADEBLACK:  s->transitionf = fadeblack_transition; break;
+    case FADEWHITE:  s->transitionf = fadewhite_transition; break;
     case RADIAL:     s->transitionf = s->depth <= 8 ? radial8_transition     : radial16_transition;     break;
     case SMOOTHLEFT: s->transitionf = s->depth <= 8 ? smoothleft8_transition : smoothleft16_transition; break;
     case SMOOTHRIGHT:s->transitionf = s->depth <= 8 ? smoothright8_transition: smoothright16_transition;break;
@@ -1763,7 +1785,7 @@ static int config_output(AVFilterLink *outlink)
     case VERTCLOSE:  s->transitionf = s->depth <= 8 ? vertclose8_transition  : vertclose16_transition;  break;
     case HORZOPEN:   s->transitionf = s->depth <= 8 ? horzopen8_transition   : horzopen16_transition;   break;
     case HORZCLOSE:  s->transitionf = s->depth <= 8 ? horzclose8_transition  : horzclose16_transition;  break;
-    case DISSOLVE:   s->transitionf = s->depth <= 8 ? dissolve8_transition   : dissolve16_transition;   break;
+    case DISSOLVE:   s->transitionf = dissolve_transition; break;
     case PIXELIZE:   s->transitionf = s->depth <= 8 ? pixelize8_transition   : pixelize16_transition;   break;
     case DIAGTL:     s->transitionf = s->depth <= 8 ? diagtl8_transition     : diagtl16_transition;     break;
     case DIAGTR:     s->transitionf = s->depth <= 8 ? diagtr8_transition     : diagtr16_transition;     break;
@@ -1783,6 +1805,18 @@ static int config_output(AVFilterLink *outlink)
     case SQUEEZEV:   s->transitionf = s->depth <= 8 ? squeezev8_transition   : squeezev16_transition;   break;
     }
 
+    ff_xfade_init(&s->dsp, s->depth);
+
+    av_freep(&s->rnd);
+    if (s->transition == DISSOLVE) {
+        /* one line of noise per slice job */
+        s->rnd_linesize = FFALIGN(outlink->w, 32);
+        s->rnd = av_malloc_array(s->rnd_linesize * ff_filter_get_nb_threads(ctx),
+                                 sizeof(*s->rnd));
+        if (!s->rnd)
+            return AVERROR(ENOMEM);
+    }
+
     if (s->transition == CUSTOM) {
         static const char *const func2_names[]    = {
             "a0", "a1", "a2", "a3",
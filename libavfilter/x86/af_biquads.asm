@@ -0,0 +1,163 @@
+;*****************************************************************************
+;* x86-optimized functions for biquads filters
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+; Each register holds one value for the 4 interleaved channels. The
+; expressions are evaluated in the same order as in the C code and without
+; fused multiply-add, so that the output stays bit identical to it.
+
+%macro LOAD_COEFFS 0
+    mova              m0, [coeffsq + 0 * mmsize]    ; b0
+    mova              m1, [coeffsq + 1 * mmsize]    ; b1
+    mova              m2, [coeffsq + 2 * mmsize]    ; b2
+    mova              m3, [coeffsq + 3 * mmsize]    ; -a1
+    mova              m4, [coeffsq + 4 * mmsize]    ; -a2
+    movsxdifnidn    lenq, lend
+    shl             lenq, 5
+    add             bufq, lenq
+    neg             lenq
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_biquad_di_lanes(double *buf, int len, double *state,
+;                         const double *coeffs)
+;------------------------------------------------------------------------------
+
+%if ARCH_X86_64
+INIT_YMM avx
+cglobal biquad_di_lanes, 4, 4, 12, buf, len, state, coeffs
+    LOAD_COEFFS
+    mova              m5, [stateq + 0 * mmsize]     ; i1
+    mova              m6, [stateq + 1 * mmsize]     ; i2
+    mova              m7, [stateq + 2 * mmsize]     ; o1
+    mova              m8, [stateq + 3 * mmsize]     ; o2
+    test            lenq, lenq
+    jz .end
+
+.loop:
+    ; o2 = i2 * b2 + i1 * b1 + in0 * b0 + o2 * a2 + o1 * a1
+    mulpd            m10, m6, m2
+    mova              m6, [bufq + lenq]             ; i2 = in0
+    mulpd            m11, m5, m1
+    addpd            m10, m11
+    mulpd            m11, m6, m0
+    addpd            m10, m11
+    mulpd            m11, m8, m4
+    addpd            m10, m11
+    mulpd            m11, m7, m3
+    addpd             m8, m10, m11
+    mova   [bufq + lenq], m8
+
+    ; o1 = i1 * b2 + in0 * b1 + in1 * b0 + o1 * a2 + o2 * a1
+    mulpd            m10, m5, m2
+    mova              m5, [bufq + lenq + mmsize]    ; i1 = in1
+    mulpd            m11, m6, m1
+    addpd            m10, m11
+    mulpd            m11, m5, m0
+    addpd            m10, m11
+    mulpd            m11, m7, m4
+    addpd            m10, m11
+    mulpd            m11, m8, m3
+    addpd             m7, m10, m11
+    mova [bufq + lenq + mmsize], m7
+
+    add             lenq, 2 * mmsize
+    jl .loop
+
+.end:
+    mova [stateq + 0 * mmsize], m5
+    mova [stateq + 1 * mmsize], m6
+    mova [stateq + 2 * mmsize], m7
+    mova [stateq + 3 * mmsize], m8
+    RET
+
+;------------------------------------------------------------------------------
+; void ff_biquad_dii_lanes(double *buf, int len, double *state,
+;                          const double *coeffs)
+;------------------------------------------------------------------------------
+
+cglobal biquad_dii_lanes, 4, 4, 12, buf, len, state, coeffs
+    LOAD_COEFFS
+    mova              m5, [stateq + 0 * mmsize]     ; w1
+    mova              m6, [stateq + 1 * mmsize]     ; w2
+    test            lenq, lenq
+    jz .end
+
+.loop:
+    ; w0 = in + a1 * w1 + a2 * w2
+    mulpd             m9, m3, m5
+    addpd             m9, [bufq + lenq]
+    mulpd            m10, m4, m6
+    addpd             m9, m10
+    ; out = b0 * w0 + b1 * w1 + b2 * w2
+    mulpd            m10, m0, m9
+    mulpd            m11, m1, m5
+    addpd            m10, m11
+    mulpd            m11, m2, m6
+    addpd            m10, m11
+    mova   [bufq + lenq], m10
+    mova              m6, m5
+    mova              m5, m9
+    add             lenq, mmsize
+    jl .loop
+
+.end:
+    mova [stateq + 0 * mmsize], m5
+    mova [stateq + 1 * mmsize], m6
+    RET
+
+;------------------------------------------------------------------------------
+; void ff_biquad_tdii_lanes(double *buf, int len, double *state,
+;                           const double *coeffs)
+;------------------------------------------------------------------------------
+
+cglobal biquad_tdii_lanes, 4, 4, 12, buf, len, state, coeffs
+    LOAD_COEFFS
+    mova              m5, [stateq + 0 * mmsize]     ; w1
+    mova              m6, [stateq + 1 * mmsize]     ; w2
+    test            lenq, lenq
+    jz .end
+
+.loop:
+    mova              m9, [bufq + lenq]
+    ; out = b0 * in + w1
+    mulpd            m10, m0, m9
+    addpd            m10, m5
+    ; w1 = b1 * in + w2 + a1 * out
+    mulpd             m5, m1, m9
+    addpd             m5, m6
+    mulpd            m11, m3, m10
+    addpd             m5, m11
+    ; w2 = b2 * in + a2 * out
+    mulpd             m6, m2, m9
+    mulpd            m11, m4, m10
+    addpd             m6, m11
+    mova   [bufq + lenq], m10
+    add             lenq, mmsize
+    jl .loop
+
+.end:
+    mova [stateq + 0 * mmsize], m5
+    mova [stateq + 1 * mmsize], m6
+    RET
+%endif
@@ -0,0 +1,38 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/af_biquadsdsp.h"
+
+void ff_biquad_di_lanes_avx(double *buf, int len, double *state, const double *coeffs);
+void ff_biquad_dii_lanes_avx(double *buf, int len, double *state, const double *coeffs);
+void ff_biquad_tdii_lanes_avx(double *buf, int len, double *state, const double *coeffs);
+
+av_cold void ff_biquads_init_x86(BiquadsDSPContext *dsp)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (ARCH_X86_64 && EXTERNAL_AVX_FAST(cpu_flags)) {
+        dsp->filter_di   = ff_biquad_di_lanes_avx;
+        dsp->filter_dii  = ff_biquad_dii_lanes_avx;
+        dsp->filter_tdii = ff_biquad_tdii_lanes_avx;
+    }
+}
@@ -0,0 +1,192 @@
+;*****************************************************************************
+;* x86-optimized functions for the drawing utilities
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pd_0x1010101:  times 8 dd 0x1010101
+pd_pixel_perm: dd 0, 0, 0, 0, 1, 1, 1, 1
+pw_128:        times 16 dw 128
+pw_257:        times 16 dw 257
+
+SECTION .text
+
+; The samples are blended as dwords, exactly like the C version:
+; dst = ((0x1010101 - mask * alpha) * dst + mask * alpha * src) >> 24
+
+; %1 mask and result register, %2 dst register, %3 temporary register
+%macro BLEND 3
+    pmulld           m%1, m3
+    psubd            m%3, m4, m%1
+    pmulld           m%3, m%2
+    pmulld           m%1, m2
+    paddd            m%1, m%3
+    psrld            m%1, 24
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_blend_line8_step1(uint8_t *dst, const uint8_t *mask, int w,
+;                           const uint32_t *src, const uint32_t *alpha)
+;------------------------------------------------------------------------------
+
+%macro BLEND_LINE8_STEP1 0
+cglobal blend_line8_step1, 5, 6, 6, dst, mask, w, src, alpha, x
+    movsxdifnidn         wq, wd
+%if cpuflag(avx2)
+    vbroadcasti128       m2, [srcq]
+    vbroadcasti128       m3, [alphaq]
+%else
+    movu                 m2, [srcq]
+    movu                 m3, [alphaq]
+%endif
+    mova                 m4, [pd_0x1010101]
+    xor                  xq, xq
+
+.loop:
+    pmovzxbd             m0, [maskq + xq]
+    pmovzxbd             m1, [dstq + xq]
+    BLEND                 0, 1, 5
+%if cpuflag(avx2)
+    vextracti128        xm1, m0, 1
+    packusdw            xm0, xm1
+    packuswb            xm0, xm0
+    movq       [dstq + xq], xm0
+%else
+    packusdw             m0, m0
+    packuswb             m0, m0
+    movd       [dstq + xq], m0
+%endif
+    add                  xq, mmsize / 4
+    cmp                  xq, wq
+    jl .loop
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_blend_line8_step4(uint8_t *dst, const uint8_t *mask, int w,
+;                           const uint32_t *src, const uint32_t *alpha)
+;------------------------------------------------------------------------------
+
+%macro BLEND_LINE8_STEP4 0
+cglobal blend_line8_step4, 5, 7, 7, dst, mask, w, src, alpha, x, tmp
+    movsxdifnidn         wq, wd
+%if cpuflag(avx2)
+    vbroadcasti128       m2, [srcq]
+    vbroadcasti128       m3, [alphaq]
+    mova                 m6, [pd_pixel_perm]
+%else
+    movu                 m2, [srcq]
+    movu                 m3, [alphaq]
+%endif
+    mova                 m4, [pd_0x1010101]
+    xor                  xq, xq
+
+.loop:
+    ; Every dword lane takes the mask value of its pixel
+%if cpuflag(avx2)
+    movzx              tmpd, word [maskq + xq]
+    movd                xm0, tmpd
+    pmovzxbd             m0, xm0
+    vpermd               m0, m6, m0
+%else
+    movzx              tmpd, byte [maskq + xq]
+    movd                 m0, tmpd
+    pshufd               m0, m0, 0
+%endif
+    pmovzxbd             m1, [dstq + xq * 4]
+    BLEND                 0, 1, 5
+%if cpuflag(avx2)
+    vextracti128        xm1, m0, 1
+    packusdw            xm0, xm1
+    packuswb            xm0, xm0
+    movq   [dstq + xq * 4], xm0
+%else
+    packusdw             m0, m0
+    packuswb             m0, m0
+    movd   [dstq + xq * 4], m0
+%endif
+    add                  xq, mmsize / 16
+    cmp                  xq, wq
+    jl .loop
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_blend_overlay8(uint8_t *dst, const uint8_t *color,
+;                        const uint8_t *transp, int w)
+;------------------------------------------------------------------------------
+
+; dst = av_clip_uint8((((dst * transp + 128) * 257) >> 16) + color)
+%macro BLEND_OVERLAY8 0
+cglobal blend_overlay8, 4, 5, 7, dst, color, transp, w, x
+    movsxdifnidn         wq, wd
+    mova                 m4, [pw_128]
+    mova                 m5, [pw_257]
+    xor                  xq, xq
+
+.loop:
+%if cpuflag(avx2)
+    pmovzxbw             m0, [dstq + xq]
+    pmovzxbw             m1, [transpq + xq]
+    pmullw               m0, m1
+    paddw                m0, m4
+    pmulhuw              m0, m5
+    vextracti128        xm1, m0, 1
+    packuswb            xm0, xm1
+    paddusb             xm0, [colorq + xq]
+%else
+    pxor                 m3, m3
+    movu                 m0, [dstq + xq]
+    movu                 m2, [transpq + xq]
+    punpckhbw            m1, m0, m3
+    punpcklbw            m0, m3
+    punpckhbw            m6, m2, m3
+    punpcklbw            m2, m3
+    pmullw               m0, m2
+    pmullw               m1, m6
+    paddw                m0, m4
+    paddw                m1, m4
+    pmulhuw              m0, m5
+    pmulhuw              m1, m5
+    packuswb             m0, m1
+    movu                 m2, [colorq + xq]
+    paddusb              m0, m2
+%endif
+    movu       [dstq + xq], xm0
+    add                  xq, 16
+    cmp                  xq, wq
+    jl .loop
+    RET
+%endmacro
+
+INIT_XMM sse2
+BLEND_OVERLAY8
+
+INIT_XMM sse4
+BLEND_LINE8_STEP1
+BLEND_LINE8_STEP4
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+BLEND_LINE8_STEP1
+BLEND_LINE8_STEP4
+BLEND_OVERLAY8
+%endif
@@ -0,0 +1,53 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/drawutils.h"
+
+#define BLEND_LINE8_FUNCS(opt)                                                  \
+void ff_blend_line8_step1_##opt(uint8_t *dst, const uint8_t *mask, int w,       \
+                                const uint32_t *src, const uint32_t *alpha);    \
+void ff_blend_line8_step4_##opt(uint8_t *dst, const uint8_t *mask, int w,       \
+                                const uint32_t *src, const uint32_t *alpha);
+
+BLEND_LINE8_FUNCS(sse4)
+BLEND_LINE8_FUNCS(avx2)
+
+void ff_blend_overlay8_sse2(uint8_t *dst, const uint8_t *color,
+                            const uint8_t *transp, int w);
+void ff_blend_overlay8_avx2(uint8_t *dst, const uint8_t *color,
+                            const uint8_t *transp, int w);
+
+av_cold void ff_draw_init_x86(FFDrawContext *draw)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE2(cpu_flags))
+        draw->blend_overlay8 = ff_blend_overlay8_sse2;
+    if (EXTERNAL_SSE4(cpu_flags)) {
+        draw->blend_line8[0] = ff_blend_line8_step1_sse4;
+        draw->blend_line8[1] = ff_blend_line8_step4_sse4;
+    }
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        draw->blend_line8[0] = ff_blend_line8_step1_avx2;
+        draw->blend_line8[1] = ff_blend_line8_step4_avx2;
+        draw->blend_overlay8 = ff_blend_overlay8_avx2;
+    }
+}
@@ -63,12 +63,56 @@ REP_RET
 %endmacro
 
 
+; The absolute differences of 16 bits samples are widened to dwords, summed
+; over the row, then widened again and added to the qword sums.
+%macro SAD16_FRAMES 0
+cglobal scene_sad16, 6, 7, 6, src1, stride1, src2, stride2, width, end, x
+    add    widthq, widthq
+    add     src1q, widthq
+    add     src2q, widthq
+    neg    widthq
+    pxor       m1, m1
+    pxor       m4, m4
+
+.nextrow:
+    mov        xq, widthq
+    pxor       m2, m2
+
+    .loop:
+        movu            m0, [src1q + xq]
+        movu            m3, [src2q + xq]
+        psubusw         m5, m0, m3
+        psubusw         m3, m0
+        por             m0, m5, m3
+        punpckhwd       m3, m0, m4
+        punpcklwd       m0, m4
+        paddd           m2, m0
+        paddd           m2, m3
+        add             xq, mmsize
+    jl .loop
+    punpckhdq  m0, m2, m4
+    punpckldq  m2, m4
+    paddq      m1, m0
+    paddq      m1, m2
+    add     src1q, stride1q
+    add     src2q, stride2q
+    sub      endd, 1
+    jg .nextrow
+
+    mov         r0q, r6mp
+    movu      [r0q], m1      ; sum
+REP_RET
+%endmacro
+
+
 INIT_XMM sse2
 SAD_FRAMES
+SAD16_FRAMES
 
 %if HAVE_AVX2_EXTERNAL
 
 INIT_YMM avx2
 SAD_FRAMES
+SAD16_FRAMES
 
 %endif
@@ -20,26 +20,32 @@
 #include "libavutil/x86/cpu.h"
 #include "libavfilter/scene_sad.h"
 
-#define SCENE_SAD_FUNC(FUNC_NAME, ASM_FUNC_NAME, MMSIZE)                      \
+/* The asm functions process width rounded down to a multiple of the vector
+ * size, the remaining columns are passed to TAIL_FUNC. */
+#define SCENE_SAD_FUNC(FUNC_NAME, ASM_FUNC_NAME, MMSIZE, BPP, TAIL_FUNC)      \
 void ASM_FUNC_NAME(SCENE_SAD_PARAMS);                                         \
                                                                               \
 static void FUNC_NAME(SCENE_SAD_PARAMS) {                                     \
     uint64_t sad[MMSIZE / 8] = {0};                                           \
-    ptrdiff_t awidth = width & ~(MMSIZE - 1);                                 \
+    ptrdiff_t awidth = width & ~(MMSIZE / BPP - 1);                           \
     *sum = 0;                                                                 \
-    ASM_FUNC_NAME(src1, stride1, src2, stride2, awidth, height, sad);         \
-    for (int i = 0; i < MMSIZE / 8; i++)                                      \
-        *sum += sad[i];                                                       \
-    ff_scene_sad_c(src1 + awidth, stride1,                                    \
-                   src2 + awidth, stride2,                                    \
-                   width - awidth, height, sad);                              \
+    if (awidth) {                                                             \
+        ASM_FUNC_NAME(src1, stride1, src2, stride2, awidth, height, sad);     \
+        for (int i = 0; i < MMSIZE / 8; i++)                                  \
+            *sum += sad[i];                                                   \
+    }                                                                         \
+    TAIL_FUNC(src1 + awidth * BPP, stride1,                                   \
+              src2 + awidth * BPP, stride2,                                   \
+              width - awidth, height, sad);                                   \
     *sum += sad[0];                                                           \
 }
 
 #if HAVE_X86ASM
-SCENE_SAD_FUNC(scene_sad_sse2, ff_scene_sad_sse2, 16)
+SCENE_SAD_FUNC(scene_sad_sse2,   ff_scene_sad_sse2,   16, 1, ff_scene_sad_c)
+SCENE_SAD_FUNC(scene_sad16_sse2, ff_scene_sad16_sse2, 16, 2, ff_scene_sad16_c)
 #if HAVE_AVX2_EXTERNAL
-SCENE_SAD_FUNC(scene_sad_avx2, ff_scene_sad_avx2, 32)
+SCENE_SAD_FUNC(scene_sad_avx2,   ff_scene_sad_avx2,   32, 1, scene_sad_sse2)
+SCENE_SAD_FUNC(scene_sad16_avx2, ff_scene_sad16_avx2, 32, 2, scene_sad16_sse2)
 #endif
 #endif
 
@@ -55,6 +61,14 @@ ff_scene_sad_fn ff_scene_sad_get_fn_x86(int depth)
         if (EXTERNAL_SSE2(cpu_flags))
             return scene_sad_sse2;
     }
+    if (depth == 16) {
+#if HAVE_AVX2_EXTERNAL
+        if (EXTERNAL_AVX2_FAST(cpu_flags))
+            return scene_sad16_avx2;
+#endif
+        if (EXTERNAL_SSE2(cpu_flags))
+            return scene_sad16_sse2;
+    }
 #endif
     return NULL;
 }
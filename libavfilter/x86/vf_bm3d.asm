@@ -0,0 +1,203 @@
+;*****************************************************************************
+;* x86-optimized functions for bm3d filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+%if ARCH_X86_64
+
+;------------------------------------------------------------------------------
+; int64_t ff_bm3d_ssd8(const uint8_t *a, const uint8_t *b, ptrdiff_t stride,
+;                      int size)
+;------------------------------------------------------------------------------
+
+; Every iteration handles 16 pixels, a dword lane sums at most 512 squares
+; of 8-bit differences for the largest 64x64 blocks so it cannot overflow.
+%macro SSD8 0
+cglobal bm3d_ssd8, 4, 6, 6, a, b, stride, size, x, h
+    movsxdifnidn   sizeq, sized
+    mov               hq, sizeq
+    add               aq, sizeq
+    add               bq, sizeq
+    neg            sizeq
+    pxor              m4, m4
+    pxor              m5, m5
+
+.row:
+    mov               xq, sizeq
+.col:
+%if mmsize == 32
+    pmovzxbw          m0, [aq + xq]
+    pmovzxbw          m1, [bq + xq]
+%else
+    movu              m0, [aq + xq]
+    movu              m1, [bq + xq]
+    punpckhbw         m2, m0, m5
+    punpckhbw         m3, m1, m5
+    punpcklbw         m0, m5
+    punpcklbw         m1, m5
+    psubw             m2, m3
+    pmaddwd           m2, m2
+    paddd             m4, m2
+%endif
+    psubw             m0, m1
+    pmaddwd           m0, m0
+    paddd             m4, m0
+    add               xq, 16
+    jl .col
+
+    add               aq, strideq
+    add               bq, strideq
+    dec               hq
+    jg .row
+
+    HADDD             m4, m0
+    movd             eax, xm4
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; int64_t ff_bm3d_ssd16(const uint8_t *a, const uint8_t *b, ptrdiff_t stride,
+;                       int size)
+;------------------------------------------------------------------------------
+
+; The absolute differences of 16-bit samples are squared into full dwords
+; which are accumulated as qwords.
+%macro SSD16 0
+cglobal bm3d_ssd16, 4, 6, 6, a, b, stride, size, x, h
+    movsxdifnidn   sizeq, sized
+    mov               hq, sizeq
+    add            sizeq, sizeq
+    add               aq, sizeq
+    add               bq, sizeq
+    neg            sizeq
+    pxor              m4, m4
+    pxor              m5, m5
+
+.row:
+    mov               xq, sizeq
+.col:
+    movu              m0, [aq + xq]
+    movu              m1, [bq + xq]
+    psubusw           m2, m0, m1
+    psubusw           m1, m0
+    por               m1, m2
+    pmullw            m0, m1, m1
+    pmulhuw           m1, m1
+    punpckhwd         m2, m0, m1
+    punpcklwd         m0, m1
+    punpckhdq         m1, m0, m5
+    punpckldq         m0, m5
+    paddq             m4, m0
+    paddq             m4, m1
+    punpckhdq         m1, m2, m5
+    punpckldq         m2, m5
+    paddq             m4, m2
+    paddq             m4, m1
+    add               xq, mmsize
+    jl .col
+
+    add               aq, strideq
+    add               bq, strideq
+    dec               hq
+    jg .row
+
+%if mmsize == 32
+    vextracti128     xm0, m4, 1
+    paddq            xm4, xm0
+%endif
+    punpckhqdq       xm0, xm4, xm4
+    paddq            xm4, xm0
+    movq             rax, xm4
+    RET
+%endmacro
+
+INIT_XMM sse2
+SSD8
+SSD16
+
+INIT_YMM avx2
+SSD8
+SSD16
+
+;------------------------------------------------------------------------------
+; void ff_bm3d_mat_mul(float *dst, const float *a, const float *b,
+;                      int rows, int n, int cols)
+;------------------------------------------------------------------------------
+
+; Two rows of dst are computed at once, 2 * mmsize / 4 columns at a time,
+; every row of b being loaded once for both of them.
+%macro MAT_MUL 0
+cglobal bm3d_mat_mul, 6, 10, 9, dst, a, b, rows, n, cols, x, k, bp, a1
+    movsxdifnidn   rowsq, rowsd
+    movsxdifnidn      nq, nd
+    movsxdifnidn   colsq, colsd
+    shl            colsq, 2
+    lea              a1q, [aq + nq * 4]
+
+.row:
+    xor               xq, xq
+.col:
+    lea              bpq, [bq + xq]
+    xor               kq, kq
+    xorps             m0, m0
+    xorps             m1, m1
+    xorps             m2, m2
+    xorps             m3, m3
+
+.loop:
+    VBROADCASTSS      m4, [aq  + kq * 4]
+    VBROADCASTSS      m5, [a1q + kq * 4]
+    mova              m6, [bpq]
+    mova              m7, [bpq + mmsize]
+    FMULADD_PS        m0, m4, m6, m0, m8
+    FMULADD_PS        m1, m4, m7, m1, m8
+    FMULADD_PS        m2, m5, m6, m2, m8
+    FMULADD_PS        m3, m5, m7, m3, m8
+    add              bpq, colsq
+    inc               kq
+    cmp               kq, nq
+    jl .loop
+
+    lea               kq, [dstq + colsq]
+    mova [dstq + xq], m0
+    mova [dstq + xq + mmsize], m1
+    mova   [kq + xq], m2
+    mova   [kq + xq + mmsize], m3
+    add               xq, 2 * mmsize
+    cmp               xq, colsq
+    jl .col
+
+    lea               aq, [aq  + nq * 8]
+    lea              a1q, [a1q + nq * 8]
+    lea             dstq, [dstq + colsq * 2]
+    sub            rowsq, 2
+    jg .row
+    RET
+%endmacro
+
+INIT_XMM sse
+MAT_MUL
+
+INIT_YMM avx2
+MAT_MUL
+
+%endif
@@ -0,0 +1,50 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/bm3d.h"
+
+int64_t ff_bm3d_ssd8_sse2(const uint8_t *a, const uint8_t *b, ptrdiff_t stride, int size);
+int64_t ff_bm3d_ssd8_avx2(const uint8_t *a, const uint8_t *b, ptrdiff_t stride, int size);
+int64_t ff_bm3d_ssd16_sse2(const uint8_t *a, const uint8_t *b, ptrdiff_t stride, int size);
+int64_t ff_bm3d_ssd16_avx2(const uint8_t *a, const uint8_t *b, ptrdiff_t stride, int size);
+
+void ff_bm3d_mat_mul_sse(float *dst, const float *a, const float *b,
+                         int rows, int n, int cols);
+void ff_bm3d_mat_mul_avx2(float *dst, const float *a, const float *b,
+                          int rows, int n, int cols);
+
+av_cold void ff_bm3d_init_x86(BM3DDSPContext *dsp, int depth)
+{
+#if ARCH_X86_64
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE(cpu_flags))
+        dsp->mat_mul = ff_bm3d_mat_mul_sse;
+
+    if (EXTERNAL_SSE2(cpu_flags))
+        dsp->ssd = depth > 8 ? ff_bm3d_ssd16_sse2 : ff_bm3d_ssd8_sse2;
+
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        dsp->ssd = depth > 8 ? ff_bm3d_ssd16_avx2 : ff_bm3d_ssd8_avx2;
+        dsp->mat_mul = ff_bm3d_mat_mul_avx2;
+    }
+#endif
+}
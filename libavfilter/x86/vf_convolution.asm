@@ -154,3 +154,288 @@ cglobal filter_3x3, 4, 15, 7, dst, width, rdiv, bias, matrix, ptr, c0, c1, c2, c
 INIT_XMM sse4
 FILTER_3X3
 %endif
+
+; Load the samples of tap %2 at x + %3 as dwords in m%1, only the one
+; at x if %4 is set
+%macro LOAD 3-4 0
+    mov          srcq, [ptrq + %2 * gprsize]
+%if %4
+%if BPC == 1
+    movzx        srcd, byte [srcq + xq]
+%else
+    movzx        srcd, word [srcq + 2 * xq]
+%endif
+    movd         xm%1, srcd
+%elif BPC == 1
+    pmovzxbd     m%1, [srcq + xq + %3]
+%else
+    pmovzxwd     m%1, [srcq + 2 * xq + 2 * %3]
+%endif
+%endmacro
+
+; Clip the dwords of m%1 and store them at x + %2, only the first one
+; if %3 is set
+%macro STORE 2-3 0
+%if BPC == 2
+    pminsd       m%1, m7
+%endif
+%if %3
+%if BPC == 1
+    packssdw     xm%1, xm%1
+    packuswb     xm%1, xm%1
+    movd         srcd, xm%1
+    mov          [dstq + xq], srcb
+%else
+    packusdw     xm%1, xm%1
+    movd         srcd, xm%1
+    mov          [dstq + 2 * xq], srcw
+%endif
+%else
+    vextracti128 xm3, m%1, 1
+%if BPC == 1
+    packssdw     xm%1, xm3
+    packuswb     xm%1, xm%1
+    movq         [dstq + xq + %2], xm%1
+%else
+    packusdw     xm%1, xm3
+    movu         [dstq + 2 * xq + 2 * %2], xm%1
+%endif
+%endif
+%endmacro
+
+%macro CONVERT 1
+    cvtdq2ps     m%1, m%1
+    mulps        m%1, m0     ; sum *= rdiv
+    addps        m%1, m1     ; sum += bias
+    addps        m%1, m5     ; sum += 0.5
+    cvttps2dq    m%1, m%1
+%endmacro
+
+; void filter_5x5_avx2(uint8_t *dst, int width,
+;                      float rdiv, float bias, const int *const matrix,
+;                      const uint8_t *c[], int peak, int radius,
+;                      int dstride, int stride)
+
+; %1: function name, %2: number of taps (0 for 2 * radius + 1),
+; %3: bytes per sample
+%macro FILTER 3
+%define BPC %3
+%if UNIX64
+cglobal %1, 6, 11, 8, dst, width, matrix, ptr, peak, radius, taps, x, i, src, vend
+%else
+cglobal %1, 8, 13, 8, dst, width, rdiv, bias, matrix, ptr, peak, radius, taps, x, i, src, vend
+%endif
+
+%if WIN64
+    SWAP m0, m2
+    SWAP m1, m3
+%endif
+    movsxdifnidn widthq, widthd
+    VBROADCASTSS m0, xm0
+    VBROADCASTSS m1, xm1
+    VBROADCASTSS m5, [half]
+%if BPC == 2
+    movd         xm7, peakd
+    vpbroadcastd m7, xm7
+%endif
+%if %2
+    mov          tapsd, %2
+%else
+    lea          tapsd, [2 * radiusq + 1]
+%endif
+
+    mov          vendq, widthq
+    xor          xq, xq
+    and          vendq, ~(mmsize / 2 - 1)
+    jle .tail_check
+
+.loop:
+    pxor         m4, m4
+    pxor         m6, m6
+    xor          id, id
+.taps:
+    vpbroadcastd m2, [matrixq + 4 * iq]
+    LOAD          3, iq, 0
+    pmulld       m3, m2
+    paddd        m4, m3
+    LOAD          3, iq, mmsize / 4
+    pmulld       m3, m2
+    paddd        m6, m3
+    inc          id
+    cmp          id, tapsd
+    jl .taps
+
+    CONVERT       4
+    CONVERT       6
+    STORE         4, 0
+    STORE         6, mmsize / 4
+
+    add          xq, mmsize / 2
+    cmp          xq, vendq
+    jl .loop
+.tail_check:
+    cmp          xq, widthq
+    jge .end
+
+.tail:
+    pxor         m4, m4
+    xor          id, id
+.tail_taps:
+    vpbroadcastd m2, [matrixq + 4 * iq]
+    LOAD          3, iq, 0, 1
+    pmulld       m3, m2
+    paddd        m4, m3
+    inc          id
+    cmp          id, tapsd
+    jl .tail_taps
+
+    CONVERT       4
+    STORE         4, 0, 1
+
+    inc          xq
+    cmp          xq, widthq
+    jl .tail
+.end:
+    RET
+%endmacro
+
+; The edge operators leave suma in m4 and sumb in m6
+%macro ROBERTS 2
+    LOAD          4, 0, %1, %2
+    LOAD          3, 1, %1, %2
+    psubd        m4, m3      ; suma = c0 - c1
+    LOAD          6, 4, %1, %2
+    LOAD          3, 3, %1, %2
+    psubd        m6, m3      ; sumb = c4 - c3
+%endmacro
+
+%macro PREWITT 2
+    LOAD          4, 6, %1, %2
+    LOAD          3, 7, %1, %2
+    paddd        m4, m3
+    LOAD          3, 8, %1, %2
+    paddd        m4, m3
+    LOAD          3, 0, %1, %2
+    psubd        m4, m3
+    LOAD          3, 1, %1, %2
+    psubd        m4, m3
+    LOAD          3, 2, %1, %2
+    psubd        m4, m3      ; suma = c6 + c7 + c8 - c0 - c1 - c2
+    LOAD          6, 2, %1, %2
+    LOAD          3, 5, %1, %2
+    paddd        m6, m3
+    LOAD          3, 8, %1, %2
+    paddd        m6, m3
+    LOAD          3, 0, %1, %2
+    psubd        m6, m3
+    LOAD          3, 3, %1, %2
+    psubd        m6, m3
+    LOAD          3, 6, %1, %2
+    psubd        m6, m3      ; sumb = c2 + c5 + c8 - c0 - c3 - c6
+%endmacro
+
+%macro SOBEL 2
+    LOAD          4, 7, %1, %2
+    LOAD          3, 1, %1, %2
+    psubd        m4, m3
+    pslld        m4, 1
+    LOAD          3, 6, %1, %2
+    paddd        m4, m3
+    LOAD          3, 8, %1, %2
+    paddd        m4, m3
+    LOAD          3, 0, %1, %2
+    psubd        m4, m3
+    LOAD          3, 2, %1, %2
+    psubd        m4, m3      ; suma = c6 + 2 * c7 + c8 - c0 - 2 * c1 - c2
+    LOAD          6, 5, %1, %2
+    LOAD          3, 3, %1, %2
+    psubd        m6, m3
+    pslld        m6, 1
+    LOAD          3, 2, %1, %2
+    paddd        m6, m3
+    LOAD          3, 8, %1, %2
+    paddd        m6, m3
+    LOAD          3, 0, %1, %2
+    psubd        m6, m3
+    LOAD          3, 6, %1, %2
+    psubd        m6, m3      ; sumb = c2 + 2 * c5 + c8 - c0 - 2 * c3 - c6
+%endmacro
+
+%macro MAGNITUDE 0
+    cvtdq2ps     m4, m4
+    cvtdq2ps     m6, m6
+    mulps        m4, m4
+    mulps        m6, m6
+    addps        m4, m6
+    sqrtps       m4, m4
+    mulps        m4, m0      ; sum *= scale
+    addps        m4, m1      ; sum += delta
+    cvttps2dq    m4, m4
+%endmacro
+
+; %1: function name, %2: operator, %3: bytes per sample
+%macro EDGE 3
+%define BPC %3
+%if UNIX64
+cglobal %1, 6, 9, 8, dst, width, matrix, ptr, peak, radius, x, src, vend
+%else
+cglobal %1, 8, 11, 8, dst, width, scale, delta, matrix, ptr, peak, radius, x, src, vend
+%endif
+
+%if WIN64
+    SWAP m0, m2
+    SWAP m1, m3
+%endif
+    movsxdifnidn widthq, widthd
+    VBROADCASTSS m0, xm0
+    VBROADCASTSS m1, xm1
+%if BPC == 2
+    movd         xm7, peakd
+    vpbroadcastd m7, xm7
+%endif
+
+    mov          vendq, widthq
+    xor          xq, xq
+    and          vendq, ~(mmsize / 4 - 1)
+    jle .tail_check
+
+.loop:
+    %2            0, 0
+    MAGNITUDE
+    STORE         4, 0
+
+    add          xq, mmsize / 4
+    cmp          xq, vendq
+    jl .loop
+.tail_check:
+    cmp          xq, widthq
+    jge .end
+
+.tail:
+    %2            0, 1
+    MAGNITUDE
+    STORE         4, 0, 1
+
+    inc          xq
+    cmp          xq, widthq
+    jl .tail
+.end:
+    RET
+%endmacro
+
+%if ARCH_X86_64 && HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+FILTER filter_5x5,    25, 1
+FILTER filter_7x7,    49, 1
+FILTER filter_row,     0, 1
+FILTER filter16_3x3,   9, 2
+FILTER filter16_5x5,  25, 2
+FILTER filter16_7x7,  49, 2
+FILTER filter16_row,   0, 2
+EDGE   filter_prewitt,   PREWITT, 1
+EDGE   filter_roberts,   ROBERTS, 1
+EDGE   filter_sobel,     SOBEL,   1
+EDGE   filter16_prewitt, PREWITT, 2
+EDGE   filter16_roberts, ROBERTS, 2
+EDGE   filter16_sobel,   SOBEL,   2
+%endif
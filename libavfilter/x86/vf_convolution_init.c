@@ -29,6 +29,71 @@ void ff_filter_3x3_sse4(uint8_t *dst, int width,
                         const uint8_t *c[], int peak, int radius,
                         int dstride, int stride);
 
+void ff_filter_5x5_avx2(uint8_t *dst, int width,
+                        float rdiv, float bias, const int *const matrix,
+                        const uint8_t *c[], int peak, int radius,
+                        int dstride, int stride);
+
+void ff_filter_7x7_avx2(uint8_t *dst, int width,
+                        float rdiv, float bias, const int *const matrix,
+                        const uint8_t *c[], int peak, int radius,
+                        int dstride, int stride);
+
+void ff_filter_row_avx2(uint8_t *dst, int width,
+                        float rdiv, float bias, const int *const matrix,
+                        const uint8_t *c[], int peak, int radius,
+                        int dstride, int stride);
+
+void ff_filter16_3x3_avx2(uint8_t *dst, int width,
+                          float rdiv, float bias, const int *const matrix,
+                          const uint8_t *c[], int peak, int radius,
+                          int dstride, int stride);
+
+void ff_filter16_5x5_avx2(uint8_t *dst, int width,
+                          float rdiv, float bias, const int *const matrix,
+                          const uint8_t *c[], int peak, int radius,
+                          int dstride, int stride);
+
+void ff_filter16_7x7_avx2(uint8_t *dst, int width,
+                          float rdiv, float bias, const int *const matrix,
+                          const uint8_t *c[], int peak, int radius,
+                          int dstride, int stride);
+
+void ff_filter16_row_avx2(uint8_t *dst, int width,
+                          float rdiv, float bias, const int *const matrix,
+                          const uint8_t *c[], int peak, int radius,
+                          int dstride, int stride);
+
+void ff_filter_prewitt_avx2(uint8_t *dst, int width,
+                            float rdiv, float bias, const int *const matrix,
+                            const uint8_t *c[], int peak, int radius,
+                            int dstride, int stride);
+
+void ff_filter_roberts_avx2(uint8_t *dst, int width,
+                            float rdiv, float bias, const int *const matrix,
+                            const uint8_t *c[], int peak, int radius,
+                            int dstride, int stride);
+
+void ff_filter_sobel_avx2(uint8_t *dst, int width,
+                          float rdiv, float bias, const int *const matrix,
+                          const uint8_t *c[], int peak, int radius,
+                          int dstride, int stride);
+
+void ff_filter16_prewitt_avx2(uint8_t *dst, int width,
+                              float rdiv, float bias, const int *const matrix,
+                              const uint8_t *c[], int peak, int radius,
+                              int dstride, int stride);
+
+void ff_filter16_roberts_avx2(uint8_t *dst, int width,
+                              float rdiv, float bias, const int *const matrix,
+                              const uint8_t *c[], int peak, int radius,
+                              int dstride, int stride);
+
+void ff_filter16_sobel_avx2(uint8_t *dst, int width,
+                            float rdiv, float bias, const int *const matrix,
+                            const uint8_t *c[], int peak, int radius,
+                            int dstride, int stride);
+
 av_cold void ff_convolution_init_x86(ConvolutionContext *s)
 {
 #if ARCH_X86_64
@@ -40,7 +105,50 @@ av_cold void ff_convolution_init_x86(ConvolutionContext *s)
                 if (EXTERNAL_SSE4(cpu_flags))
                     s->filter[i] = ff_filter_3x3_sse4;
             }
+            if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+                if (s->matrix_length[i] == 9 && s->depth > 8)
+                    s->filter[i] = ff_filter16_3x3_avx2;
+                else if (s->matrix_length[i] == 25)
+                    s->filter[i] = s->depth > 8 ? ff_filter16_5x5_avx2 : ff_filter_5x5_avx2;
+                else if (s->matrix_length[i] == 49)
+                    s->filter[i] = s->depth > 8 ? ff_filter16_7x7_avx2 : ff_filter_7x7_avx2;
+            }
+        } else if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+            s->filter[i] = s->depth > 8 ? ff_filter16_row_avx2 : ff_filter_row_avx2;
         }
     }
 #endif
 }
+
+av_cold void ff_prewitt_init_x86(ConvolutionContext *s)
+{
+#if ARCH_X86_64
+    int i;
+    int cpu_flags = av_get_cpu_flags();
+    if (EXTERNAL_AVX2_FAST(cpu_flags))
+        for (i = 0; i < 4; i++)
+            s->filter[i] = s->depth > 8 ? ff_filter16_prewitt_avx2 : ff_filter_prewitt_avx2;
+#endif
+}
+
+av_cold void ff_roberts_init_x86(ConvolutionContext *s)
+{
+#if ARCH_X86_64
+    int i;
+    int cpu_flags = av_get_cpu_flags();
+    if (EXTERNAL_AVX2_FAST(cpu_flags))
+        for (i = 0; i < 4; i++)
+            s->filter[i] = s->depth > 8 ? ff_filter16_roberts_avx2 : ff_filter_roberts_avx2;
+#endif
+}
+
+av_cold void ff_sobel_init_x86(ConvolutionContext *s)
+{
+#if ARCH_X86_64
+    int i;
+    int cpu_flags = av_get_cpu_flags();
+    if (EXTERNAL_AVX2_FAST(cpu_flags))
+        for (i = 0; i < 4; i++)
+            s->filter[i] = s->depth > 8 ? ff_filter16_sobel_avx2 : ff_filter_sobel_avx2;
+#endif
+}
@@ -0,0 +1,193 @@
+;*****************************************************************************
+;* x86-optimized functions for fieldmatch filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+;------------------------------------------------------------------------------
+; int64_t ff_fieldmatch_sad(const uint8_t *a, ptrdiff_t a_linesize,
+;                           const uint8_t *b, ptrdiff_t b_linesize,
+;                           int width, int height)
+;------------------------------------------------------------------------------
+
+%macro SAD 0
+cglobal fieldmatch_sad, 6, 7, 3, a, a_linesize, b, b_linesize, w, h, x
+    movsxdifnidn      wq, wd
+    add               aq, wq
+    add               bq, wq
+    neg               wq
+    pxor              m2, m2
+
+.row:
+    mov               xq, wq
+.col:
+    movu              m0, [aq + xq]
+    movu              m1, [bq + xq]
+    psadbw            m0, m1
+    paddq             m2, m0
+    add               xq, mmsize
+    jl .col
+
+    add               aq, a_linesizeq
+    add               bq, b_linesizeq
+    dec               hd
+    jg .row
+
+%if mmsize == 32
+    vextracti128     xm0, m2, 1
+    paddq            xm2, xm0
+%endif
+    movhlps          xm0, xm2
+    paddq            xm2, xm0
+%if ARCH_X86_64
+    movq             rax, xm2
+%else
+    movd             eax, xm2
+    psrlq            xm2, 32
+    movd             edx, xm2
+%endif
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_fieldmatch_abs_diff(uint8_t *dst, const uint8_t *a, const uint8_t *b,
+;                             int width)
+;------------------------------------------------------------------------------
+
+%macro ABS_DIFF 0
+cglobal fieldmatch_abs_diff, 4, 4, 3, dst, a, b, w
+    movsxdifnidn      wq, wd
+    add             dstq, wq
+    add               aq, wq
+    add               bq, wq
+    neg               wq
+
+.loop:
+    movu              m0, [aq + wq]
+    movu              m1, [bq + wq]
+    psubusb           m2, m0, m1
+    psubusb           m1, m0
+    por               m1, m2
+    movu     [dstq + wq], m1
+    add               wq, mmsize
+    jl .loop
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_fieldmatch_comb_mask(uint8_t *dst, const uint8_t *prv2,
+;                              const uint8_t *prv, const uint8_t *cur,
+;                              const uint8_t *nxt, const uint8_t *nxt2,
+;                              int width, int cthresh)
+;------------------------------------------------------------------------------
+
+; The vertical filter result lies in [-1530, 1530] so it is computed on words.
+%macro COMB_MASK 0
+cglobal fieldmatch_comb_mask, 7, 7, 11, dst, prv2, prv, cur, nxt, nxt2, w
+    movd             xm5, r7m
+    SPLATW            m5, xm5
+    paddw             m6, m5, m5
+    paddw             m6, m5
+    paddw             m6, m6                ; 6 * cthresh
+    packuswb          m5, m5                ; cthresh
+    pxor              m7, m7
+    movsxdifnidn      wq, wd
+    add             dstq, wq
+    add            prv2q, wq
+    add             prvq, wq
+    add             curq, wq
+    add             nxtq, wq
+    add            nxt2q, wq
+    neg               wq
+
+.loop:
+    movu              m0, [curq + wq]
+    movu              m1, [prvq + wq]
+    movu              m2, [nxtq + wq]
+
+    ; not combed where min(|cur - prv|, |cur - nxt|) <= cthresh
+    psubusb           m3, m0, m1
+    psubusb           m4, m1, m0
+    por               m3, m4
+    psubusb           m4, m0, m2
+    psubusb           m8, m2, m0
+    por               m4, m8
+    pminub            m3, m4
+    psubusb           m3, m5
+    pcmpeqb           m3, m7
+
+    ; 4 * cur - 3 * (prv + nxt) + (prv2 + nxt2)
+    punpcklbw         m4, m1, m7
+    punpckhbw         m1, m7
+    punpcklbw         m8, m2, m7
+    punpckhbw         m2, m7
+    paddw             m4, m8
+    paddw             m1, m2
+    movu              m2, [prv2q + wq]
+    movu              m8, [nxt2q + wq]
+    punpcklbw         m9, m2, m7
+    punpckhbw         m2, m7
+    punpcklbw        m10, m8, m7
+    punpckhbw         m8, m7
+    paddw             m9, m10
+    paddw             m2, m8
+    punpcklbw         m8, m0, m7
+    punpckhbw         m0, m7
+    psllw             m8, 2
+    psllw             m0, 2
+    paddw             m8, m9
+    paddw             m0, m2
+    paddw             m9, m4, m4
+    paddw             m4, m9
+    paddw             m9, m1, m1
+    paddw             m1, m9
+    psubw             m8, m4
+    psubw             m0, m1
+
+    ; |filter| > 6 * cthresh
+    psubw             m4, m7, m8
+    pmaxsw            m8, m4
+    psubw             m4, m7, m0
+    pmaxsw            m0, m4
+    pcmpgtw           m8, m6
+    pcmpgtw           m0, m6
+    packsswb          m8, m0
+
+    pandn             m3, m8
+    movu     [dstq + wq], m3
+    add               wq, mmsize
+    jl .loop
+    RET
+%endmacro
+
+INIT_XMM sse2
+SAD
+ABS_DIFF
+%if ARCH_X86_64
+COMB_MASK
+%endif
+
+INIT_YMM avx2
+SAD
+ABS_DIFF
+%if ARCH_X86_64
+COMB_MASK
+%endif
@@ -0,0 +1,102 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/fieldmatch.h"
+
+#define FIELDMATCH_FUNCS(opt, mmsize)                                              \
+int64_t ff_fieldmatch_sad_##opt(const uint8_t *a, ptrdiff_t a_linesize,            \
+                                const uint8_t *b, ptrdiff_t b_linesize,            \
+                                int width, int height);                            \
+void ff_fieldmatch_abs_diff_##opt(uint8_t *dst, const uint8_t *a,                  \
+                                  const uint8_t *b, int width);                    \
+void ff_fieldmatch_comb_mask_##opt(uint8_t *dst, const uint8_t *m2,                \
+                                   const uint8_t *m1, const uint8_t *cur,          \
+                                   const uint8_t *p1, const uint8_t *p2,           \
+                                   int width, int cthresh);                        \
+                                                                                   \
+static int64_t fieldmatch_sad_##opt(const uint8_t *a, ptrdiff_t a_linesize,        \
+                                    const uint8_t *b, ptrdiff_t b_linesize,        \
+                                    int width, int height)                         \
+{                                                                                  \
+    const int w = width & ~(mmsize - 1);                                           \
+    int64_t sad = 0;                                                               \
+                                                                                   \
+    if (w)                                                                         \
+        sad = ff_fieldmatch_sad_##opt(a, a_linesize, b, b_linesize, w, height);   \
+    if (width > w)                                                                 \
+        sad += ff_fieldmatch_sad_c(a + w, a_linesize, b + w, b_linesize,          \
+                                   width - w, height);                             \
+    return sad;                                                                    \
+}                                                                                  \
+                                                                                   \
+static void fieldmatch_abs_diff_##opt(uint8_t *dst, const uint8_t *a,              \
+                                      const uint8_t *b, int width)                 \
+{                                                                                  \
+    const int w = width & ~(mmsize - 1);                                           \
+                                                                                   \
+    if (w)                                                                         \
+        ff_fieldmatch_abs_diff_##opt(dst, a, b, w);                                \
+    if (width > w)                                                                 \
+        ff_fieldmatch_abs_diff_c(dst + w, a + w, b + w, width - w);                \
+}                                                                                  \
+                                                                                   \
+static av_unused void fieldmatch_comb_mask_##opt(uint8_t *dst, const uint8_t *m2,  \
+                                                 const uint8_t *m1,                \
+                                                 const uint8_t *cur,               \
+                                                 const uint8_t *p1,                \
+                                                 const uint8_t *p2,                \
+                                                 int width, int cthresh)           \
+{                                                                                  \
+    const int w = width & ~(mmsize - 1);                                           \
+                                                                                   \
+    if (w)                                                                         \
+        ff_fieldmatch_comb_mask_##opt(dst, m2, m1, cur, p1, p2, w, cthresh);       \
+    if (width > w)                                                                 \
+        ff_fieldmatch_comb_mask_c(dst + w, m2 + w, m1 + w, cur + w, p1 + w, p2 + w,\
+                                  width - w, cthresh);                             \
+}
+
+#if HAVE_X86ASM
+FIELDMATCH_FUNCS(sse2, 16)
+FIELDMATCH_FUNCS(avx2, 32)
+#endif
+
+av_cold void ff_fieldmatch_init_x86(FieldMatchDSPContext *dsp)
+{
+#if HAVE_X86ASM
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE2(cpu_flags)) {
+        dsp->sad      = fieldmatch_sad_sse2;
+        dsp->abs_diff = fieldmatch_abs_diff_sse2;
+        if (ARCH_X86_64)
+            dsp->comb_mask = fieldmatch_comb_mask_sse2;
+    }
+
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        dsp->sad      = fieldmatch_sad_avx2;
+        dsp->abs_diff = fieldmatch_abs_diff_avx2;
+        if (ARCH_X86_64)
+            dsp->comb_mask = fieldmatch_comb_mask_avx2;
+    }
+#endif
+}
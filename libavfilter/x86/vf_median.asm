@@ -0,0 +1,78 @@
+;*****************************************************************************
+;* x86-optimized functions for median filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION .text
+
+; The histograms have a multiple of 16 bins, the counters wrap around like
+; the uint16_t arithmetic of the C versions.
+
+;%1 name ; %2 add or sub
+%macro HISTOGRAM_ADDSUB 2
+; void ff_median_%1(uint16_t *dst, const uint16_t *src, int bins)
+cglobal median_%1, 3, 3, 2, dst, src, bins
+    movsxdifnidn binsq, binsd
+    add          binsq, binsq
+    add           dstq, binsq
+    add           srcq, binsq
+    neg          binsq
+.loop:
+    movu            m0, [dstq + binsq]
+    movu            m1, [srcq + binsq]
+    p%2w            m0, m1
+    movu [dstq + binsq], m0
+    add          binsq, mmsize
+    jl .loop
+    RET
+%endmacro
+
+%macro HISTOGRAM_MULADD 0
+; void ff_median_hmuladd(uint16_t *dst, const uint16_t *src, int f, int bins)
+cglobal median_hmuladd, 4, 4, 3, dst, src, f, bins
+    movsxdifnidn binsq, binsd
+    movd           xm2, fd
+    SPLATW          m2, xm2
+    add          binsq, binsq
+    add           dstq, binsq
+    add           srcq, binsq
+    neg          binsq
+.loop:
+    movu            m0, [srcq + binsq]
+    movu            m1, [dstq + binsq]
+    pmullw          m0, m2
+    paddw           m0, m1
+    movu [dstq + binsq], m0
+    add          binsq, mmsize
+    jl .loop
+    RET
+%endmacro
+
+INIT_XMM sse2
+HISTOGRAM_ADDSUB hadd, add
+HISTOGRAM_ADDSUB hsub, sub
+HISTOGRAM_MULADD
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+HISTOGRAM_ADDSUB hadd, add
+HISTOGRAM_ADDSUB hsub, sub
+HISTOGRAM_MULADD
+%endif
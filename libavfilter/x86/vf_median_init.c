@@ -0,0 +1,46 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/median.h"
+
+#define MEDIAN_FUNCS(opt)                                                          \
+void ff_median_hadd_##opt(uint16_t *dst, const uint16_t *src, int bins);          \
+void ff_median_hsub_##opt(uint16_t *dst, const uint16_t *src, int bins);          \
+void ff_median_hmuladd_##opt(uint16_t *dst, const uint16_t *src, int f, int bins);
+
+MEDIAN_FUNCS(sse2)
+MEDIAN_FUNCS(avx2)
+
+av_cold void ff_median_init_x86(MedianContext *s)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE2(cpu_flags)) {
+        s->hadd    = ff_median_hadd_sse2;
+        s->hsub    = ff_median_hsub_sse2;
+        s->hmuladd = ff_median_hmuladd_sse2;
+    }
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        s->hadd    = ff_median_hadd_avx2;
+        s->hsub    = ff_median_hsub_avx2;
+        s->hmuladd = ff_median_hmuladd_avx2;
+    }
+}
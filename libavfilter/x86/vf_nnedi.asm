@@ -0,0 +1,223 @@
+;*****************************************************************************
+;* x86-optimized functions for nnedi filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or modify
+;* it under the terms of the GNU General Public License as published by
+;* the Free Software Foundation; either version 2 of the License, or
+;* (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;* GNU General Public License for more details.
+;*
+;* You should have received a copy of the GNU General Public License along
+;* with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+;* 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pf_1:       times 8 dd 1.0
+pf_exp_lo:  times 8 dd -80.0
+pf_exp_hi:  times 8 dd 80.0
+pf_log2e:   times 8 dd 1.44269504088896341
+pf_ln2_hi:  times 8 dd 0.693359375
+pf_ln2_lo:  times 8 dd -2.12194440e-4
+pf_exp_p0:  times 8 dd 1.9875691500e-4
+pf_exp_p1:  times 8 dd 1.3981999507e-3
+pf_exp_p2:  times 8 dd 8.3334519073e-3
+pf_exp_p3:  times 8 dd 4.1665795894e-2
+pf_exp_p4:  times 8 dd 1.6666665459e-1
+pf_exp_p5:  times 8 dd 5.0000001201e-1
+pd_127:     times 8 dd 127
+pd_abs:     times 8 dd 0x7fffffff
+
+SECTION .text
+
+;------------------------------------------------------------------------------
+; void ff_nnedi_prescreen_l0(float *dst, const float *kernel,
+;                            const float *input, int n)
+;------------------------------------------------------------------------------
+
+%macro PRESCREEN_L0 0
+cglobal nnedi_prescreen_l0, 4, 4, 7, dst, kernel, src, n
+    movsxdifnidn      nq, nd
+    lea             srcq, [srcq + 4 * nq]
+    neg               nq
+    xorps             m0, m0
+    xorps             m1, m1
+    xorps             m2, m2
+    xorps             m3, m3
+
+; every kernel row holds the weights of one input for all four neurons
+.loop:
+    movu              m4, [srcq + 4 * nq]
+    shufps            m5, m4, m4, q0000
+    FMULADD_PS        m0, m5, [kernelq + 0 * mmsize], m0, m6
+    shufps            m5, m4, m4, q1111
+    FMULADD_PS        m1, m5, [kernelq + 1 * mmsize], m1, m6
+    shufps            m5, m4, m4, q2222
+    FMULADD_PS        m2, m5, [kernelq + 2 * mmsize], m2, m6
+    shufps            m4, m4, m4, q3333
+    FMULADD_PS        m3, m4, [kernelq + 3 * mmsize], m3, m6
+    add          kernelq, 4 * mmsize
+    add               nq, 4
+    jl .loop
+
+    addps             m0, m1
+    addps             m2, m3
+    addps             m0, m2
+    movu          [dstq], m0
+    RET
+%endmacro
+
+INIT_XMM sse
+PRESCREEN_L0
+INIT_XMM fma3
+PRESCREEN_L0
+
+;------------------------------------------------------------------------------
+; void ff_nnedi_predict(float *dst, const float *weights, const float *bias,
+;                       const float *input, int n, int cols, float scale)
+;------------------------------------------------------------------------------
+
+; Each pass over the input window produces mmsize output neurons, held in
+; four accumulators, with the weight rows being cols floats apart.
+%macro PREDICT 0
+cglobal nnedi_predict, 6, 9, 7, dst, weights, bias, src, n, cols, k, w, stride
+%if UNIX64 == 0
+    movss            xm0, r6m
+%endif
+    shufps           xm0, xm0, q0000
+%if mmsize == 32
+    vinsertf128       m0, m0, xm0, 1
+%endif
+    movsxdifnidn      nq, nd
+    movsxdifnidn   colsq, colsd
+    lea          strideq, [colsq * 4]
+    lea             srcq, [srcq + nq * 4]
+    neg               nq
+
+.block:
+    mov               kq, nq
+    mov               wq, weightsq
+    xorps             m1, m1
+    xorps             m2, m2
+    xorps             m3, m3
+    xorps             m4, m4
+
+.loop:
+    VBROADCASTSS      m5, [srcq + kq * 4]
+    FMULADD_PS        m1, m5, [wq + 0 * mmsize], m1, m6
+    FMULADD_PS        m2, m5, [wq + 1 * mmsize], m2, m6
+    FMULADD_PS        m3, m5, [wq + 2 * mmsize], m3, m6
+    FMULADD_PS        m4, m5, [wq + 3 * mmsize], m4, m6
+    add               wq, strideq
+    inc               kq
+    jl .loop
+
+    mulps             m1, m0
+    mulps             m2, m0
+    mulps             m3, m0
+    mulps             m4, m0
+    addps             m1, [biasq + 0 * mmsize]
+    addps             m2, [biasq + 1 * mmsize]
+    addps             m3, [biasq + 2 * mmsize]
+    addps             m4, [biasq + 3 * mmsize]
+    mova [dstq + 0 * mmsize], m1
+    mova [dstq + 1 * mmsize], m2
+    mova [dstq + 2 * mmsize], m3
+    mova [dstq + 3 * mmsize], m4
+
+    add             dstq, 4 * mmsize
+    add            biasq, 4 * mmsize
+    add         weightsq, 4 * mmsize
+    sub            colsq, mmsize
+    jg .block
+    RET
+%endmacro
+
+%if ARCH_X86_64
+INIT_XMM sse
+PREDICT
+INIT_YMM avx
+PREDICT
+INIT_YMM fma3
+PREDICT
+%endif
+
+;------------------------------------------------------------------------------
+; void ff_nnedi_wae5(const float *softmax, const float *elliott, int n,
+;                    float *sums)
+;------------------------------------------------------------------------------
+
+%macro WAE5 0
+cglobal nnedi_wae5, 4, 4, 7, softmax, el, n, sums
+    movsxdifnidn      nq, nd
+    shl               nq, 2
+    add         softmaxq, nq
+    add              elq, nq
+    neg               nq
+    xorps             m0, m0                ; sum of weighted elliott neurons
+    xorps             m1, m1                ; sum of weights
+
+.loop:
+    ; w = exp(x), x being clipped to [-80, 80] so 2^n stays a normal float
+    movu              m2, [softmaxq + nq]
+    maxps             m2, [pf_exp_lo]
+    minps             m2, [pf_exp_hi]
+    mulps             m3, m2, [pf_log2e]
+    cvtps2dq          m3, m3                ; n = round(x * log2(e))
+    cvtdq2ps          m4, m3
+    mulps             m5, m4, [pf_ln2_hi]
+    subps             m2, m5
+    mulps             m4, [pf_ln2_lo]
+    subps             m2, m4                ; r = x - n * ln(2)
+    mova              m4, [pf_exp_p0]
+    FMULADD_PS        m4, m4, m2, [pf_exp_p1], m5
+    FMULADD_PS        m4, m4, m2, [pf_exp_p2], m5
+    FMULADD_PS        m4, m4, m2, [pf_exp_p3], m5
+    FMULADD_PS        m4, m4, m2, [pf_exp_p4], m5
+    FMULADD_PS        m4, m4, m2, [pf_exp_p5], m5
+    mulps             m5, m2, m2
+    FMULADD_PS        m4, m4, m5, m2, m6
+    addps             m4, [pf_1]            ; exp(r)
+    paddd             m3, [pd_127]
+    pslld             m3, 23                ; 2^n
+    mulps             m4, m3
+
+    ; elliott(y) = y / (1 + |y|)
+    movu              m2, [elq + nq]
+    andps             m5, m2, [pd_abs]
+    addps             m5, [pf_1]
+    divps             m2, m5
+
+    FMULADD_PS        m0, m4, m2, m0, m5
+    addps             m1, m4
+    add               nq, mmsize
+    jl .loop
+
+%if mmsize == 32
+    vextractf128     xm2, m0, 1
+    vextractf128     xm3, m1, 1
+    addps            xm0, xm2
+    addps            xm1, xm3
+%endif
+    unpcklps         xm2, xm0, xm1
+    unpckhps         xm0, xm1
+    addps            xm0, xm2
+    movhlps          xm2, xm0
+    addps            xm0, xm2
+    movq         [sumsq], xm0
+    RET
+%endmacro
+
+INIT_XMM sse2
+WAE5
+INIT_YMM avx2
+WAE5
@@ -0,0 +1,65 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/nnedi.h"
+
+void ff_nnedi_prescreen_l0_sse(float *dst, const float *kernel,
+                               const float *input, int n);
+void ff_nnedi_prescreen_l0_fma3(float *dst, const float *kernel,
+                                const float *input, int n);
+
+void ff_nnedi_predict_sse(float *dst, const float *weights, const float *bias,
+                          const float *input, int n, int cols, float scale);
+void ff_nnedi_predict_avx(float *dst, const float *weights, const float *bias,
+                          const float *input, int n, int cols, float scale);
+void ff_nnedi_predict_fma3(float *dst, const float *weights, const float *bias,
+                           const float *input, int n, int cols, float scale);
+
+void ff_nnedi_wae5_sse2(const float *softmax, const float *elliott, int n,
+                        float *sums);
+void ff_nnedi_wae5_avx2(const float *softmax, const float *elliott, int n,
+                        float *sums);
+
+av_cold void ff_nnedi_init_x86(NNEDIDSPContext *dsp)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (EXTERNAL_SSE(cpu_flags)) {
+        dsp->prescreen_l0 = ff_nnedi_prescreen_l0_sse;
+        if (ARCH_X86_64)
+            dsp->predict = ff_nnedi_predict_sse;
+    }
+
+    if (EXTERNAL_SSE2(cpu_flags))
+        dsp->wae5 = ff_nnedi_wae5_sse2;
+
+    if (ARCH_X86_64 && EXTERNAL_AVX_FAST(cpu_flags))
+        dsp->predict = ff_nnedi_predict_avx;
+
+    if (EXTERNAL_FMA3_FAST(cpu_flags)) {
+        dsp->prescreen_l0 = ff_nnedi_prescreen_l0_fma3;
+        if (ARCH_X86_64)
+            dsp->predict = ff_nnedi_predict_fma3;
+    }
+
+    if (EXTERNAL_AVX2_FAST(cpu_flags))
+        dsp->wae5 = ff_nnedi_wae5_avx2;
+}
@@ -23,68 +23,76 @@
 
 %include "libavutil/x86/x86util.asm"
 
-SECTION_RODATA
+SECTION_RODATA 32
 
-pb_1:     times 16 db 1
-pw_128:   times  8 dw 128
-pw_255:   times  8 dw 255
-pw_257:   times  8 dw 257
+pb_1:     times 32 db 1
+pw_1:     times 16 dw 1
+pw_128:   times 16 dw 128
+pw_m128:  times 16 dw -128
+pw_255:   times 16 dw 255
+pw_257:   times 16 dw 257
+pw_1023:  times 16 dw 1023
+pd_1:     times  8 dd 1
 
 SECTION .text
 
-INIT_XMM sse4
-cglobal overlay_row_44, 5, 7, 6, 0, d, da, s, a, w, r, x
-    xor          xq, xq
-    movsxdifnidn wq, wd
-    mov          rq, wq
-    and          rq, mmsize/2 - 1
-    cmp          wq, mmsize/2
-    jl .end
-    sub          wq, rq
-    mova         m3, [pw_255]
-    mova         m4, [pw_128]
-    mova         m5, [pw_257]
-    .loop:
-        pmovzxbw    m0, [sq+xq]
-        pmovzxbw    m2, [aq+xq]
-        pmovzxbw    m1, [dq+xq]
-        pmullw      m0, m2
-        pxor        m2, m3
-        pmullw      m1, m2
-        paddw       m0, m4
-        paddw       m0, m1
-        pmulhuw     m0, m5
-        packuswb    m0, m0
-        movq   [dq+xq], m0
-        add         xq, mmsize/2
-        cmp         xq, wq
-        jl .loop
-
-    .end:
-    mov    eax, xd
-    RET
-
-INIT_XMM sse4
-cglobal overlay_row_22, 5, 7, 6, 0, d, da, s, a, w, r, x
+; Common prologue of the row functions: rows with subsampled chroma leave
+; their last pixel to the C code, and only whole vectors are blended.
+; %1 alpha subsampling
+%macro OVERLAY_ROW_PROLOGUE 1
+%if %1 == 20
+    mov         daq, aq
+    add         daq, rmp
+%endif
     xor          xq, xq
     movsxdifnidn wq, wd
+%if %1 != 44
     sub          wq, 1
+%endif
     mov          rq, wq
     and          rq, mmsize/2 - 1
     cmp          wq, mmsize/2
     jl .end
     sub          wq, rq
+%endmacro
+
+; int ff_overlay_row_XX(uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a,
+;                       int w, ptrdiff_t alinesize)
+; %1 alpha subsampling: 44, 22 (horizontal) or 20 (horizontal and vertical)
+; %2 blending: straight, pm (premultiplied) or pm_uv (premultiplied chroma)
+%macro OVERLAY_ROW 2
+%ifidn %2, straight
+cglobal overlay_row_%1, 5 + (%1 == 20), 7, 7, 0, d, da, s, a, w, r, x
+%else
+cglobal overlay_row_%1_%2, 5 + (%1 == 20), 7, 7, 0, d, da, s, a, w, r, x
+%endif
+    OVERLAY_ROW_PROLOGUE %1
     mova         m3, [pw_255]
     mova         m4, [pw_128]
     mova         m5, [pw_257]
+%if %1 == 20
+    mova         m6, [pb_1]
+%endif
     .loop:
-        pmovzxbw    m0, [sq+xq]
+%if %1 == 44
+        pmovzxbw    m2, [aq+xq]
+%elif %1 == 22
         movu        m1, [aq+2*xq]
         pandn       m2, m3, m1
         psllw       m1, 8
         pavgw       m2, m1
         pavgw       m2, m1
         psrlw       m2, 8
+%else
+        movu        m2, [aq+2*xq]
+        movu        m1, [daq+2*xq]
+        pmaddubsw   m2, m6
+        pmaddubsw   m1, m6
+        paddw       m2, m1
+        psrlw       m2, 2
+%endif
+%ifidn %2, straight
+        pmovzxbw    m0, [sq+xq]
         pmovzxbw    m1, [dq+xq]
         pmullw      m0, m2
         pxor        m2, m3
@@ -92,8 +100,38 @@ cglobal overlay_row_22, 5, 7, 6, 0, d, da, s, a, w, r, x
         paddw       m0, m4
         paddw       m0, m1
         pmulhuw     m0, m5
+%elifidn %2, pm
+        pmovzxbw    m1, [dq+xq]
+        pxor        m2, m3
+        pmullw      m1, m2
+        paddw       m1, m4
+        pmulhuw     m1, m5
+        pmovzxbw    m0, [sq+xq]
+        paddw       m0, m1
+%else
+        ; signed as the chroma is centered on 128, the sum may reach 256
+        ; which is stored as 0 like in the C version
+        pmovzxbw    m1, [dq+xq]
+        psubw       m1, m4
+        pxor        m2, m3
+        pmullw      m1, m2
+        paddw       m1, m4
+        pmulhw      m1, m5
+        pmovzxbw    m0, [sq+xq]
+        paddw       m0, m1
+        psubw       m0, m4
+        pmaxsw      m0, [pw_m128]
+        pminsw      m0, m4
+        paddw       m0, m4
+        pand        m0, m3
+%endif
         packuswb    m0, m0
+%if mmsize == 32
+        vpermq      m0, m0, q0020
+        movu   [dq+xq], xm0
+%else
         movq   [dq+xq], m0
+%endif
         add         xq, mmsize/2
         cmp         xq, wq
         jl .loop
@@ -101,40 +139,70 @@ cglobal overlay_row_22, 5, 7, 6, 0, d, da, s, a, w, r, x
     .end:
     mov    eax, xd
     RET
+%endmacro
 
-INIT_XMM sse4
-cglobal overlay_row_20, 6, 7, 7, 0, d, da, s, a, w, r, x
-    mov         daq, aq
-    add         daq, rmp
-    xor          xq, xq
-    movsxdifnidn wq, wd
-    sub          wq, 1
-    mov          rq, wq
-    and          rq, mmsize/2 - 1
-    cmp          wq, mmsize/2
-    jl .end
-    sub          wq, rq
-    mova         m3, [pw_255]
-    mova         m4, [pw_128]
-    mova         m5, [pw_257]
-    mova         m6, [pb_1]
+; Straight blending of 10 bits samples, the division by 1023 is exact for
+; the whole range of d * (1023 - a) + s * a.
+; %1 alpha subsampling
+%macro OVERLAY_ROW_10 1
+cglobal overlay_row_%1_10, 5 + (%1 == 20), 7, 8, 0, d, da, s, a, w, r, x
+    OVERLAY_ROW_PROLOGUE %1
+    mova         m7, [pw_1023]
     .loop:
-        pmovzxbw    m0, [sq+xq]
+%if %1 == 44
         movu        m2, [aq+2*xq]
-        movu        m1, [daq+2*xq]
-        pmaddubsw   m2, m6
-        pmaddubsw   m1, m6
-        paddw       m2, m1
-        psrlw       m2, 2
-        pmovzxbw    m1, [dq+xq]
-        pmullw      m0, m2
-        pxor        m2, m3
-        pmullw      m1, m2
-        paddw       m0, m4
-        paddw       m0, m1
-        pmulhuw     m0, m5
-        packuswb    m0, m0
-        movq   [dq+xq], m0
+%else
+        movu        m2, [aq+4*xq]
+        movu        m1, [aq+4*xq+mmsize]
+%if %1 == 22
+        pslld       m5, m2, 16
+        pslld       m6, m1, 16
+        psrld       m5, 16
+        psrld       m6, 16
+        psrld       m2, 16
+        psrld       m1, 16
+        paddd       m2, m5
+        paddd       m1, m6
+        psrld       m2, 1
+        psrld       m1, 1
+        paddd       m2, m5
+        paddd       m1, m6
+        psrld       m2, 1
+        psrld       m1, 1
+%else
+        movu        m5, [daq+4*xq]
+        movu        m6, [daq+4*xq+mmsize]
+        paddw       m2, m5
+        paddw       m1, m6
+        pmaddwd     m2, [pw_1]
+        pmaddwd     m1, [pw_1]
+        psrld       m2, 2
+        psrld       m1, 2
+%endif
+        packssdw    m2, m1
+%if mmsize == 32
+        vpermq      m2, m2, q3120
+%endif
+%endif
+        movu        m0, [dq+2*xq]
+        movu        m1, [sq+2*xq]
+        pxor        m3, m2, m7
+        punpcklwd   m4, m0, m1
+        punpckhwd   m0, m1
+        punpcklwd   m1, m3, m2
+        punpckhwd   m3, m2
+        pmaddwd     m4, m1
+        pmaddwd     m0, m3
+        psrld       m1, m4, 10
+        psrld       m3, m0, 10
+        paddd       m4, m1
+        paddd       m0, m3
+        paddd       m4, [pd_1]
+        paddd       m0, [pd_1]
+        psrld       m4, 10
+        psrld       m0, 10
+        packusdw    m4, m0
+        movu [dq+2*xq], m4
         add         xq, mmsize/2
         cmp         xq, wq
         jl .loop
@@ -142,3 +210,25 @@ cglobal overlay_row_20, 6, 7, 7, 0, d, da, s, a, w, r, x
     .end:
     mov    eax, xd
     RET
+%endmacro
+
+%macro OVERLAY_ROWS 0
+OVERLAY_ROW 44, straight
+OVERLAY_ROW 22, straight
+OVERLAY_ROW 20, straight
+OVERLAY_ROW 44, pm
+OVERLAY_ROW 44, pm_uv
+OVERLAY_ROW 22, pm_uv
+OVERLAY_ROW 20, pm_uv
+OVERLAY_ROW_10 44
+OVERLAY_ROW_10 22
+OVERLAY_ROW_10 20
+%endmacro
+
+INIT_XMM sse4
+OVERLAY_ROWS
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+OVERLAY_ROWS
+%endif
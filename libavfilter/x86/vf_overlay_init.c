@@ -23,43 +23,73 @@
 #include "libavutil/x86/cpu.h"
 #include "libavfilter/vf_overlay.h"
 
-int ff_overlay_row_44_sse4(uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a,
-                           int w, ptrdiff_t alinesize);
+#define OVERLAY_ROW_FUNC(name, opt)                                            \
+int ff_overlay_row_##name##_##opt(uint8_t *d, uint8_t *da, uint8_t *s,        \
+                                  uint8_t *a, int w, ptrdiff_t alinesize);
 
-int ff_overlay_row_20_sse4(uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a,
-                           int w, ptrdiff_t alinesize);
+#define OVERLAY_ROW_FUNCS(opt)                                                 \
+OVERLAY_ROW_FUNC(44,       opt)                                                \
+OVERLAY_ROW_FUNC(22,       opt)                                                \
+OVERLAY_ROW_FUNC(20,       opt)                                                \
+OVERLAY_ROW_FUNC(44_pm,    opt)                                                \
+OVERLAY_ROW_FUNC(44_pm_uv, opt)                                                \
+OVERLAY_ROW_FUNC(22_pm_uv, opt)                                                \
+OVERLAY_ROW_FUNC(20_pm_uv, opt)                                                \
+OVERLAY_ROW_FUNC(44_10,    opt)                                                \
+OVERLAY_ROW_FUNC(22_10,    opt)                                                \
+OVERLAY_ROW_FUNC(20_10,    opt)
 
-int ff_overlay_row_22_sse4(uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a,
-                           int w, ptrdiff_t alinesize);
+OVERLAY_ROW_FUNCS(sse4)
+OVERLAY_ROW_FUNCS(avx2)
+
+/* Same choice as ff_overlay_init_rows(), which only calls this function
+ * for the formats it has C rows for. */
+#define SET_ROWS(opt)                                                          \
+    switch (format) {                                                          \
+    case OVERLAY_FORMAT_YUV420:                                                \
+        s->blend_row[0] = alpha_format ? ff_overlay_row_44_pm_##opt            \
+                                       : ff_overlay_row_44_##opt;              \
+        s->blend_row[1] = alpha_format ? ff_overlay_row_20_pm_uv_##opt         \
+                                       : ff_overlay_row_20_##opt;              \
+        break;                                                                 \
+    case OVERLAY_FORMAT_YUV422:                                                \
+        s->blend_row[0] = alpha_format ? ff_overlay_row_44_pm_##opt            \
+                                       : ff_overlay_row_44_##opt;              \
+        s->blend_row[1] = alpha_format ? ff_overlay_row_22_pm_uv_##opt         \
+                                       : ff_overlay_row_22_##opt;              \
+        break;                                                                 \
+    case OVERLAY_FORMAT_YUV444:                                                \
+        s->blend_row[0] = alpha_format ? ff_overlay_row_44_pm_##opt            \
+                                       : ff_overlay_row_44_##opt;              \
+        s->blend_row[1] = alpha_format ? ff_overlay_row_44_pm_uv_##opt         \
+                                       : ff_overlay_row_44_##opt;              \
+        break;                                                                 \
+    case OVERLAY_FORMAT_GBRP:                                                  \
+        s->blend_row[0] = alpha_format ? ff_overlay_row_44_pm_##opt            \
+                                       : ff_overlay_row_44_##opt;              \
+        s->blend_row[1] = s->blend_row[0];                                     \
+        break;                                                                 \
+    case OVERLAY_FORMAT_YUV420P10:                                             \
+        s->blend_row[0] = ff_overlay_row_44_10_##opt;                          \
+        s->blend_row[1] = ff_overlay_row_20_10_##opt;                          \
+        break;                                                                 \
+    case OVERLAY_FORMAT_YUV422P10:                                             \
+        s->blend_row[0] = ff_overlay_row_44_10_##opt;                          \
+        s->blend_row[1] = ff_overlay_row_22_10_##opt;                          \
+        break;                                                                 \
+    }                                                                          \
+    s->blend_row[2] = s->blend_row[1];
 
 av_cold void ff_overlay_init_x86(OverlayContext *s, int format, int pix_format,
                                  int alpha_format, int main_has_alpha)
 {
     int cpu_flags = av_get_cpu_flags();
 
-    if (EXTERNAL_SSE4(cpu_flags) &&
-        (format == OVERLAY_FORMAT_YUV444 ||
-         format == OVERLAY_FORMAT_GBRP) &&
-        alpha_format == 0 && main_has_alpha == 0) {
-        s->blend_row[0] = ff_overlay_row_44_sse4;
-        s->blend_row[1] = ff_overlay_row_44_sse4;
-        s->blend_row[2] = ff_overlay_row_44_sse4;
-    }
-
-    if (EXTERNAL_SSE4(cpu_flags) &&
-        (pix_format == AV_PIX_FMT_YUV420P) &&
-        (format == OVERLAY_FORMAT_YUV420) &&
-        alpha_format == 0 && main_has_alpha == 0) {
-        s->blend_row[0] = ff_overlay_row_44_sse4;
-        s->blend_row[1] = ff_overlay_row_20_sse4;
-        s->blend_row[2] = ff_overlay_row_20_sse4;
+    if (EXTERNAL_SSE4(cpu_flags)) {
+        SET_ROWS(sse4)
     }
 
-    if (EXTERNAL_SSE4(cpu_flags) &&
-        (format == OVERLAY_FORMAT_YUV422) &&
-        alpha_format == 0 && main_has_alpha == 0) {
-        s->blend_row[0] = ff_overlay_row_44_sse4;
-        s->blend_row[1] = ff_overlay_row_22_sse4;
-        s->blend_row[2] = ff_overlay_row_22_sse4;
+    if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        SET_ROWS(avx2)
     }
 }
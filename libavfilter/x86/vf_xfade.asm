@@ -0,0 +1,234 @@
+;*****************************************************************************
+;* x86-optimized functions for xfade filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;*****************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pf_0_5: times 8 dd 0.5
+pf_1:   times 8 dd 1.0
+pf_1_5: times 8 dd 1.5
+
+SECTION .text
+
+; Every iteration handles mmsize/2 pixels, held as two vectors of dwords.
+
+; %1 depth, %2 dst register, %3 src pointer, %4 half (0 or 1)
+%macro LOAD_HALF 4
+%if %1 == 8
+    pmovzxbd         m%2, [%3 + xq + %4 * mmsize/4]
+%else
+    pmovzxwd         m%2, [%3 + xq + %4 * mmsize/2]
+%endif
+%endmacro
+
+; %1 depth, %2 low half register, %3 high half register
+%macro STORE_PIXELS 3
+    packusdw         m%2, m%3
+%if cpuflag(avx2)
+    vpermq           m%2, m%2, q3120
+%endif
+%if %1 == 8
+    packuswb         m%2, m%2
+%if cpuflag(avx2)
+    vpermq           m%2, m%2, q2020
+    movu  [dstq + xq], xm%2
+%else
+    movq  [dstq + xq], m%2
+%endif
+%else
+    movu  [dstq + xq], m%2
+%endif
+%endmacro
+
+; %1 depth
+%macro ROW_INIT 1
+    movsxdifnidn widthq, widthd
+%if %1 > 8
+    add          widthq, widthq
+%endif
+    add            dstq, widthq
+    add            xf0q, widthq
+    add            xf1q, widthq
+    mov              xq, widthq
+    neg              xq
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_xfade_fade(uint8_t *dst, const uint8_t *xf0, const uint8_t *xf1,
+;                    int width, float progress)
+;------------------------------------------------------------------------------
+
+%macro XFADE_FADE 1
+cglobal xfade_fade%1, 4, 5, 6, dst, xf0, xf1, width, x
+%if UNIX64 == 0
+    movss            xm0, r4m
+%endif
+    VBROADCASTSS      m0, xm0
+    movu              m1, [pf_1]
+    subps             m1, m0
+    ROW_INIT          %1
+
+.loop:
+    LOAD_HALF         %1, 2, xf0q, 0
+    LOAD_HALF         %1, 3, xf0q, 1
+    LOAD_HALF         %1, 4, xf1q, 0
+    LOAD_HALF         %1, 5, xf1q, 1
+    cvtdq2ps          m2, m2
+    cvtdq2ps          m3, m3
+    cvtdq2ps          m4, m4
+    cvtdq2ps          m5, m5
+    mulps             m2, m0
+    mulps             m3, m0
+    mulps             m4, m1
+    mulps             m5, m1
+    addps             m2, m4
+    addps             m3, m5
+    cvttps2dq         m2, m2
+    cvttps2dq         m3, m3
+    STORE_PIXELS      %1, 2, 3
+    add               xq, mmsize * %1 / 16
+    jl .loop
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_xfade_fadecolor(uint8_t *dst, const uint8_t *xf0, const uint8_t *xf1,
+;                         int width, float progress, float mix0, float mix1,
+;                         float color)
+;------------------------------------------------------------------------------
+
+%macro XFADE_FADECOLOR 1
+cglobal xfade_fadecolor%1, 4, 5, 10, dst, xf0, xf1, width, x
+%if WIN64
+    movss            xm0, r4m
+    movss            xm1, r5m
+    movss            xm2, r6m
+    movss            xm3, r7m
+%endif
+    VBROADCASTSS      m0, xm0               ; progress
+    VBROADCASTSS      m1, xm1               ; mix0
+    VBROADCASTSS      m2, xm2               ; mix1
+    VBROADCASTSS      m3, xm3               ; color
+    movu              m4, [pf_1]
+    subps             m5, m4, m1
+    mulps             m5, m3                ; color * (1 - mix0)
+    subps             m6, m4, m2            ; 1 - mix1
+    mulps             m3, m2                ; color * mix1
+    subps             m4, m0                ; 1 - progress
+    ROW_INIT          %1
+
+.loop:
+    LOAD_HALF         %1, 2, xf0q, 0
+    LOAD_HALF         %1, 7, xf0q, 1
+    LOAD_HALF         %1, 8, xf1q, 0
+    LOAD_HALF         %1, 9, xf1q, 1
+    cvtdq2ps          m2, m2
+    cvtdq2ps          m7, m7
+    cvtdq2ps          m8, m8
+    cvtdq2ps          m9, m9
+    mulps             m2, m1
+    mulps             m7, m1
+    addps             m2, m5
+    addps             m7, m5
+    mulps             m8, m6
+    mulps             m9, m6
+    addps             m8, m3
+    addps             m9, m3
+    mulps             m2, m0
+    mulps             m7, m0
+    mulps             m8, m4
+    mulps             m9, m4
+    addps             m2, m8
+    addps             m7, m9
+    cvttps2dq         m2, m2
+    cvttps2dq         m7, m7
+    STORE_PIXELS      %1, 2, 7
+    add               xq, mmsize * %1 / 16
+    jl .loop
+    RET
+%endmacro
+
+;------------------------------------------------------------------------------
+; void ff_xfade_dissolve(uint8_t *dst, const uint8_t *xf0, const uint8_t *xf1,
+;                        const float *rnd, int width, float progress)
+;------------------------------------------------------------------------------
+
+%macro XFADE_DISSOLVE 1
+cglobal xfade_dissolve%1, 5, 6, 8, dst, xf0, xf1, rnd, width, x
+%if UNIX64 == 0
+    movss            xm0, r5m
+%endif
+    VBROADCASTSS      m0, xm0
+    addps             m0, m0                ; progress * 2
+    movu              m1, [pf_1_5]
+    movu              m7, [pf_0_5]
+    ROW_INIT          %1
+%assign rnd_scale 32 / %1
+    lea             rndq, [rndq + widthq * rnd_scale]
+
+.loop:
+    movu              m2, [rndq + xq * rnd_scale]
+    movu              m3, [rndq + xq * rnd_scale + mmsize]
+    addps             m2, m2
+    addps             m3, m3
+    addps             m2, m0
+    addps             m3, m0
+    subps             m2, m1
+    subps             m3, m1
+    cmpnltps          m2, m7                ; take xf0 where smooth >= 0.5
+    cmpnltps          m3, m7
+    LOAD_HALF         %1, 4, xf0q, 0
+    LOAD_HALF         %1, 5, xf0q, 1
+    pand              m4, m2
+    pand              m5, m3
+    LOAD_HALF         %1, 6, xf1q, 0
+    pandn             m2, m6
+    por               m2, m4
+    LOAD_HALF         %1, 6, xf1q, 1
+    pandn             m3, m6
+    por               m3, m5
+    STORE_PIXELS      %1, 2, 3
+    add               xq, mmsize * %1 / 16
+    jl .loop
+    RET
+%endmacro
+
+INIT_XMM sse4
+XFADE_FADE 8
+XFADE_FADE 16
+XFADE_DISSOLVE 8
+XFADE_DISSOLVE 16
+%if ARCH_X86_64
+XFADE_FADECOLOR 8
+XFADE_FADECOLOR 16
+%endif
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+XFADE_FADE 8
+XFADE_FADE 16
+XFADE_DISSOLVE 8
+XFADE_DISSOLVE 16
+%if ARCH_X86_64
+XFADE_FADECOLOR 8
+XFADE_FADECOLOR 16
+%endif
+%endif
@@ -0,0 +1,70 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/xfade.h"
+
+#define XFADE_FUNCS(depth, opt)                                                         \
+void ff_xfade_fade##depth##_##opt(uint8_t *dst, const uint8_t *xf0,                     \
+                                  const uint8_t *xf1, int width, float progress);       \
+void ff_xfade_fadecolor##depth##_##opt(uint8_t *dst, const uint8_t *xf0,                \
+                                       const uint8_t *xf1, int width, float progress,   \
+                                       float mix0, float mix1, float color);            \
+void ff_xfade_dissolve##depth##_##opt(uint8_t *dst, const uint8_t *xf0,                 \
+                                      const uint8_t *xf1, const float *rnd,             \
+                                      int width, float progress);
+
+XFADE_FUNCS(8, sse4)
+XFADE_FUNCS(8, avx2)
+XFADE_FUNCS(16, sse4)
+XFADE_FUNCS(16, avx2)
+
+av_cold void ff_xfade_init_x86(XFadeDSPContext *dsp, int depth)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (depth <= 8) {
+        if (EXTERNAL_SSE4(cpu_flags)) {
+            dsp->fade     = ff_xfade_fade8_sse4;
+            dsp->dissolve = ff_xfade_dissolve8_sse4;
+            if (ARCH_X86_64)
+                dsp->fadecolor = ff_xfade_fadecolor8_sse4;
+        }
+        if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+            dsp->fade     = ff_xfade_fade8_avx2;
+            dsp->dissolve = ff_xfade_dissolve8_avx2;
+            if (ARCH_X86_64)
+                dsp->fadecolor = ff_xfade_fadecolor8_avx2;
+        }
+    } else {
+        if (EXTERNAL_SSE4(cpu_flags)) {
+            dsp->fade     = ff_xfade_fade16_sse4;
+            dsp->dissolve = ff_xfade_dissolve16_sse4;
+            if (ARCH_X86_64)
+                dsp->fadecolor = ff_xfade_fadecolor16_sse4;
+        }
+        if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+            dsp->fade     = ff_xfade_fade16_avx2;
+            dsp->dissolve = ff_xfade_dissolve16_avx2;
+            if (ARCH_X86_64)
+                dsp->fadecolor = ff_xfade_fadecolor16_avx2;
+        }
+    }
+}
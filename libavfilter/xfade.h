@@ -0,0 +1,37 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_XFADE_H
+#define AVFILTER_XFADE_H
+
+#include <stdint.h>
+
+typedef struct XFadeDSPContext {
+    void (*fade)(uint8_t *dst, const uint8_t *xf0, const uint8_t *xf1,
+                 int width, float progress);
+    void (*fadecolor)(uint8_t *dst, const uint8_t *xf0, const uint8_t *xf1,
+                      int width, float progress, float mix0, float mix1,
+                      float color);
+    void (*dissolve)(uint8_t *dst, const uint8_t *xf0, const uint8_t *xf1,
+                     const float *rnd, int width, float progress);
+} XFadeDSPContext;
+
+void ff_xfade_init(XFadeDSPContext *dsp, int depth);
+void ff_xfade_init_x86(XFadeDSPContext *dsp, int depth);
+
+#endif /* AVFILTER_XFADE_H */
@@ -174,8 +174,36 @@ struct AVExpr {
     } a;
     struct AVExpr *param[3];
     double *var;
+
+    /* flattened program, only set on the root of vectorizable expressions */
+    struct ExprOp *ops;
+    int nb_ops;
+    int nb_regs;
+    double *regs;
+    int nb_consts;
+    double *const_scratch;
 };
 
+/**
+ * Instruction of the flattened form of an expression, evaluating the node
+ * of the same type over a block of values. The operands and the result are
+ * held in registers of EXPR_BLOCK_SIZE values.
+ */
+typedef struct ExprOp {
+    int type;
+    double value;
+    int const_index;
+    union {
+        double (*func0)(double);
+        double (*func1)(void *, double);
+        double (*func2)(void *, double, double);
+    } a;
+    int dst;
+    int src[3];             ///< -1 for an absent optional parameter
+} ExprOp;
+
+#define EXPR_BLOCK_SIZE 128
+
 static double etime(double v)
 {
     return av_gettime() * 0.000001;
@@ -340,6 +368,9 @@ void av_expr_free(AVExpr *e)
     av_expr_free(e->param[1]);
     av_expr_free(e->param[2]);
     av_freep(&e->var);
+    av_freep(&e->ops);
+    av_freep(&e->regs);
+    av_freep(&e->const_scratch);
     av_freep(&e);
 }
 
@@ -682,6 +713,141 @@ static int verify_expr(AVExpr *e)
     }
 }
 
+/**
+ * Return 1 if the expression only depends on its literal values, i.e. it
+ * does not use constants, functions with side effects or the variables.
+ */
+static int is_constant_expr(const AVExpr *e)
+{
+    int i;
+
+    switch (e->type) {
+    case e_const:
+    case e_func1:
+    case e_func2:
+    case e_ld:
+    case e_st:
+    case e_random:
+    case e_while:
+    case e_taylor:
+    case e_root:
+    case e_print:
+        return 0;
+    case e_func0:
+        if (e->a.func0 == etime)
+            return 0;
+        break;
+    default:
+        break;
+    }
+    for (i = 0; i < 3; i++)
+        if (e->param[i] && !is_constant_expr(e->param[i]))
+            return 0;
+    return 1;
+}
+
+/**
+ * Replace all the constant subexpressions by their value.
+ */
+static void fold_constants(AVExpr *e)
+{
+    int i;
+
+    if (!e || e->type == e_value)
+        return;
+
+    if (is_constant_expr(e)) {
+        Parser p = { 0 };
+        double value = eval_expr(&p, e);
+
+        for (i = 0; i < 3; i++)
+            av_expr_free(e->param[i]);
+        memset(e->param, 0, sizeof(e->param));
+        e->type  = e_value;
+        e->value = value;
+        return;
+    }
+
+    for (i = 0; i < 3; i++)
+        fold_constants(e->param[i]);
+}
+
+/**
+ * Return 1 if the expression can be evaluated for several values at once:
+ * it must neither have side effects nor depend on the evaluation order.
+ */
+static int is_vectorizable_expr(const AVExpr *e)
+{
+    int i;
+
+    switch (e->type) {
+    case e_ld:
+    case e_st:
+    case e_random:
+    case e_while:
+    case e_taylor:
+    case e_root:
+    case e_print:
+        return 0;
+    default:
+        break;
+    }
+    for (i = 0; i < 3; i++)
+        if (e->param[i] && !is_vectorizable_expr(e->param[i]))
+            return 0;
+    return 1;
+}
+
+static int count_ops(const AVExpr *e)
+{
+    return e ? 1 + count_ops(e->param[0]) + count_ops(e->param[1]) + count_ops(e->param[2]) : 0;
+}
+
+/**
+ * Flatten the expression into root->ops, its result being stored into
+ * register reg and registers above reg being used for the parameters.
+ */
+static void compile_expr(AVExpr *root, const AVExpr *e, int reg)
+{
+    ExprOp *op;
+    int i;
+
+    for (i = 0; i < 3; i++)
+        if (e->param[i])
+            compile_expr(root, e->param[i], reg + i);
+
+    op = &root->ops[root->nb_ops++];
+    op->type        = e->type;
+    op->value       = e->value;
+    op->const_index = e->const_index;
+    if (e->type == e_func1)
+        op->a.func1 = e->a.func1;
+    else if (e->type == e_func2)
+        op->a.func2 = e->a.func2;
+    else
+        op->a.func0 = e->a.func0;
+    op->dst         = reg;
+    for (i = 0; i < 3; i++)
+        op->src[i] = e->param[i] ? reg + i : -1;
+    root->nb_regs = FFMAX(root->nb_regs, reg + 1);
+}
+
+static int compile_program(AVExpr *e)
+{
+    if (!is_vectorizable_expr(e))
+        return 0;
+
+    e->ops = av_malloc_array(count_ops(e), sizeof(*e->ops));
+    if (!e->ops)
+        return AVERROR(ENOMEM);
+    compile_expr(e, e, 0);
+
+    e->regs = av_malloc_array(e->nb_regs, EXPR_BLOCK_SIZE * sizeof(*e->regs));
+    if (!e->regs)
+        return AVERROR(ENOMEM);
+    return 0;
+}
+
 int av_expr_parse(AVExpr **expr, const char *s,
                   const char * const *const_names,
                   const char * const *func1_names, double (* const *funcs1)(void *, double),
@@ -724,11 +890,16 @@ int av_expr_parse(AVExpr **expr, const char *s,
         ret = AVERROR(EINVAL);
         goto end;
     }
+    fold_constants(e);
     e->var= av_mallocz(sizeof(double) *VARS);
     if (!e->var) {
         ret = AVERROR(ENOMEM);
         goto end;
     }
+    while (const_names && const_names[e->nb_consts])
+        e->nb_consts++;
+    if ((ret = compile_program(e)) < 0)
+        goto end;
     *expr = e;
     e = NULL;
 end:
@@ -773,6 +944,111 @@ double av_expr_eval(AVExpr *e, const double *const_values, void *opaque)
     return eval_expr(&p, e);
 }
 
+static void run_program(AVExpr *e, double *res, int nb, int offset,
+                        const double *const_values,
+                        const double * const *const_arrays, void *opaque)
+{
+    int i, j;
+
+    for (j = 0; j < e->nb_ops; j++) {
+        const ExprOp *op = &e->ops[j];
+        const double v = op->value;
+        double *d = e->regs + op->dst * EXPR_BLOCK_SIZE;
+        const double *a = op->src[0] >= 0 ? e->regs + op->src[0] * EXPR_BLOCK_SIZE : NULL;
+        const double *b = op->src[1] >= 0 ? e->regs + op->src[1] * EXPR_BLOCK_SIZE : NULL;
+        const double *c = op->src[2] >= 0 ? e->regs + op->src[2] * EXPR_BLOCK_SIZE : NULL;
+
+#define LOOP(expr) for (i = 0; i < nb; i++) d[i] = expr; break
+
+        switch (op->type) {
+        case e_value:  LOOP(v);
+        case e_const:
+            if (const_arrays && const_arrays[op->const_index]) {
+                const double *src = const_arrays[op->const_index] + offset;
+                LOOP(v * src[i]);
+            } else {
+                const double x = v * const_values[op->const_index];
+                LOOP(x);
+            }
+        case e_func0:  LOOP(v * op->a.func0(a[i]));
+        case e_func1:  LOOP(v * op->a.func1(opaque, a[i]));
+        case e_func2:  LOOP(v * op->a.func2(opaque, a[i], b[i]));
+        case e_squish: LOOP(1/(1+exp(4*a[i])));
+        case e_gauss:  LOOP(exp(-a[i]*a[i]/2)/sqrt(2*M_PI));
+        case e_isnan:  LOOP(v * !!isnan(a[i]));
+        case e_isinf:  LOOP(v * !!isinf(a[i]));
+        case e_floor:  LOOP(v * floor(a[i]));
+        case e_ceil:   LOOP(v * ceil (a[i]));
+        case e_trunc:  LOOP(v * trunc(a[i]));
+        case e_round:  LOOP(v * round(a[i]));
+        case e_sgn:    LOOP(v * FFDIFFSIGN(a[i], 0));
+        case e_sqrt:   LOOP(v * sqrt (a[i]));
+        case e_not:    LOOP(v * (a[i] == 0));
+        case e_if:     LOOP(v * (a[i] ? b[i] : c ? c[i] : 0));
+        case e_ifnot:  LOOP(v * (!a[i] ? b[i] : c ? c[i] : 0));
+        case e_clip:
+            LOOP(isnan(b[i]) || isnan(c[i]) || isnan(a[i]) || b[i] > c[i] ? NAN :
+                 v * av_clipd(a[i], b[i], c[i]));
+        case e_between: LOOP(v * (a[i] >= b[i] && a[i] <= c[i]));
+        case e_lerp:   LOOP(a[i] + (b[i] - a[i]) * c[i]);
+        case e_mod:    LOOP(v * (a[i] - floor((!CONFIG_FTRAPV || b[i]) ? a[i] / b[i] : a[i] * INFINITY) * b[i]));
+        case e_gcd:    LOOP(v * av_gcd(a[i], b[i]));
+        case e_max:    LOOP(v * (a[i] >  b[i] ? a[i] : b[i]));
+        case e_min:    LOOP(v * (a[i] <  b[i] ? a[i] : b[i]));
+        case e_eq:     LOOP(v * (a[i] == b[i] ? 1.0 : 0.0));
+        case e_gt:     LOOP(v * (a[i] >  b[i] ? 1.0 : 0.0));
+        case e_gte:    LOOP(v * (a[i] >= b[i] ? 1.0 : 0.0));
+        case e_lt:     LOOP(v * (a[i] <  b[i] ? 1.0 : 0.0));
+        case e_lte:    LOOP(v * (a[i] <= b[i] ? 1.0 : 0.0));
+        case e_pow:    LOOP(v * pow(a[i], b[i]));
+        case e_mul:    LOOP(v * (a[i] * b[i]));
+        case e_div:    LOOP(v * (b[i] ? (a[i] / b[i]) : a[i] * INFINITY));
+        case e_add:    LOOP(v * (a[i] + b[i]));
+        case e_last:   LOOP(v * b[i]);
+        case e_hypot:  LOOP(v * hypot(a[i], b[i]));
+        case e_atan2:  LOOP(v * atan2(a[i], b[i]));
+        case e_bitand: LOOP(isnan(a[i]) || isnan(b[i]) ? NAN : v * ((long int)a[i] & (long int)b[i]));
+        case e_bitor:  LOOP(isnan(a[i]) || isnan(b[i]) ? NAN : v * ((long int)a[i] | (long int)b[i]));
+        default:       LOOP(NAN);
+        }
+#undef LOOP
+    }
+
+    memcpy(res, e->regs, nb * sizeof(*res));
+}
+
+int av_expr_eval_array(AVExpr *e, double *res, int nb,
+                       const double *const_values,
+                       const double * const *const_arrays, void *opaque)
+{
+    int i, j;
+
+    if (nb < 0)
+        return AVERROR(EINVAL);
+
+    if (e->ops) {
+        for (i = 0; i < nb; i += EXPR_BLOCK_SIZE)
+            run_program(e, res + i, FFMIN(nb - i, EXPR_BLOCK_SIZE), i,
+                        const_values, const_arrays, opaque);
+        return 0;
+    }
+
+    if (!e->const_scratch && e->nb_consts) {
+        e->const_scratch = av_malloc_array(e->nb_consts, sizeof(*e->const_scratch));
+        if (!e->const_scratch)
+            return AVERROR(ENOMEM);
+    }
+    if (e->nb_consts)
+        memcpy(e->const_scratch, const_values, e->nb_consts * sizeof(*const_values));
+    for (i = 0; i < nb; i++) {
+        for (j = 0; const_arrays && j < e->nb_consts; j++)
+            if (const_arrays[j])
+                e->const_scratch[j] = const_arrays[j][i];
+        res[i] = av_expr_eval(e, e->const_scratch, opaque);
+    }
+    return 0;
+}
+
 int av_expr_parse_and_eval(double *d, const char *s,
                            const char * const *const_names, const double *const_values,
                            const char * const *func1_names, double (* const *funcs1)(void *, double),
@@ -86,6 +86,34 @@ int av_expr_parse(AVExpr **expr, const char *s,
  */
 double av_expr_eval(AVExpr *e, const double *const_values, void *opaque);
 
+/**
+ * Evaluate a previously parsed expression for several sets of values.
+ *
+ * This is equivalent to calling av_expr_eval() nb times, but expressions
+ * without side effects are evaluated on whole blocks of values at once,
+ * which is considerably faster. Both branches of if() and ifnot() may be
+ * evaluated, so the functions from funcs1 and funcs2 must not have side
+ * effects.
+ *
+ * The evaluation uses scratch buffers stored in the AVExpr, so it must not
+ * run concurrently on the same AVExpr from several threads; use one parsed
+ * expression per thread instead.
+ *
+ * @param res an array of nb doubles where the results are stored
+ * @param nb number of values to evaluate
+ * @param const_values a zero terminated array of values for the identifiers
+ * from av_expr_parse() const_names, used for the identifiers whose entry in
+ * const_arrays is NULL
+ * @param const_arrays an array of pointers to nb values for each identifier
+ * from av_expr_parse() const_names, or NULL entries for the identifiers
+ * keeping the same value in const_values for all the evaluations; may be NULL
+ * @param opaque a pointer which will be passed to all functions from funcs1 and funcs2
+ * @return 0 on success, a negative AVERROR code otherwise
+ */
+int av_expr_eval_array(AVExpr *e, double *res, int nb,
+                       const double *const_values,
+                       const double * const *const_arrays, void *opaque);
+
 /**
  * Track the presence of variables and their number of occurrences in a parsed expression
  *
@@ -37,6 +37,44 @@ static const char *const const_names[] = {
     0
 };
 
+#define NB_ARRAY_VALUES 300
+
+/* check that av_expr_eval_array() matches av_expr_eval() for varying PI */
+static void check_eval_array(const char *s)
+{
+    AVExpr *e_scalar = NULL, *e_array = NULL;
+    double pi[NB_ARRAY_VALUES], res[NB_ARRAY_VALUES];
+    const double *arrays[] = { pi, NULL };
+    double values[] = { 0, M_E, 0 };
+    int i;
+
+    if (av_expr_parse(&e_scalar, s, const_names, NULL, NULL, NULL, NULL, 0, NULL) < 0 ||
+        av_expr_parse(&e_array,  s, const_names, NULL, NULL, NULL, NULL, 0, NULL) < 0)
+        goto end;
+
+    for (i = 0; i < NB_ARRAY_VALUES; i++)
+        pi[i] = (i - NB_ARRAY_VALUES / 2) * M_PI / 16;
+    if (av_expr_eval_array(e_array, res, NB_ARRAY_VALUES, values, arrays, NULL) < 0) {
+        printf("av_expr_eval_array failed\n");
+        goto end;
+    }
+
+    for (i = 0; i < NB_ARRAY_VALUES; i++) {
+        double d;
+
+        values[0] = pi[i];
+        d = av_expr_eval(e_scalar, values, NULL);
+        if (d != res[i] && !(isnan(d) && isnan(res[i]))) {
+            printf("'%s' mismatch for PI=%f: %f != %f\n", s, pi[i], res[i], d);
+            break;
+        }
+    }
+
+end:
+    av_expr_free(e_scalar);
+    av_expr_free(e_array);
+}
+
 int main(int argc, char **argv)
 {
     int i;
@@ -155,6 +193,9 @@ int main(int argc, char **argv)
             printf("av_expr_parse_and_eval failed\n");
     }
 
+    for (expr = exprs; *expr; expr++)
+        check_eval_array(*expr);
+
     ret = av_expr_parse_and_eval(&d, "1+(5-2)^(3-1)+1/2+sin(PI)-max(-2.2,-3.1)",
                            const_names, const_values,
                            NULL, NULL, NULL, NULL, NULL, 0, NULL);
@@ -0,0 +1,186 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "libavutil/common.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mathematics.h"
+#include "libavutil/mem.h"
+#include "libavutil/tx.h"
+
+/* Even lengths, with half-length FFTs done as power of two, compound and
+ * naive transforms */
+static const int lengths[] = {
+    2, 4, 6, 14, 16, 24, 30, 40, 60, 64, 96, 120, 256, 480, 1024,
+};
+
+#define MAX_LEN 1024
+
+static const struct {
+    enum AVTXType type;
+    int inv;
+    int is_double;
+    const char *name;
+} tests[] = {
+    { AV_TX_FLOAT_RDFT,  0, 0, "float rdft r2c"  },
+    { AV_TX_FLOAT_RDFT,  1, 0, "float rdft c2r"  },
+    { AV_TX_FLOAT_DCT,   0, 0, "float dct-ii"    },
+    { AV_TX_FLOAT_DCT,   1, 0, "float dct-iii"   },
+    { AV_TX_DOUBLE_RDFT, 0, 1, "double rdft r2c" },
+    { AV_TX_DOUBLE_RDFT, 1, 1, "double rdft c2r" },
+    { AV_TX_DOUBLE_DCT,  0, 1, "double dct-ii"   },
+    { AV_TX_DOUBLE_DCT,  1, 1, "double dct-iii"  },
+};
+
+static int is_rdft(enum AVTXType type)
+{
+    return type == AV_TX_FLOAT_RDFT || type == AV_TX_DOUBLE_RDFT;
+}
+
+/**
+ * Compute the transform naively in double precision.
+ * The spectrums of the RDFT are laid out as len / 2 + 1 complex values.
+ */
+static void ref_transform(double *out, const double *in, enum AVTXType type,
+                          int inv, int len)
+{
+    if (is_rdft(type) && !inv) {
+        for (int k = 0; k <= len / 2; k++) {
+            double re = 0, im = 0;
+            for (int n = 0; n < len; n++) {
+                const double phi = 2 * M_PI * ((int64_t)n * k % len) / len;
+                re += in[n] * cos(phi);
+                im -= in[n] * sin(phi);
+            }
+            out[2 * k]     = re;
+            out[2 * k + 1] = im;
+        }
+    } else if (is_rdft(type)) {
+        for (int n = 0; n < len; n++) {
+            double sum = in[0] + (n & 1 ? -in[len] : in[len]);
+            for (int k = 1; k < len / 2; k++) {
+                const double phi = 2 * M_PI * ((int64_t)n * k % len) / len;
+                sum += 2 * (in[2 * k] * cos(phi) - in[2 * k + 1] * sin(phi));
+            }
+            out[n] = sum;
+        }
+    } else if (!inv) {
+        for (int k = 0; k < len; k++) {
+            double sum = 0;
+            for (int n = 0; n < len; n++)
+                sum += in[n] * cos(M_PI * (2 * n + 1) * k / (2 * len));
+            out[k] = sum;
+        }
+    } else {
+        for (int n = 0; n < len; n++) {
+            double sum = in[0] / 2;
+            for (int k = 1; k < len; k++)
+                sum += in[k] * cos(M_PI * (2 * n + 1) * k / (2 * len));
+            out[n] = sum;
+        }
+    }
+}
+
+/**
+ * Run one transform on random data and compare it to the reference.
+ *
+ * @return the largest error, relative to the largest reference output
+ */
+static double check(AVLFG *lfg, enum AVTXType type, int inv, int is_double,
+                    int len, double *ref_in, double *ref_out)
+{
+    const int nb_in  = is_rdft(type) && inv  ? len + 2 : len;
+    const int nb_out = is_rdft(type) && !inv ? len + 2 : len;
+    const size_t size = is_double ? sizeof(double) : sizeof(float);
+    AVTXContext *ctx = NULL;
+    av_tx_fn tx;
+    void *in = NULL, *out = NULL;
+    double err = 0, peak = 0;
+
+    for (int i = 0; i < nb_in; i++)
+        ref_in[i] = av_lfg_get(lfg) / (double)UINT32_MAX - 0.5;
+    /* the DC and Nyquist bins of a real signal have no imaginary part */
+    if (is_rdft(type) && inv)
+        ref_in[1] = ref_in[len + 1] = 0;
+    ref_transform(ref_out, ref_in, type, inv, len);
+
+    in  = av_malloc_array(nb_in,  size);
+    out = av_malloc_array(nb_out, size);
+    if (!in || !out || av_tx_init(&ctx, &tx, type, inv, len, NULL, 0) < 0) {
+        err = INFINITY;
+        goto end;
+    }
+
+    for (int i = 0; i < nb_in; i++) {
+        if (is_double)
+            ((double *)in)[i] = ref_in[i];
+        else
+            ((float *)in)[i] = ref_in[i];
+    }
+
+    tx(ctx, out, in, size);
+
+    for (int i = 0; i < nb_out; i++) {
+        const double v = is_double ? ((double *)out)[i] : ((float *)out)[i];
+        err  = FFMAX(err, fabs(v - ref_out[i]));
+        peak = FFMAX(peak, fabs(ref_out[i]));
+    }
+    err /= FFMAX(peak, 1.0);
+
+end:
+    av_tx_uninit(&ctx);
+    av_free(in);
+    av_free(out);
+    return err;
+}
+
+int main(void)
+{
+    double *ref_in  = av_malloc_array(MAX_LEN + 2, sizeof(*ref_in));
+    double *ref_out = av_malloc_array(MAX_LEN + 2, sizeof(*ref_out));
+    AVLFG lfg;
+    int ret = 0;
+
+    if (!ref_in || !ref_out)
+        return 1;
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+
+    for (int t = 0; t < FF_ARRAY_ELEMS(tests); t++) {
+        const double max_err = tests[t].is_double ? 1e-10 : 1e-5;
+
+        printf("%s:", tests[t].name);
+        for (int i = 0; i < FF_ARRAY_ELEMS(lengths); i++) {
+            double err = check(&lfg, tests[t].type, tests[t].inv,
+                               tests[t].is_double, lengths[i], ref_in, ref_out);
+
+            printf(" %d", lengths[i]);
+            if (!(err <= max_err)) {
+                printf(" (error %g)", err);
+                ret = 1;
+            }
+        }
+        printf("\n");
+    }
+
+    av_free(ref_in);
+    av_free(ref_out);
+    return ret;
+}
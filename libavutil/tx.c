@@ -16,6 +16,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "config.h"
 #include "tx_priv.h"
 
 int ff_tx_type_is_mdct(enum AVTXType type)
@@ -116,6 +117,7 @@ av_cold void av_tx_uninit(AVTXContext **ctx)
     av_free((*ctx)->exptab);
     av_free((*ctx)->revtab);
     av_free((*ctx)->tmp);
+    av_free((*ctx)->rtmp);
 
     av_freep(ctx);
 }
@@ -133,6 +135,8 @@ av_cold int av_tx_init(AVTXContext **ctx, av_tx_fn *tx, enum AVTXType type,
     case AV_TX_FLOAT_MDCT:
         if ((err = ff_tx_init_mdct_fft_float(s, tx, type, inv, len, scale, flags)))
             goto fail;
+        if (ARCH_X86)
+            ff_tx_init_float_x86(s, tx);
         break;
     case AV_TX_DOUBLE_FFT:
     case AV_TX_DOUBLE_MDCT:
@@ -144,6 +148,16 @@ av_cold int av_tx_init(AVTXContext **ctx, av_tx_fn *tx, enum AVTXType type,
         if ((err = ff_tx_init_mdct_fft_int32(s, tx, type, inv, len, scale, flags)))
             goto fail;
         break;
+    case AV_TX_FLOAT_RDFT:
+    case AV_TX_FLOAT_DCT:
+        if ((err = ff_tx_init_rdft_dct_float(s, tx, type, inv, len, scale, flags)))
+            goto fail;
+        break;
+    case AV_TX_DOUBLE_RDFT:
+    case AV_TX_DOUBLE_DCT:
+        if ((err = ff_tx_init_rdft_dct_double(s, tx, type, inv, len, scale, flags)))
+            goto fail;
+        break;
     default:
         err = AVERROR(EINVAL);
         goto fail;
@@ -74,6 +74,45 @@ enum AVTXType {
      * Stride must be a non-zero multiple of sizeof(int32_t).
      */
     AV_TX_INT32_MDCT = 5,
+    /**
+     * Real to complex and complex to real DFT with a sample data type of
+     * float and a scale type of float.
+     * The forward transform takes len real samples and outputs len/2 + 1
+     * AVComplexFloat values, the imaginary parts of the first and last of
+     * which are always zero. The inverse transform takes len/2 + 1 complex
+     * values and outputs len real samples. The output is not normalized,
+     * a forward transform followed by an inverse one multiplies the signal
+     * by len. If scale is NULL, 1.0 is used.
+     * len must be even. The input and output arrays may be the same, in which
+     * case it must be large enough to hold len + 2 samples.
+     * The inverse transform runs its complex FFT directly into the output
+     * array, which must therefore always be aligned as required by the SIMD
+     * FFTs, even when it is a different array than the input.
+     * The stride parameter is ignored.
+     */
+    AV_TX_FLOAT_RDFT = 6,
+    /**
+     * Same as AV_TX_FLOAT_RDFT with data and scale type of double.
+     */
+    AV_TX_DOUBLE_RDFT = 7,
+    /**
+     * Real to real DCT with a sample data type of float and a scale type
+     * of float. The forward transform is a DCT-II,
+     * X[k] = sum(x[n] * cos(pi * (2n + 1) * k / (2 * len))), and the inverse
+     * is a DCT-III, x[n] = X[0] / 2 + sum(X[k] * cos(pi * (2n + 1) * k / (2 * len))),
+     * so a forward transform followed by an inverse one multiplies the signal
+     * by len / 2. If scale is NULL, 1.0 is used.
+     * len must be even. The input and output arrays may be the same.
+     * The forward transform runs its complex FFT directly into the output
+     * array, which must therefore always be aligned as required by the SIMD
+     * FFTs, even when it is a different array than the input.
+     * The stride parameter is ignored.
+     */
+    AV_TX_FLOAT_DCT = 8,
+    /**
+     * Same as AV_TX_FLOAT_DCT with data and scale type of double.
+     */
+    AV_TX_DOUBLE_DCT = 9,
 };
 
 /**
@@ -102,7 +141,8 @@ typedef void (*av_tx_fn)(AVTXContext *s, void *out, void *in, ptrdiff_t stride);
  * @param type type the type of transform
  * @param inv whether to do an inverse or a forward transform
  * @param len the size of the transform in samples
- * @param scale pointer to the value to scale the output if supported by type
+ * @param scale pointer to the value to scale the output if supported by type,
+ *              may be NULL for the RDFT and DCT types
  * @param flags currently unused
  *
  * @return 0 on success, negative error code on failure
@@ -116,6 +116,10 @@ struct AVTXContext {
     FFTComplex *tmp;    /* Temporary buffer needed for all compound transforms */
     int        *pfatab; /* Input/Output mapping for compound transforms */
     int        *revtab; /* Input mapping for power of two transforms */
+
+    av_tx_fn    fft;    /* Half-length complex FFT of RDFTs and DCTs */
+    int         len;    /* RDFT and DCT length */
+    FFTComplex *rtmp;   /* Temporary buffer for RDFTs and DCTs */
 };
 
 /* Shared functions */
@@ -150,6 +154,15 @@ int ff_tx_init_mdct_fft_int32(AVTXContext *s, av_tx_fn *tx,
                               enum AVTXType type, int inv, int len,
                               const void *scale, uint64_t flags);
 
+int ff_tx_init_rdft_dct_float(AVTXContext *s, av_tx_fn *tx,
+                              enum AVTXType type, int inv, int len,
+                              const void *scale, uint64_t flags);
+int ff_tx_init_rdft_dct_double(AVTXContext *s, av_tx_fn *tx,
+                               enum AVTXType type, int inv, int len,
+                               const void *scale, uint64_t flags);
+
+void ff_tx_init_float_x86(AVTXContext *s, av_tx_fn *tx);
+
 typedef struct CosTabsInitOnce {
     void (*func)(void);
     AVOnce control;
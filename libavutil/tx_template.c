@@ -726,3 +726,185 @@ int TX_NAME(ff_tx_init_mdct_fft)(AVTXContext *s, av_tx_fn *tx,
 
     return 0;
 }
+
+#ifndef TX_INT32
+
+/* Turns the half-length FFT z of a real signal, taken as even + i*odd samples,
+ * into the len2 + 1 bins of its spectrum. out and z may be the same. */
+static av_always_inline void rdft_postprocess(FFTComplex *out, const FFTComplex *z,
+                                              const FFTComplex *tw, int len2,
+                                              FFTSample scale)
+{
+    const FFTSample half = 0.5 * scale;
+    const FFTComplex dc = z[0];
+
+    for (int k = 1; k <= len2 >> 1; k++) {
+        const FFTComplex zk = z[k], zm = z[len2 - k];
+        const FFTComplex a = { half * (zk.re + zm.re), half * (zk.im - zm.im) };
+        const FFTComplex d = { half * (zk.im + zm.im), half * (zm.re - zk.re) };
+        FFTComplex b;
+
+        CMUL3(b, d, tw[k]);
+
+        out[k].re        = a.re + b.re;
+        out[k].im        = a.im + b.im;
+        out[len2 - k].re = a.re - b.re;
+        out[len2 - k].im = b.im - a.im;
+    }
+
+    out[0].re    = scale * (dc.re + dc.im);
+    out[0].im    = 0;
+    out[len2].re = scale * (dc.re - dc.im);
+    out[len2].im = 0;
+}
+
+/* Inverse of rdft_postprocess(), up to a factor of 2. z and in may be the same. */
+static av_always_inline void rdft_preprocess(FFTComplex *z, const FFTComplex *in,
+                                             const FFTComplex *tw, int len2,
+                                             FFTSample scale)
+{
+    const FFTSample dc = in[0].re, ny = in[len2].re;
+
+    for (int k = 1; k <= len2 >> 1; k++) {
+        const FFTComplex xk = in[k], xm = in[len2 - k];
+        const FFTComplex a = { scale * (xk.re + xm.re), scale * (xk.im - xm.im) };
+        const FFTComplex d = { scale * (xk.re - xm.re), scale * (xk.im + xm.im) };
+        FFTComplex b;
+
+        /* b = i * conj(tw[k]) * d */
+        CMUL(b.im, b.re, d.re, d.im, tw[k].re, -tw[k].im);
+        b.re = -b.re;
+
+        z[k].re        = a.re + b.re;
+        z[k].im        = a.im + b.im;
+        z[len2 - k].re = a.re - b.re;
+        z[len2 - k].im = b.im - a.im;
+    }
+
+    z[0].re = scale * (dc + ny);
+    z[0].im = scale * (dc - ny);
+}
+
+static void rdft_r2c(AVTXContext *s, void *_dst, void *_src, ptrdiff_t stride)
+{
+    const int len2 = s->len >> 1;
+
+    s->fft(s, s->rtmp, _src, sizeof(FFTComplex));
+    rdft_postprocess(_dst, s->rtmp, s->exptab, len2, s->scale);
+}
+
+static void rdft_c2r(AVTXContext *s, void *_dst, void *_src, ptrdiff_t stride)
+{
+    const int len2 = s->len >> 1;
+
+    rdft_preprocess(s->rtmp, _src, s->exptab, len2, s->scale);
+    s->fft(s, _dst, s->rtmp, sizeof(FFTComplex));
+}
+
+/* DCT-II through a real FFT of the reordered input, see
+ * J. Makhoul, "A fast cosine transform in one and two dimensions", 1980. */
+static void dct_ii(AVTXContext *s, void *_dst, void *_src, ptrdiff_t stride)
+{
+    FFTSample *dst = _dst, *src = _src, *v = (FFTSample *)s->rtmp;
+    FFTComplex *z = s->rtmp;
+    const int len = s->len, len2 = len >> 1;
+    const FFTComplex *dtw = s->exptab + (len >> 2) + 1;
+    FFTComplex t;
+
+    for (int i = 0; i < len2; i++) {
+        v[i]           = src[2*i];
+        v[len - 1 - i] = src[2*i + 1];
+    }
+
+    s->fft(s, dst, v, sizeof(FFTComplex));
+    rdft_postprocess(z, _dst, s->exptab, len2, 1.0);
+
+    dst[0] = z[0].re * dtw[0].re;
+    for (int k = 1; k < len2; k++) {
+        CMUL3(t, z[k], dtw[k]);
+        dst[k]       =  t.re;
+        dst[len - k] = -t.im;
+    }
+    CMUL3(t, z[len2], dtw[len2]);
+    dst[len2] = t.re;
+}
+
+static void dct_iii(AVTXContext *s, void *_dst, void *_src, ptrdiff_t stride)
+{
+    FFTSample *dst = _dst, *src = _src, *v;
+    FFTComplex *z = s->rtmp;
+    const int len = s->len, len2 = len >> 1;
+    const FFTComplex *dtw = s->exptab + (len >> 2) + 1;
+
+    z[0].re = src[0] * dtw[0].re;
+    z[0].im = src[0] * dtw[0].im;
+    for (int k = 1; k <= len2; k++) {
+        const FFTComplex x = { src[k], -src[len - k] };
+        CMUL3(z[k], x, dtw[k]);
+    }
+
+    rdft_preprocess(z, z, s->exptab, len2, 1.0);
+    s->fft(s, z + FFALIGN(len2 + 1, 4), z, sizeof(FFTComplex));
+
+    v = (FFTSample *)(z + FFALIGN(len2 + 1, 4));
+    for (int i = 0; i < len2; i++) {
+        dst[2*i]     = v[i];
+        dst[2*i + 1] = v[len - 1 - i];
+    }
+}
+
+int TX_NAME(ff_tx_init_rdft_dct)(AVTXContext *s, av_tx_fn *tx,
+                                 enum AVTXType type, int inv, int len,
+                                 const void *scale, uint64_t flags)
+{
+    const int is_dct = type == AV_TX_FLOAT_DCT || type == AV_TX_DOUBLE_DCT;
+    const int len2 = len >> 1, len4 = len >> 2;
+    const double sc = scale ? *((SCALE_TYPE *)scale) : 1.0;
+    int err;
+
+    if (len < 2 || (len & 1))
+        return AVERROR(EINVAL);
+
+    if ((err = TX_NAME(ff_tx_init_mdct_fft)(s, &s->fft, type, inv, len2,
+                                            NULL, flags)))
+        return err;
+#ifdef TX_FLOAT
+    if (ARCH_X86)
+        ff_tx_init_float_x86(s, &s->fft);
+#endif
+
+    s->len   = len;
+    s->scale = sc;
+
+    if (!(s->exptab = av_malloc_array(len4 + 1 + (is_dct ? len2 + 1 : 0),
+                                      sizeof(*s->exptab))))
+        return AVERROR(ENOMEM);
+    /* The DCT-III needs a second, aligned, half-length buffer for the FFT output */
+    if (!(s->rtmp = av_malloc_array(FFALIGN(len2 + 1, 4) + (is_dct ? len2 : 0),
+                                    sizeof(*s->rtmp))))
+        return AVERROR(ENOMEM);
+
+    for (int i = 0; i <= len4; i++) {
+        const double alpha = 2 * M_PI * i / len;
+        s->exptab[i].re = cos(alpha);
+        s->exptab[i].im = -sin(alpha);
+    }
+
+    if (is_dct) {
+        FFTComplex *dtw = s->exptab + len4 + 1;
+        const double mult = inv ? 0.5 * sc : sc;
+
+        for (int i = 0; i <= len2; i++) {
+            const double alpha = M_PI_2 * i / len;
+            dtw[i].re = cos(alpha) * mult;
+            dtw[i].im = (inv ? sin(alpha) : -sin(alpha)) * mult;
+        }
+        *tx = inv ? dct_iii : dct_ii;
+    } else {
+        *tx = inv ? rdft_c2r : rdft_r2c;
+    }
+
+    return 0;
+}
+
+#endif /* TX_INT32 */
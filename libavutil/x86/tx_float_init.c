@@ -0,0 +1,198 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#define TX_FLOAT
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/tx_priv.h"
+#include "libavutil/x86/cpu.h"
+
+void ff_tx_fft_calc_sse(FFTComplex *z, int nbits);
+void ff_tx_fft_calc_avx(FFTComplex *z, int nbits);
+void ff_tx_fft_calc_fma3(FFTComplex *z, int nbits);
+
+void ff_tx_imdct_prerotate_sse(FFTComplex *z, const FFTSample *src,
+                               const FFTComplex *exp, const int *revtab, int len4);
+void ff_tx_imdct_prerotate_avx(FFTComplex *z, const FFTSample *src,
+                               const FFTComplex *exp, const int *revtab, int len4);
+void ff_tx_imdct_postrotate_sse(FFTComplex *z, const FFTComplex *exp, int len8);
+void ff_tx_imdct_postrotate_avx(FFTComplex *z, const FFTComplex *exp, int len8);
+void ff_tx_mdct_postrotate_sse(FFTComplex *z, const FFTComplex *exp, int len8);
+void ff_tx_mdct_postrotate_avx(FFTComplex *z, const FFTComplex *exp, int len8);
+
+#if HAVE_X86ASM
+static void imdct_prerotate_c(AVTXContext *s, FFTComplex *z,
+                              const FFTSample *src, ptrdiff_t stride)
+{
+    const FFTComplex *exp = s->exptab;
+    const FFTSample *in1 = src, *in2 = src + (s->m*2 - 1) * stride;
+
+    for (int i = 0; i < s->m; i++) {
+        FFTComplex tmp = { in2[-2*i*stride], in1[2*i*stride] };
+        CMUL3(z[s->revtab[i]], tmp, exp[i]);
+    }
+}
+
+static void mdct_prerotate_c(AVTXContext *s, FFTComplex *z, const FFTSample *src)
+{
+    const FFTComplex *exp = s->exptab;
+    const int m = s->m, len4 = m, len3 = len4 * 3;
+    FFTComplex tmp;
+
+    for (int i = 0; i < m; i++) { /* Folding and pre-reindexing */
+        const int k = 2*i;
+        if (k < len4) {
+            tmp.re = FOLD(-src[ len4 + k],  src[1*len4 - 1 - k]);
+            tmp.im = FOLD(-src[ len3 + k], -src[1*len3 - 1 - k]);
+        } else {
+            tmp.re = FOLD(-src[ len4 + k], -src[5*len4 - 1 - k]);
+            tmp.im = FOLD( src[-len4 + k], -src[1*len3 - 1 - k]);
+        }
+        CMUL(z[s->revtab[i]].im, z[s->revtab[i]].re, tmp.re, tmp.im,
+             exp[i].re, exp[i].im);
+    }
+}
+
+static void mdct_postrotate_c(AVTXContext *s, FFTSample *dst, FFTComplex *z,
+                              ptrdiff_t stride)
+{
+    const FFTComplex *exp = s->exptab;
+    const int len8 = s->m >> 1;
+
+    for (int i = 0; i < len8; i++) {
+        const int i0 = len8 + i, i1 = len8 - i - 1;
+        FFTComplex src1 = { z[i1].re, z[i1].im };
+        FFTComplex src0 = { z[i0].re, z[i0].im };
+
+        CMUL(dst[2*i1*stride + stride], dst[2*i0*stride], src0.re, src0.im,
+             exp[i0].im, exp[i0].re);
+        CMUL(dst[2*i0*stride + stride], dst[2*i1*stride], src1.re, src1.im,
+             exp[i1].im, exp[i1].re);
+    }
+}
+
+#define DECL_TX_FUNCS(opt, rot)                                                \
+static void fft_##opt(AVTXContext *s, void *_out, void *_in, ptrdiff_t stride) \
+{                                                                              \
+    FFTComplex *in = _in, *out = _out;                                         \
+                                                                               \
+    for (int i = 0; i < s->m; i++)                                             \
+        out[s->revtab[i]] = in[i];                                             \
+    ff_tx_fft_calc_##opt(out, av_log2(s->m));                                  \
+}                                                                              \
+                                                                               \
+static void imdct_##opt(AVTXContext *s, void *_dst, void *_src,                \
+                        ptrdiff_t stride)                                      \
+{                                                                              \
+    FFTComplex *z = _dst;                                                      \
+                                                                               \
+    stride /= sizeof(FFTSample);                                               \
+                                                                               \
+    if (ARCH_X86_64 && stride == 1)                                            \
+        ff_tx_imdct_prerotate_##rot(z, _src, s->exptab, s->revtab, s->m);      \
+    else                                                                       \
+        imdct_prerotate_c(s, z, _src, stride);                                 \
+    ff_tx_fft_calc_##opt(z, av_log2(s->m));                                    \
+    ff_tx_imdct_postrotate_##rot(z, s->exptab, s->m >> 1);                     \
+}                                                                              \
+                                                                               \
+static void mdct_##opt(AVTXContext *s, void *_dst, void *_src,                 \
+                       ptrdiff_t stride)                                       \
+{                                                                              \
+    FFTComplex *z = _dst;                                                      \
+                                                                               \
+    stride /= sizeof(FFTSample);                                               \
+                                                                               \
+    mdct_prerotate_c(s, z, _src);                                              \
+    ff_tx_fft_calc_##opt(z, av_log2(s->m));                                    \
+    if (stride == 1)                                                           \
+        ff_tx_mdct_postrotate_##rot(z, s->exptab, s->m >> 1);                  \
+    else                                                                       \
+        mdct_postrotate_c(s, _dst, z, stride);                                 \
+}
+
+DECL_TX_FUNCS(sse,  sse)
+DECL_TX_FUNCS(avx,  avx)
+DECL_TX_FUNCS(fma3, avx)
+
+static const int avx_tab[] = {
+    0, 4, 1, 5, 8, 12, 9, 13, 2, 6, 3, 7, 10, 14, 11, 15
+};
+
+static int is_second_half_of_fft32(int i, int n)
+{
+    if (n <= 32)
+        return i >= 16;
+    else if (i < n/2)
+        return is_second_half_of_fft32(i, n/2);
+    else if (i < 3*n/4)
+        return is_second_half_of_fft32(i - n/2, n/4);
+    else
+        return is_second_half_of_fft32(i - 3*n/4, n/4);
+}
+
+/* Reorders the revtab for the data layout the SSE or AVX codelets use. */
+static av_cold void gen_simd_revtab(AVTXContext *s, int avx)
+{
+    const int m = s->m, inv = s->inv;
+
+    for (int i = 0; i < m; i++) {
+        const int k = -split_radix_permutation(i, m, inv) & (m - 1);
+        int j;
+
+        if (!avx)
+            j = (i & ~3) | ((i >> 1) & 1) | ((i << 1) & 2);
+        else if (is_second_half_of_fft32(i & ~15, m))
+            j = (i & ~15) + avx_tab[i & 15];
+        else
+            j = (i & ~7) | ((i >> 1) & 3) | ((i << 2) & 4);
+
+        s->revtab[k] = j;
+    }
+}
+#endif /* HAVE_X86ASM */
+
+av_cold void ff_tx_init_float_x86(AVTXContext *s, av_tx_fn *tx)
+{
+#if HAVE_X86ASM
+    int cpu_flags = av_get_cpu_flags();
+    const int is_mdct = ff_tx_type_is_mdct(s->type);
+    const int m = s->m;
+
+    /* Only the direct power of two transforms are handled */
+    if (s->n != 1 || m < 4 || !s->revtab)
+        return;
+    /* The MDCT rotations work on 4 pairs of complex values at a time */
+    if (is_mdct && m < 16)
+        return;
+
+    if (EXTERNAL_SSE(cpu_flags)) {
+        gen_simd_revtab(s, 0);
+        *tx = is_mdct ? s->inv ? imdct_sse : mdct_sse : fft_sse;
+    }
+
+    if (EXTERNAL_AVX_FAST(cpu_flags) && m >= 32) {
+        gen_simd_revtab(s, 1);
+        *tx = is_mdct ? s->inv ? imdct_avx : mdct_avx : fft_avx;
+
+        if (EXTERNAL_FMA3_FAST(cpu_flags))
+            *tx = is_mdct ? s->inv ? imdct_fma3 : mdct_fma3 : fft_fma3;
+    }
+#endif
+}
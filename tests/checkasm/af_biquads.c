@@ -0,0 +1,96 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/af_biquadsdsp.h"
+#include "libavutil/mem_internal.h"
+
+#define LEN 256
+#define BUF_SIZE (LEN * BIQUADS_LANES)
+
+#define randomize_buffer(buf, size)                  \
+    do {                                             \
+        for (int i = 0; i < size; i++)               \
+            buf[i] = (rnd() & 0xFFFF) / 32768. - 1.; \
+    } while (0)
+
+/* a different lowpass section for each lane */
+static void init_coeffs(double *coeffs)
+{
+    for (int c = 0; c < BIQUADS_LANES; c++) {
+        double w0    = 2 * M_PI * (500 + 1000 * c) / 48000.;
+        double alpha = sin(w0) / (2 * 0.707);
+        double a0    = 1 + alpha;
+
+        coeffs[0 * BIQUADS_LANES + c] =  (1 - cos(w0)) / 2 / a0;
+        coeffs[1 * BIQUADS_LANES + c] =  (1 - cos(w0)) / a0;
+        coeffs[2 * BIQUADS_LANES + c] =  (1 - cos(w0)) / 2 / a0;
+        coeffs[3 * BIQUADS_LANES + c] =  2 * cos(w0) / a0;
+        coeffs[4 * BIQUADS_LANES + c] = -(1 - alpha) / a0;
+    }
+}
+
+static void check_filter(void (*filter)(double *buf, int len, double *state,
+                                        const double *coeffs),
+                         const char *name)
+{
+    LOCAL_ALIGNED_32(double, src,       [BUF_SIZE]);
+    LOCAL_ALIGNED_32(double, dst_ref,   [BUF_SIZE]);
+    LOCAL_ALIGNED_32(double, dst_new,   [BUF_SIZE]);
+    LOCAL_ALIGNED_32(double, state,     [4 * BIQUADS_LANES]);
+    LOCAL_ALIGNED_32(double, state_ref, [4 * BIQUADS_LANES]);
+    LOCAL_ALIGNED_32(double, state_new, [4 * BIQUADS_LANES]);
+    LOCAL_ALIGNED_32(double, coeffs,    [5 * BIQUADS_LANES]);
+
+    declare_func(void, double *buf, int len, double *state, const double *coeffs);
+
+    init_coeffs(coeffs);
+    randomize_buffer(src, BUF_SIZE);
+    randomize_buffer(state, 4 * BIQUADS_LANES);
+
+    if (check_func(filter, "biquad_%s_lanes", name)) {
+        memcpy(dst_ref, src, sizeof(*src) * BUF_SIZE);
+        memcpy(dst_new, src, sizeof(*src) * BUF_SIZE);
+        memcpy(state_ref, state, sizeof(*state) * 4 * BIQUADS_LANES);
+        memcpy(state_new, state, sizeof(*state) * 4 * BIQUADS_LANES);
+        call_ref(dst_ref, LEN, state_ref, coeffs);
+        call_new(dst_new, LEN, state_new, coeffs);
+        if (!double_near_abs_eps_array(dst_ref, dst_new, 1e-12, BUF_SIZE) ||
+            !double_near_abs_eps_array(state_ref, state_new, 1e-12, 4 * BIQUADS_LANES))
+            fail();
+        bench_new(dst_new, LEN, state_new, coeffs);
+    }
+}
+
+void checkasm_check_biquads(void)
+{
+    BiquadsDSPContext dsp;
+
+    ff_biquads_init(&dsp);
+
+    check_filter(dsp.filter_di, "di");
+    report("di");
+
+    check_filter(dsp.filter_dii, "dii");
+    report("dii");
+
+    check_filter(dsp.filter_tdii, "tdii");
+    report("tdii");
+}
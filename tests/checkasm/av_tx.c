@@ -0,0 +1,191 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "config.h"
+
+#include <float.h>
+
+#include "libavutil/mem_internal.h"
+#include "libavutil/tx.h"
+
+#if CONFIG_FFT
+#include "libavcodec/fft.h"
+#endif
+
+#include "checkasm.h"
+
+#define MAX_LEN 4096
+
+/* The transforms are compared against a double precision one, the error of
+ * a float split-radix FFT grows with the log of its length, the magnitude
+ * of the output with the square root of it for random input. */
+#define TOLERANCE(len) (FLT_EPSILON * 8 * av_log2(len) * sqrt(len))
+
+static void randomize(float *buf, double *dbuf, int len)
+{
+    for (int i = 0; i < len; i++) {
+        buf[i]  = (float)rnd() / UINT_MAX * 2.0f - 1.0f;
+        dbuf[i] = buf[i];
+    }
+}
+
+static int compare(const float *out, const double *ref, int len, float eps)
+{
+    for (int i = 0; i < len; i++) {
+        if (!float_near_abs_eps(out[i], ref[i], eps)) {
+            fprintf(stderr, "%d: %- .12f - %- .12f = % .12g\n",
+                    i, out[i], ref[i], out[i] - ref[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void check_fft(void)
+{
+    LOCAL_ALIGNED_32(float,  in,   [2 * MAX_LEN]);
+    LOCAL_ALIGNED_32(float,  out,  [2 * MAX_LEN]);
+    LOCAL_ALIGNED_32(double, din,  [2 * MAX_LEN]);
+    LOCAL_ALIGNED_32(double, dout, [2 * MAX_LEN]);
+    AVTXContext *s = NULL, *ds = NULL;
+    av_tx_fn tx, dtx;
+
+    declare_func(void, AVTXContext *s, void *out, void *in, ptrdiff_t stride);
+
+    for (int len = 4; len <= MAX_LEN; len <<= 1) {
+        for (int inv = 0; inv < 2; inv++) {
+            if (av_tx_init(&s,  &tx,  AV_TX_FLOAT_FFT,  inv, len, NULL, 0) < 0 ||
+                av_tx_init(&ds, &dtx, AV_TX_DOUBLE_FFT, inv, len, NULL, 0) < 0) {
+                fail();
+                goto end;
+            }
+
+            if (check_func(tx, "%sfft_%d", inv ? "i" : "", len)) {
+                randomize(in, din, 2 * len);
+                dtx(ds, dout, din, sizeof(AVComplexDouble));
+                call_new(s, out, in, sizeof(AVComplexFloat));
+                if (compare(out, dout, 2 * len, TOLERANCE(len)))
+                    fail();
+                bench_new(s, out, in, sizeof(AVComplexFloat));
+            }
+
+            av_tx_uninit(&s);
+            av_tx_uninit(&ds);
+        }
+    }
+
+end:
+    av_tx_uninit(&s);
+    av_tx_uninit(&ds);
+}
+
+static void check_mdct(void)
+{
+    LOCAL_ALIGNED_32(float,  in,   [2 * MAX_LEN]);
+    LOCAL_ALIGNED_32(float,  out,  [2 * MAX_LEN]);
+    LOCAL_ALIGNED_32(double, din,  [2 * MAX_LEN]);
+    LOCAL_ALIGNED_32(double, dout, [2 * MAX_LEN]);
+    const float scale = 1.0f;
+    const double dscale = 1.0;
+    AVTXContext *s = NULL, *ds = NULL;
+    av_tx_fn tx, dtx;
+
+    declare_func(void, AVTXContext *s, void *out, void *in, ptrdiff_t stride);
+
+    for (int len = 32; len <= MAX_LEN / 2; len <<= 1) {
+        for (int inv = 0; inv < 2; inv++) {
+            if (av_tx_init(&s,  &tx,  AV_TX_FLOAT_MDCT,  inv, len, &scale,  0) < 0 ||
+                av_tx_init(&ds, &dtx, AV_TX_DOUBLE_MDCT, inv, len, &dscale, 0) < 0) {
+                fail();
+                goto end;
+            }
+
+            if (check_func(tx, "%smdct_%d", inv ? "i" : "", len)) {
+                /* The forward transform reads 2 * len samples, the inverse one len */
+                randomize(in, din, 2 * len);
+                dtx(ds, dout, din, sizeof(double));
+                call_new(s, out, in, sizeof(float));
+                if (compare(out, dout, len, TOLERANCE(len)))
+                    fail();
+                bench_new(s, out, in, sizeof(float));
+            }
+
+            av_tx_uninit(&s);
+            av_tx_uninit(&ds);
+        }
+    }
+
+end:
+    av_tx_uninit(&s);
+    av_tx_uninit(&ds);
+}
+
+#if CONFIG_FFT
+/* Benchmarks the libavcodec FFT of the same lengths for comparison */
+static void check_lavc_fft(void)
+{
+    LOCAL_ALIGNED_32(float,  in,   [2 * MAX_LEN]);
+    LOCAL_ALIGNED_32(float,  out,  [2 * MAX_LEN]);
+    LOCAL_ALIGNED_32(double, din,  [2 * MAX_LEN]);
+    LOCAL_ALIGNED_32(double, dout, [2 * MAX_LEN]);
+    AVTXContext *ds = NULL;
+    av_tx_fn dtx;
+    FFTContext s;
+
+    declare_func(void, FFTContext *s, FFTComplex *z);
+
+    for (int bits = 2; (1 << bits) <= MAX_LEN; bits++) {
+        const int len = 1 << bits;
+
+        if (ff_fft_init(&s, bits, 0) < 0)
+            return;
+        if (av_tx_init(&ds, &dtx, AV_TX_DOUBLE_FFT, 0, len, NULL, 0) < 0) {
+            ff_fft_end(&s);
+            return;
+        }
+
+        if (check_func(s.fft_calc, "lavc_fft_%d", len)) {
+            randomize(in, din, 2 * len);
+            dtx(ds, dout, din, sizeof(AVComplexDouble));
+            memcpy(out, in, 2 * len * sizeof(*in));
+            s.fft_permute(&s, (FFTComplex *)out);
+            call_new(&s, (FFTComplex *)out);
+            if (compare(out, dout, 2 * len, TOLERANCE(len)))
+                fail();
+            bench_new(&s, (FFTComplex *)out);
+        }
+
+        ff_fft_end(&s);
+        av_tx_uninit(&ds);
+    }
+}
+#endif
+
+void checkasm_check_av_tx(void)
+{
+    check_fft();
+    report("fft");
+
+    check_mdct();
+    report("mdct");
+
+#if CONFIG_FFT
+    check_lavc_fft();
+    report("lavc_fft");
+#endif
+}
@@ -0,0 +1,117 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavfilter/drawutils.h"
+#include "libavutil/mem_internal.h"
+
+#define WIDTH 256
+
+#define randomize_buffers(buf, size)      \
+    do {                                  \
+        for (int j = 0; j < size; j++)    \
+            buf[j] = rnd() & 0xFF;        \
+    } while (0)
+
+static void check_blend_line8(int step)
+{
+    LOCAL_ALIGNED_32(uint8_t, mask,    [WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [WIDTH * 4]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [WIDTH * 4]);
+    uint32_t src[4], alpha[4];
+    FFDrawContext draw;
+
+    declare_func(void, uint8_t *dst, const uint8_t *mask, int w,
+                 const uint32_t *src, const uint32_t *alpha);
+
+    ff_draw_init(&draw, step == 4 ? AV_PIX_FMT_RGBA : AV_PIX_FMT_YUV444P, 0);
+
+    if (check_func(draw.blend_line8[step == 4], "blend_line8_step%d", step)) {
+        for (int i = 0; i < 4; i++) {
+            src[i] = rnd() & 0xFF;
+            /* Same range as the alpha of ff_blend_mask(), null for the
+             * unused components */
+            alpha[i] = step == 1 || i < 3 ? (0x10307 * (rnd() & 0xFF) + 0x3) >> 8 : 0;
+        }
+        if (step == 1)
+            for (int i = 1; i < 4; i++) {
+                src[i]   = src[0];
+                alpha[i] = alpha[0];
+            }
+
+        for (int w = 8; w <= WIDTH; w += 8) {
+            randomize_buffers(mask, WIDTH);
+            /* Fully transparent and opaque mask values */
+            mask[0] = 0;
+            mask[1] = 0xFF;
+            randomize_buffers(dst_ref, WIDTH * 4);
+            memcpy(dst_new, dst_ref, WIDTH * 4);
+
+            call_ref(dst_ref, mask, w, src, alpha);
+            call_new(dst_new, mask, w, src, alpha);
+            if (memcmp(dst_ref, dst_new, WIDTH * 4))
+                fail();
+        }
+        bench_new(dst_new, mask, WIDTH, src, alpha);
+    }
+}
+
+static void check_blend_overlay8(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, color,   [WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t, transp,  [WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [WIDTH]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [WIDTH]);
+    FFDrawContext draw;
+
+    declare_func(void, uint8_t *dst, const uint8_t *color,
+                 const uint8_t *transp, int w);
+
+    ff_draw_init(&draw, AV_PIX_FMT_YUV444P, 0);
+
+    if (check_func(draw.blend_overlay8, "blend_overlay8")) {
+        for (int w = 16; w <= WIDTH; w += 16) {
+            randomize_buffers(color,  WIDTH);
+            randomize_buffers(transp, WIDTH);
+            transp[0] = 0;
+            transp[1] = 0xFF;
+            randomize_buffers(dst_ref, WIDTH);
+            memcpy(dst_new, dst_ref, WIDTH);
+
+            call_ref(dst_ref, color, transp, w);
+            call_new(dst_new, color, transp, w);
+            if (memcmp(dst_ref, dst_new, WIDTH))
+                fail();
+        }
+        bench_new(dst_new, color, transp, WIDTH);
+    }
+}
+
+void checkasm_check_drawutils(void)
+{
+    check_blend_line8(1);
+    report("blend_line8_step1");
+
+    check_blend_line8(4);
+    report("blend_line8_step4");
+
+    check_blend_overlay8();
+    report("blend_overlay8");
+}
@@ -0,0 +1,98 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/scene_sad.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem_internal.h"
+
+#define WIDTH  256
+#define HEIGHT 8
+#define STRIDE (WIDTH * 2 + 64)
+
+static void randomize_buffers(uint8_t *buf1, uint8_t *buf2, int depth)
+{
+    const int mask = (1 << depth) - 1;
+
+    for (int i = 0; i < STRIDE * HEIGHT; i += 2) {
+        const int a = rnd() & mask;
+        /* mostly small differences, with some of the full range */
+        const int b = rnd() & 7 ? av_clip(a + (int)(rnd() % 33) - 16, 0, mask) : rnd() & mask;
+
+        if (depth == 8) {
+            buf1[i] = a, buf1[i + 1] = rnd();
+            buf2[i] = b, buf2[i + 1] = rnd();
+        } else {
+            AV_WN16(buf1 + i, a);
+            AV_WN16(buf2 + i, b);
+        }
+    }
+}
+
+static void check_scene_sad(int depth)
+{
+    LOCAL_ALIGNED_32(uint8_t, src1, [STRIDE * HEIGHT]);
+    LOCAL_ALIGNED_32(uint8_t, src2, [STRIDE * HEIGHT]);
+    static const int widths[] = { 1, 8, 15, 16, 33, 64, 200, WIDTH };
+    ff_scene_sad_fn sad = ff_scene_sad_get_fn(depth);
+
+    declare_func(void, const uint8_t *src1, ptrdiff_t stride1,
+                 const uint8_t *src2, ptrdiff_t stride2,
+                 ptrdiff_t width, ptrdiff_t height, uint64_t *sum);
+
+    if (!check_func(sad, "scene_sad%d", depth))
+        return;
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+        for (int h = 1; h <= HEIGHT; h += HEIGHT - 1) {
+            uint64_t sum_ref = 0, sum_new = 0;
+
+            randomize_buffers(src1, src2, depth);
+            call_ref(src1, STRIDE, src2, STRIDE, widths[i], h, &sum_ref);
+            call_new(src1, STRIDE, src2, STRIDE, widths[i], h, &sum_new);
+            if (sum_ref != sum_new)
+                fail();
+        }
+    }
+    randomize_buffers(src1, src2, depth);
+    if (depth == 16) {
+        /* the largest differences */
+        for (int i = 0; i < WIDTH; i++) {
+            AV_WN16(src1 + 2 * i, i & 1 ? 0xffff : 0);
+            AV_WN16(src2 + 2 * i, i & 1 ? 0 : 0xffff);
+        }
+    }
+    {
+        uint64_t sum_ref = 0, sum_new = 0;
+        call_ref(src1, STRIDE, src2, STRIDE, WIDTH, HEIGHT, &sum_ref);
+        call_new(src1, STRIDE, src2, STRIDE, WIDTH, HEIGHT, &sum_new);
+        if (sum_ref != sum_new)
+            fail();
+        bench_new(src1, STRIDE, src2, STRIDE, WIDTH, HEIGHT, &sum_new);
+    }
+}
+
+void checkasm_check_scene_sad(void)
+{
+    check_scene_sad(8);
+    report("scene_sad8");
+
+    check_scene_sad(16);
+    report("scene_sad16");
+}
@@ -0,0 +1,110 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "checkasm.h"
+#include "libavfilter/bm3d.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem_internal.h"
+
+#define MAX_BLOCK 64
+#define STRIDE    (MAX_BLOCK * 2 + 32)
+#define BUF_SIZE  (STRIDE * (MAX_BLOCK + 1))
+#define MAX_MAT   256
+
+static void check_ssd(int depth)
+{
+    LOCAL_ALIGNED_32(uint8_t, a, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, b, [BUF_SIZE]);
+    const int mask = (1 << depth) - 1;
+    BM3DDSPContext dsp;
+
+    declare_func(int64_t, const uint8_t *a, const uint8_t *b,
+                 ptrdiff_t stride, int size);
+
+    ff_bm3d_init(&dsp, depth);
+
+    for (int i = 0; i < BUF_SIZE; i++) {
+        a[i] = rnd();
+        b[i] = rnd();
+    }
+    if (depth > 8) {
+        for (int i = 0; i < BUF_SIZE / 2; i++) {
+            AV_WN16A(a + 2 * i, AV_RN16A(a + 2 * i) & mask);
+            AV_WN16A(b + 2 * i, AV_RN16A(b + 2 * i) & mask);
+        }
+    }
+
+    for (int size = 16; size <= MAX_BLOCK; size *= 2) {
+        if (check_func(dsp.ssd, "bm3d_ssd%d_%d", depth, size)) {
+            /* misalign the blocks like arbitrary search positions do */
+            const int offset = depth > 8 ? 6 : 3;
+            int64_t ref = call_ref(a + offset, b + 1, STRIDE, size);
+            int64_t new = call_new(a + offset, b + 1, STRIDE, size);
+
+            if (ref != new)
+                fail();
+            bench_new(a + offset, b + 1, STRIDE, size);
+        }
+    }
+}
+
+static void check_mat_mul(void)
+{
+    LOCAL_ALIGNED_32(float, a,       [MAX_MAT * MAX_MAT]);
+    LOCAL_ALIGNED_32(float, b,       [MAX_MAT * MAX_MAT]);
+    LOCAL_ALIGNED_32(float, dst_ref, [MAX_MAT * MAX_MAT]);
+    LOCAL_ALIGNED_32(float, dst_new, [MAX_MAT * MAX_MAT]);
+    static const int sizes[][3] = {
+        { 16, 16, 16 }, { 64, 64, 64 }, { 256, 5, 16 }, { 256, 32, 32 },
+    };
+    BM3DDSPContext dsp;
+
+    declare_func(void, float *dst, const float *a, const float *b,
+                 int rows, int n, int cols);
+
+    ff_bm3d_init(&dsp, 8);
+
+    for (int i = 0; i < MAX_MAT * MAX_MAT; i++) {
+        a[i] = (rnd() & 0xFFFF) / 256.f - 128.f;
+        b[i] = (rnd() & 0xFFFF) / 65536.f - 0.5f;
+    }
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(sizes); i++) {
+        const int rows = sizes[i][0], n = sizes[i][1], cols = sizes[i][2];
+
+        if (check_func(dsp.mat_mul, "bm3d_mat_mul_%dx%dx%d", rows, n, cols)) {
+            call_ref(dst_ref, a, b, rows, n, cols);
+            call_new(dst_new, a, b, rows, n, cols);
+            if (!float_near_abs_eps_array(dst_ref, dst_new, 0.01f, rows * cols))
+                fail();
+            bench_new(dst_new, a, b, rows, n, cols);
+        }
+    }
+}
+
+void checkasm_check_vf_bm3d(void)
+{
+    check_ssd(8);
+    report("ssd8");
+
+    check_ssd(16);
+    report("ssd16");
+
+    check_mat_mul();
+    report("mat_mul");
+}
@@ -0,0 +1,128 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/convolution.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem_internal.h"
+
+#define WIDTH 512
+#define HEIGHT 7
+#define SRC_STRIDE ((WIDTH + 64) * 2)
+
+static void check_filter(ConvolutionContext *s, const uint8_t *src,
+                         int taps_w, int taps_h, int radius,
+                         float rdiv, float bias, const char *name)
+{
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [WIDTH * 2]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [WIDTH * 2]);
+    const int bpc = (s->depth + 7) / 8;
+    const int peak = (1 << s->depth) - 1;
+    const uint8_t *c[49];
+    int i;
+
+    declare_func(void, uint8_t *dst, int width,
+                 float rdiv, float bias, const int *const matrix,
+                 const uint8_t *c[], int peak, int radius,
+                 int dstride, int stride);
+
+    for (i = 0; i < taps_w * taps_h; i++)
+        c[i] = src + (i / taps_w) * SRC_STRIDE + (i % taps_w) * bpc;
+
+    if (check_func(s->filter[0], "%s%s", s->depth > 8 ? "filter16_" : "filter_", name)) {
+        const int width = WIDTH - (rnd() & 15);
+
+        memset(dst_ref, 0, WIDTH * 2);
+        memset(dst_new, 0, WIDTH * 2);
+        call_ref(dst_ref, width, rdiv, bias, s->matrix[0], c, peak, radius, 0, SRC_STRIDE);
+        call_new(dst_new, width, rdiv, bias, s->matrix[0], c, peak, radius, 0, SRC_STRIDE);
+        if (memcmp(dst_ref, dst_new, WIDTH * 2))
+            fail();
+
+        call_ref(dst_ref, 1, rdiv, bias, s->matrix[0], c, peak, radius, 0, SRC_STRIDE);
+        call_new(dst_new, 1, rdiv, bias, s->matrix[0], c, peak, radius, 0, SRC_STRIDE);
+        if (memcmp(dst_ref, dst_new, WIDTH * 2))
+            fail();
+
+        bench_new(dst_new, WIDTH, rdiv, bias, s->matrix[0], c, peak, radius, 0, SRC_STRIDE);
+    }
+}
+
+static void set_matrix(ConvolutionContext *s, int mode, int length, int size)
+{
+    int i;
+
+    s->mode[0] = mode;
+    s->matrix_length[0] = length;
+    s->size[0] = size;
+    for (i = 0; i < length; i++)
+        s->matrix[0][i] = (int)(rnd() % 33) - 16;
+}
+
+void checkasm_check_vf_convolution(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src, [HEIGHT * SRC_STRIDE]);
+    static const int depths[] = { 8, 16 };
+    ConvolutionContext s = { 0 };
+    int i, j, radius;
+
+    for (j = 0; j < HEIGHT * SRC_STRIDE / 2; j++)
+        AV_WN16A(src + 2 * j, rnd());
+
+    for (i = 0; i < FF_ARRAY_ELEMS(depths); i++) {
+        const int depth = depths[i];
+        const float bias = (rnd() % (1 << depth)) / 4.f;
+
+        s.depth = depth;
+
+        set_matrix(&s, MATRIX_SQUARE, 9, 3);
+        ff_convolution_init(&s);
+        check_filter(&s, src, 3, 3, 1, 1.f / 16, bias, "3x3");
+
+        set_matrix(&s, MATRIX_SQUARE, 25, 5);
+        ff_convolution_init(&s);
+        check_filter(&s, src, 5, 5, 2, 1.f / 64, bias, "5x5");
+
+        set_matrix(&s, MATRIX_SQUARE, 49, 7);
+        ff_convolution_init(&s);
+        check_filter(&s, src, 7, 7, 3, 1.f / 128, bias, "7x7");
+
+        radius = 1 + rnd() % 24;
+        set_matrix(&s, MATRIX_ROW, 2 * radius + 1, 2 * radius + 1);
+        ff_convolution_init(&s);
+        check_filter(&s, src, 2 * radius + 1, 1, radius, 1.f / 32, bias, "row");
+    }
+    report("convolution");
+
+    for (i = 0; i < FF_ARRAY_ELEMS(depths); i++) {
+        const int depth = depths[i];
+
+        s.depth = depth;
+
+        ff_prewitt_init(&s);
+        check_filter(&s, src, 3, 3, 1, 0.75f, 3.f, "prewitt");
+
+        ff_roberts_init(&s);
+        check_filter(&s, src, 3, 3, 1, 0.75f, 3.f, "roberts");
+
+        ff_sobel_init(&s);
+        check_filter(&s, src, 3, 3, 1, 0.75f, 3.f, "sobel");
+    }
+    report("edge");
+}
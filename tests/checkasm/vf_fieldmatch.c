@@ -0,0 +1,136 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/fieldmatch.h"
+#include "libavutil/mem_internal.h"
+
+#define WIDTH    1920
+#define LINESIZE (WIDTH + 64)
+#define HEIGHT   8
+#define BUF_SIZE (LINESIZE * HEIGHT)
+
+/* mostly small values so that the thresholds are exercised */
+static void randomize_buffer(uint8_t *buf, int size)
+{
+    for (int i = 0; i < size; i++)
+        buf[i] = rnd() & 1 ? rnd() & 0x1f : rnd();
+}
+
+static void check_sad(const FieldMatchDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(uint8_t, a, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, b, [BUF_SIZE]);
+    static const int widths[] = { 7, 64, 719, WIDTH };
+
+    declare_func(int64_t, const uint8_t *a, ptrdiff_t a_linesize,
+                 const uint8_t *b, ptrdiff_t b_linesize, int width, int height);
+
+    randomize_buffer(a, BUF_SIZE);
+    randomize_buffer(b, BUF_SIZE);
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+        const int w = widths[i];
+
+        if (check_func(dsp->sad, "fieldmatch_sad_%d", w)) {
+            if (call_ref(a + 1, LINESIZE, b, LINESIZE, w, HEIGHT) !=
+                call_new(a + 1, LINESIZE, b, LINESIZE, w, HEIGHT))
+                fail();
+            bench_new(a + 1, LINESIZE, b, LINESIZE, w, HEIGHT);
+        }
+    }
+}
+
+static void check_abs_diff(const FieldMatchDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(uint8_t, a,       [LINESIZE]);
+    LOCAL_ALIGNED_32(uint8_t, b,       [LINESIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [LINESIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [LINESIZE]);
+    static const int widths[] = { 7, 64, 719, WIDTH };
+
+    declare_func(void, uint8_t *dst, const uint8_t *a, const uint8_t *b, int width);
+
+    randomize_buffer(a, LINESIZE);
+    randomize_buffer(b, LINESIZE);
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(widths); i++) {
+        const int w = widths[i];
+
+        if (check_func(dsp->abs_diff, "fieldmatch_abs_diff_%d", w)) {
+            memset(dst_ref, 0, LINESIZE);
+            memset(dst_new, 0, LINESIZE);
+            call_ref(dst_ref, a, b + 3, w);
+            call_new(dst_new, a, b + 3, w);
+            if (memcmp(dst_ref, dst_new, LINESIZE))
+                fail();
+            bench_new(dst_new, a, b + 3, w);
+        }
+    }
+}
+
+static void check_comb_mask(const FieldMatchDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(uint8_t, src,     [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [LINESIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [LINESIZE]);
+    static const int cthresh[] = { 0, 9, 255 };
+    const uint8_t *cur = src + 2 * LINESIZE;
+
+    declare_func(void, uint8_t *dst, const uint8_t *m2, const uint8_t *m1,
+                 const uint8_t *cur, const uint8_t *p1, const uint8_t *p2,
+                 int width, int cthresh);
+
+    randomize_buffer(src, BUF_SIZE);
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(cthresh); i++) {
+        const int ct = cthresh[i];
+
+        if (check_func(dsp->comb_mask, "fieldmatch_comb_mask_%d", ct)) {
+            for (int w = WIDTH - 17; w <= WIDTH; w += 17) {
+                memset(dst_ref, 0x55, LINESIZE);
+                memset(dst_new, 0x55, LINESIZE);
+                call_ref(dst_ref, cur - 2 * LINESIZE, cur - LINESIZE, cur,
+                         cur + LINESIZE, cur + 2 * LINESIZE, w, ct);
+                call_new(dst_new, cur - 2 * LINESIZE, cur - LINESIZE, cur,
+                         cur + LINESIZE, cur + 2 * LINESIZE, w, ct);
+                if (memcmp(dst_ref, dst_new, LINESIZE))
+                    fail();
+            }
+            bench_new(dst_new, cur - 2 * LINESIZE, cur - LINESIZE, cur,
+                      cur + LINESIZE, cur + 2 * LINESIZE, WIDTH, ct);
+        }
+    }
+}
+
+void checkasm_check_vf_fieldmatch(void)
+{
+    FieldMatchDSPContext dsp;
+
+    ff_fieldmatch_init(&dsp);
+
+    check_sad(&dsp);
+    report("sad");
+
+    check_abs_diff(&dsp);
+    report("abs_diff");
+
+    check_comb_mask(&dsp);
+    report("comb_mask");
+}
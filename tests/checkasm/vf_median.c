@@ -0,0 +1,106 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/median.h"
+#include "libavutil/mem_internal.h"
+
+#define MAX_BINS 256
+
+static void randomize_buffers(uint16_t *buf, int size)
+{
+    for (int i = 0; i < size; i++)
+        buf[i] = rnd();
+}
+
+static void hadd_c(uint16_t *dst, const uint16_t *src, int bins)
+{
+    for (int i = 0; i < bins; i++)
+        dst[i] += src[i];
+}
+
+static void hsub_c(uint16_t *dst, const uint16_t *src, int bins)
+{
+    for (int i = 0; i < bins; i++)
+        dst[i] -= src[i];
+}
+
+static void hmuladd_c(uint16_t *dst, const uint16_t *src, int f, int bins)
+{
+    for (int i = 0; i < bins; i++)
+        dst[i] += f * src[i];
+}
+
+static void check_addsub(void (*func)(uint16_t *dst, const uint16_t *src, int bins),
+                         const char *name)
+{
+    LOCAL_ALIGNED_32(uint16_t, src,     [MAX_BINS]);
+    LOCAL_ALIGNED_32(uint16_t, dst_ref, [MAX_BINS]);
+    LOCAL_ALIGNED_32(uint16_t, dst_new, [MAX_BINS]);
+
+    declare_func(void, uint16_t *dst, const uint16_t *src, int bins);
+
+    for (int bins = 16; bins <= MAX_BINS; bins *= 2) {
+        if (check_func(func, "median_%s_%d", name, bins)) {
+            randomize_buffers(src, MAX_BINS);
+            randomize_buffers(dst_ref, MAX_BINS);
+            memcpy(dst_new, dst_ref, sizeof(*dst_ref) * MAX_BINS);
+            call_ref(dst_ref, src, bins);
+            call_new(dst_new, src, bins);
+            if (memcmp(dst_ref, dst_new, sizeof(*dst_ref) * MAX_BINS))
+                fail();
+            bench_new(dst_new, src, bins);
+        }
+    }
+}
+
+void checkasm_check_vf_median(void)
+{
+    LOCAL_ALIGNED_32(uint16_t, src,     [MAX_BINS]);
+    LOCAL_ALIGNED_32(uint16_t, dst_ref, [MAX_BINS]);
+    LOCAL_ALIGNED_32(uint16_t, dst_new, [MAX_BINS]);
+    MedianContext s = { .hadd = hadd_c, .hsub = hsub_c, .hmuladd = hmuladd_c };
+
+    if (ARCH_X86)
+        ff_median_init_x86(&s);
+
+    check_addsub(s.hadd, "hadd");
+    check_addsub(s.hsub, "hsub");
+    report("addsub");
+
+    {
+        declare_func(void, uint16_t *dst, const uint16_t *src, int f, int bins);
+
+        for (int bins = 16; bins <= MAX_BINS; bins *= 2) {
+            if (check_func(s.hmuladd, "median_hmuladd_%d", bins)) {
+                const int f = 1 + rnd() % 255;
+
+                randomize_buffers(src, MAX_BINS);
+                randomize_buffers(dst_ref, MAX_BINS);
+                memcpy(dst_new, dst_ref, sizeof(*dst_ref) * MAX_BINS);
+                call_ref(dst_ref, src, f, bins);
+                call_new(dst_new, src, f, bins);
+                if (memcmp(dst_ref, dst_new, sizeof(*dst_ref) * MAX_BINS))
+                    fail();
+                bench_new(dst_new, src, f, bins);
+            }
+        }
+    }
+    report("muladd");
+}
@@ -0,0 +1,127 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <math.h>
+#include "checkasm.h"
+#include "libavfilter/nnedi.h"
+#include "libavutil/mem_internal.h"
+
+#define MAX_NNS   256
+#define MAX_NSIZE (48 * 6)
+
+static void randomize_floats(float *buf, int size, float range)
+{
+    for (int i = 0; i < size; i++)
+        buf[i] = ((rnd() & 0xFFFF) / 32768.f - 1.f) * range;
+}
+
+static void check_prescreen_l0(const NNEDIDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(float, kernel,  [4 * 64]);
+    LOCAL_ALIGNED_32(float, input,   [64]);
+    LOCAL_ALIGNED_32(float, dst_ref, [4]);
+    LOCAL_ALIGNED_32(float, dst_new, [4]);
+
+    declare_func(void, float *dst, const float *kernel,
+                 const float *input, int n);
+
+    randomize_floats(kernel, 4 * 64, 1.f);
+    randomize_floats(input, 64, 255.f);
+
+    for (int n = 48; n <= 64; n += 16) {
+        if (check_func(dsp->prescreen_l0, "nnedi_prescreen_l0_%d", n)) {
+            call_ref(dst_ref, kernel, input, n);
+            call_new(dst_new, kernel, input, n);
+            if (!float_near_abs_eps_array(dst_ref, dst_new, 1e-2f, 4))
+                fail();
+            bench_new(dst_new, kernel, input, n);
+        }
+    }
+}
+
+static void check_predict(const NNEDIDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(float, weights, [MAX_NSIZE * 2 * MAX_NNS]);
+    LOCAL_ALIGNED_32(float, bias,    [2 * MAX_NNS]);
+    LOCAL_ALIGNED_32(float, input,   [MAX_NSIZE]);
+    LOCAL_ALIGNED_32(float, dst_ref, [2 * MAX_NNS]);
+    LOCAL_ALIGNED_32(float, dst_new, [2 * MAX_NNS]);
+    static const int sizes[][2] = { { 16, 48 }, { 64, 128 }, { 256, 288 } };
+    const float scale = 1.f / 64.f;
+
+    declare_func(void, float *dst, const float *weights, const float *bias,
+                 const float *input, int n, int cols, float scale);
+
+    randomize_floats(weights, MAX_NSIZE * 2 * MAX_NNS, 1.f);
+    randomize_floats(bias, 2 * MAX_NNS, 1.f);
+    randomize_floats(input, MAX_NSIZE, 64.f);
+
+    for (int i = 0; i < FF_ARRAY_ELEMS(sizes); i++) {
+        const int cols = 2 * sizes[i][0];
+        const int n = sizes[i][1];
+
+        if (check_func(dsp->predict, "nnedi_predict_%dx%d", sizes[i][0], n)) {
+            call_ref(dst_ref, weights, bias, input, n, cols, scale);
+            call_new(dst_new, weights, bias, input, n, cols, scale);
+            if (!float_near_abs_eps_array(dst_ref, dst_new, 1e-3f, cols))
+                fail();
+            bench_new(dst_new, weights, bias, input, n, cols, scale);
+        }
+    }
+}
+
+static void check_wae5(const NNEDIDSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(float, activation, [2 * MAX_NNS]);
+    float sums_ref[2], sums_new[2];
+
+    declare_func(void, const float *softmax, const float *elliott, int n,
+                 float *sums);
+
+    randomize_floats(activation, 2 * MAX_NNS, 20.f);
+    /* exercise the clipping of the exponent */
+    activation[0] = -100.f;
+    activation[1] =  100.f;
+
+    for (int nns = 16; nns <= MAX_NNS; nns *= 2) {
+        if (check_func(dsp->wae5, "nnedi_wae5_%d", nns)) {
+            call_ref(activation, activation + nns, nns, sums_ref);
+            call_new(activation, activation + nns, nns, sums_new);
+            if (!float_near_abs_eps(sums_ref[1], sums_new[1], fabsf(sums_ref[1]) * 1e-5f) ||
+                !float_near_abs_eps(sums_ref[0], sums_new[0], fabsf(sums_ref[1]) * 1e-5f))
+                fail();
+            bench_new(activation, activation + nns, nns, sums_new);
+        }
+    }
+}
+
+void checkasm_check_vf_nnedi(void)
+{
+    NNEDIDSPContext dsp;
+
+    ff_nnedi_init(&dsp);
+
+    check_prescreen_l0(&dsp);
+    report("prescreen_l0");
+
+    check_predict(&dsp);
+    report("predict");
+
+    check_wae5(&dsp);
+    report("wae5");
+}
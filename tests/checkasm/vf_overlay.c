@@ -0,0 +1,96 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <string.h>
+
+#include "checkasm.h"
+#include "libavfilter/vf_overlay.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem_internal.h"
+
+#define WIDTH 128
+
+#define randomize_buffers(buf, size, mask)                          \
+    do {                                                            \
+        for (int j = 0; j < size; j++)                              \
+            AV_WN16(buf + 2 * j, rnd() & mask);                     \
+    } while (0)
+
+static void check_overlay_row(const char *name, int format, int pix_format,
+                              int alpha_format, int plane)
+{
+    LOCAL_ALIGNED_32(uint8_t, src,     [WIDTH * 2]);
+    LOCAL_ALIGNED_32(uint8_t, alpha,   [WIDTH * 2 * 4]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [WIDTH * 2]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [WIDTH * 2]);
+    const int depth = format == OVERLAY_FORMAT_YUV420P10 ||
+                      format == OVERLAY_FORMAT_YUV422P10 ? 10 : 8;
+    const int mask = depth == 8 ? 0xFFFF : 0x3FF;
+    const int bytes = (depth + 7) / 8;
+    /* Room for the alpha of two rows of pixels twice as wide */
+    const ptrdiff_t alinesize = WIDTH * 2 * bytes;
+    OverlayContext s;
+
+    declare_func(int, uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a,
+                 int w, ptrdiff_t alinesize);
+
+    ff_overlay_init_rows(&s, format, pix_format, alpha_format, 0);
+
+    if (check_func(s.blend_row[plane], "overlay_row_%s", name)) {
+        for (int w = 1; w <= WIDTH; w++) {
+            int ret_ref, ret_new;
+
+            randomize_buffers(src,     WIDTH,     mask);
+            randomize_buffers(alpha,   WIDTH * 4, mask);
+            randomize_buffers(dst_ref, WIDTH,     mask);
+            /* Fully transparent and opaque pixels */
+            if (depth == 8) {
+                memset(alpha,     0x00, 4);
+                memset(alpha + 4, 0xFF, 4);
+                memset(alpha + alinesize,     0x00, 4);
+                memset(alpha + alinesize + 4, 0xFF, 4);
+            }
+            memcpy(dst_new, dst_ref, WIDTH * 2);
+
+            ret_ref = call_ref(dst_ref, NULL, src, alpha, w, alinesize);
+            ret_new = call_new(dst_new, NULL, src, alpha, w, alinesize);
+            /* The C code blends the pixels left by the assembly */
+            if (ret_new > ret_ref || memcmp(dst_ref, dst_new, ret_new * bytes))
+                fail();
+        }
+        bench_new(dst_new, NULL, src, alpha, WIDTH, alinesize);
+    }
+}
+
+void checkasm_check_vf_overlay(void)
+{
+    check_overlay_row("44",       OVERLAY_FORMAT_YUV444, AV_PIX_FMT_YUV444P, 0, 0);
+    check_overlay_row("22",       OVERLAY_FORMAT_YUV422, AV_PIX_FMT_YUV422P, 0, 1);
+    check_overlay_row("20",       OVERLAY_FORMAT_YUV420, AV_PIX_FMT_YUV420P, 0, 1);
+    report("overlay_row");
+
+    check_overlay_row("44_pm",    OVERLAY_FORMAT_YUV444, AV_PIX_FMT_YUV444P, 1, 0);
+    check_overlay_row("44_pm_uv", OVERLAY_FORMAT_YUV444, AV_PIX_FMT_YUV444P, 1, 1);
+    check_overlay_row("22_pm_uv", OVERLAY_FORMAT_YUV422, AV_PIX_FMT_YUV422P, 1, 1);
+    check_overlay_row("20_pm_uv", OVERLAY_FORMAT_YUV420, AV_PIX_FMT_YUV420P, 1, 1);
+    report("overlay_row_pm");
+
+    check_overlay_row("44_10", OVERLAY_FORMAT_YUV420P10, AV_PIX_FMT_YUV420P10, 0, 0);
+    check_overlay_row("22_10", OVERLAY_FORMAT_YUV422P10, AV_PIX_FMT_YUV422P10, 0, 1);
+    check_overlay_row("20_10", OVERLAY_FORMAT_YUV420P10, AV_PIX_FMT_YUV420P10, 0, 1);
+    report("overlay_row_10");
+}
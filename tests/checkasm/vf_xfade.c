@@ -0,0 +1,116 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavfilter/xfade.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem_internal.h"
+
+#define WIDTH 256
+#define BUF_SIZE (WIDTH * 2 + 64)
+
+#define randomize_buffers(buf, size)      \
+    do {                                  \
+        int j;                            \
+        uint8_t *tmp_buf = (uint8_t *)buf;\
+        for (j = 0; j < size; j++)        \
+            tmp_buf[j] = rnd() & 0xFF;    \
+    } while (0)
+
+static void check_xfade(int depth)
+{
+    LOCAL_ALIGNED_32(uint8_t, xf0,     [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, xf1,     [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [BUF_SIZE]);
+    LOCAL_ALIGNED_32(float,   noise,   [WIDTH + 32]);
+    const int mask = (1 << depth) - 1;
+    const int bytes = (depth + 7) / 8;
+    const float progress = (rnd() & 0xFFFF) / 65535.f;
+    XFadeDSPContext dsp;
+    int w;
+
+    ff_xfade_init(&dsp, depth);
+
+    randomize_buffers(xf0, BUF_SIZE);
+    randomize_buffers(xf1, BUF_SIZE);
+    if (depth > 8) {
+        for (int i = 0; i < BUF_SIZE / 2; i++) {
+            AV_WN16A(xf0 + 2 * i, AV_RN16A(xf0 + 2 * i) & mask);
+            AV_WN16A(xf1 + 2 * i, AV_RN16A(xf1 + 2 * i) & mask);
+        }
+    }
+    for (int i = 0; i < WIDTH + 32; i++)
+        noise[i] = (rnd() & 0xFFFF) / 65536.f;
+
+    /* test both a full and a ragged width */
+    for (w = WIDTH - 3; w <= WIDTH; w += 3) {
+        if (check_func(dsp.fade, "xfade_fade%d", depth)) {
+            declare_func(void, uint8_t *dst, const uint8_t *xf0, const uint8_t *xf1,
+                         int width, float progress);
+
+            memset(dst_ref, 0, BUF_SIZE);
+            memset(dst_new, 0, BUF_SIZE);
+            call_ref(dst_ref, xf0, xf1, w, progress);
+            call_new(dst_new, xf0, xf1, w, progress);
+            if (memcmp(dst_ref, dst_new, w * bytes))
+                fail();
+            bench_new(dst_new, xf0, xf1, WIDTH, progress);
+        }
+
+        if (check_func(dsp.fadecolor, "xfade_fadecolor%d", depth)) {
+            declare_func(void, uint8_t *dst, const uint8_t *xf0, const uint8_t *xf1,
+                         int width, float progress, float mix0, float mix1,
+                         float color);
+            const float mix0 = progress * progress;
+            const float mix1 = 1.f - progress;
+            const float color = mask / 2;
+
+            memset(dst_ref, 0, BUF_SIZE);
+            memset(dst_new, 0, BUF_SIZE);
+            call_ref(dst_ref, xf0, xf1, w, progress, mix0, mix1, color);
+            call_new(dst_new, xf0, xf1, w, progress, mix0, mix1, color);
+            if (memcmp(dst_ref, dst_new, w * bytes))
+                fail();
+            bench_new(dst_new, xf0, xf1, WIDTH, progress, mix0, mix1, color);
+        }
+
+        if (check_func(dsp.dissolve, "xfade_dissolve%d", depth)) {
+            declare_func(void, uint8_t *dst, const uint8_t *xf0, const uint8_t *xf1,
+                         const float *rnd, int width, float progress);
+
+            memset(dst_ref, 0, BUF_SIZE);
+            memset(dst_new, 0, BUF_SIZE);
+            call_ref(dst_ref, xf0, xf1, noise, w, progress);
+            call_new(dst_new, xf0, xf1, noise, w, progress);
+            if (memcmp(dst_ref, dst_new, w * bytes))
+                fail();
+            bench_new(dst_new, xf0, xf1, noise, WIDTH, progress);
+        }
+    }
+}
+
+void checkasm_check_vf_xfade(void)
+{
+    check_xfade(8);
+    report("xfade8");
+
+    check_xfade(16);
+    report("xfade16");
+}
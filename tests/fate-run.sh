@@ -371,6 +371,12 @@ refcmp_metadata(){
         -f null /dev/null | awk -v ref=${ref} -v fuzz=${fuzz} -f ${base}/refcmp-metadata.awk -
 }
 
+lavfi_metadata(){
+    filters=$1
+    fuzz=${2:-0.001}
+    ffmpeg $FLAGS -auto_conversion_filters -lavfi "$filters" -f null /dev/null | awk -v ref=${ref} -v fuzz=${fuzz} -f ${base}/refcmp-metadata.awk -
+}
+
 pixfmt_conversion(){
     conversion="${test#pixfmt-}"
     outdir="tests/data/pixfmt"
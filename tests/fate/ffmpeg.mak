@@ -41,6 +41,20 @@ fate-ffmpeg-filter_colorkey: CMD = framecrc -auto_conversion_filters -idct simpl
 FATE_FFMPEG-$(CONFIG_COLOR_FILTER) += fate-ffmpeg-lavfi
 fate-ffmpeg-lavfi: CMD = framecrc -lavfi color=d=1:r=5 -fflags +bitexact
 
+tests/data/reinit-filter-%.ppm: TAG = GEN
+tests/data/reinit-filter-%.ppm: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+	-f lavfi -i testsrc=s=$*:r=5:d=1 -f image2pipe -c:v ppm -y $(TARGET_PATH)/$@ 2>/dev/null
+
+# The frames change size mid-stream and are scaled back to the first size,
+# without reinitializing the filtergraph: tmix keeps blending the frames
+# from before the change
+FATE_FFMPEG-$(call ALLYES, LAVFI_INDEV TESTSRC_FILTER IMAGE2PIPE_MUXER PPM_ENCODER IMAGE_PPM_PIPE_DEMUXER PPM_DECODER CONCAT_PROTOCOL SCALE_FILTER TMIX_FILTER) += fate-ffmpeg-reinit_filter-scale
+fate-ffmpeg-reinit_filter-scale: tests/data/reinit-filter-320x240.ppm tests/data/reinit-filter-160x120.ppm
+fate-ffmpeg-reinit_filter-scale: CMD = framecrc -reinit_filter 2 -f ppm_pipe \
+  -i "concat:$(TARGET_PATH)/tests/data/reinit-filter-320x240.ppm|$(TARGET_PATH)/tests/data/reinit-filter-160x120.ppm" \
+  -vf tmix=frames=3
+
 FATE_SAMPLES_FFMPEG-$(CONFIG_RAWVIDEO_DEMUXER) += fate-force_key_frames
 fate-force_key_frames: tests/data/vsynth_lena.yuv
 fate-force_key_frames: CMD = enc_dec \
@@ -393,6 +393,18 @@ fate-filter-hdcd-s32p: CMD = md5 -i $(SRC) -af hdcd -f s32le
 fate-filter-hdcd-s32p: CMP = oneline
 fate-filter-hdcd-s32p: REF = 0c5513e83eedaa10ab6fac9ddc173cf5
 
+ASTATS_SRC = sine=frequency=440:sample_rate=8000:duration=0.5:samples_per_frame=2000[a];anoisesrc=sample_rate=8000:duration=0.5:amplitude=0.25:seed=42:nb_samples=2000[b];[a][b]amerge
+ASTATS_MEASURE = DC_offset+Min_level+Max_level+Min_difference+Max_difference+Mean_difference+RMS_difference+Peak_level+RMS_level+Flat_factor+Peak_count+Noise_floor+Noise_floor_count+Bit_depth+Dynamic_range+Zero_crossings+Zero_crossings_rate+Number_of_samples+Number_of_NaNs+Number_of_Infs+Number_of_denormals
+ASTATS_DEPS = SINE_FILTER ANOISESRC_FILTER AMERGE_FILTER AFORMAT_FILTER ASTATS_FILTER AMETADATA_FILTER NULL_MUXER
+
+FATE_AFILTER-$(call ALLYES, $(ASTATS_DEPS)) += fate-filter-astats-s16 fate-filter-astats-flt
+fate-filter-astats-s16: CMD = lavfi_metadata "$(ASTATS_SRC),aformat=s16,astats=metadata=1:measure_perchannel=$(ASTATS_MEASURE):measure_overall=$(ASTATS_MEASURE),ametadata=print:file=-"
+fate-filter-astats-flt: CMD = lavfi_metadata "$(ASTATS_SRC),aformat=fltp,astats=metadata=1:measure_perchannel=$(ASTATS_MEASURE):measure_overall=$(ASTATS_MEASURE),ametadata=print:file=-"
+
+FATE_AFILTER-$(call ALLYES, SINE_FILTER VOLUME_FILTER) += fate-filter-audio-quantum
+fate-filter-audio-quantum: libavfilter/tests/audioquantum$(EXESUF)
+fate-filter-audio-quantum: CMD = run libavfilter/tests/audioquantum$(EXESUF)
+
 FATE_AFILTER-yes += fate-filter-formats
 fate-filter-formats: libavfilter/tests/formats$(EXESUF)
 fate-filter-formats: CMD = run libavfilter/tests/formats$(EXESUF)
@@ -126,6 +126,16 @@ FATE_FILTER-$(call ALLYES, MINTERPOLATE_FILTER TESTSRC2_FILTER) += fate-filter-m
 fate-filter-minterpolate-up: CMD = framecrc -lavfi testsrc2=r=2:d=10,minterpolate=fps=10 -t 1
 fate-filter-minterpolate-down: CMD = framecrc -lavfi testsrc2=r=2:d=10,minterpolate=fps=1 -t 1
 
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER FORMAT_FILTER SETPARAMS_FILTER TONEMAP_FILTER) += fate-filter-tonemap-yuv420p10
+fate-filter-tonemap-yuv420p10: CMD = framecrc -lavfi testsrc2=s=320x240:r=5:d=1,format=yuv420p10,setparams=color_trc=smpte2084,tonemap=hable:format=yuv420p
+
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER FORMAT_FILTER SCALE_FILTER SETPARAMS_FILTER TONEMAP_FILTER) += fate-filter-tonemap-bt709
+fate-filter-tonemap-bt709: CMD = framecrc -auto_conversion_filters -lavfi testsrc2=s=320x240:r=5:d=1,format=yuv420p10,setparams=color_trc=bt709,tonemap=hable,format=yuv420p
+
+FATE_FILTER-$(call ALLYES, TESTSRC_FILTER FORMAT_FILTER SPLIT_FILTER HSTACK_FILTER SELECT_FILTER NULLSINK_FILTER) += fate-filter-queue-limit
+fate-filter-queue-limit: libavfilter/tests/queuelimit$(EXESUF)
+fate-filter-queue-limit: CMD = run libavfilter/tests/queuelimit$(EXESUF)
+
 FATE_FILTER_VSYNTH-$(CONFIG_BOXBLUR_FILTER) += fate-filter-boxblur
 fate-filter-boxblur: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf boxblur=2:1
 
@@ -141,6 +151,12 @@ fate-filter-fade: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf fade=in:5:15,fade=out
 FATE_FILTER_VSYNTH-$(call ALLYES, INTERLACE_FILTER FIELDORDER_FILTER) += fate-filter-fieldorder
 fate-filter-fieldorder: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf interlace=tff,scale,fieldorder=bff -sws_flags +accurate_rnd+bitexact
 
+# the matches must not depend on the number of slices
+FATE_FILTER_VSYNTH-$(call ALLYES, TELECINE_FILTER NOISE_FILTER FIELDMATCH_FILTER) += fate-filter-fieldmatch fate-filter-fieldmatch-threads
+fate-filter-fieldmatch: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 1 -vf telecine,noise=alls=20:allf=t,fieldmatch=order=bff
+fate-filter-fieldmatch-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 4 -vf telecine,noise=alls=20:allf=t,fieldmatch=order=bff
+fate-filter-fieldmatch-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-fieldmatch
+
 define FATE_FPFILTER_SUITE
 FATE_FILTER_FRAMEPACK += fate-filter-framepack-$(1)
 fate-filter-framepack-$(1): CMD = framecrc -c:v pgmyuv -i $(TARGET_PATH)/tests/vsynth1/%02d.pgm -c:v pgmyuv -i $(TARGET_PATH)/tests/vsynth1/%02d.pgm -filter_complex framepack=$(1) -frames 15
@@ -211,6 +227,15 @@ FATE_FILTER_VSYNTH-$(CONFIG_VSTACK_FILTER) += fate-filter-vstack
 fate-filter-vstack: tests/data/filtergraphs/vstack
 fate-filter-vstack: CMD = framecrc -c:v pgmyuv -i $(SRC) -c:v pgmyuv -i $(SRC) -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/vstack
 
+# inputs drawing into their area of the output frame
+FATE_FILTER_VSYNTH-$(call ALLYES, CROP_FILTER HFLIP_FILTER HSTACK_FILTER) += fate-filter-hstack-views
+fate-filter-hstack-views: tests/data/filtergraphs/hstack-views
+fate-filter-hstack-views: CMD = framecrc -c:v pgmyuv -i $(SRC) -c:v pgmyuv -i $(SRC) -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/hstack-views
+
+FATE_FILTER_VSYNTH-$(call ALLYES, CROP_FILTER HFLIP_FILTER XSTACK_FILTER) += fate-filter-xstack-views
+fate-filter-xstack-views: tests/data/filtergraphs/xstack-views
+fate-filter-xstack-views: CMD = framecrc -c:v pgmyuv -i $(SRC) -c:v pgmyuv -i $(SRC) -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/xstack-views
+
 FATE_FILTER_VSYNTH-$(CONFIG_OVERLAY_FILTER) += fate-filter-overlay
 fate-filter-overlay: tests/data/filtergraphs/overlay
 fate-filter-overlay: CMD = framecrc -c:v pgmyuv -i $(SRC) -c:v pgmyuv -i $(SRC) -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/overlay